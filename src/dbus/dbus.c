@@ -3,6 +3,7 @@
  */
 #include "alloc-util.h"
 #include "dbus.h"
+#include "file-util.h"
 #include "log.h"
 #include "string-util.h"
 
@@ -14,16 +15,51 @@ void sd_bus_free(sd_bus *bus) {
         bus = sd_bus_unref(bus);
 }
 
+/* Connection setup (auth handshake and Hello) costs more than most of the calls made here, so every helper
+ * shares one lazily opened connection. sd-bus objects are not thread safe, hence one per thread. */
+static __thread sd_bus *system_bus = NULL;
+
+int dbus_acquire_system_bus(sd_bus **ret) {
+        int r;
+
+        assert(ret);
+
+        /* The broker may have dropped us (dbus-broker restart) or we are in a forked child */
+        if (system_bus && sd_bus_is_open(system_bus) <= 0)
+                system_bus = sd_bus_flush_close_unref(system_bus);
+
+        if (!system_bus) {
+                r = sd_bus_open_system(&system_bus);
+                if (r < 0)
+                        return r;
+        }
+
+        *ret = sd_bus_ref(system_bus);
+        return 0;
+}
+
+void dbus_release_system_bus(void) {
+        system_bus = sd_bus_flush_close_unref(system_bus);
+}
+
+/* Bumped whenever nmctl asks networkd (or systemd on its behalf) to change the runtime state, so that
+ * callers caching Describe output know when it went stale */
+static __thread unsigned network_generation = 0;
+
+unsigned dbus_network_generation(void) {
+        return network_generation;
+}
+
 int dbus_get_string_systemd_manager(const char *p, char **ret) {
         _cleanup_(sd_bus_error_free) sd_bus_error bus_error = SD_BUS_ERROR_NULL;
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
-        _cleanup_(sd_bus_freep) sd_bus *bus = NULL;
+        _cleanup_(sd_bus_unrefp) sd_bus *bus = NULL;
         char *v;
         int r;
 
         assert(p);
 
-        r = sd_bus_open_system(&bus);
+        r = dbus_acquire_system_bus(&bus);
         if (r < 0)
                 return r;
 
@@ -56,12 +92,12 @@ int dbus_get_string_systemd_manager(const char *p, char **ret) {
 int dbus_set_hostname(const char *hostname) {
         _cleanup_(sd_bus_error_free) sd_bus_error bus_error = SD_BUS_ERROR_NULL;
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
-        _cleanup_(sd_bus_freep) sd_bus *bus = NULL;
+        _cleanup_(sd_bus_unrefp) sd_bus *bus = NULL;
         int r;
 
         assert(hostname);
 
-        r = sd_bus_open_system(&bus);
+        r = dbus_acquire_system_bus(&bus);
         if (r < 0)
                 return r;
 
@@ -85,13 +121,13 @@ int dbus_set_hostname(const char *hostname) {
 int dbus_call_hostnamed_describe(char **ret) {
         _cleanup_(sd_bus_error_free) sd_bus_error bus_error = SD_BUS_ERROR_NULL;
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
-        _cleanup_(sd_bus_freep) sd_bus *bus = NULL;
+        _cleanup_(sd_bus_unrefp) sd_bus *bus = NULL;
         _auto_cleanup_ char *v = NULL;
         int r;
 
         assert(ret);
 
-        r = sd_bus_open_system(&bus);
+        r = dbus_acquire_system_bus(&bus);
         if (r < 0)
                 return r;
 
@@ -121,11 +157,11 @@ int dbus_call_hostnamed_describe(char **ret) {
 int dbus_get_property_from_hostnamed_time(const char *p, uint64_t *ret) {
         _cleanup_(sd_bus_error_free) sd_bus_error bus_error = SD_BUS_ERROR_NULL;
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
-        _cleanup_(sd_bus_freep) sd_bus *bus = NULL;
+        _cleanup_(sd_bus_unrefp) sd_bus *bus = NULL;
         uint64_t t;
         int r;
 
-        r = sd_bus_open_system(&bus);
+        r = dbus_acquire_system_bus(&bus);
         if (r < 0)
                 return r;
 
@@ -151,12 +187,12 @@ int dbus_get_property_from_hostnamed_time(const char *p, uint64_t *ret) {
 int dbus_get_property_from_hostnamed(const char *p, char **ret) {
         _cleanup_(sd_bus_error_free) sd_bus_error bus_error = SD_BUS_ERROR_NULL;
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
-        _cleanup_(sd_bus_freep) sd_bus *bus = NULL;
+        _cleanup_(sd_bus_unrefp) sd_bus *bus = NULL;
         _auto_cleanup_ char *t = NULL;
         char *s;
         int r;
 
-        r = sd_bus_open_system(&bus);
+        r = dbus_acquire_system_bus(&bus);
         if (r < 0)
                 return r;
 
@@ -188,12 +224,12 @@ int dbus_get_property_from_hostnamed(const char *p, char **ret) {
 int dbus_stop_unit(const char *unit) {
         _cleanup_(sd_bus_error_free) sd_bus_error bus_error = SD_BUS_ERROR_NULL;
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
-        _cleanup_(sd_bus_freep) sd_bus *bus = NULL;
+        _cleanup_(sd_bus_unrefp) sd_bus *bus = NULL;
         int r;
 
         assert(unit);
 
-        r = sd_bus_open_system(&bus);
+        r = dbus_acquire_system_bus(&bus);
         if (r < 0)
                 return r;
 
@@ -212,16 +248,17 @@ int dbus_stop_unit(const char *unit) {
                 return r;
         }
 
+        network_generation++;
         return 0;
 }
 
 int dbus_restart_unit(const char *unit) {
         _cleanup_(sd_bus_error_free) sd_bus_error bus_error = SD_BUS_ERROR_NULL;
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
-        _cleanup_(sd_bus_freep) sd_bus *bus = NULL;
+        _cleanup_(sd_bus_unrefp) sd_bus *bus = NULL;
         int r;
 
-        r = sd_bus_open_system(&bus);
+        r = dbus_acquire_system_bus(&bus);
         if (r < 0)
                 return r;
 
@@ -235,35 +272,19 @@ int dbus_restart_unit(const char *unit) {
                                "ss",
                                unit,
                                "replace");
-        return r;
+        if (r < 0)
+                return r;
+
+        network_generation++;
+        return 0;
 }
 
-int dbus_get_current_dns_server_from_resolved(DNSServer **ret) {
-        _cleanup_(sd_bus_error_free) sd_bus_error bus_error = SD_BUS_ERROR_NULL;
-        _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
-        _cleanup_(sd_bus_freep) sd_bus *bus = NULL;
+static int read_dns_server(sd_bus_message *reply, DNSServer **ret) {
         _auto_cleanup_ DNSServer *dns = NULL;
         int r, ifindex = 0, family = 0;
         const void *a;
         size_t sz;
 
-        r = sd_bus_open_system(&bus);
-        if (r < 0)
-                return r;
-
-        r = sd_bus_get_property(bus,
-                                "org.freedesktop.resolve1",
-                                "/org/freedesktop/resolve1",
-                                "org.freedesktop.resolve1.Manager",
-                                "CurrentDNSServer",
-                                &bus_error,
-                                &reply,
-                                "(iiay)");
-        if (r < 0) {
-                log_warning("Failed to get D-Bus property 'CurrentDNSServer': %s", bus_error.message);
-                return r;
-        }
-
         r = sd_bus_message_enter_container(reply, 'r', "iiay");
         if (r < 0) {
                 log_warning("Failed to enter bus message container: %s", strerror(-r));
@@ -319,16 +340,42 @@ int dbus_get_current_dns_server_from_resolved(DNSServer **ret) {
         return 0;
 }
 
+int dbus_get_current_dns_server_from_resolved(DNSServer **ret) {
+        _cleanup_(sd_bus_error_free) sd_bus_error bus_error = SD_BUS_ERROR_NULL;
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
+        _cleanup_(sd_bus_unrefp) sd_bus *bus = NULL;
+        int r;
+
+        r = dbus_acquire_system_bus(&bus);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_get_property(bus,
+                                "org.freedesktop.resolve1",
+                                "/org/freedesktop/resolve1",
+                                "org.freedesktop.resolve1.Manager",
+                                "CurrentDNSServer",
+                                &bus_error,
+                                &reply,
+                                "(iiay)");
+        if (r < 0) {
+                log_warning("Failed to get D-Bus property 'CurrentDNSServer': %s", bus_error.message);
+                return r;
+        }
+
+        return read_dns_server(reply, ret);
+}
+
 int dbus_acquire_dns_servers_from_resolved(const char *dns, DNSServers **ret) {
         _cleanup_(sd_bus_error_free) sd_bus_error bus_error = SD_BUS_ERROR_NULL;
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
-        _cleanup_(sd_bus_freep) sd_bus *bus = NULL;
+        _cleanup_(sd_bus_unrefp) sd_bus *bus = NULL;
         DNSServers *serv = NULL;
         int r;
 
         assert(dns);
 
-        r = sd_bus_open_system(&bus);
+        r = dbus_acquire_system_bus(&bus);
         if (r < 0)
                 return r;
 
@@ -433,13 +480,13 @@ int dbus_acquire_dns_servers_from_resolved(const char *dns, DNSServers **ret) {
 int dbus_add_dns_server(int ifindex, DNSServers *dns) {
         _cleanup_(sd_bus_error_free) sd_bus_error bus_error = SD_BUS_ERROR_NULL;
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
-        _cleanup_(sd_bus_freep) sd_bus *bus = NULL;
+        _cleanup_(sd_bus_unrefp) sd_bus *bus = NULL;
         int r;
 
         assert(dns);
         assert(ifindex > 0);
 
-        r = sd_bus_open_system(&bus);
+        r = dbus_acquire_system_bus(&bus);
         if (r < 0)
                 return r;
 
@@ -516,14 +563,14 @@ int dbus_add_dns_server(int ifindex, DNSServers *dns) {
 int dbus_add_dns_domains(int ifindex, char **domains) {
         _cleanup_(sd_bus_error_free) sd_bus_error bus_error = SD_BUS_ERROR_NULL;
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
-        _cleanup_(sd_bus_freep) sd_bus *bus = NULL;
+        _cleanup_(sd_bus_unrefp) sd_bus *bus = NULL;
         char **d;
         int r;
 
         assert(domains);
         assert(ifindex > 0);
 
-        r = sd_bus_open_system(&bus);
+        r = dbus_acquire_system_bus(&bus);
         if (r < 0)
                 return r;
 
@@ -576,14 +623,14 @@ int dbus_add_dns_domains(int ifindex, char **domains) {
 int dbus_acquire_dns_domains_from_resolved(DNSDomains **domains) {
         _cleanup_(sd_bus_error_free) sd_bus_error bus_error = SD_BUS_ERROR_NULL;
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
-        _cleanup_(sd_bus_freep) sd_bus *bus = NULL;
+        _cleanup_(sd_bus_unrefp) sd_bus *bus = NULL;
         int r, route_only, ifindex = 0;
         DNSDomains *serv = NULL;
         DNSDomain *i = NULL;
 
         assert(domains);
 
-        r = sd_bus_open_system(&bus);
+        r = dbus_acquire_system_bus(&bus);
         if (r < 0)
                 return r;
 
@@ -663,12 +710,12 @@ int dbus_acquire_dns_domains_from_resolved(DNSDomains **domains) {
 
 int dbus_revert_resolve_link(int ifindex) {
         _cleanup_(sd_bus_error_free) sd_bus_error bus_error = SD_BUS_ERROR_NULL;
-        _cleanup_(sd_bus_freep) sd_bus *bus = NULL;
+        _cleanup_(sd_bus_unrefp) sd_bus *bus = NULL;
         int r;
 
         assert(ifindex > 0);
 
-        r = sd_bus_open_system(&bus);
+        r = dbus_acquire_system_bus(&bus);
         if (r < 0)
                 return r;
 
@@ -692,11 +739,11 @@ int dbus_revert_resolve_link(int ifindex) {
 int dbus_acqure_dns_setting_from_resolved(const char *setting, char **ret) {
         _cleanup_(sd_bus_error_free) sd_bus_error bus_error = SD_BUS_ERROR_NULL;
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
-        _cleanup_(sd_bus_freep) sd_bus *bus = NULL;
+        _cleanup_(sd_bus_unrefp) sd_bus *bus = NULL;
         const void *a;
         int r;
 
-        r = sd_bus_open_system(&bus);
+        r = dbus_acquire_system_bus(&bus);
         if (r < 0)
                 return r;
 
@@ -726,12 +773,12 @@ int dbus_acqure_dns_setting_from_resolved(const char *setting, char **ret) {
         return 0;
 }
 
-int dbus_network_reload(void) {
+static int network_reload(void) {
         _cleanup_(sd_bus_error_free) sd_bus_error bus_error = SD_BUS_ERROR_NULL;
-        _cleanup_(sd_bus_freep) sd_bus *bus = NULL;
+        _cleanup_(sd_bus_unrefp) sd_bus *bus = NULL;
         int r;
 
-        r = sd_bus_open_system(&bus);
+        r = dbus_acquire_system_bus(&bus);
         if (r < 0) {
                 log_warning("Failed to connect system bus: %s", bus_error.message);
                 return r;
@@ -750,17 +797,18 @@ int dbus_network_reload(void) {
                 return r;
         }
 
+        network_generation++;
         return 0;
 }
 
-int dbus_reconfigure_link(int ifindex) {
+static int reconfigure_link(int ifindex) {
         _cleanup_(sd_bus_error_free) sd_bus_error bus_error = SD_BUS_ERROR_NULL;
-        _cleanup_(sd_bus_freep) sd_bus *bus = NULL;
+        _cleanup_(sd_bus_unrefp) sd_bus *bus = NULL;
         int r;
 
         assert(ifindex > 0);
 
-        r = sd_bus_open_system(&bus);
+        r = dbus_acquire_system_bus(&bus);
         if (r < 0) {
                 log_warning("Failed to connect system bus: %s", bus_error.message);
                 return r;
@@ -780,19 +828,101 @@ int dbus_reconfigure_link(int ifindex) {
                 return r;
         }
 
+        network_generation++;
+        return 0;
+}
+
+/* Reload requests made inside a dbus_network_reload_defer() / dbus_network_reload_flush() pair only mark
+ * networkd dirty. The outermost flush then issues a single Reload, so multi step operations (YAML apply,
+ * set-static ...) do not make networkd re-evaluate every link once per step. Scopes nest.
+ *
+ * The flush skips the Reload when no configuration file was created, removed or changed since the scope was
+ * opened, e.g. when a YAML file is applied a second time. ReconfigureLink requests are collected too and sent
+ * once per link after the Reload, since ReconfigureLink only applies what networkd has already loaded. */
+static __thread unsigned reload_defer_depth = 0;
+static __thread unsigned reload_changes = 0;
+static __thread bool reload_pending = false;
+static __thread bool reload_forced = false;
+static __thread GArray *reconfigure_links = NULL;
+
+void dbus_network_reload_defer(void) {
+        if (reload_defer_depth++ == 0)
+                reload_changes = conf_file_get_changes();
+}
+
+int dbus_network_reload_flush(void) {
+        _cleanup_(g_array_unrefp) GArray *links = NULL;
+        int r = 0;
+
+        assert(reload_defer_depth > 0);
+
+        if (--reload_defer_depth > 0)
+                return 0;
+
+        if (reload_pending && (reload_forced || conf_file_get_changes() != reload_changes))
+                r = network_reload();
+
+        reload_pending = reload_forced = false;
+
+        links = steal_ptr(reconfigure_links);
+        if (!links || r < 0)
+                return r;
+
+        for (guint i = 0; i < links->len; i++) {
+                int k;
+
+                k = reconfigure_link(g_array_index(links, int, i));
+                if (k < 0 && r >= 0)
+                        r = k;
+        }
+
+        return r;
+}
+
+int dbus_network_reload(void) {
+        if (reload_defer_depth > 0) {
+                reload_pending = true;
+                return 0;
+        }
+
+        return network_reload();
+}
+
+/* For an explicit user request: reloads even when nmctl itself did not touch any file */
+int dbus_network_force_reload(void) {
+        if (reload_defer_depth > 0)
+                reload_forced = true;
+
+        return dbus_network_reload();
+}
+
+int dbus_reconfigure_link(int ifindex) {
+        assert(ifindex > 0);
+
+        if (reload_defer_depth == 0)
+                return reconfigure_link(ifindex);
+
+        if (!reconfigure_links)
+                reconfigure_links = g_array_new(false, false, sizeof(int));
+
+        for (guint i = 0; i < reconfigure_links->len; i++)
+                if (g_array_index(reconfigure_links, int, i) == ifindex)
+                        return 0;
+
+        g_array_append_val(reconfigure_links, ifindex);
         return 0;
 }
 
 int dbus_get_system_property_from_networkd(const char *p, char **ret) {
         _cleanup_(sd_bus_error_free) sd_bus_error bus_error = SD_BUS_ERROR_NULL;
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *m = NULL;
-        _cleanup_(sd_bus_freep) sd_bus *bus = NULL;
+        _cleanup_(sd_bus_unrefp) sd_bus *bus = NULL;
         char *v;
         int r;
 
         assert(p);
 
-        r = sd_bus_open_system(&bus);
+        r = dbus_acquire_system_bus(&bus);
         if (r < 0) {
                 log_warning("Failed to connect system bus: %s", bus_error.message);
                 return r;
@@ -826,13 +956,13 @@ int dbus_get_system_property_from_networkd(const char *p, char **ret) {
 int dbus_describe_network(char **ret) {
         _cleanup_(sd_bus_error_free) sd_bus_error bus_error = SD_BUS_ERROR_NULL;
         _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
-        _cleanup_(sd_bus_freep) sd_bus *bus = NULL;
+        _cleanup_(sd_bus_unrefp) sd_bus *bus = NULL;
         _auto_cleanup_ char *v = NULL;
         int r;
 
         assert(ret);
 
-        r = sd_bus_open_system(&bus);
+        r = dbus_acquire_system_bus(&bus);
         if (r < 0)
                 return r;
 
@@ -856,3 +986,310 @@ int dbus_describe_network(char **ret) {
 
         return 0;
 }
+
+/* Same as dbus_describe_network() but for a single link, which saves networkd from serializing every link */
+int dbus_describe_link(int ifindex, char **ret) {
+        _cleanup_(sd_bus_error_free) sd_bus_error bus_error = SD_BUS_ERROR_NULL;
+        _cleanup_(sd_bus_message_unrefp) sd_bus_message *reply = NULL;
+        _cleanup_(sd_bus_unrefp) sd_bus *bus = NULL;
+        _auto_cleanup_ char *path = NULL, *index = NULL;
+        const char *v;
+        int r;
+
+        assert(ifindex > 0);
+        assert(ret);
+
+        index = g_strdup_printf("%d", ifindex);
+        if (!index)
+                return log_oom();
+
+        r = sd_bus_path_encode("/org/freedesktop/network1/link", index, &path);
+        if (r < 0)
+                return r;
+
+        r = dbus_acquire_system_bus(&bus);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_call_method(bus,
+                               "org.freedesktop.network1",
+                               path,
+                               "org.freedesktop.network1.Link",
+                               "Describe",
+                               &bus_error,
+                               &reply, NULL);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_read(reply, "s", &v);
+        if (r < 0)
+                return r;
+
+        *ret = strdup(v);
+        if (!*ret)
+                return log_oom();
+
+        return 0;
+}
+
+/* Outstanding asynchronous calls of dbus_acquire_system_status() */
+enum {
+        CALL_HOSTNAMED,
+        CALL_MANAGER_VERSION,
+        CALL_MANAGER_ARCHITECTURE,
+        CALL_MANAGER_VIRTUALIZATION,
+        CALL_NETWORKD,
+        CALL_RESOLVED,
+        _CALL_MAX,
+};
+
+typedef struct PendingCalls {
+        sd_bus_slot *slots[_CALL_MAX];
+        sd_bus_message *replies[_CALL_MAX];
+        unsigned pending;
+} PendingCalls;
+
+typedef struct PendingCall {
+        PendingCalls *calls;
+        size_t id;
+} PendingCall;
+
+static void pending_calls_done(PendingCalls *c) {
+        /* Dropping the slots cancels whatever did not complete */
+        for (size_t i = 0; i < _CALL_MAX; i++) {
+                sd_bus_slot_unref(c->slots[i]);
+                sd_bus_message_unref(c->replies[i]);
+        }
+}
+
+static int pending_call_handler(sd_bus_message *m, void *userdata, sd_bus_error *ret_error) {
+        PendingCall *c = userdata;
+
+        c->calls->pending--;
+
+        if (sd_bus_message_is_method_error(m, NULL)) {
+                log_debug("D-Bus call failed: %s", sd_bus_message_get_error(m)->message);
+                return 0;
+        }
+
+        c->calls->replies[c->id] = sd_bus_message_ref(m);
+        return 0;
+}
+
+static int call_async(sd_bus *bus,
+                      PendingCall *c,
+                      const char *destination,
+                      const char *path,
+                      const char *member,
+                      const char *types,
+                      const char *a,
+                      const char *b) {
+        int r;
+
+        r = sd_bus_call_method_async(bus,
+                                     &c->calls->slots[c->id],
+                                     destination,
+                                     path,
+                                     "org.freedesktop.DBus.Properties",
+                                     member,
+                                     pending_call_handler,
+                                     c,
+                                     types,
+                                     a,
+                                     b);
+        if (r < 0)
+                return r;
+
+        c->calls->pending++;
+        return 0;
+}
+
+/* Reads the a{sv} reply of Properties.GetAll. String and integer properties end up in the table as strings,
+ * CurrentDNSServer of resolved is handed out separately, anything else is skipped. */
+static int read_properties(sd_bus_message *m, GHashTable *table, DNSServer **dns) {
+        int r;
+
+        r = sd_bus_message_enter_container(m, 'a', "{sv}");
+        if (r < 0)
+                return r;
+
+        while ((r = sd_bus_message_enter_container(m, 'e', "sv")) > 0) {
+                const char *name, *contents;
+                char type;
+
+                r = sd_bus_message_read(m, "s", &name);
+                if (r < 0)
+                        return r;
+
+                r = sd_bus_message_peek_type(m, &type, &contents);
+                if (r < 0)
+                        return r;
+
+                r = sd_bus_message_enter_container(m, 'v', contents);
+                if (r < 0)
+                        return r;
+
+                if (streq(contents, "s")) {
+                        const char *v;
+
+                        r = sd_bus_message_read(m, "s", &v);
+                        if (r < 0)
+                                return r;
+
+                        g_hash_table_replace(table, g_strdup(name), g_strdup(v));
+                } else if (streq(contents, "t")) {
+                        uint64_t v;
+
+                        r = sd_bus_message_read(m, "t", &v);
+                        if (r < 0)
+                                return r;
+
+                        g_hash_table_replace(table, g_strdup(name), g_strdup_printf("%" PRIu64, v));
+                } else if (dns && streq(name, "CurrentDNSServer") && streq(contents, "(iiay)")) {
+                        r = read_dns_server(m, dns);
+                        if (r < 0)
+                                return r;
+                } else {
+                        r = sd_bus_message_skip(m, contents);
+                        if (r < 0)
+                                return r;
+                }
+
+                r = sd_bus_message_exit_container(m);
+                if (r < 0)
+                        return r;
+
+                r = sd_bus_message_exit_container(m);
+                if (r < 0)
+                        return r;
+        }
+        if (r < 0)
+                return r;
+
+        return sd_bus_message_exit_container(m);
+}
+
+/* Reads the "v" reply of Properties.Get */
+static int read_string_property(sd_bus_message *m, const char *name, GHashTable *table) {
+        const char *v;
+        int r;
+
+        r = sd_bus_message_read(m, "v", "s", &v);
+        if (r < 0)
+                return r;
+
+        g_hash_table_replace(table, g_strdup(name), g_strdup(v));
+        return 0;
+}
+
+void dbus_system_status_free(DBusSystemStatus *s) {
+        if (!s)
+                return;
+
+        g_hash_table_unref(s->hostnamed);
+        g_hash_table_unref(s->manager);
+        g_hash_table_unref(s->networkd);
+        g_hash_table_unref(s->resolved);
+        free(s->current_dns_server);
+        free(s);
+}
+
+/* Collects everything "status" shows from hostnamed, the systemd manager, networkd and resolved. Instead of one
+ * blocking round trip per property all calls are queued on the shared connection first and the replies are
+ * collected afterwards. hostnamed, networkd and resolved each answer a single GetAll. Services which are not
+ * running simply leave their table empty. */
+int dbus_acquire_system_status(DBusSystemStatus **ret) {
+        _cleanup_(dbus_system_status_freep) DBusSystemStatus *s = NULL;
+        _cleanup_(pending_calls_done) PendingCalls calls = {};
+        _cleanup_(sd_bus_unrefp) sd_bus *bus = NULL;
+        PendingCall c[_CALL_MAX];
+        const char *date;
+        int r;
+
+        assert(ret);
+
+        s = new(DBusSystemStatus, 1);
+        if (!s)
+                return log_oom();
+
+        *s = (DBusSystemStatus) {
+                .hostnamed = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free),
+                .manager = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free),
+                .networkd = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free),
+                .resolved = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free),
+        };
+        if (!s->hostnamed || !s->manager || !s->networkd || !s->resolved)
+                return log_oom();
+
+        for (size_t i = 0; i < _CALL_MAX; i++)
+                c[i] = (PendingCall) {
+                        .calls = &calls,
+                        .id = i,
+                };
+
+        r = dbus_acquire_system_bus(&bus);
+        if (r < 0)
+                return r;
+
+        r = call_async(bus, &c[CALL_HOSTNAMED], "org.freedesktop.hostname1", "/org/freedesktop/hostname1",
+                       "GetAll", "s", "org.freedesktop.hostname1", NULL);
+        if (r < 0)
+                return r;
+
+        r = call_async(bus, &c[CALL_MANAGER_VERSION], "org.freedesktop.systemd1", "/org/freedesktop/systemd1",
+                       "Get", "ss", "org.freedesktop.systemd1.Manager", "Version");
+        if (r < 0)
+                return r;
+
+        r = call_async(bus, &c[CALL_MANAGER_ARCHITECTURE], "org.freedesktop.systemd1", "/org/freedesktop/systemd1",
+                       "Get", "ss", "org.freedesktop.systemd1.Manager", "Architecture");
+        if (r < 0)
+                return r;
+
+        r = call_async(bus, &c[CALL_MANAGER_VIRTUALIZATION], "org.freedesktop.systemd1", "/org/freedesktop/systemd1",
+                       "Get", "ss", "org.freedesktop.systemd1.Manager", "Virtualization");
+        if (r < 0)
+                return r;
+
+        r = call_async(bus, &c[CALL_NETWORKD], "org.freedesktop.network1", "/org/freedesktop/network1",
+                       "GetAll", "s", "org.freedesktop.network1.Manager", NULL);
+        if (r < 0)
+                return r;
+
+        r = call_async(bus, &c[CALL_RESOLVED], "org.freedesktop.resolve1", "/org/freedesktop/resolve1",
+                       "GetAll", "s", "org.freedesktop.resolve1.Manager", NULL);
+        if (r < 0)
+                return r;
+
+        while (calls.pending > 0) {
+                r = sd_bus_process(bus, NULL);
+                if (r < 0)
+                        return r;
+                if (r > 0)
+                        continue;
+
+                r = sd_bus_wait(bus, UINT64_MAX);
+                if (r < 0)
+                        return r;
+        }
+
+        if (calls.replies[CALL_HOSTNAMED])
+                (void) read_properties(calls.replies[CALL_HOSTNAMED], s->hostnamed, NULL);
+        if (calls.replies[CALL_NETWORKD])
+                (void) read_properties(calls.replies[CALL_NETWORKD], s->networkd, NULL);
+        if (calls.replies[CALL_RESOLVED])
+                (void) read_properties(calls.replies[CALL_RESOLVED], s->resolved, &s->current_dns_server);
+        if (calls.replies[CALL_MANAGER_VERSION])
+                (void) read_string_property(calls.replies[CALL_MANAGER_VERSION], "Version", s->manager);
+        if (calls.replies[CALL_MANAGER_ARCHITECTURE])
+                (void) read_string_property(calls.replies[CALL_MANAGER_ARCHITECTURE], "Architecture", s->manager);
+        if (calls.replies[CALL_MANAGER_VIRTUALIZATION])
+                (void) read_string_property(calls.replies[CALL_MANAGER_VIRTUALIZATION], "Virtualization", s->manager);
+
+        date = g_hash_table_lookup(s->hostnamed, "FirmwareDate");
+        if (date)
+                s->firmware_date = g_ascii_strtoull(date, NULL, 10);
+
+        *ret = steal_ptr(s);
+        return 0;
+}
@@ -12,6 +12,24 @@
 void sd_bus_free(sd_bus *bus);
 DEFINE_CLEANUP(sd_bus *, sd_bus_free);
 
+int dbus_acquire_system_bus(sd_bus **ret);
+void dbus_release_system_bus(void);
+
+/* Properties of hostnamed, the systemd manager, networkd and resolved as strings, keyed by property name */
+typedef struct DBusSystemStatus {
+        GHashTable *hostnamed;
+        GHashTable *manager;
+        GHashTable *networkd;
+        GHashTable *resolved;
+
+        uint64_t firmware_date;
+        DNSServer *current_dns_server;
+} DBusSystemStatus;
+
+int dbus_acquire_system_status(DBusSystemStatus **ret);
+void dbus_system_status_free(DBusSystemStatus *s);
+DEFINE_CLEANUP(DBusSystemStatus*, dbus_system_status_free);
+
 int dbus_get_string_systemd_manager(const char *p, char **ret);
 int dbus_get_property_from_hostnamed(const char *p, char **ret);
 int dbus_get_property_from_hostnamed_time(const char *p, uint64_t *ret);
@@ -31,7 +49,12 @@ int dbus_revert_resolve_link(int ifindex);
 int dbus_acquire_dns_domains_from_resolved(DNSDomains **domains);
 
 int dbus_describe_network(char **ret);
+int dbus_describe_link(int ifindex, char **ret);
+unsigned dbus_network_generation(void);
 int dbus_network_reload(void);
+int dbus_network_force_reload(void);
+void dbus_network_reload_defer(void);
+int dbus_network_reload_flush(void);
 int dbus_reconfigure_link(int ifindex);
 
 int dbus_get_system_property_from_networkd(const char *p, char **ret);
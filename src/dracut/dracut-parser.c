@@ -39,11 +39,7 @@ const char *dracut_dhcp_mode_to_name(int id) {
 int dracut_dhcp_mode_to_mode(const char *name) {
         assert(name);
 
-        for (size_t i = DRACUT_DHCP_MODE_NONE; i < (int) ELEMENTSOF(dracut_dhcp_mode_table); i++)
-                if (streq_fold(name, dracut_dhcp_mode_table[i]))
-                        return i;
-
-        return _DRACUT_DHCP_MODE_INVALID;
+        return string_table_lookup(dracut_dhcp_mode_table, ELEMENTSOF(dracut_dhcp_mode_table), name);
 }
 
 static const char *const dracut_to_networkd_dhcp_mode_table[_DRACUT_DHCP_MODE_MAX] = {
@@ -68,11 +64,7 @@ const char *dracut_to_networkd_dhcp_mode_to_name(int id) {
 int dracut_to_networkd_dhcp_name_to_mode(const char *name) {
         assert(name);
 
-        for (size_t i = DRACUT_DHCP_MODE_NONE; i < (int) ELEMENTSOF(dracut_to_networkd_dhcp_mode_table); i++)
-                if (streq_fold(name, dracut_to_networkd_dhcp_mode_table[i]))
-                        return i;
-
-        return _DRACUT_DHCP_MODE_INVALID;
+        return string_table_lookup(dracut_to_networkd_dhcp_mode_table, ELEMENTSOF(dracut_to_networkd_dhcp_mode_table), name);
 }
 
 static int parse_dhcp_type(const char *s, Network *n) {
@@ -124,7 +116,7 @@ static int dracut_parse_mac(char *mac, Network *n) {
 
         if (strv_length(s) > 0 && !isempty(s[0])) {
                 r = parse_address_from_str_and_add(s[0], n->addresses);
-                if (r < 0)
+                if (r < 0 && r != -EEXIST)
                         return r;
         }
 
@@ -151,18 +143,21 @@ static int dracut_parse_mac(char *mac, Network *n) {
 
                 route->gw = *ip;
                 route->family = ip->family;
-                if (!g_hash_table_insert(n->routes, GUINT_TO_POINTER(route), route))
-                        return -EINVAL;
         }
 
-        if (strv_length(s) >= 3 && !isempty(s[3])) {
+        if (route && strv_length(s) >= 3 && !isempty(s[3])) {
                 r = parse_ip_from_str(s[3], &prefix);
                  if (r >= 0)
                          route->gw.prefix_len = ipv4_netmask_to_prefixlen(prefix);
                  else
                          r = parse_int(s[3], &route->gw.prefix_len);
         }
-        steal_ptr(route);
+
+        /* Insert only once the key fields are final, the table hashes them */
+        if (route) {
+                g_hash_table_replace(n->routes, route, route);
+                steal_ptr(route);
+        }
 
         if (strv_length(s) >= 4 && !isempty(s[4])) {
                 n->hostname = g_strdup(s[4]);
@@ -188,13 +183,13 @@ static int dracut_parse_mac(char *mac, Network *n) {
         if (r < 0) {
                 if (strv_length(s) >= 7 && !isempty(s[7])) {
                         r = parse_address_from_str_and_add(s[7], n->nameservers);
-                        if (r < 0)
+                        if (r < 0 && r != -EEXIST)
                                 return r;
                 }
 
                 if (strv_length(s) >= 7 && !isempty(s[8])) {
                         r = parse_address_from_str_and_add(s[8], n->nameservers);
-                        if (r < 0)
+                        if (r < 0 && r != -EEXIST)
                                 return r;
                 }
         }
@@ -262,7 +257,7 @@ static int parse_command_line_nameserver(const char *line, Network *n) {
         assert(n);
 
         r = parse_address_from_str_and_add(line, n->nameservers);
-        if (r < 0) {
+        if (r < 0 && r != -EEXIST) {
                 log_warning("Failed to parse nameserver: %s", line);
                 return r;
         }
@@ -304,8 +299,7 @@ static int parse_command_line_rd_route(const char *line, Network *n) {
 
                 route->gw = *gw;
                 route->family = gw->family;
-                if (!g_hash_table_insert(n->routes, route, route))
-                        return -EINVAL;
+                g_hash_table_replace(n->routes, route, route);
 
                 steal_ptr(route);
        }
@@ -323,12 +317,8 @@ static int merge_network_routes(void *key, void *value, void *network) {
         Route *route = value;
         Network *n = network;
 
-        if (!g_hash_table_insert(n->routes, route, route)) {
-                log_warning("Failed to merge dracut routes: %s", n->ifname);
-                return -1;
-        }
-
-        return 0;
+        g_hash_table_replace(n->routes, route, route);
+        return true;
 }
 
 static int merge_network(GHashTable *networks_by_ifname, Network *n) {
@@ -375,6 +365,8 @@ int parse_proc_command_line(const char *cmd_line, GHashTable **ret) {
                 _auto_cleanup_ char *k = NULL, *v = NULL;
 
                 r = parse_line(*j, &k, &v);
+                if (r == -ENODATA) /* Runs of spaces */
+                        continue;
                 if (r < 0)
                         return r;
 
@@ -420,3 +412,33 @@ int parse_proc_command_line(const char *cmd_line, GHashTable **ret) {
         *ret = steal_ptr(networks);
         return 0;
 }
+
+/* Writes a .network file for each interface parse_proc_command_line() returned. The others are written when one
+ * fails, the first error is returned. Reloading networkd is up to the caller, the generator runs before it. */
+int dracut_generate_network_config(GHashTable *networks) {
+        GHashTableIter iter;
+        gpointer v;
+        int r = 0;
+
+        assert(networks);
+
+        g_hash_table_iter_init(&iter, networks);
+        while (g_hash_table_iter_next(&iter, NULL, &v)) {
+                Network *n = v;
+                int k;
+
+                if (!n->ifname) {
+                        log_debug("Ignoring network configuration without interface name");
+                        continue;
+                }
+
+                k = write_network_config(n);
+                if (k < 0) {
+                        log_warning("Failed to generate network configuration for '%s': %s", n->ifname, strerror(-k));
+                        if (r >= 0)
+                                r = k;
+                }
+        }
+
+        return r;
+}
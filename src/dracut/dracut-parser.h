@@ -40,3 +40,4 @@ const char *dracut_to_networkd_dhcp_mode_to_name(int id);
 int dracut_to_networkd_dhcp_name_to_mode(const char *name);
 
 int parse_proc_command_line(const char *cmdline, GHashTable **ret);
+int dracut_generate_network_config(GHashTable *networks);
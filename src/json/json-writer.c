@@ -0,0 +1,482 @@
+/* Copyright 2024 VMware, Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <endian.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc-util.h"
+#include "json-writer.h"
+#include "log.h"
+#include "macros.h"
+#include "string-util.h"
+
+#define JSON_WRITER_DEPTH_MAX 64
+
+/* RFC 8949 major types, simple values and the self-describe tag 55799 */
+enum {
+        CBOR_MAJOR_UINT   = 0,
+        CBOR_MAJOR_NEGINT = 1,
+        CBOR_MAJOR_TEXT   = 3,
+        CBOR_MAJOR_ARRAY  = 4,
+        CBOR_MAJOR_MAP    = 5,
+        CBOR_MAJOR_TAG    = 6,
+};
+
+#define CBOR_FALSE              0xf4
+#define CBOR_TRUE               0xf5
+#define CBOR_NULL               0xf6
+#define CBOR_DOUBLE             0xfb
+#define CBOR_INDEFINITE         0x1f
+#define CBOR_BREAK              0xff
+#define CBOR_TAG_SELF_DESCRIBE  55799
+
+struct JsonWriter {
+        FILE *f;
+        JsonWriterFormat format;
+
+        /* open_memstream() backing of json_writer_new_string() */
+        char *buf;
+        size_t size;
+        bool memstream;
+
+        unsigned depth;
+        bool empty[JSON_WRITER_DEPTH_MAX];
+        bool started;
+        int error;
+};
+
+static const char *const json_writer_format_table[_JSON_WRITER_FORMAT_MAX] = {
+        [JSON_WRITER_FORMAT_JSON] = "json",
+        [JSON_WRITER_FORMAT_CBOR] = "cbor",
+};
+
+const char *json_writer_format_to_name(int id) {
+        if (id < 0)
+                return NULL;
+
+        if ((size_t) id >= ELEMENTSOF(json_writer_format_table))
+                return NULL;
+
+        return json_writer_format_table[id];
+}
+
+int json_writer_name_to_format(const char *name) {
+        assert(name);
+
+        return string_table_lookup(json_writer_format_table, ELEMENTSOF(json_writer_format_table), name);
+}
+
+int json_writer_new(FILE *f, JsonWriterFormat format, JsonWriter **ret) {
+        JsonWriter *w;
+
+        assert(f);
+        assert(format >= 0 && format < _JSON_WRITER_FORMAT_MAX);
+        assert(ret);
+
+        w = new0(JsonWriter, 1);
+        if (!w)
+                return -ENOMEM;
+
+        w->f = f;
+        w->format = format;
+
+        *ret = w;
+        return 0;
+}
+
+int json_writer_new_string(JsonWriter **ret) {
+        _cleanup_(json_writer_freep) JsonWriter *w = NULL;
+
+        assert(ret);
+
+        w = new0(JsonWriter, 1);
+        if (!w)
+                return -ENOMEM;
+
+        w->f = open_memstream(&w->buf, &w->size);
+        if (!w->f)
+                return -errno;
+
+        w->memstream = true;
+
+        *ret = steal_ptr(w);
+        return 0;
+}
+
+void json_writer_free(JsonWriter *w) {
+        if (!w)
+                return;
+
+        if (w->memstream) {
+                if (w->f)
+                        fclose(w->f);
+                free(w->buf);
+        }
+
+        free(w);
+}
+
+int json_writer_finish(JsonWriter *w, char **ret) {
+        assert(w);
+
+        /* A producer bailed out half way */
+        if (w->error == 0 && w->depth > 0)
+                w->error = -EBADMSG;
+
+        if (w->error == 0) {
+                if (!w->memstream && w->format == JSON_WRITER_FORMAT_JSON)
+                        fputc('\n', w->f);
+
+                if (fflush(w->f) != 0 || ferror(w->f))
+                        w->error = -EIO;
+        }
+
+        if (w->error < 0)
+                return w->error;
+
+        if (w->memstream) {
+                fclose(steal_ptr(w->f));
+
+                if (ret)
+                        *ret = steal_ptr(w->buf);
+        }
+
+        return 0;
+}
+
+static void cbor_head(JsonWriter *w, uint8_t major, uint64_t v) {
+        uint8_t b[9];
+        size_t n;
+
+        if (v < 24) {
+                b[0] = major << 5 | v;
+                n = 1;
+        } else if (v <= UINT8_MAX) {
+                b[0] = major << 5 | 24;
+                b[1] = v;
+                n = 2;
+        } else if (v <= UINT16_MAX) {
+                uint16_t be = htobe16(v);
+
+                b[0] = major << 5 | 25;
+                memcpy(b + 1, &be, sizeof(be));
+                n = 3;
+        } else if (v <= UINT32_MAX) {
+                uint32_t be = htobe32(v);
+
+                b[0] = major << 5 | 26;
+                memcpy(b + 1, &be, sizeof(be));
+                n = 5;
+        } else {
+                uint64_t be = htobe64(v);
+
+                b[0] = major << 5 | 27;
+                memcpy(b + 1, &be, sizeof(be));
+                n = 9;
+        }
+
+        fwrite(b, 1, n, w->f);
+}
+
+static void cbor_text(JsonWriter *w, const char *s) {
+        size_t n = strlen(s);
+
+        cbor_head(w, CBOR_MAJOR_TEXT, n);
+        fwrite(s, 1, n, w->f);
+}
+
+static void cbor_int(JsonWriter *w, int64_t v) {
+        if (v >= 0)
+                cbor_head(w, CBOR_MAJOR_UINT, v);
+        else
+                cbor_head(w, CBOR_MAJOR_NEGINT, -1 - v);
+}
+
+static void json_writer_indent(JsonWriter *w) {
+        for (unsigned i = 0; i < w->depth; i++)
+                fputs("  ", w->f);
+}
+
+static void json_writer_escape(JsonWriter *w, const char *s) {
+        fputc('"', w->f);
+
+        for (const char *p = s; *p; p++) {
+                unsigned char c = *p;
+
+                switch (c) {
+                case '"':
+                        fputs("\\\"", w->f);
+                        break;
+                case '\\':
+                        fputs("\\\\", w->f);
+                        break;
+                case '\b':
+                        fputs("\\b", w->f);
+                        break;
+                case '\f':
+                        fputs("\\f", w->f);
+                        break;
+                case '\n':
+                        fputs("\\n", w->f);
+                        break;
+                case '\r':
+                        fputs("\\r", w->f);
+                        break;
+                case '\t':
+                        fputs("\\t", w->f);
+                        break;
+                default:
+                        if (c < 0x20)
+                                fprintf(w->f, "\\u%04x", c);
+                        else
+                                fputc(c, w->f);
+                }
+        }
+
+        fputc('"', w->f);
+}
+
+/* Separator, newline, indentation and member name in front of every value */
+static bool json_writer_prefix(JsonWriter *w, const char *key) {
+        if (w->error < 0)
+                return false;
+
+        if (w->format == JSON_WRITER_FORMAT_CBOR) {
+                if (!w->started)
+                        cbor_head(w, CBOR_MAJOR_TAG, CBOR_TAG_SELF_DESCRIBE);
+                w->started = true;
+
+                if (key)
+                        cbor_text(w, key);
+
+                return true;
+        }
+
+        if (w->depth > 0) {
+                if (!w->empty[w->depth - 1])
+                        fputc(',', w->f);
+                w->empty[w->depth - 1] = false;
+
+                fputc('\n', w->f);
+                json_writer_indent(w);
+        }
+
+        if (key) {
+                json_writer_escape(w, key);
+                fputs(": ", w->f);
+        }
+
+        return true;
+}
+
+static void json_writer_open(JsonWriter *w, const char *key, bool object) {
+        assert(w);
+
+        if (!json_writer_prefix(w, key))
+                return;
+
+        if (w->depth >= JSON_WRITER_DEPTH_MAX) {
+                w->error = -E2BIG;
+                return;
+        }
+
+        if (w->format == JSON_WRITER_FORMAT_CBOR)
+                fputc((object ? CBOR_MAJOR_MAP : CBOR_MAJOR_ARRAY) << 5 | CBOR_INDEFINITE, w->f);
+        else
+                fputc(object ? '{' : '[', w->f);
+
+        w->empty[w->depth++] = true;
+}
+
+static void json_writer_close(JsonWriter *w, bool object) {
+        assert(w);
+
+        if (w->error < 0)
+                return;
+
+        assert(w->depth > 0);
+
+        if (w->format == JSON_WRITER_FORMAT_CBOR) {
+                w->depth--;
+                fputc(CBOR_BREAK, w->f);
+                return;
+        }
+
+        if (w->empty[--w->depth])
+                fputc(' ', w->f);
+        else {
+                fputc('\n', w->f);
+                json_writer_indent(w);
+        }
+
+        fputc(object ? '}' : ']', w->f);
+}
+
+void json_writer_begin_object(JsonWriter *w, const char *key) {
+        json_writer_open(w, key, true);
+}
+
+void json_writer_end_object(JsonWriter *w) {
+        json_writer_close(w, true);
+}
+
+void json_writer_begin_array(JsonWriter *w, const char *key) {
+        json_writer_open(w, key, false);
+}
+
+void json_writer_end_array(JsonWriter *w) {
+        json_writer_close(w, false);
+}
+
+void json_writer_string(JsonWriter *w, const char *key, const char *v) {
+        assert(w);
+
+        if (!json_writer_prefix(w, key))
+                return;
+
+        if (w->format == JSON_WRITER_FORMAT_CBOR) {
+                if (v)
+                        cbor_text(w, v);
+                else
+                        fputc(CBOR_NULL, w->f);
+        } else if (v)
+                json_writer_escape(w, v);
+        else
+                fputs("null", w->f);
+}
+
+void json_writer_int(JsonWriter *w, const char *key, int64_t v) {
+        assert(w);
+
+        if (!json_writer_prefix(w, key))
+                return;
+
+        if (w->format == JSON_WRITER_FORMAT_CBOR)
+                cbor_int(w, v);
+        else
+                fprintf(w->f, "%" PRIi64, v);
+}
+
+void json_writer_bool(JsonWriter *w, const char *key, bool v) {
+        assert(w);
+
+        if (!json_writer_prefix(w, key))
+                return;
+
+        if (w->format == JSON_WRITER_FORMAT_CBOR)
+                fputc(v ? CBOR_TRUE : CBOR_FALSE, w->f);
+        else
+                fputs(v ? "true" : "false", w->f);
+}
+
+/* In CBOR "ScopeString" and friends are left out when the integer "Scope" is in the same object */
+static bool cbor_member_redundant(json_object *parent, const char *key) {
+        _auto_cleanup_ char *base = NULL;
+        size_t n;
+
+        if (!string_has_suffix(key, "String"))
+                return false;
+
+        n = strlen(key) - strlen("String");
+        if (n == 0)
+                return false;
+
+        base = strndup(key, n);
+        if (!base)
+                return false;
+
+        return json_object_object_get_ex(parent, base, NULL);
+}
+
+static void json_writer_cbor_value(JsonWriter *w, json_object *j) {
+        switch (json_object_get_type(j)) {
+        case json_type_null:
+                fputc(CBOR_NULL, w->f);
+                break;
+        case json_type_boolean:
+                fputc(json_object_get_boolean(j) ? CBOR_TRUE : CBOR_FALSE, w->f);
+                break;
+        case json_type_int:
+                cbor_int(w, json_object_get_int64(j));
+                break;
+        case json_type_double: {
+                double d = json_object_get_double(j);
+                uint64_t u, be;
+
+                memcpy(&u, &d, sizeof(u));
+                be = htobe64(u);
+
+                fputc(CBOR_DOUBLE, w->f);
+                fwrite(&be, 1, sizeof(be), w->f);
+                break;
+        }
+        case json_type_string:
+                cbor_text(w, json_object_get_string(j));
+                break;
+        case json_type_array:
+                fputc(CBOR_MAJOR_ARRAY << 5 | CBOR_INDEFINITE, w->f);
+                for (size_t i = 0; i < json_object_array_length(j); i++)
+                        json_writer_cbor_value(w, json_object_array_get_idx(j, i));
+                fputc(CBOR_BREAK, w->f);
+                break;
+        case json_type_object:
+                fputc(CBOR_MAJOR_MAP << 5 | CBOR_INDEFINITE, w->f);
+                json_object_object_foreach(j, k, v) {
+                        if (cbor_member_redundant(j, k))
+                                continue;
+
+                        cbor_text(w, k);
+                        json_writer_cbor_value(w, v);
+                }
+                fputc(CBOR_BREAK, w->f);
+                break;
+        }
+}
+
+/* Writes an already built tree as one value, JSON is re-indented to the current depth */
+void json_writer_json(JsonWriter *w, const char *key, json_object *j) {
+        const char *s;
+
+        assert(w);
+
+        if (!json_writer_prefix(w, key))
+                return;
+
+        if (w->format == JSON_WRITER_FORMAT_CBOR) {
+                json_writer_cbor_value(w, j);
+                return;
+        }
+
+        s = json_object_to_json_string_ext(j, JSON_C_TO_STRING_NOSLASHESCAPE | JSON_C_TO_STRING_SPACED | JSON_C_TO_STRING_PRETTY);
+        if (!s) {
+                w->error = -ENOMEM;
+                return;
+        }
+
+        /* Strings never contain a raw newline, so every newline is layout */
+        for (const char *p = s; *p; p++) {
+                fputc(*p, w->f);
+                if (*p == '\n')
+                        json_writer_indent(w);
+        }
+}
+
+/* Writes the members of 'j' into the object currently open, those 'filter' accepts when it is set */
+void json_writer_members(JsonWriter *w, json_object *j, bool (*filter)(const char *key)) {
+        assert(w);
+        assert(j);
+
+        json_object_object_foreach(j, k, v) {
+                if (filter && !filter(k))
+                        continue;
+
+                if (w->format == JSON_WRITER_FORMAT_CBOR && cbor_member_redundant(j, k))
+                        continue;
+
+                json_writer_json(w, k, v);
+        }
+}
@@ -0,0 +1,50 @@
+/* Copyright 2024 VMware, Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <json-c/json.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "alloc-util.h"
+
+/* Emits a document as it is produced. JSON is pretty printed in the layout json_object_to_json_string_ext()
+ * uses for JSON_C_TO_STRING_SPACED | JSON_C_TO_STRING_PRETTY | JSON_C_TO_STRING_NOSLASHESCAPE. CBOR (RFC 8949)
+ * has the same members, with containers of indefinite length so nothing needs to be counted up front, and
+ * without the "<Member>String" spelling of a member that is already there as an integer.
+ *
+ * 'key' is the member name inside objects and must be NULL inside arrays and at the top level. Write errors
+ * are sticky and reported by json_writer_finish(). */
+typedef struct JsonWriter JsonWriter;
+
+typedef enum JsonWriterFormat {
+        JSON_WRITER_FORMAT_JSON,
+        JSON_WRITER_FORMAT_CBOR,
+        _JSON_WRITER_FORMAT_MAX,
+        _JSON_WRITER_FORMAT_INVALID = -EINVAL,
+} JsonWriterFormat;
+
+const char *json_writer_format_to_name(int id);
+int json_writer_name_to_format(const char *name);
+
+int json_writer_new(FILE *f, JsonWriterFormat format, JsonWriter **ret);
+int json_writer_new_string(JsonWriter **ret);
+void json_writer_free(JsonWriter *w);
+DEFINE_CLEANUP(JsonWriter*, json_writer_free);
+
+int json_writer_finish(JsonWriter *w, char **ret);
+
+void json_writer_begin_object(JsonWriter *w, const char *key);
+void json_writer_end_object(JsonWriter *w);
+void json_writer_begin_array(JsonWriter *w, const char *key);
+void json_writer_end_array(JsonWriter *w);
+
+void json_writer_string(JsonWriter *w, const char *key, const char *v);
+void json_writer_int(JsonWriter *w, const char *key, int64_t v);
+void json_writer_bool(JsonWriter *w, const char *key, bool v);
+
+void json_writer_json(JsonWriter *w, const char *key, json_object *j);
+void json_writer_members(JsonWriter *w, json_object *j, bool (*filter)(const char *key));
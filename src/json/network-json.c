@@ -10,10 +10,12 @@
 #include "ansi-color.h"
 #include "arphrd-to-name.h"
 #include "ctl.h"
+#include "ctl-display.h"
 #include "config-parser.h"
 #include "dbus.h"
 #include "device.h"
 #include "dns.h"
+#include "json-writer.h"
 #include "log.h"
 #include "macros.h"
 #include "network-address.h"
@@ -30,7 +32,7 @@
 static void json_fill_routing_policy_rules(gpointer key, gpointer value, gpointer userdata) {
         _cleanup_(json_object_putp) json_object *jd = NULL, *jrule = NULL, *config_source = NULL;
         _auto_cleanup_ char *from = NULL, *to = NULL, *table = NULL;
-        json_object *jobj = (json_object *) userdata;
+        JsonWriter *w = (JsonWriter *) userdata;
         RoutingPolicyRule *rule;
         size_t size;
         int r;
@@ -285,404 +287,184 @@ static void json_fill_routing_policy_rules(gpointer key, gpointer value, gpointe
         json_object_object_add(jrule, "ConfigSource", config_source);
         steal_ptr(config_source);
 
-        json_object_array_add(jobj, jrule);
-        steal_ptr(jrule);
+        json_writer_json(w, NULL, jrule);
+}
+
+/* Prints 'j' to stdout in the format selected with --output= */
+int json_print_object(json_object *j) {
+        _cleanup_(json_writer_freep) JsonWriter *w = NULL;
+        int r;
+
+        assert(j);
+
+        r = json_writer_new(stdout, output_format(), &w);
+        if (r < 0)
+                return log_oom();
+
+        json_writer_json(w, NULL, j);
+        return json_writer_finish(w, NULL);
 }
 
 int json_fill_system_status(char **ret) {
-        _cleanup_(json_object_putp) json_object *jobj = NULL, *jn = NULL;
-        _auto_cleanup_ char *state = NULL, *carrier_state = NULL, *hostname = NULL, *kernel = NULL,
-                *kernel_release = NULL, *arch = NULL, *virt = NULL, *os = NULL, *systemd = NULL,
-                *online_state = NULL, *address_state = NULL, *ipv4_address_state = NULL,
-                *ipv6_address_state = NULL, *hwvendor = NULL, *hwmodel = NULL, *firmware = NULL,
-                *firmware_vendor = NULL;
-        _auto_cleanup_ char *mdns = NULL, *llmnr = NULL, *dns_over_tls = NULL, *conf_mode = NULL;
+        _cleanup_(dbus_system_status_freep) DBusSystemStatus *status = NULL;
         _cleanup_(routing_policy_rules_freep) RoutingPolicyRules *rules = NULL;
+        _cleanup_(json_writer_freep) JsonWriter *w = NULL;
         _cleanup_(links_freep) Links *links = NULL;
-        _auto_cleanup_ DNSServer *c = NULL;
+        _auto_cleanup_hash_ GHashTable *devices = NULL;
+        static const struct {
+                const char *key;
+                const char *property;
+                bool manager;
+        } system_properties[] = {
+                { "SystemName",                "StaticHostname"                   },
+                { "KernelName",                "KernelName"                       },
+                { "KernelRelease",             "KernelRelease"                    },
+                { "SystemdVersion",            "Version",                   true  },
+                { "Architecture",              "Architecture",              true  },
+                { "Virtualization",            "Virtualization",            true  },
+                { "OperatingSystemPrettyName", "OperatingSystemPrettyName"        },
+                { "HardwareVendor",            "HardwareVendor"                   },
+                { "HardwareModel",             "HardwareModel"                    },
+                { "FirmwareVersion",           "FirmwareVersion"                  },
+                { "FirmwareVendor",            "FirmwareVendor"                   },
+        };
+        static const char *const network_properties[] = {
+                "OperationalState",
+                "CarrierState",
+                "OnlineState",
+                "AddressState",
+                "IPv4AddressState",
+                "IPv6AddressState",
+        };
+        const char *mdns, *llmnr, *dns_over_tls, *conf_mode;
         sd_id128_t machine_id = {};
         sd_id128_t boot_id = {};
-        usec_t firmware_date;
+        DNSServer *c;
         int r;
 
-        r = json_acquire_and_parse_network_data(&jn);
+        r = dbus_acquire_system_status(&status);
         if (r < 0) {
-                log_warning("Failed acquire network data: %s", strerror(-r));
+                log_warning("Failed to acquire system status: %s", strerror(-r));
                 return r;
         }
 
-        jobj = json_object_new_object();
-        if (!jobj)
+        r = ret ? json_writer_new_string(&w) : json_writer_new(stdout, output_format(), &w);
+        if (r < 0)
                 return log_oom();
 
-        r = dbus_get_property_from_hostnamed("StaticHostname", &hostname);
-        if (r >=0 && hostname) {
-                _cleanup_(json_object_putp) json_object *js = NULL;
-
-                js = json_object_new_string(hostname);
-                if (!js)
-                        return log_oom();
-
-                json_object_object_add(jobj, "SystemName", js);
-                steal_ptr(js);
-        }
-
-        r = dbus_get_property_from_hostnamed("KernelName", &kernel);
-        if (r >=0 && kernel) {
-                _cleanup_(json_object_putp) json_object *js = NULL;
-
-                js = json_object_new_string(kernel);
-                if (!js)
-                        return log_oom();
-
-                json_object_object_add(jobj,"KernelName", js);
-                steal_ptr(js);
-        }
-
-        r = dbus_get_property_from_hostnamed("KernelRelease", &kernel_release);
-        if (r >=0 && kernel_release) {
-                _cleanup_(json_object_putp) json_object *js = NULL;
-
-                js = json_object_new_string(kernel_release);
-                if (!js)
-                        return log_oom();
-
-                json_object_object_add(jobj,"KernelRelease", js);
-                steal_ptr(js);
-        }
-
-        r = dbus_get_string_systemd_manager("Version", &systemd);
-        if (r >=0 && systemd) {
-                _cleanup_(json_object_putp) json_object *js = NULL;
-
-                js = json_object_new_string(systemd);
-                if (!js)
-                        return log_oom();
-
-                json_object_object_add(jobj, "SystemdVersion", js);
-                steal_ptr(js);
-        }
-
-        r = dbus_get_string_systemd_manager("Architecture", &arch);
-        if (r >=0 && arch) {
-                _cleanup_(json_object_putp) json_object *js = NULL;
-
-                js = json_object_new_string(arch);
-                if (!js)
-                        return log_oom();
-
-                json_object_object_add(jobj, "Architecture", js);
-                steal_ptr(js);
-        }
+        json_writer_begin_object(w, NULL);
 
-        r = dbus_get_string_systemd_manager("Virtualization", &virt);
-        if (r >=0 && virt) {
-                _cleanup_(json_object_putp) json_object *js = NULL;
+        for (size_t i = 0; i < ELEMENTSOF(system_properties); i++) {
+                const char *v;
 
-                js = json_object_new_string(virt);
-                if (!js)
-                        return log_oom();
-
-                json_object_object_add(jobj, "Virtualization", js);
-                steal_ptr(js);
-        }
-
-        r = dbus_get_property_from_hostnamed("OperatingSystemPrettyName", &os);
-        if (r >=0 && os) {
-                _cleanup_(json_object_putp) json_object *js = NULL;
-
-                js = json_object_new_string(os);
-                if (!js)
-                        return log_oom();
-
-                json_object_object_add(jobj, "OperatingSystemPrettyName", js);
-                steal_ptr(js);
-        }
-
-        r = dbus_get_property_from_hostnamed("HardwareVendor", &hwvendor);
-        if (r >= 0 && hwvendor) {
-                _cleanup_(json_object_putp) json_object *js = NULL;
-
-                js = json_object_new_string(hwvendor);
-                if (!js)
-                        return log_oom();
-
-                json_object_object_add(jobj, "HardwareVendor", js);
-                steal_ptr(js);
-        }
-
-        r = dbus_get_property_from_hostnamed("HardwareModel", &hwmodel);
-        if (r >= 0 && hwmodel) {
-                _cleanup_(json_object_putp) json_object *js = NULL;
-
-                js = json_object_new_string(hwmodel);
-                if (!js)
-                        return log_oom();
-
-                json_object_object_add(jobj, "HardwareModel", js);
-                steal_ptr(js);
-        }
-
-        r = dbus_get_property_from_hostnamed("FirmwareVersion", &firmware);
-        if (r >= 0 && firmware) {
-                _cleanup_(json_object_putp) json_object *js = NULL;
-
-                js = json_object_new_string(firmware);
-                if (!js)
-                        return log_oom();
-
-                json_object_object_add(jobj, "FirmwareVersion", js);
-                steal_ptr(js);
-        }
-
-        r = dbus_get_property_from_hostnamed("FirmwareVendor", &firmware_vendor);
-        if (r >= 0 && firmware_vendor) {
-                _cleanup_(json_object_putp) json_object *js = NULL;
-
-                js = json_object_new_string(firmware_vendor);
-                if (!js)
-                        return log_oom();
-
-                json_object_object_add(jobj, "FirmwareVendor", js);
-                steal_ptr(js);
-        }
-
-        r = dbus_get_property_from_hostnamed_time("FirmwareDate", &firmware_date);
-        if (r >= 0 && firmware_date) {
-                _cleanup_(json_object_putp) json_object *js = NULL;
-                time_t now = firmware_date / USEC_PER_SEC;
-
-                js = json_object_new_string(rstrip(ctime(&now)));
-                if (!js)
-                        return log_oom();
+                if (!field_enabled(system_properties[i].key))
+                        continue;
 
-                json_object_object_add(jobj, "FirmwareDate", js);
-                steal_ptr(js);
+                v = g_hash_table_lookup(system_properties[i].manager ? status->manager : status->hostnamed, system_properties[i].property);
+                if (v)
+                        json_writer_string(w, system_properties[i].key, v);
         }
 
-        r = sd_id128_get_boot(&boot_id);
-        if (r >= 0) {
-                _cleanup_(json_object_putp) json_object *js = NULL;
-                _auto_cleanup_ char *p = NULL;
-
-                p = new(char, SD_ID128_STRING_MAX);
-                if (!p)
-                        return log_oom();
-
-                js = json_object_new_string(sd_id128_to_string(boot_id, p));
-                if (!js)
-                        return log_oom();
+        if (status->firmware_date && field_enabled("FirmwareDate")) {
+                time_t now = status->firmware_date / USEC_PER_SEC;
 
-                json_object_object_add(jobj, "BootID", js);
-                steal_ptr(js);
+                json_writer_string(w, "FirmwareDate", rstrip(ctime(&now)));
         }
 
-        r = sd_id128_get_machine(&machine_id);
+        r = field_enabled("BootID") ? sd_id128_get_boot(&boot_id) : -ENODATA;
         if (r >= 0) {
-                _cleanup_(json_object_putp) json_object *js = NULL;
                 char ids[SD_ID128_STRING_MAX];
 
-                sd_id128_to_string(machine_id, ids);
-
-                js = json_object_new_string(ids);
-                if (!js)
-                        return log_oom();
-
-                json_object_object_add(jobj, "MachineID", js);
-                steal_ptr(js);
-        }
-
-        r = dbus_get_system_property_from_networkd("OperationalState", &state);
-        if (r >= 0) {
-                _cleanup_(json_object_putp) json_object *js = NULL;
-
-                js = json_object_new_string(state);
-                if (!js)
-                        return log_oom();
-
-                json_object_object_add(jobj, "OperationalState", js);
-                steal_ptr(js);
-        }
-
-        r = dbus_get_system_property_from_networkd("CarrierState", &carrier_state);
-        if (r >= 0) {
-                _cleanup_(json_object_putp) json_object *js = NULL;
-
-                js = json_object_new_string(carrier_state);
-                if (!js)
-                        return log_oom();
-
-                json_object_object_add(jobj, "CarrierState", js);
-                steal_ptr(js);
-        }
-
-        r = dbus_get_system_property_from_networkd("OnlineState", &online_state);
-        if (r >= 0) {
-                _cleanup_(json_object_putp) json_object *js = NULL;
-
-                js = json_object_new_string(online_state);
-                if (!js)
-                        return log_oom();
-
-                json_object_object_add(jobj, "OnlineState", js);
-                steal_ptr(js);
-        }
-
-        r = dbus_get_system_property_from_networkd("AddressState", &address_state);
-        if (r >= 0) {
-                _cleanup_(json_object_putp) json_object *js = NULL;
-
-                js = json_object_new_string(address_state);
-                if (!js)
-                        return log_oom();
-
-                json_object_object_add(jobj, "AddressState", js);
-                steal_ptr(js);
+                json_writer_string(w, "BootID", sd_id128_to_string(boot_id, ids));
         }
 
-        r = dbus_get_system_property_from_networkd("IPv4AddressState", &ipv4_address_state);
+        r = field_enabled("MachineID") ? sd_id128_get_machine(&machine_id) : -ENODATA;
         if (r >= 0) {
-                _cleanup_(json_object_putp) json_object *js = NULL;
-
-                js = json_object_new_string(ipv4_address_state);
-                if (!js)
-                        return log_oom();
+                char ids[SD_ID128_STRING_MAX];
 
-                json_object_object_add(jobj, "IPv4AddressState", js);
-                steal_ptr(js);
+                json_writer_string(w, "MachineID", sd_id128_to_string(machine_id, ids));
         }
 
-        r = dbus_get_system_property_from_networkd("IPv6AddressState", &ipv6_address_state);
-        if (r >= 0) {
-                _cleanup_(json_object_putp) json_object *js = NULL;
+        for (size_t i = 0; i < ELEMENTSOF(network_properties); i++) {
+                const char *v;
 
-                js = json_object_new_string(ipv6_address_state);
-                if (!js)
-                        return log_oom();
+                if (!field_enabled(network_properties[i]))
+                        continue;
 
-                json_object_object_add(jobj, "IPv6AddressState", js);
-                steal_ptr(js);
+                v = g_hash_table_lookup(status->networkd, network_properties[i]);
+                if (v)
+                        json_writer_string(w, network_properties[i], v);
         }
 
+        /* Each link is written out as soon as it is gathered, only one of them is held at a time. That includes
+         * networkd's description, which is asked for one link at a time. The array is always there, --fields=
+         * selects what is shown of each link. */
         r = netlink_acquire_all_links(&links);
         if (r >= 0) {
-                _cleanup_(json_object_putp) json_object *ja = NULL;
+                if (link_fields_need_device())
+                        (void) net_devices_enumerate(&devices);
 
-                ja = json_object_new_array();
-                if (!ja)
-                        return log_oom();
+                json_writer_begin_array(w, "Interfaces");
 
                 for (GList *i = links->links; i; i = g_list_next (i)) {
-                        _cleanup_(json_object_putp) json_object *js = NULL;
+                        _cleanup_(json_object_putp) json_object *jn = NULL;
                         _auto_cleanup_ IfNameIndex *p = NULL;
                         Link *link = (Link *) i->data;
 
                         r = parse_ifname_or_index(link->name, &p);
-                        if (r >= 0) {
-                                r = json_fill_one_link(p, false, jn, &js);
-                                if (r >= 0) {
-                                        json_object_array_add(ja, js);
-                                        steal_ptr(js);
-                                }
+                        if (r < 0)
+                                continue;
+
+                        if (link_fields_need_network_data()) {
+                                r = json_acquire_and_parse_link_data(p->ifindex, &jn);
+                                if (r < 0)
+                                        log_debug("Failed to acquire network data of '%s': %s", p->ifname, strerror(-r));
                         }
+
+                        (void) json_fill_one_link(p, false, jn, devices, w);
                 }
 
-                json_object_object_add(jobj, "Interfaces", ja);
-                steal_ptr(ja);
+                json_writer_end_array(w);
         }
 
-        r = dbus_get_current_dns_server_from_resolved(&c);
-        if (r >= 0 && c) {
+        c = status->current_dns_server;
+        if (c && field_enabled("CurrentDNSServer")) {
                 _auto_cleanup_ char *pretty = NULL;
 
-                r =ip_to_str(c->address.family, &c->address, &pretty);
-                if (r >= 0) {
-                        _cleanup_(json_object_putp) json_object *jd = NULL;
-
-                        jd = json_object_new_string(pretty);
-                        if (!jd)
-                                return log_oom();
-
-                        json_object_object_add(jobj, "CurrentDNSServer", jd);
-                        steal_ptr(jd);
-                        steal_ptr(pretty);
-                }
+                r = ip_to_str(c->address.family, &c->address, &pretty);
+                if (r >= 0)
+                        json_writer_string(w, "CurrentDNSServer", pretty);
         }
 
-        (void) dbus_acqure_dns_setting_from_resolved("MulticastDNS", &mdns);
-        (void) dbus_acqure_dns_setting_from_resolved("LLMNR", &llmnr);
-        (void) dbus_acqure_dns_setting_from_resolved("DNSOverTLS", &dns_over_tls);
-        (void) dbus_acqure_dns_setting_from_resolved("ResolvConfMode", &conf_mode);
-
-        if (mdns || llmnr || conf_mode || dns_over_tls) {
-                _cleanup_(json_object_putp) json_object *j = NULL, *js = NULL;
-
-
-                j = json_object_new_object();
-                if (!j)
-                        return log_oom();
-
-                js = json_object_new_string(str_na(mdns));
-                if (!js)
-                        return log_oom();
-
-                json_object_object_add(j, "MDNS", js);
-                steal_ptr(js);
-
-                js = json_object_new_string(str_na(llmnr));
-                if (!js)
-                        return log_oom();
-
-                json_object_object_add(j, "LLMNR", js);
-                steal_ptr(js);
-
-                js = json_object_new_string(str_na(dns_over_tls));
-                if (!js)
-                        return log_oom();
-
-                json_object_object_add(j, "DNSOverTLS", js);
-                steal_ptr(js);
-
-                js = json_object_new_string(str_na(conf_mode));
-                if (!js)
-                        return log_oom();
-
-                json_object_object_add(j, "ResolvConfMode", js);
-                steal_ptr(js);
-
-                json_object_object_add(jobj, "DNSSettings", j);
-                steal_ptr(j);
+        mdns = g_hash_table_lookup(status->resolved, "MulticastDNS");
+        llmnr = g_hash_table_lookup(status->resolved, "LLMNR");
+        dns_over_tls = g_hash_table_lookup(status->resolved, "DNSOverTLS");
+        conf_mode = g_hash_table_lookup(status->resolved, "ResolvConfMode");
+
+        if ((mdns || llmnr || conf_mode || dns_over_tls) && field_enabled("DNSSettings")) {
+                json_writer_begin_object(w, "DNSSettings");
+                json_writer_string(w, "MDNS", str_na(mdns));
+                json_writer_string(w, "LLMNR", str_na(llmnr));
+                json_writer_string(w, "DNSOverTLS", str_na(dns_over_tls));
+                json_writer_string(w, "ResolvConfMode", str_na(conf_mode));
+                json_writer_end_object(w);
         }
 
-        r = acquire_routing_policy_rules(&rules);
+        r = field_enabled("RoutingPolicyRules") ? acquire_routing_policy_rules(&rules) : -ENODATA;
         if (r >= 0 && set_size(rules->routing_policy_rules) > 0) {
-                _cleanup_(json_object_putp) json_object *jrules = NULL;
-
-                jrules = json_object_new_array();
-                if (!jrules)
-                        return log_oom();
-
-                set_foreach(rules->routing_policy_rules, json_fill_routing_policy_rules, jrules);
-                json_object_object_add(jobj, "RoutingPolicyRules", jrules);
-                steal_ptr(jrules);
+                json_writer_begin_array(w, "RoutingPolicyRules");
+                set_foreach(rules->routing_policy_rules, json_fill_routing_policy_rules, w);
+                json_writer_end_array(w);
         }
 
-        if (ret) {
-                char *s;
+        json_writer_end_object(w);
 
-                s = strdup(json_object_to_json_string_ext(jobj, JSON_C_TO_STRING_NOSLASHESCAPE | JSON_C_TO_STRING_SPACED | JSON_C_TO_STRING_PRETTY));
-                if (!s)
-                        return log_oom();
-
-                *ret = steal_ptr(s);
-        } else
-                printf("%s\n", json_object_to_json_string_ext(jobj, JSON_C_TO_STRING_NOSLASHESCAPE | JSON_C_TO_STRING_SPACED | JSON_C_TO_STRING_PRETTY));
-
-        return r;
+        return json_writer_finish(w, ret);
 }
 
 int json_fill_dns_server(const IfNameIndex *p, int ifindex, json_object *jn) {
-        _cleanup_(json_object_putp) json_object *jobj = NULL, *jdns = NULL;
+        _cleanup_(json_object_putp) json_object *jdns = NULL;
+        _cleanup_(json_writer_freep) JsonWriter *w = NULL;
         int r;
 
         assert(jn);
@@ -694,15 +476,15 @@ int json_fill_dns_server(const IfNameIndex *p, int ifindex, json_object *jn) {
         if (!jdns)
                 return -ENOENT;
 
-        jobj = json_object_new_object();
-        if (!jobj)
+        r = json_writer_new(stdout, output_format(), &w);
+        if (r < 0)
                 return log_oom();
 
-        json_object_object_add(jobj, "DNS", jdns);
-        steal_ptr(jdns);
+        json_writer_begin_object(w, NULL);
+        json_writer_json(w, "DNS", jdns);
+        json_writer_end_object(w);
 
-        printf("%s\n", json_object_to_json_string_ext(jobj, JSON_C_TO_STRING_NOSLASHESCAPE | JSON_C_TO_STRING_SPACED | JSON_C_TO_STRING_PRETTY));
-        return 0;
+        return json_writer_finish(w, NULL);
 }
 
 int json_build_dns_server(const IfNameIndex *p, char **dns_config) {
@@ -802,8 +584,7 @@ int json_build_dns_server(const IfNameIndex *p, char **dns_config) {
         json_object_object_add(jobj, "DNS", jdns);
         steal_ptr(jdns);
 
-        printf("%s\n", json_object_to_json_string_ext(jobj, JSON_C_TO_STRING_NOSLASHESCAPE | JSON_C_TO_STRING_SPACED | JSON_C_TO_STRING_PRETTY));
-        return 0;
+        return json_print_object(jobj);
 }
 
 static int json_parse_dns_search_domains(const json_object *jn, const char *link, json_object **ret) {
@@ -860,8 +641,7 @@ int json_fill_dns_server_domains(IfNameIndex *p, json_object *jn) {
                         if (r >= 0) {
                                 json_object_object_add(jobj, "SearchDomains", jd);
 
-                                printf("%s\n", json_object_to_json_string_ext(jobj, JSON_C_TO_STRING_NOSLASHESCAPE | JSON_C_TO_STRING_SPACED | JSON_C_TO_STRING_PRETTY));
-                                return 0;
+                                return json_print_object(jobj);
                         }
                 } else {
                         _cleanup_(json_object_putp) json_object *ja = NULL;
@@ -895,8 +675,7 @@ int json_fill_dns_server_domains(IfNameIndex *p, json_object *jn) {
                                 json_object_object_add(jobj, "SearchDomains", ja);
                                 steal_ptr(ja);
 
-                                printf("%s\n", json_object_to_json_string_ext(jobj, JSON_C_TO_STRING_NOSLASHESCAPE | JSON_C_TO_STRING_SPACED | JSON_C_TO_STRING_PRETTY));
-                                return 0;
+                                return json_print_object(jobj);
                         }
                 }
         }
@@ -943,9 +722,7 @@ int json_fill_dns_server_domains(IfNameIndex *p, json_object *jn) {
                 json_object_object_add(jobj, "SearchDomains", jdomains);
                 steal_ptr(jdomains);
 
-                printf("%s\n", json_object_to_json_string_ext(jobj, JSON_C_TO_STRING_NOSLASHESCAPE | JSON_C_TO_STRING_SPACED | JSON_C_TO_STRING_PRETTY));
-
-                return 0;
+                return json_print_object(jobj);
         }
 
         for (GList *iter = links->links; iter; iter = g_list_next (iter)) {
@@ -991,8 +768,7 @@ int json_fill_dns_server_domains(IfNameIndex *p, json_object *jn) {
         json_object_object_add(j, "SearchDomains", jobj);
         steal_ptr(jobj);
 
-        printf("%s\n", json_object_to_json_string_ext(j, JSON_C_TO_STRING_NOSLASHESCAPE | JSON_C_TO_STRING_SPACED | JSON_C_TO_STRING_PRETTY));
-        return 0;
+        return json_print_object(j);
 }
 
 int json_acquire_dns_mode(DHCPClient mode, bool dhcpv4, bool dhcpv6, bool static_dns) {
@@ -1017,8 +793,7 @@ int json_acquire_dns_mode(DHCPClient mode, bool dhcpv4, bool dhcpv6, bool static
         json_object_object_add(jobj, "DNSMode", s);
         steal_ptr(s);
 
-        printf("%s\n", json_object_to_json_string_ext(jobj, JSON_C_TO_STRING_NOSLASHESCAPE | JSON_C_TO_STRING_SPACED | JSON_C_TO_STRING_PRETTY));
-        return 0;
+        return json_print_object(jobj);
 }
 
 int json_acquire_dhcp_mode(DHCPClient mode) {
@@ -1034,19 +809,20 @@ int json_acquire_dhcp_mode(DHCPClient mode) {
         json_object_object_add(jobj, "DHCPMode", s);
         steal_ptr(s);
 
-        printf("%s\n", json_object_to_json_string_ext(jobj, JSON_C_TO_STRING_NOSLASHESCAPE | JSON_C_TO_STRING_SPACED | JSON_C_TO_STRING_PRETTY));
-        return 0;
+        return json_print_object(jobj);
 }
 
 int json_build_ntp_server(const IfNameIndex *p, json_object **ret) {
-        _auto_cleanup_strv_ char **dhcp_ntp = NULL, **link_ntp = NULL, **ntp = NULL;
+        _cleanup_(link_state_snapshot_freep) LinkStateSnapshot *state = NULL;
         _cleanup_(json_object_putp) json_object *jntp = NULL;
+        _auto_cleanup_strv_ char **ntp = NULL;
+        char **dhcp_ntp = NULL, **link_ntp = NULL;
         char **n;
         int r;
 
-        if (p) {
-                (void) network_parse_link_dhcp4_ntp(p->ifindex, &dhcp_ntp);
-                (void) network_parse_link_ntp(p->ifindex, &link_ntp);
+        if (p && link_state_snapshot_new(p->ifindex, &state) >= 0) {
+                dhcp_ntp = link_state_snapshot_dhcp4_ntp(state);
+                link_ntp = link_state_snapshot_ntp(state);
         }
 
         r = network_parse_ntp(&ntp);
@@ -1087,7 +863,7 @@ int json_build_ntp_server(const IfNameIndex *p, json_object **ret) {
 
                 if (ntp && strv_length(ntp) && (dhcp_ntp && strv_contains((const char **) dhcp_ntp, *n))) {
                         _cleanup_(json_object_putp) json_object *js = NULL;
-                        _auto_cleanup_ char *provider = NULL;
+                        const char *provider;
 
                         js = json_object_new_string("DHCPv4");
                         if (!js)
@@ -1096,15 +872,14 @@ int json_build_ntp_server(const IfNameIndex *p, json_object **ret) {
                         json_object_object_add(jaddr, "ConfigSource", js);
                         steal_ptr(js);
 
-                        r = network_parse_link_dhcp4_server_address(p->ifindex, &provider);
-                        if (r >= 0) {
+                        provider = link_state_snapshot_dhcp4_server_address(state);
+                        if (provider) {
                                 js = json_object_new_string(provider);
                                 if (!js)
                                         return log_oom();
 
                                 json_object_object_add(jaddr, "ConfigProvider", js);
                                 steal_ptr(js);
-                                steal_ptr(provider);
                         }
                 } else  {
                         _cleanup_(json_object_putp) json_object *js = NULL;
@@ -1398,64 +1173,56 @@ int json_parse_address_config_source(const json_object *jobj,
                                      char **ret_config_source,
                                      char **ret_config_provider,
                                      char **ret_config_state) {
-        json_object *interfaces = NULL;
+        json_object *interface, *addresses = NULL;
         int r;
 
         assert(jobj);
         assert(link);
         assert(address);
 
-        if (!json_object_object_get_ex(jobj, "Interfaces", &interfaces))
+        interface = json_network_data_get_interface(jobj, link);
+        if (!interface)
                 return -ENOENT;
 
-        for (size_t i = 0; i < json_object_array_length(interfaces); i++){
-                json_object *interface = json_object_array_get_idx(interfaces, i);
-                json_object *name;
+        if (!json_object_object_get_ex(interface, "Addresses", &addresses))
+                return -ENOENT;
 
-                if (json_object_object_get_ex(interface, "Name", &name) && streq(json_object_get_string(name), link)) {
-                        json_object *addresses = NULL;
+        for (size_t i = 0; i < json_object_array_length(addresses); i++) {
+                json_object *config_source = NULL, *config_provider = NULL, *config_state = NULL, *a = NULL, *prefix = NULL, *family = NULL;
+                json_object *addr = json_object_array_get_idx(addresses, i);
 
-                        if (!json_object_object_get_ex(interface, "Addresses", &addresses))
-                                continue;
+                if (json_object_object_get_ex(addr, "Address", &a) && json_object_object_get_ex(addr, "PrefixLength", &prefix) &&
+                    json_object_object_get_ex(addr, "Family", &family)) {
+                        _auto_cleanup_ char *ip = NULL, *provider = NULL;
 
-                        for (size_t j = 0; j < json_object_array_length(addresses); j++){
-                                json_object *config_source = NULL, *config_provider = NULL, *config_state = NULL, *a = NULL, *prefix = NULL, *family = NULL;
-                                json_object *addr = json_object_array_get_idx(addresses, j);
+                        r = json_array_to_ip(a, json_object_get_int(family), json_object_get_int(prefix), &ip);
+                        if (r < 0)
+                                continue;
 
-                                if (json_object_object_get_ex(addr, "Address", &a) && json_object_object_get_ex(addr, "PrefixLength", &prefix) &&
-                                    json_object_object_get_ex(addr, "Family", &family)) {
-                                        _auto_cleanup_ char *ip = NULL, *provider = NULL;
+                        if (streq(address, ip)) {
+                                if (json_object_object_get_ex(addr, "ConfigSource", &config_source)) {
+                                        *ret_config_source = strdup(json_object_get_string(config_source));
+                                        if (!*ret_config_source)
+                                                return -ENOMEM;
+                                }
 
-                                        r = json_array_to_ip(a, json_object_get_int(family), json_object_get_int(prefix), &ip);
+                                if (json_object_object_get_ex(addr, "ConfigProvider", &config_provider)) {
+                                        r = json_array_to_ip(config_provider, json_object_get_int(family), -1, &provider);
                                         if (r < 0)
-                                                continue;
+                                                return r;
 
-                                        if (streq(address, ip)) {
-                                                if (json_object_object_get_ex(addr, "ConfigSource", &config_source)) {
-                                                        *ret_config_source = strdup(json_object_get_string(config_source));
-                                                        if (!*ret_config_source)
-                                                                return -ENOMEM;
-                                                }
-
-                                                if (json_object_object_get_ex(addr, "ConfigProvider", &config_provider)) {
-                                                        r = json_array_to_ip(config_provider, json_object_get_int(family), -1, &provider);
-                                                        if (r < 0)
-                                                                return r;
-
-                                                        *ret_config_provider = strdup(provider);
-                                                        if (!*ret_config_provider)
-                                                                return -ENOMEM;
-                                                }
-
-                                                if (json_object_object_get_ex(addr, "ConfigState", &config_state)) {
-                                                        *ret_config_state = strdup(json_object_get_string(config_state));
-                                                        if (!*ret_config_state)
-                                                                return -ENOMEM;
-                                                }
-
-                                                return 0;
-                                        }
+                                        *ret_config_provider = strdup(provider);
+                                        if (!*ret_config_provider)
+                                                return -ENOMEM;
                                 }
+
+                                if (json_object_object_get_ex(addr, "ConfigState", &config_state)) {
+                                        *ret_config_state = strdup(json_object_get_string(config_state));
+                                        if (!*ret_config_state)
+                                                return -ENOMEM;
+                                }
+
+                                return 0;
                         }
                 }
         }
@@ -1470,63 +1237,54 @@ int json_parse_route_config_source(const json_object *jobj,
                                    char **ret_config_source,
                                    char **ret_config_provider,
                                    char **ret_config_state) {
-        json_object *interfaces = NULL;
+        json_object *interface, *routes = NULL;
         int r;
 
         assert(jobj);
+        assert(link);
         assert(address);
 
-        if (!json_object_object_get_ex(jobj, "Interfaces", &interfaces))
+        interface = json_network_data_get_interface(jobj, link);
+        if (!interface)
                 return -ENOENT;
 
-        for (size_t i = 0; i < json_object_array_length(interfaces); i++){
-                json_object *interface = json_object_array_get_idx(interfaces, i);
-                json_object *routes = NULL, *l = NULL;
-
-                if (!json_object_object_get_ex(interface, "Name", &l))
-                        continue;
-
-                if (!streq(link, json_object_get_string(l)))
-                        continue;
-
-                if (!json_object_object_get_ex(interface, "Routes", &routes))
-                        continue;
+        if (!json_object_object_get_ex(interface, "Routes", &routes))
+                return -ENOENT;
 
-                for (size_t j = 0; j < json_object_array_length(routes); j++){
-                        json_object *config_source = NULL, *config_provider = NULL, *config_state = NULL, *a = NULL, *family = NULL;
-                        json_object *addr = json_object_array_get_idx(routes, j);
+        for (size_t i = 0; i < json_object_array_length(routes); i++) {
+                json_object *config_source = NULL, *config_provider = NULL, *config_state = NULL, *a = NULL, *family = NULL;
+                json_object *addr = json_object_array_get_idx(routes, i);
 
-                        if (json_object_object_get_ex(addr, config, &a) && json_object_object_get_ex(addr, "Family", &family)) {
-                                _auto_cleanup_ char *ip = NULL, *provider = NULL;
+                if (json_object_object_get_ex(addr, config, &a) && json_object_object_get_ex(addr, "Family", &family)) {
+                        _auto_cleanup_ char *ip = NULL, *provider = NULL;
 
-                                r = json_array_to_ip(a, json_object_get_int(family), -1, &ip);
-                                if (r < 0)
-                                        continue;
-
-                                if (streq(address, ip)) {
-                                        if (json_object_object_get_ex(addr, "ConfigSource", &config_source)) {
-                                                *ret_config_source = strdup(json_object_get_string(config_source));
-                                                if (!*ret_config_source)
-                                                        return -ENOMEM;
-                                        }
+                        r = json_array_to_ip(a, json_object_get_int(family), -1, &ip);
+                        if (r < 0)
+                                continue;
 
-                                        if (json_object_object_get_ex(addr, "ConfigProvider", &config_provider)) {
-                                                r = json_array_to_ip(config_provider, json_object_get_int(family), -1, &provider);
-                                                if (r >= 0) {
-                                                        *ret_config_provider = strdup(provider);
-                                                        if (!*ret_config_provider)
-                                                                return -ENOMEM;
-                                                }
-                                        }
+                        if (streq(address, ip)) {
+                                if (json_object_object_get_ex(addr, "ConfigSource", &config_source)) {
+                                        *ret_config_source = strdup(json_object_get_string(config_source));
+                                        if (!*ret_config_source)
+                                                return -ENOMEM;
+                                }
 
-                                        if (json_object_object_get_ex(addr, "ConfigState", &config_state)) {
-                                                *ret_config_state = strdup(json_object_get_string(config_state));
-                                                if (!*ret_config_state)
+                                if (json_object_object_get_ex(addr, "ConfigProvider", &config_provider)) {
+                                        r = json_array_to_ip(config_provider, json_object_get_int(family), -1, &provider);
+                                        if (r >= 0) {
+                                                *ret_config_provider = strdup(provider);
+                                                if (!*ret_config_provider)
                                                         return -ENOMEM;
                                         }
+                                }
 
-                                        return 0;
+                                if (json_object_object_get_ex(addr, "ConfigState", &config_state)) {
+                                        *ret_config_state = strdup(json_object_get_string(config_state));
+                                        if (!*ret_config_state)
+                                                return -ENOMEM;
                                 }
+
+                                return 0;
                         }
                 }
         }
@@ -1534,16 +1292,142 @@ int json_parse_route_config_source(const json_object *jobj,
         return -ENOENT;
 }
 
+/* networkd's Describe output, parsed at most once per command. The reply lists every link with all of its
+ * addresses and routes, so both the D-Bus round trip and the parse are worth sharing between the callers.
+ * Interfaces are indexed by name for the per address and per route config source lookups. The cache is
+ * dropped once nmctl made networkd reload or reconfigure anything. */
+typedef struct NetworkData {
+        json_object *jn;
+        GHashTable *interfaces;
+        unsigned generation;
+} NetworkData;
+
+static __thread NetworkData network_data = {};
+
+void json_network_data_cache_clear(void) {
+        if (network_data.interfaces) {
+                g_hash_table_unref(network_data.interfaces);
+                network_data.interfaces = NULL;
+        }
+
+        if (network_data.jn) {
+                json_object_put(network_data.jn);
+                network_data.jn = NULL;
+        }
+}
+
+static GHashTable *network_data_index_interfaces(json_object *jn) {
+        json_object *interfaces = NULL;
+        GHashTable *h;
+
+        h = g_hash_table_new(g_str_hash, g_str_equal);
+        if (!json_object_object_get_ex(jn, "Interfaces", &interfaces))
+                return h;
+
+        for (size_t i = 0; i < json_object_array_length(interfaces); i++) {
+                json_object *interface = json_object_array_get_idx(interfaces, i);
+                json_object *name;
+
+                if (json_object_object_get_ex(interface, "Name", &name))
+                        g_hash_table_insert(h, (gpointer) json_object_get_string(name), interface);
+        }
+
+        return h;
+}
+
+/* Returns the entry of "Interfaces" describing the link 'ifname', or NULL. No reference is taken. */
+json_object *json_network_data_get_interface(const json_object *jn, const char *ifname) {
+        json_object *interfaces = NULL;
+
+        assert(jn);
+        assert(ifname);
+
+        if (jn == network_data.jn && network_data.interfaces)
+                return g_hash_table_lookup(network_data.interfaces, ifname);
+
+        if (!json_object_object_get_ex(jn, "Interfaces", &interfaces))
+                return NULL;
+
+        for (size_t i = 0; i < json_object_array_length(interfaces); i++) {
+                json_object *interface = json_object_array_get_idx(interfaces, i);
+                json_object *name;
+
+                if (json_object_object_get_ex(interface, "Name", &name) && streq(json_object_get_string(name), ifname))
+                        return interface;
+        }
+
+        return NULL;
+}
+
 int json_acquire_and_parse_network_data(json_object **ret) {
         _cleanup_(json_object_putp) json_object *jobj = NULL;
         _auto_cleanup_ char *s = NULL;
         int r;
 
+        assert(ret);
+
+        if (network_data.jn && network_data.generation == dbus_network_generation()) {
+                *ret = json_object_get(network_data.jn);
+                return 0;
+        }
+
+        json_network_data_cache_clear();
+
         r = dbus_describe_network(&s);
         if (r < 0)
                 return r;
 
         jobj = json_tokener_parse(s);
+        if (!jobj)
+                return -EBADMSG;
+
+        network_data = (NetworkData) {
+                .jn = json_object_get(jobj),
+                .interfaces = network_data_index_interfaces(jobj),
+                .generation = dbus_network_generation(),
+        };
+
+        *ret = steal_ptr(jobj);
+        return 0;
+}
+
+/* Like json_acquire_and_parse_network_data(), but only asks networkd for the link 'ifindex'. The result has
+ * the same layout, an "Interfaces" array, here with that single link, so it can be passed to the same parsers. */
+int json_acquire_and_parse_link_data(int ifindex, json_object **ret) {
+        _cleanup_(json_object_putp) json_object *jobj = NULL, *interfaces = NULL, *link = NULL;
+        _auto_cleanup_ char *s = NULL;
+        int r;
+
+        assert(ifindex > 0);
+        assert(ret);
+
+        /* The whole picture is already at hand */
+        if (network_data.jn && network_data.generation == dbus_network_generation())
+                return json_acquire_and_parse_network_data(ret);
+
+        r = dbus_describe_link(ifindex, &s);
+        if (r < 0) {
+                /* networkd without org.freedesktop.network1.Link.Describe */
+                log_debug("Failed to describe link %d, describing all links: %s", ifindex, strerror(-r));
+                return json_acquire_and_parse_network_data(ret);
+        }
+
+        link = json_tokener_parse(s);
+        if (!link)
+                return -EBADMSG;
+
+        interfaces = json_object_new_array();
+        if (!interfaces)
+                return log_oom();
+
+        json_object_array_add(interfaces, steal_ptr(link));
+
+        jobj = json_object_new_object();
+        if (!jobj)
+                return log_oom();
+
+        json_object_object_add(jobj, "Interfaces", steal_ptr(interfaces));
+
         *ret = steal_ptr(jobj);
         return 0;
 }
@@ -1558,43 +1442,34 @@ int json_acquire_network_status(void) {
                 return r;
         }
 
-        printf("%s\n", json_object_to_json_string_ext(jobj, JSON_C_TO_STRING_NOSLASHESCAPE | JSON_C_TO_STRING_SPACED | JSON_C_TO_STRING_PRETTY));
-        return 0;
+        return json_print_object(jobj);
 }
 
 int json_get_link_address(IfNameIndex *p, char **ret) {
-        _cleanup_(json_object_putp) json_object *jn = NULL, *jobj = NULL;
+        _cleanup_(json_writer_freep) JsonWriter *w = NULL;
+        _cleanup_(json_object_putp) json_object *jn = NULL;
         _cleanup_(link_freep) Link *l = NULL;
         int r;
 
-        r = json_acquire_and_parse_network_data(&jn);
+        r = json_acquire_and_parse_link_data(p->ifindex, &jn);
         if (r < 0) {
                 log_warning("Failed acquire network data: %s", strerror(-r));
                 return r;
         }
 
-        jobj = json_object_new_object();
-        if (!jobj)
-                return log_oom();
-
         r = netlink_acqure_one_link(p->ifname, &l);
         if (r < 0)
                 return r;
 
-        r = json_fill_address(false, l, jn, jobj);
+        r = ret ? json_writer_new_string(&w) : json_writer_new(stdout, output_format(), &w);
         if (r < 0)
-                return r;
-
-        if (ret) {
-                char *s;
-
-                s = strdup(json_object_to_json_string_ext(jobj, JSON_C_TO_STRING_NOSLASHESCAPE | JSON_C_TO_STRING_SPACED | JSON_C_TO_STRING_PRETTY));
-                if (!s)
-                        return log_oom();
+                return log_oom();
 
-                *ret = steal_ptr(s);
-        } else
-                printf("%s\n", json_object_to_json_string_ext(jobj, JSON_C_TO_STRING_NOSLASHESCAPE | JSON_C_TO_STRING_SPACED | JSON_C_TO_STRING_PRETTY));
+        json_writer_begin_object(w, NULL);
+        r = json_fill_address(false, l, jn, w);
+        json_writer_end_object(w);
+        if (r < 0)
+                return r;
 
-        return r;
+        return json_writer_finish(w, ret);
 }
@@ -6,6 +6,7 @@
 
 #include <json-c/json.h>
 
+#include "json-writer.h"
 #include "network.h"
 #include "network-util.h"
 #include "network-address.h"
@@ -13,9 +14,12 @@
 
 DEFINE_CLEANUP(json_object*, json_object_put);
 
+int json_print_object(json_object *j);
+
 int json_fill_system_status(char **ret);
 int json_acquire_network_status(void);
-int json_fill_one_link(IfNameIndex *p, bool ipv4, json_object *jn, json_object **ret);
+int json_fill_one_link(IfNameIndex *p, bool ipv4, json_object *jn, GHashTable *devices, JsonWriter *w);
+int json_show_one_link(IfNameIndex *p, bool ipv4, json_object *jn, char **ret);
 
 int json_fill_dns_server(const IfNameIndex *p, int ifindex, json_object *jn);
 int json_parse_dns_servers(const json_object *jn, const char *link, json_object **ret);
@@ -28,7 +32,7 @@ int json_fill_ntp_servers(const json_object *jn, const char *link, json_object *
 int json_build_ntp_server(const IfNameIndex *p, json_object **ret);
 
 int json_get_link_address(IfNameIndex *p, char **ret);
-int json_fill_address(bool ipv4, Link *l, json_object *jn,  json_object *jobj);
+int json_fill_address(bool ipv4, Link *l, json_object *jn, JsonWriter *w);
 
 int address_flags_to_string(Address *a, json_object *jobj, uint32_t flags);
 int routes_flags_to_string(Route *rt, json_object *jobj, uint32_t flags);
@@ -37,6 +41,9 @@ int json_acquire_dns_mode(DHCPClient mode, bool dhcpv4, bool dhcpv6, bool static
 int json_acquire_dhcp_mode(DHCPClient mode);
 
 int json_acquire_and_parse_network_data(json_object **ret);
+int json_acquire_and_parse_link_data(int ifindex, json_object **ret);
+void json_network_data_cache_clear(void);
+json_object *json_network_data_get_interface(const json_object *jn, const char *ifname);
 int json_parse_address_config_source(const json_object *jobj,
                                      const char *link,
                                      const char *address,
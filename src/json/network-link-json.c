@@ -9,10 +9,12 @@
 #include "ansi-color.h"
 #include "arphrd-to-name.h"
 #include "ctl.h"
+#include "ctl-display.h"
 #include "config-parser.h"
 #include "dbus.h"
 #include "device.h"
 #include "dns.h"
+#include "json-writer.h"
 #include "log.h"
 #include "macros.h"
 #include "network-address.h"
@@ -167,8 +169,9 @@ int address_flags_to_string(Address *a, json_object *jobj, uint32_t flags) {
         return 0;
 }
 
-static int json_fill_ipv6_link_local_addresses(Link *l, Addresses *addr, json_object *ret) {
-        _cleanup_(json_object_putp) json_object *js = NULL;
+static int json_fill_ipv6_link_local_addresses(Link *l, Addresses *addr, JsonWriter *w) {
+        _auto_cleanup_ char *c = NULL;
+        Address *link_local = NULL;
         GHashTableIter iter;
         gpointer key, value;
         unsigned long size;
@@ -177,30 +180,24 @@ static int json_fill_ipv6_link_local_addresses(Link *l, Addresses *addr, json_ob
         g_hash_table_iter_init(&iter, addr->addresses->hash);
         while (g_hash_table_iter_next (&iter, &key, &value)) {
                 Address *a = (Address *) g_bytes_get_data(key, &size);
-                _auto_cleanup_ char *c = NULL;
-
-                if (a->family != AF_INET6)
-                        continue;
 
-                if (IN6_IS_ADDR_LINKLOCAL(&a->address.in6)) {
-                        r = ip_to_str(a->family, &a->address, &c);
-                        if (r < 0)
-                                return r;
+                if (a->family == AF_INET6 && IN6_IS_ADDR_LINKLOCAL(&a->address.in6))
+                        link_local = a;
+        }
 
-                        js = json_object_new_string(c);
-                        if (!js)
-                                return log_oom();
+        if (!link_local)
+                return 0;
 
-                        json_object_object_add(ret, "IPv6LinkLocalAddress", js);
-                        steal_ptr(js);
-                }
-        }
+        r = ip_to_str(link_local->family, &link_local->address, &c);
+        if (r < 0)
+                return r;
 
+        json_writer_string(w, "IPv6LinkLocalAddress", c);
         return 0;
 }
 
-static int json_fill_one_link_addresses(bool ipv4, Link *l, Addresses *addr, json_object *jn, json_object *ret) {
-        _cleanup_(json_object_putp) json_object *js = NULL, *jobj = NULL;
+static int json_fill_one_link_addresses(bool ipv4, Link *l, Addresses *addr, json_object *jn, JsonWriter *w) {
+        _cleanup_(json_object_putp) json_object *js = NULL;
         GHashTableIter iter;
         gpointer key, value;
         unsigned long size;
@@ -212,7 +209,7 @@ static int json_fill_one_link_addresses(bool ipv4, Link *l, Addresses *addr, jso
         g_hash_table_iter_init(&iter, addr->addresses->hash);
         while (g_hash_table_iter_next (&iter, &key, &value)) {
                 _auto_cleanup_ char *c = NULL, *b = NULL, *cp = NULL, *config_source = NULL, *config_provider = NULL, *config_state = NULL;
-                _cleanup_(json_object_putp) json_object *jscope = NULL, *jflags = NULL, *jlft = NULL, *jlabel = NULL, *jproto = NULL;
+                _cleanup_(json_object_putp) json_object *jobj = NULL, *jscope = NULL, *jflags = NULL, *jlft = NULL, *jlabel = NULL, *jproto = NULL;
                 Address *a = (Address *) g_bytes_get_data(key, &size);
 
                 if (ipv4 && a->family != AF_INET)
@@ -351,8 +348,7 @@ static int json_fill_one_link_addresses(bool ipv4, Link *l, Addresses *addr, jso
                         steal_ptr(js);
                 }
 
-                json_object_array_add(ret, jobj);
-                steal_ptr(jobj);
+                json_writer_json(w, NULL, jobj);
         }
 
         return 0;
@@ -506,7 +502,7 @@ static int json_fill_config_source(json_object *jobj, const char *config_source,
         return 0;
 }
 
-static int json_fill_one_link_routes(bool ipv4, json_object *jn, Link *l, Routes *rts, json_object *ret) {
+static int json_fill_one_link_routes(bool ipv4, json_object *jn, Link *l, Routes *rts, JsonWriter *w) {
         _auto_cleanup_ char *config_source = NULL, *config_profiver = NULL, *config_state = NULL;
         GHashTableIter iter;
         gpointer key, value;
@@ -673,32 +669,24 @@ static int json_fill_one_link_routes(bool ipv4, json_object *jn, Link *l, Routes
                 else if (destination && json_parse_route_config_source(jn, l->name, "Destination", destination, &config_source, &config_profiver, &config_state) >= 0)
                         json_fill_config_source(jobj, config_source, config_profiver, config_state);
 
-                json_object_array_add(ret, jobj);
-                steal_ptr(jobj);
+                json_writer_json(w, NULL, jobj);
         }
 
         return 0;
 }
 
-static int json_fill_one_link_udev(json_object *j, Link *l, char **link_file) {
+static int json_fill_one_link_udev(json_object *j, Link *l, const NetDevice *dev, char **link_file) {
         const char *link = NULL, *driver =  NULL, *path = NULL, *vendor = NULL, *model = NULL;
-        _cleanup_(sd_device_unrefp) sd_device *sd_device = NULL;
         _auto_cleanup_ char *desc = NULL;
-        const char *t = NULL;
 
         assert(l);
 
-        (void) device_new_from_ifname(&sd_device, l->name);
-        if (sd_device) {
-                (void) sd_device_get_property_value(sd_device, "ID_NET_LINK_FILE", &link);
-                (void) sd_device_get_property_value(sd_device, "ID_NET_DRIVER", &driver);
-                (void) sd_device_get_property_value(sd_device, "ID_PATH", &path);
-
-                if (sd_device_get_property_value(sd_device, "ID_VENDOR_FROM_DATABASE", &vendor) < 0)
-                        (void) sd_device_get_property_value(sd_device, "ID_VENDOR", &vendor);
-
-                if (sd_device_get_property_value(sd_device, "ID_MODEL_FROM_DATABASE", &model) < 0)
-                        (void) sd_device_get_property_value(sd_device, "ID_MODEL", &model);
+        if (dev) {
+                link = dev->link_file;
+                driver = dev->driver;
+                path = dev->path;
+                vendor = dev->vendor;
+                model = dev->model;
         }
 
         if (l->kind) {
@@ -712,13 +700,10 @@ static int json_fill_one_link_udev(json_object *j, Link *l, char **link_file) {
                 steal_ptr(js);
         }
 
-        if (sd_device && sd_device_get_devtype(sd_device, &t) >= 0 && !isempty(t)) {
+        if (dev && dev->devtype) {
                 _cleanup_(json_object_putp) json_object *js = NULL;
 
-                if (sd_device_get_devtype(sd_device, &t) >= 0 &&  !isempty(t))
-                        js = json_object_new_string(t);
-                else
-                        js = json_object_new_string(str_na(arphrd_to_name(l->iftype)));
+                js = json_object_new_string(dev->devtype);
                 if (!js)
                         return log_oom();
 
@@ -763,7 +748,7 @@ static int json_fill_one_link_udev(json_object *j, Link *l, char **link_file) {
         if (model) {
                 _cleanup_(json_object_putp) json_object *js = NULL;
 
-                js = json_object_new_string(path);
+                js = json_object_new_string(model);
                 if (!js)
                         return log_oom();
 
@@ -1343,17 +1328,20 @@ static int fill_link_flags(json_object *jobj, Link *l) {
         return 0;
 }
 
-static int fill_link_networkd_message(json_object *jobj, Link *l, char *network) {
-        _auto_cleanup_ char *online_state = NULL, *link = NULL, *address_state = NULL, *ipv4_state = NULL,
-                *ipv6_state = NULL, *required_for_online = NULL, *device_activation_policy = NULL;
+static int fill_link_networkd_message(json_object *jobj, Link *l, const NetDevice *dev, const LinkStateSnapshot *state) {
+        const char *online_state, *address_state, *ipv4_state, *ipv6_state, *required_for_online,
+                *device_activation_policy, *network;
+        _auto_cleanup_ char *link = NULL;
         int r;
 
         assert(jobj);
         assert(l);
 
-        r = json_fill_one_link_udev(jobj, l, &link);
-        if (r < 0)
-                return r;
+        if (link_fields_need_device()) {
+                r = json_fill_one_link_udev(jobj, l, dev, &link);
+                if (r < 0)
+                        return r;
+        }
 
         if (str_na(link)) {
                 _cleanup_(json_object_putp) json_object *js = NULL;
@@ -1366,6 +1354,7 @@ static int fill_link_networkd_message(json_object *jobj, Link *l, char *network)
                 steal_ptr(js);
         }
 
+        network = link_state_snapshot_network_file(state);
         if (network) {
                 _cleanup_(json_object_putp) json_object *js = NULL;
 
@@ -1395,8 +1384,8 @@ static int fill_link_networkd_message(json_object *jobj, Link *l, char *network)
                 steal_ptr(js);
         }
 
-        r = network_parse_link_address_state(l->ifindex, &address_state);
-        if (r >= 0) {
+        address_state = link_state_snapshot_address_state(state);
+        if (address_state) {
                 _cleanup_(json_object_putp) json_object *js = NULL;
 
                 js = json_object_new_string(address_state);
@@ -1407,8 +1396,8 @@ static int fill_link_networkd_message(json_object *jobj, Link *l, char *network)
                 steal_ptr(js);
         }
 
-        r = network_parse_link_ipv4_state(l->ifindex, &ipv4_state);
-        if (r >= 0) {
+        ipv4_state = link_state_snapshot_ipv4_state(state);
+        if (ipv4_state) {
                 _cleanup_(json_object_putp) json_object *js = NULL;
 
                 js = json_object_new_string(ipv4_state);
@@ -1419,8 +1408,8 @@ static int fill_link_networkd_message(json_object *jobj, Link *l, char *network)
                 steal_ptr(js);
         }
 
-        r = network_parse_link_ipv6_state(l->ifindex, &ipv6_state);
-        if (r >= 0) {
+        ipv6_state = link_state_snapshot_ipv6_state(state);
+        if (ipv6_state) {
                 _cleanup_(json_object_putp) json_object *js = NULL;
 
                 js = json_object_new_string(ipv6_state);
@@ -1431,8 +1420,8 @@ static int fill_link_networkd_message(json_object *jobj, Link *l, char *network)
                 steal_ptr(js);
         }
 
-        r = network_parse_link_online_state(l->ifindex, &online_state);
-        if (r >= 0) {
+        online_state = link_state_snapshot_online_state(state);
+        if (online_state) {
                 _cleanup_(json_object_putp) json_object *js = NULL;
 
                 js = json_object_new_string(online_state);
@@ -1443,8 +1432,8 @@ static int fill_link_networkd_message(json_object *jobj, Link *l, char *network)
                 steal_ptr(js);
         }
 
-        r = network_parse_link_required_for_online(l->ifindex, &required_for_online);
-        if (r >= 0) {
+        required_for_online = link_state_snapshot_required_for_online(state);
+        if (required_for_online) {
                 _cleanup_(json_object_putp) json_object *js = NULL;
 
                 js = json_object_new_string(required_for_online);
@@ -1455,8 +1444,8 @@ static int fill_link_networkd_message(json_object *jobj, Link *l, char *network)
                 steal_ptr(js);
         }
 
-        r = network_parse_link_device_activation_policy(l->ifindex, &device_activation_policy);
-        if (r >= 0) {
+        device_activation_policy = link_state_snapshot_activation_policy(state);
+        if (device_activation_policy) {
                 _cleanup_(json_object_putp) json_object *js = NULL;
 
                 js = json_object_new_string(device_activation_policy);
@@ -1471,167 +1460,111 @@ static int fill_link_networkd_message(json_object *jobj, Link *l, char *network)
 }
 
 static int fill_link_dns_settings(json_object *jobj, json_object *jn, const char *link) {
-        json_object *interfaces = NULL, *ifname = NULL;
+        json_object *interface, *d;
 
         assert(jn);
+        assert(link);
 
-        if (!json_object_object_get_ex(jn, "Interfaces", &interfaces))
+        interface = json_network_data_get_interface(jn, link);
+        if (!interface)
                 return -ENOENT;
 
-        for (size_t i = 0; i < json_object_array_length(interfaces); i++) {
-                json_object *interface = json_object_array_get_idx(interfaces, i);
-                _cleanup_(json_object_putp) json_object *jaddr = NULL;
-                json_object *settings;
-
-                if (!json_object_object_get_ex(interface, "Name", &ifname))
-                        continue;
-
-                if (link && streq(link, json_object_get_string(ifname)))
-                        continue;
-
-                if (!json_object_object_get_ex(interface, "DNSSettings", &settings))
-                        continue;
-
-                json_object_object_add(jobj, "DNSSettings", json_object_get(settings));
-                steal_ptr(settings);
-
-                return 0;
-        }
+        if (!json_object_object_get_ex(interface, "DNSSettings", &d))
+                return -ENOENT;
 
-        return -ENOENT;
+        json_object_object_add(jobj, "DNSSettings", json_object_get(d));
+        return 0;
 }
 
 static int fill_link_search_domain(json_object *jobj, json_object *jn, const char *link) {
-        json_object *interfaces = NULL, *ifname = NULL;
+        json_object *interface, *d;
 
         assert(jn);
+        assert(link);
 
-        if (!json_object_object_get_ex(jn, "Interfaces", &interfaces))
+        interface = json_network_data_get_interface(jn, link);
+        if (!interface)
                 return -ENOENT;
 
-        for (size_t i = 0; i < json_object_array_length(interfaces); i++) {
-                json_object *interface = json_object_array_get_idx(interfaces, i);
-                _cleanup_(json_object_putp) json_object *jaddr = NULL;
-                json_object *d;
-
-                if (!json_object_object_get_ex(interface, "Name", &ifname))
-                        continue;
-
-                if (link && streq(link, json_object_get_string(ifname)))
-                        continue;
-
-                if (!json_object_object_get_ex(interface, "SearchDomains", &d))
-                        continue;
-
-                json_object_object_add(jobj, "SearchDomains", json_object_get(d));
-                steal_ptr(d);
-
-                return 0;
-        }
+        if (!json_object_object_get_ex(interface, "SearchDomains", &d))
+                return -ENOENT;
 
-        return -ENOENT;
+        json_object_object_add(jobj, "SearchDomains", json_object_get(d));
+        return 0;
 }
 
 static int fill_link_dhcpv4_client(json_object *jobj, json_object *jn, const char *link) {
-        json_object *interfaces = NULL, *ifname = NULL;
+        json_object *interface, *d;
 
         assert(jn);
+        assert(link);
 
-        if (!json_object_object_get_ex(jn, "Interfaces", &interfaces))
+        interface = json_network_data_get_interface(jn, link);
+        if (!interface)
                 return -ENOENT;
 
-        for (size_t i = 0; i < json_object_array_length(interfaces); i++) {
-                json_object *interface = json_object_array_get_idx(interfaces, i);
-                _cleanup_(json_object_putp) json_object *jaddr = NULL;
-                json_object *d;
-
-                if (!json_object_object_get_ex(interface, "Name", &ifname))
-                        continue;
-
-                if (link && streq(link, json_object_get_string(ifname)))
-                        continue;
-
-                if (!json_object_object_get_ex(interface, "DHCPv4Client", &d))
-                        continue;
-
-                json_object_object_add(jobj, "DHCPv4Client", json_object_get(d));
-                steal_ptr(d);
-
-                return 0;
-        }
+        if (!json_object_object_get_ex(interface, "DHCPv4Client", &d))
+                return -ENOENT;
 
-        return -ENOENT;
+        json_object_object_add(jobj, "DHCPv4Client", json_object_get(d));
+        return 0;
 }
 
 static int fill_link_dhcpv6_client(json_object *jobj, json_object *jn, const char *link) {
-        json_object *interfaces = NULL, *ifname = NULL;
+        json_object *interface, *d;
 
         assert(jn);
+        assert(link);
 
-        if (!json_object_object_get_ex(jn, "Interfaces", &interfaces))
+        interface = json_network_data_get_interface(jn, link);
+        if (!interface)
                 return -ENOENT;
 
-        for (size_t i = 0; i < json_object_array_length(interfaces); i++) {
-                json_object *interface = json_object_array_get_idx(interfaces, i);
-                _cleanup_(json_object_putp) json_object *jaddr = NULL;
-                json_object *d;
-
-                if (!json_object_object_get_ex(interface, "Name", &ifname))
-                        continue;
-
-                if (link && streq(link, json_object_get_string(ifname)))
-                        continue;
-
-                if (!json_object_object_get_ex(interface, "DHCPv6Client", &d))
-                        continue;
-
-                json_object_object_add(jobj, "DHCPv6Client", json_object_get(d));
-                steal_ptr(d);
-
-                return 0;
-        }
+        if (!json_object_object_get_ex(interface, "DHCPv6Client", &d))
+                return -ENOENT;
 
-        return -ENOENT;
+        json_object_object_add(jobj, "DHCPv6Client", json_object_get(d));
+        return 0;
 }
 
-int json_fill_address(bool ipv4, Link *l, json_object *jn,  json_object *jobj) {
+int json_fill_address(bool ipv4, Link *l, json_object *jn, JsonWriter *w) {
         _cleanup_(addresses_freep) Addresses *addr = NULL;
         int r;
 
         assert(l);
         assert(jn);
-        assert(jobj);
+        assert(w);
 
         r = netlink_get_one_link_address(l->ifindex, &addr);
         if (r >= 0 && addr && set_size(addr->addresses) > 0) {
-                _cleanup_(json_object_putp) json_object *ja = NULL;
-
-                json_fill_ipv6_link_local_addresses(l, addr, jobj);
-
-                ja = json_object_new_array();
-                if (!ja)
-                        return log_oom();
-
-                json_fill_one_link_addresses(ipv4, l, addr, jn, ja);
+                (void) json_fill_ipv6_link_local_addresses(l, addr, w);
 
-                json_object_object_add(jobj, "Addresses", ja);
-                steal_ptr(ja);
+                json_writer_begin_array(w, "Addresses");
+                (void) json_fill_one_link_addresses(ipv4, l, addr, jn, w);
+                json_writer_end_array(w);
         }
 
         return r;
 }
 
-int json_fill_one_link(IfNameIndex *p, bool ipv4, json_object *jn,  json_object **ret) {
-        _auto_cleanup_ char *setup_state = NULL, *tz = NULL, *network = NULL, *dhcp4_duid_type = NULL,
-                *dhcp6_duid_type = NULL, *dhcp4_duid_data = NULL, *dhcp6_duid_data = NULL, *iaid = NULL;
+/* 'jn' may be NULL when none of the selected fields needs networkd's description of the link, see
+ * link_fields_need_network_data(). Data sources not contributing to a selected field are not consulted.
+ * 'devices' is the table from net_devices_enumerate() when all links are shown, otherwise NULL and the link's
+ * device is looked up on its own. */
+int json_fill_one_link(IfNameIndex *p, bool ipv4, json_object *jn, GHashTable *devices, JsonWriter *w) {
+        _auto_cleanup_ char *dhcp4_duid_type = NULL, *dhcp6_duid_type = NULL, *dhcp4_duid_data = NULL,
+                *dhcp6_duid_data = NULL, *iaid = NULL;
         _cleanup_(json_object_putp) json_object *jobj = NULL, *jdns = NULL, *jntp = NULL;
+        _cleanup_(link_state_snapshot_freep) LinkStateSnapshot *state = NULL;
+        _cleanup_(net_device_freep) NetDevice *device = NULL;
         _cleanup_(addresses_freep) Addresses *addr = NULL;
         _cleanup_(routes_freep) Routes *route = NULL;
         _cleanup_(link_freep) Link *l = NULL;
+        const NetDevice *dev = NULL;
         int r;
 
         assert(p);
-        assert(jn);
+        assert(w);
 
         jobj = json_object_new_object();
         if (!jobj)
@@ -1671,18 +1604,12 @@ int json_fill_one_link(IfNameIndex *p, bool ipv4, json_object *jn,  json_object
                 steal_ptr(ja);
         }
 
-        r = network_parse_link_setup_state(l->ifindex, &setup_state);
-        if (r == -ENODATA) {
-                setup_state = g_strdup("unmanaged");
-                if (!setup_state)
-                        return log_oom();
-
-                r = 0;
-        }
+        /* All networkd state of this link below is served from one read of its state file */
+        r = link_state_snapshot_new(l->ifindex, &state);
         if (r >= 0) {
                 _cleanup_(json_object_putp) json_object *js = NULL;
 
-                js = json_object_new_string(setup_state);
+                js = json_object_new_string(link_state_snapshot_setup_state(state) ?: "unmanaged");
                 if (!js)
                         return log_oom();
 
@@ -1690,51 +1617,66 @@ int json_fill_one_link(IfNameIndex *p, bool ipv4, json_object *jn,  json_object
                 steal_ptr(js);
         }
 
+        if (link_fields_need_device()) {
+                if (devices)
+                        dev = net_devices_get(devices, l->ifindex);
+                else {
+                        (void) net_device_new_from_ifname(l->name, &device);
+                        dev = device;
+                }
+        }
+
         (void) json_fill_link_attributes(jobj, l);
-        (void) network_parse_link_network_file(l->ifindex, &network);
-        (void) fill_link_networkd_message(jobj, l, network);
+        (void) fill_link_networkd_message(jobj, l, dev, state);
 
         (void) fill_link_flags(jobj, l);
 
         (void) fill_link_message(jobj, l);
-        (void) json_fill_address(ipv4, l, jn, jobj);
 
-        r = netlink_get_one_link_route(l->ifindex, &route);
-        if (r >= 0 && route && set_size(route->routes) > 0) {
-                _cleanup_(json_object_putp) json_object *ja = NULL;
+        json_writer_begin_object(w, NULL);
+        json_writer_members(w, jobj, field_enabled);
 
-                ja = json_object_new_array();
-                if (!ja)
-                        return log_oom();
+        /* Addresses and routes are written as they are read, one entry at a time, and what follows them is
+         * collected into a fresh object */
+        json_object_put(steal_ptr(jobj));
 
-                json_fill_one_link_routes(ipv4, jn, l, route, ja);
+        if (jn && fields_enabled((const char *const[]) { "Addresses", "IPv6LinkLocalAddress", NULL }))
+                (void) json_fill_address(ipv4, l, jn, w);
 
-                json_object_object_add(jobj, "Routes", ja);
-                steal_ptr(ja);
+        r = jn && field_enabled("Routes") ? netlink_get_one_link_route(l->ifindex, &route) : -ENODATA;
+        if (r >= 0 && route && set_size(route->routes) > 0) {
+                json_writer_begin_array(w, "Routes");
+                (void) json_fill_one_link_routes(ipv4, jn, l, route, w);
+                json_writer_end_array(w);
         }
 
-        r = json_parse_dns_servers(jn, l->name, &jdns);
-        if (r >= 0) {
-                json_object_object_add(jobj, "DNS", jdns);
-                steal_ptr(jdns);
-        }
+        jobj = json_object_new_object();
+        if (!jobj)
+                return log_oom();
+
+        if (jn) {
+                r = json_parse_dns_servers(jn, l->name, &jdns);
+                if (r >= 0) {
+                        json_object_object_add(jobj, "DNS", jdns);
+                        steal_ptr(jdns);
+                }
 
-        (void) fill_link_search_domain(jobj, jn, l->name);
-        (void) fill_link_dns_settings(jobj, jn, l->name);
-        (void) fill_link_dhcpv4_client(jobj, jn, l->name);
-        (void) fill_link_dhcpv6_client(jobj, jn, l->name);
+                (void) fill_link_search_domain(jobj, jn, l->name);
+                (void) fill_link_dns_settings(jobj, jn, l->name);
+                (void) fill_link_dhcpv4_client(jobj, jn, l->name);
+                (void) fill_link_dhcpv6_client(jobj, jn, l->name);
 
-        r = json_fill_ntp_servers(jn, l->name, &jntp);
-        if (r >= 0) {
-                json_object_object_add(jobj, "NTP", jntp);
-                steal_ptr(jntp);
+                r = json_fill_ntp_servers(jn, l->name, &jntp);
+                if (r >= 0) {
+                        json_object_object_add(jobj, "NTP", jntp);
+                        steal_ptr(jntp);
+                }
         }
 
-        (void) network_parse_link_timezone(l->ifindex, &tz);
-        if (tz) {
+        if (link_state_snapshot_timezone(state)) {
                 _cleanup_(json_object_putp) json_object *js = NULL;
 
-                js = json_object_new_string(str_na(tz));
+                js = json_object_new_string(link_state_snapshot_timezone(state));
                 if (!js)
                         return log_oom();
 
@@ -1742,7 +1684,7 @@ int json_fill_one_link(IfNameIndex *p, bool ipv4, json_object *jn,  json_object
                 steal_ptr(js);
         }
 
-        r = manager_acquire_link_dhcp_client_iaid(p, DHCP_CLIENT_IPV4, &iaid);
+        r = field_enabled("DHCPv4IAID") ? manager_acquire_link_dhcp_client_iaid(p, DHCP_CLIENT_IPV4, &iaid) : -ENODATA;
         if (r >= 0) {
                 _cleanup_(json_object_putp) json_object *js = NULL;
 
@@ -1754,7 +1696,7 @@ int json_fill_one_link(IfNameIndex *p, bool ipv4, json_object *jn,  json_object
                 steal_ptr(js);
         }
 
-        r = manager_acquire_link_dhcp_client_iaid(p, DHCP_CLIENT_IPV6, &iaid);
+        r = field_enabled("DHCPv6IAID") ? manager_acquire_link_dhcp_client_iaid(p, DHCP_CLIENT_IPV6, &iaid) : -ENODATA;
         if (r >= 0) {
                 _cleanup_(json_object_putp) json_object *js = NULL;
 
@@ -1766,7 +1708,7 @@ int json_fill_one_link(IfNameIndex *p, bool ipv4, json_object *jn,  json_object
                 steal_ptr(js);
         }
 
-        r = manager_acquire_link_dhcp_client_duid(p, DHCP_CLIENT_IPV4, &dhcp4_duid_type, &dhcp4_duid_data);
+        r = field_enabled("DHCPv4DUID") ? manager_acquire_link_dhcp_client_duid(p, DHCP_CLIENT_IPV4, &dhcp4_duid_type, &dhcp4_duid_data) : -ENODATA;
         if (r >= 0) {
                 _cleanup_(json_object_putp) json_object *js = NULL, *j = NULL;
 
@@ -1793,7 +1735,7 @@ int json_fill_one_link(IfNameIndex *p, bool ipv4, json_object *jn,  json_object
                 steal_ptr(j);
         }
 
-        r = manager_acquire_link_dhcp_client_duid(p, DHCP_CLIENT_IPV6, &dhcp6_duid_type, &dhcp6_duid_data);
+        r = field_enabled("DHCPv6DUID") ? manager_acquire_link_dhcp_client_duid(p, DHCP_CLIENT_IPV6, &dhcp6_duid_type, &dhcp6_duid_data) : -ENODATA;
         if (r >= 0) {
                 _cleanup_(json_object_putp) json_object *js = NULL, *j = NULL;
 
@@ -1820,10 +1762,24 @@ int json_fill_one_link(IfNameIndex *p, bool ipv4, json_object *jn,  json_object
                 steal_ptr(j);
         }
 
-        if (ret)
-                *ret = steal_ptr(jobj);
-        else
-                printf("%s\n", json_object_to_json_string_ext(jobj, JSON_C_TO_STRING_NOSLASHESCAPE | JSON_C_TO_STRING_SPACED | JSON_C_TO_STRING_PRETTY));
+        json_writer_members(w, jobj, field_enabled);
+        json_writer_end_object(w);
 
         return 0;
 }
+
+/* Writes the status of one link to stdout in the --output= format, or into a JSON string when 'ret' is set */
+int json_show_one_link(IfNameIndex *p, bool ipv4, json_object *jn, char **ret) {
+        _cleanup_(json_writer_freep) JsonWriter *w = NULL;
+        int r;
+
+        r = ret ? json_writer_new_string(&w) : json_writer_new(stdout, output_format(), &w);
+        if (r < 0)
+                return log_oom();
+
+        r = json_fill_one_link(p, ipv4, jn, NULL, w);
+        if (r < 0)
+                return r;
+
+        return json_writer_finish(w, ret);
+}
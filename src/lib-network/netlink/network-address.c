@@ -50,6 +50,14 @@ int address_new(Address **ret) {
         return 0;
 }
 
+void address_free(Address *a) {
+        if (!a)
+                return;
+
+        free(a->label);
+        free(a);
+}
+
 void addresses_free(Addresses *a) {
         GHashTableIter iter;
         gpointer key, value;
@@ -113,15 +121,15 @@ static int validate_address_attributes(const struct nlattr *attr, void *data) {
         return MNL_CB_OK;
 }
 
-static int fill_link_address(const struct nlmsghdr *nlh, void *data) {
+/* Parses one RTM_NEWADDR or RTM_DELADDR message, from a dump as well as a multicast notification */
+int netlink_parse_address_message(const struct nlmsghdr *nlh, Address **ret) {
         struct ifaddrmsg *ifa = mnl_nlmsg_get_payload(nlh);
         struct nlattr *tb[IFA_MAX + 2] = {};
-        _auto_cleanup_ Address *a = NULL;
-        Addresses *addrs = data;
+        _cleanup_(address_freep) Address *a = NULL;
         int r;
 
         assert(nlh);
-        assert(data);
+        assert(ret);
 
         r = address_new(&a);
         if (r < 0)
@@ -135,9 +143,6 @@ static int fill_link_address(const struct nlmsghdr *nlh, void *data) {
            .address.prefix_len = ifa->ifa_prefixlen,
         };
 
-        if (addrs->ifindex !=0 && addrs->ifindex != a->ifindex)
-                return MNL_CB_OK;
-
         mnl_attr_parse(nlh, sizeof(*ifa), validate_address_attributes, tb);
         if (tb[IFA_ADDRESS]) {
                 if (a->family == AF_INET)
@@ -175,6 +180,26 @@ static int fill_link_address(const struct nlmsghdr *nlh, void *data) {
         if (tb[IFA_CACHEINFO])
                 memcpy(&a->ci, mnl_attr_get_payload(tb[IFA_CACHEINFO]), sizeof(struct ifa_cacheinfo));
 
+        *ret = steal_ptr(a);
+        return 0;
+}
+
+static int fill_link_address(const struct nlmsghdr *nlh, void *data) {
+        struct ifaddrmsg *ifa = mnl_nlmsg_get_payload(nlh);
+        _cleanup_(address_freep) Address *a = NULL;
+        Addresses *addrs = data;
+        int r;
+
+        assert(nlh);
+        assert(data);
+
+        if (addrs->ifindex !=0 && addrs->ifindex != (int) ifa->ifa_index)
+                return MNL_CB_OK;
+
+        r = netlink_parse_address_message(nlh, &a);
+        if (r < 0)
+                return r;
+
         r = address_add(&addrs, a);
         if (r < 0)
                 return r;
@@ -183,7 +208,7 @@ static int fill_link_address(const struct nlmsghdr *nlh, void *data) {
         return MNL_CB_OK;
 }
 
-static int acquire_link_address(int s, int ifindex, Addresses **ret) {
+static int acquire_link_address(int ifindex, Addresses **ret) {
         _cleanup_(mnl_freep) Mnl *m = NULL;
         struct nlmsghdr *nlh;
         Addresses *a = NULL;
@@ -214,30 +239,16 @@ static int acquire_link_address(int s, int ifindex, Addresses **ret) {
 }
 
 int netlink_acquire_all_link_addresses(Addresses **ret) {
-       _auto_cleanup_close_ int s = -1;
-        int r;
-
         assert(ret);
 
-        r = rtnl_socket_open(0, &s);
-        if (r < 0)
-                return r;
-
-        return acquire_link_address(s, 0, ret);
+        return acquire_link_address(0, ret);
 }
 
 int netlink_get_one_link_address(int ifindex, Addresses **ret) {
-        _auto_cleanup_close_ int s = -1;
-        int r;
-
         assert(ifindex > 0);
         assert(ret);
 
-        r = rtnl_socket_open(0, &s);
-        if (r < 0)
-                return r;
-
-        return acquire_link_address(s, ifindex, ret);
+        return acquire_link_address(ifindex, ret);
 }
 
 static int link_add_address(int s, int ifindex, IPAddress *address, IPAddress *peer) {
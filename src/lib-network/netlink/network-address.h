@@ -45,9 +45,12 @@ void addresses_free(Addresses *a);
 DEFINE_CLEANUP(Addresses*, addresses_free);
 
 int address_new(Address **ret);
+void address_free(Address *a);
+DEFINE_CLEANUP(Address*, address_free);
 int address_add(Addresses **h, Address *a);
 
 int netlink_acquire_all_link_addresses(Addresses **ret);
 int netlink_get_one_link_address(int ifindex, Addresses **ret);
+int netlink_parse_address_message(const struct nlmsghdr *nlh, Address **ret);
 
 int netlink_add_link_address(int ifindex, IPAddress *address, IPAddress *peer);
@@ -50,13 +50,15 @@ const char *link_state_to_name(int id) {
 }
 
 int link_name_to_state(char *name) {
+        int r;
+
         assert(name);
 
-        for (size_t i = LINK_STATE_DOWN; i < (int) ELEMENTSOF(link_states_table); i++)
-                if (streq_fold(name, link_states_table[i]))
-                        return i;
+        r = string_table_lookup(link_states_table, ELEMENTSOF(link_states_table), name);
+        if (r < 0)
+                return _LINK_STATE_INVALID;
 
-        return _LINK_STATE_INVALID;
+        return r;
 }
 
 static const char* const ipv6_address_generation_mode_table[] = {
@@ -444,6 +446,93 @@ int netlink_acquire_all_links(Links **ret) {
         return 0;
 }
 
+/* Parses one RTM_NEWLINK message, from a dump as well as a multicast notification */
+int netlink_parse_link_message(const struct nlmsghdr *nlh, Link **ret) {
+        _cleanup_(links_freep) Links *links = NULL;
+        int r;
+
+        assert(nlh);
+        assert(ret);
+
+        r = links_new(&links);
+        if (r < 0)
+                return r;
+
+        r = fill_one_link_info(nlh, links);
+        if (r < 0)
+                return r;
+        if (!links->links)
+                return -ENODATA;
+
+        *ret = links->links->data;
+        links->links = g_list_delete_link(links->links, links->links);
+        return 0;
+}
+
+static int fill_link_stats(const struct nlmsghdr *nlh, void *data) {
+        struct if_stats_msg *ifsm = mnl_nlmsg_get_payload(nlh);
+        GHashTable *stats = data;
+        struct nlattr *attr;
+
+        assert(nlh);
+        assert(data);
+
+        mnl_attr_for_each(attr, nlh, sizeof(*ifsm)) {
+                struct rtnl_link_stats64 *s;
+
+                if (mnl_attr_get_type(attr) != IFLA_STATS_LINK_64)
+                        continue;
+
+                if (mnl_attr_get_payload_len(attr) < sizeof(struct rtnl_link_stats64))
+                        break;
+
+                s = new(struct rtnl_link_stats64, 1);
+                if (!s)
+                        return MNL_CB_ERROR;
+
+                memcpy(s, mnl_attr_get_payload(attr), sizeof(struct rtnl_link_stats64));
+                g_hash_table_replace(stats, GINT_TO_POINTER(ifsm->ifindex), s);
+                break;
+        }
+
+        return MNL_CB_OK;
+}
+
+/* The 64 bit counters of all links keyed by ifindex. RTM_GETSTATS filtered down to IFLA_STATS_LINK_64 carries
+ * nothing else, which keeps polling them cheap compared to a full link dump. */
+int netlink_acquire_all_link_stats(GHashTable **ret) {
+        _auto_cleanup_hash_ GHashTable *stats = NULL;
+        _cleanup_(mnl_freep) Mnl *m = NULL;
+        struct if_stats_msg *ifsm;
+        struct nlmsghdr *nlh;
+        int r;
+
+        assert(ret);
+
+        r = mnl_new(&m);
+        if (r < 0)
+                return r;
+
+        nlh = mnl_nlmsg_put_header(m->buf);
+        nlh->nlmsg_type = RTM_GETSTATS;
+        nlh->nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+        ifsm = mnl_nlmsg_put_extra_header(nlh, sizeof(struct if_stats_msg));
+        ifsm->family = AF_UNSPEC;
+        ifsm->filter_mask = IFLA_STATS_FILTER_BIT(IFLA_STATS_LINK_64);
+        m->nlh = nlh;
+
+        stats = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+        if (!stats)
+                return log_oom();
+
+        r = mnl_send(m, fill_link_stats, stats, NETLINK_ROUTE);
+        if (r < 0)
+                return r;
+
+        *ret = steal_ptr(stats);
+        return 0;
+}
+
 int netlink_remove_link(const IfNameIndex *p) {
         _auto_cleanup_ IPlinkMessage *m = NULL;
         _auto_cleanup_close_ int s = -1;
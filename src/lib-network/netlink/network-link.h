@@ -90,6 +90,8 @@ DEFINE_CLEANUP(Links*, links_free);
 
 int netlink_acquire_all_links(Links **ret);
 int netlink_acqure_one_link(const char *ifname, Link **ret);
+int netlink_parse_link_message(const struct nlmsghdr *nlh, Link **ret);
+int netlink_acquire_all_link_stats(GHashTable **ret);
 
 int link_read_sysfs_attribute(const char *ifname, const char *attribute, char **ret);
 int link_set_mac_address(const IfNameIndex *p, const char *mac_address);
@@ -0,0 +1,235 @@
+/* Copyright 2024 VMware, Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "alloc-util.h"
+#include "log.h"
+#include "network-route.h"
+#include "network-util.h"
+#include "string-util.h"
+
+/* Routes as configuration: what the YAML, dracut and ctl parsers fill and the .network writer reads. Kept apart
+ * from the netlink code so that programs only writing files do not link it. */
+
+int route_new(Route **ret) {
+        Route *route;
+
+        assert(ret);
+
+        route = new(Route, 1);
+        if (!route)
+                return log_oom();
+
+        *route = (Route) {
+                .family = AF_UNSPEC,
+                .scope = RT_SCOPE_UNIVERSE,
+                .protocol = RTPROT_UNSPEC,
+                .table = RT_TABLE_MAIN,
+                .onlink = -1,
+                .quick_ack = -1,
+                .tfo = -1,
+                .ttl_propogate = -1,
+                .type = _ROUTE_TYPE_INVALID,
+        };
+
+        *ret = route;
+        return 0;
+}
+
+guint route_hash(gconstpointer p) {
+        const Route *rt = p;
+        guint h;
+
+        assert(rt);
+
+        h = (guint) rt->family;
+        h = h * 31 + ip_address_hash(&rt->dst);
+        h = h * 31 + rt->dst_prefixlen;
+        h = h * 31 + ip_address_hash(&rt->gw);
+        h = h * 31 + rt->table;
+        h = h * 31 + rt->metric;
+
+        return h;
+}
+
+gboolean route_equal(gconstpointer v1, gconstpointer v2) {
+        const Route *a = v1, *b = v2;
+
+        assert(a);
+        assert(b);
+
+        return a->family == b->family &&
+                a->dst_prefixlen == b->dst_prefixlen &&
+                a->src_prefixlen == b->src_prefixlen &&
+                ip_address_equal(&a->dst, &b->dst) &&
+                ip_address_equal(&a->src, &b->src) &&
+                ip_address_equal(&a->gw, &b->gw) &&
+                ip_address_equal(&a->prefsrc, &b->prefsrc) &&
+                a->priority == b->priority &&
+                a->table == b->table &&
+                a->mtu == b->mtu &&
+                a->metric == b->metric &&
+                a->flags == b->flags &&
+                a->tos == b->tos &&
+                a->type == b->type &&
+                a->scope == b->scope;
+}
+
+int route_table_to_string(uint32_t table, char **ret) {
+        _auto_cleanup_ char *str = NULL;
+        const char *s;
+        int r;
+
+        s = route_table_to_name(table);
+        if (!s)
+                r = asprintf(&str, "%" PRIu32, table);
+        else
+                r = asprintf(&str, "%s(%" PRIu32 ")", s, table);
+        if (r < 0)
+                return -ENOMEM;
+
+        *ret = steal_ptr(str);
+        return 0;
+}
+
+static const char * const route_table[_ROUTE_TABLE_MAX] = {
+       [ROUTE_TABLE_LOCAL]    = "local",
+       [ROUTE_TABLE_MAIN]     = "main",
+       [ROUTE_TABLE_DEFAULT]  = "default",
+};
+
+const char *route_table_to_name(int id) {
+        if (id < 0)
+                return NULL;
+
+        if ((size_t) id >= ELEMENTSOF(route_table))
+                return NULL;
+
+        return route_table[id];
+}
+
+int route_table_to_mode(const char *name) {
+        assert(name);
+
+        return string_table_lookup(route_table, ELEMENTSOF(route_table), name);
+}
+
+static const char *const route_scope_type[_ROUTE_SCOPE_MAX] =  {
+        [ROUTE_SCOPE_UNIVERSE] = "global",
+        [ROUTE_SCOPE_SITE]     = "site",
+        [ROUTE_SCOPE_LINK]     = "link",
+        [ROUTE_SCOPE_HOST]     = "host",
+        [ROUTE_SCOPE_NOWHERE]  = "nowhere",
+};
+
+const char *route_scope_type_to_name(int id) {
+        if (id < 0)
+                return NULL;
+
+        if ((size_t) id >= ELEMENTSOF(route_scope_type))
+                return NULL;
+
+        return route_scope_type[id];
+}
+
+int route_scope_type_to_mode(const char *name) {
+        assert(name);
+
+        return string_table_lookup(route_scope_type, ELEMENTSOF(route_scope_type), name);
+}
+
+static const char * const route_type[_ROUTE_TYPE_MAX] = {
+        [ROUTE_TYPE_UNICAST]     = "unicast",
+        [ROUTE_TYPE_LOCAL]       = "local",
+        [ROUTE_TYPE_BROADCAST]   = "broadcast",
+        [ROUTE_TYPE_ANYCAST]     = "anycast",
+        [ROUTE_TYPE_MULTICAST]   = "multicast",
+        [ROUTE_TYPE_BLACKHOLE]   = "blackhole",
+        [ROUTE_TYPE_UNREACHABLE] = "unreachable",
+        [ROUTE_TYPE_PROHIBIT]    = "prohibit",
+        [ROUTE_TYPE_THROW]       = "throw",
+        [ROUTE_TYPE_NAT]         = "nat",
+        [ROUTE_TYPE_XRESOLVE]    = "xresolve",
+};
+
+const char *route_type_to_name(int id) {
+        if (id < 0)
+                return NULL;
+
+        if ((size_t) id >= ELEMENTSOF(route_type))
+                return NULL;
+
+        return route_type[id];
+}
+
+int route_type_to_mode(const char *name) {
+        assert(name);
+
+        return string_table_lookup(route_type, ELEMENTSOF(route_type), name);
+}
+
+static const char * const ipv6_route_preference_type[_IPV6_ROUTE_PREFERENCE_MAX] = {
+        [IPV6_ROUTE_PREFERENCE_LOW]     = "low",
+        [IPV6_ROUTE_PREFERENCE_MEDIUM]  = "medium",
+        [IPV6_ROUTE_PREFERENCE_HIGH]    = "high",
+};
+
+const char *ipv6_route_preference_to_name(int id) {
+        if (id < 0)
+                return NULL;
+
+        if ((size_t) id >= ELEMENTSOF(ipv6_route_preference_type))
+                return NULL;
+
+        return ipv6_route_preference_type[id];
+}
+
+int ipv6_route_preference_type_to_mode(const char *name) {
+        assert(name);
+
+        return string_table_lookup(ipv6_route_preference_type, ELEMENTSOF(ipv6_route_preference_type), name);
+}
+
+static const char * const route_protocol_type[_ROUTE_PROTOCOL_MAX] = {
+       [ROUTE_PROTOCOL_KERNEL]  = "kernel",
+       [ROUTE_PROTOCOL_BOOT]    = "boot",
+       [ROUTE_PROTOCOL_STATIC]  = "static",
+       [ROUTE_PRTOCOL_DHCP]     = "dhcp",
+};
+
+const char *route_protocol_to_name(int id) {
+        if (id < 0)
+                return NULL;
+
+        if ((size_t) id >= ELEMENTSOF(route_protocol_type))
+                return NULL;
+
+        return route_protocol_type[id];
+}
+
+int route_protocol_to_mode(const char *name) {
+        assert(name);
+
+        return string_table_lookup(route_protocol_type, ELEMENTSOF(route_protocol_type), name);
+}
+
+static const char * const ipoib_mode_table[_IP_OIB_MODE_MODE_MAX] = {
+        [IP_OIB_MODE_DATAGRAM]       = "datagram",
+        [IP_OIB_MODE_MODE_CONNECTED] = "connected",
+};
+
+const char *ipoib_mode_to_name(int id) {
+        if (id < 0)
+                return NULL;
+
+        if ((size_t) id >= ELEMENTSOF(ipoib_mode_table))
+                return NULL;
+
+        return ipoib_mode_table[id];
+}
+
+int ipoib_name_to_mode(const char *name) {
+        assert(name);
+
+        return string_table_lookup(ipoib_mode_table, ELEMENTSOF(ipoib_mode_table), name);
+}
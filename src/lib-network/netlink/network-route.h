@@ -112,6 +112,8 @@ typedef struct Routes {
 } Routes;
 
 int route_new(Route **ret);
+guint route_hash(gconstpointer p);
+gboolean route_equal(gconstpointer a, gconstpointer b);
 void routes_free(Routes *rt);
 
 DEFINE_CLEANUP(Routes *, routes_free);
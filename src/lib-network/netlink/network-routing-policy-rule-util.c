@@ -0,0 +1,89 @@
+/* Copyright 2024 VMware, Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "alloc-util.h"
+#include "log.h"
+#include "network-routing-policy-rule.h"
+#include "network-util.h"
+
+/* Routing policy rules as configuration, see network-route-util.c */
+
+int routing_policy_rule_new(RoutingPolicyRule **ret) {
+        RoutingPolicyRule *rule;
+
+        assert(ret);
+
+        rule = new(RoutingPolicyRule, 1);
+        if (!rule)
+                return log_oom();
+
+        *rule = (RoutingPolicyRule) {
+                .table = RT_TABLE_MAIN,
+                .uid_range.start = ((uid_t) -1),
+                .uid_range.end = ((uid_t) -1),
+                .suppress_prefixlen = -1,
+                .suppress_ifgroup = -1,
+                .protocol = RTPROT_UNSPEC,
+                .type = FR_ACT_TO_TBL,
+                .priority = UINT_MAX,
+                .tos = UINT8_MAX,
+                .fwmark = UINT_MAX,
+        };
+
+        *ret = rule;
+        return 0;
+}
+
+void routing_policy_rule_free(RoutingPolicyRule *rule) {
+        if (!rule)
+                return;
+
+        free(rule->sport_str);
+        free(rule->dport_str);
+        free(rule->ipproto_str);
+        free(rule);
+}
+
+guint routing_policy_rule_hash(gconstpointer p) {
+        const RoutingPolicyRule *rule = p;
+        guint h;
+
+        assert(rule);
+
+        h = (guint) rule->family;
+        h = h * 31 + ip_address_hash(&rule->to);
+        h = h * 31 + ip_address_hash(&rule->from);
+        h = h * 31 + rule->table;
+        h = h * 31 + rule->priority;
+        h = h * 31 + rule->fwmark;
+
+        return h;
+}
+
+gboolean routing_policy_rule_equal(gconstpointer v1, gconstpointer v2) {
+        const RoutingPolicyRule *a = v1, *b = v2;
+
+        assert(a);
+        assert(b);
+
+        return a->family == b->family &&
+                a->to_prefixlen == b->to_prefixlen &&
+                a->from_prefixlen == b->from_prefixlen &&
+                ip_address_equal(&a->to, &b->to) &&
+                ip_address_equal(&a->from, &b->from) &&
+                g_strcmp0(a->iif, b->iif) == 0 &&
+                g_strcmp0(a->oif, b->oif) == 0 &&
+                a->table == b->table &&
+                a->priority == b->priority &&
+                a->fwmark == b->fwmark &&
+                a->fwmask == b->fwmask &&
+                a->type == b->type &&
+                a->tos == b->tos &&
+                a->ipproto == b->ipproto &&
+                a->sport.start == b->sport.start &&
+                a->sport.end == b->sport.end &&
+                a->dport.start == b->dport.start &&
+                a->dport.end == b->dport.end &&
+                a->invert_rule == b->invert_rule;
+}
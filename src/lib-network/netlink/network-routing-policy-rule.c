@@ -9,42 +9,6 @@
 #include "mnl_util.h"
 #include "network-util.h"
 
-int routing_policy_rule_new(RoutingPolicyRule **ret) {
-        RoutingPolicyRule *rule;
-
-        assert(ret);
-
-        rule = new(RoutingPolicyRule, 1);
-        if (!rule)
-                return log_oom();
-
-        *rule = (RoutingPolicyRule) {
-                .table = RT_TABLE_MAIN,
-                .uid_range.start = ((uid_t) -1),
-                .uid_range.end = ((uid_t) -1),
-                .suppress_prefixlen = -1,
-                .suppress_ifgroup = -1,
-                .protocol = RTPROT_UNSPEC,
-                .type = FR_ACT_TO_TBL,
-                .priority = UINT_MAX,
-                .tos = UINT8_MAX,
-                .fwmark = UINT_MAX,
-        };
-
-        *ret = rule;
-        return 0;
-}
-
-void routing_policy_rule_free(RoutingPolicyRule *rule) {
-        if (!rule)
-                return;
-
-        free(rule->sport_str);
-        free(rule->dport_str);
-        free(rule->ipproto_str);
-        free(rule);
-}
-
 static int routing_policy_rules_new(RoutingPolicyRules **ret) {
         RoutingPolicyRules *rule;
         int r;
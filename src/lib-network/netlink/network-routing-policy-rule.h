@@ -65,5 +65,8 @@ DEFINE_CLEANUP(RoutingPolicyRules *, routing_policy_rules_free);
 int routing_policy_rule_new(RoutingPolicyRule **ret);
 void routing_policy_rule_free(RoutingPolicyRule *rule);
 
+guint routing_policy_rule_hash(gconstpointer p);
+gboolean routing_policy_rule_equal(gconstpointer a, gconstpointer b);
+
 DEFINE_CLEANUP(RoutingPolicyRule *, routing_policy_rule_free);
 int acquire_routing_policy_rules(RoutingPolicyRules **ret);
@@ -4,16 +4,46 @@
 
 #include "alloc-util.h"
 #include "config-parser.h"
+#include "log.h"
 #include "networkd-api.h"
+#include "networkd-state-cache.h"
 #include "string-util.h"
 
+/* Looks a key up in a networkd state file, served from the in-memory cache when it is enabled */
+static int netif_parse_state(const char *path, const char *key, char **ret) {
+        _auto_cleanup_hash_ GHashTable *table = NULL;
+        const char *v;
+        int r;
+
+        assert(path);
+        assert(key);
+        assert(ret);
+
+        if (!netif_state_cache_enabled())
+                return parse_state_file(path, key, ret, NULL);
+
+        r = netif_state_cache_acquire(path, &table);
+        if (r < 0)
+                return r;
+
+        v = g_hash_table_lookup(table, key);
+        if (!v)
+                return -ENOENT;
+
+        *ret = g_strdup(v);
+        if (!*ret)
+                return log_oom();
+
+        return 0;
+}
+
 int network_parse_string(const char *key, char **state) {
         _auto_cleanup_ char *s = NULL;
         int r;
 
         assert(state);
 
-        r = parse_state_file("/run/systemd/netif/state", key, &s, NULL);
+        r = netif_parse_state("/run/systemd/netif/state", key, &s);
         if (r < 0)
                 return r;
 
@@ -50,7 +80,7 @@ static int network_parse_strv(const char *key, char ***ret) {
 
         assert(ret);
 
-        r = parse_state_file("/run/systemd/netif/state", key, &s, NULL);
+        r = netif_parse_state("/run/systemd/netif/state", key, &s);
         if (r < 0)
                 return r;
 
@@ -87,7 +117,7 @@ static int network_parse_link_strv(int ifindex, const char *key, char ***ret) {
         assert(ret);
 
         asprintf(&path, "/run/systemd/netif/links/%i", ifindex);
-        r = parse_state_file(path, key, &s, NULL);
+        r = netif_parse_state(path, key, &s);
         if (r < 0)
                 return r;
 
@@ -108,7 +138,7 @@ static int network_parse_link_string(int ifindex, const char *key, char **ret) {
         assert(ret);
 
         asprintf(&path, "/run/systemd/netif/links/%i", ifindex);
-        r = parse_state_file(path, key, &s, NULL);
+        r = netif_parse_state(path, key, &s);
         if (r < 0)
                 return r;
 
@@ -129,7 +159,7 @@ static int network_parse_link_lease_strv(int ifindex, const char *key, char ***r
         assert(ret);
 
         asprintf(&path, "/run/systemd/netif/leases/%i", ifindex);
-        r = parse_state_file(path, key, &s, NULL);
+        r = netif_parse_state(path, key, &s);
         if (r < 0)
                 return r;
 
@@ -150,7 +180,7 @@ static int network_parse_link_lease_string(int ifindex, const char *key, char **
         assert(ret);
 
         asprintf(&path, "/run/systemd/netif/leases/%i", ifindex);
-        r = parse_state_file(path, key, &s, NULL);
+        r = netif_parse_state(path, key, &s);
         if (r < 0)
                 return r;
 
@@ -286,3 +316,268 @@ int network_parse_link_dhcp4_search_domains(int ifindex, char ***ret) {
 int network_parse_link_dhcp4_ntp(int ifindex, char ***ret) {
         return network_parse_link_lease_strv(ifindex, "NTP", ret);
 }
+
+static char *state_table_get_string(GHashTable *table, const char *key) {
+        const char *v;
+
+        v = g_hash_table_lookup(table, key);
+        if (isempty(v))
+                return NULL;
+
+        return g_strdup(v);
+}
+
+static char **state_table_get_strv(GHashTable *table, const char *key) {
+        const char *v;
+
+        v = g_hash_table_lookup(table, key);
+        if (isempty(v))
+                return NULL;
+
+        return strsplit(v, " ", -1);
+}
+
+int link_state_snapshot_new(int ifindex, LinkStateSnapshot **ret) {
+        _cleanup_(link_state_snapshot_freep) LinkStateSnapshot *s = NULL;
+        _auto_cleanup_hash_ GHashTable *table = NULL;
+        _auto_cleanup_ char *path = NULL;
+        int r;
+
+        assert(ifindex > 0);
+        assert(ret);
+
+        asprintf(&path, "/run/systemd/netif/links/%i", ifindex);
+        r = netif_state_cache_acquire(path, &table);
+        if (r < 0)
+                return r;
+
+        s = new0(LinkStateSnapshot, 1);
+        if (!s)
+                return log_oom();
+
+        *s = (LinkStateSnapshot) {
+                .ifindex = ifindex,
+                .setup_state = state_table_get_string(table, "ADMIN_STATE"),
+                .operational_state = state_table_get_string(table, "OPER_STATE"),
+                .address_state = state_table_get_string(table, "ADDRESS_STATE"),
+                .ipv4_state = state_table_get_string(table, "IPV4_ADDRESS_STATE"),
+                .ipv6_state = state_table_get_string(table, "IPV6_ADDRESS_STATE"),
+                .online_state = state_table_get_string(table, "ONLINE_STATE"),
+                .required_for_online = state_table_get_string(table, "REQUIRED_FOR_ONLINE"),
+                .activation_policy = state_table_get_string(table, "ACTIVATION_POLICY"),
+                .network_file = state_table_get_string(table, "NETWORK_FILE"),
+                .llmnr = state_table_get_string(table, "LLMNR"),
+                .mdns = state_table_get_string(table, "MDNS"),
+                .dnssec = state_table_get_string(table, "DNSSEC"),
+                .dnssec_nta = state_table_get_string(table, "DNSSEC_NTA"),
+                .timezone = state_table_get_string(table, "TIMEZONE"),
+                .dhcp6_client_iaid = state_table_get_string(table, "DHCP6_CLIENT_IAID"),
+                .dhcp6_client_duid = state_table_get_string(table, "DHCP6_CLIENT_DUID"),
+                .dns = state_table_get_strv(table, "DNS"),
+                .ntp = state_table_get_strv(table, "NTP"),
+                .search_domains = state_table_get_strv(table, "DOMAINS"),
+                .route_domains = state_table_get_strv(table, "ROUTE_DOMAINS"),
+                .addresses = state_table_get_strv(table, "ADDRESSES"),
+        };
+
+        *ret = steal_ptr(s);
+        return 0;
+}
+
+void link_state_snapshot_free(LinkStateSnapshot *s) {
+        if (!s)
+                return;
+
+        g_free(s->setup_state);
+        g_free(s->operational_state);
+        g_free(s->address_state);
+        g_free(s->ipv4_state);
+        g_free(s->ipv6_state);
+        g_free(s->online_state);
+        g_free(s->required_for_online);
+        g_free(s->activation_policy);
+        g_free(s->network_file);
+        g_free(s->llmnr);
+        g_free(s->mdns);
+        g_free(s->dnssec);
+        g_free(s->dnssec_nta);
+        g_free(s->timezone);
+        g_free(s->dhcp6_client_iaid);
+        g_free(s->dhcp6_client_duid);
+
+        strv_free(s->dns);
+        strv_free(s->ntp);
+        strv_free(s->search_domains);
+        strv_free(s->route_domains);
+        strv_free(s->addresses);
+
+        g_free(s->dhcp4_address);
+        g_free(s->dhcp4_server_address);
+        g_free(s->dhcp4_router);
+        g_free(s->dhcp4_client_id);
+        g_free(s->dhcp4_lifetime);
+        g_free(s->dhcp4_t1);
+        g_free(s->dhcp4_t2);
+
+        strv_free(s->dhcp4_dns);
+        strv_free(s->dhcp4_search_domains);
+        strv_free(s->dhcp4_ntp);
+
+        g_free(s);
+}
+
+/* Most links have no DHCPv4 lease, so the lease file is only read when one of its keys is asked for */
+static void link_state_snapshot_load_lease(LinkStateSnapshot *s) {
+        _auto_cleanup_hash_ GHashTable *table = NULL;
+        _auto_cleanup_ char *path = NULL;
+
+        assert(s);
+
+        if (s->lease_loaded)
+                return;
+
+        s->lease_loaded = true;
+
+        asprintf(&path, "/run/systemd/netif/leases/%i", s->ifindex);
+        if (netif_state_cache_acquire(path, &table) < 0)
+                return;
+
+        s->dhcp4_address = state_table_get_string(table, "ADDRESS");
+        s->dhcp4_server_address = state_table_get_string(table, "SERVER_ADDRESS");
+        s->dhcp4_router = state_table_get_string(table, "ROUTER");
+        s->dhcp4_client_id = state_table_get_string(table, "CLIENTID");
+        s->dhcp4_lifetime = state_table_get_string(table, "LIFETIME");
+        s->dhcp4_t1 = state_table_get_string(table, "T1");
+        s->dhcp4_t2 = state_table_get_string(table, "T2");
+        s->dhcp4_dns = state_table_get_strv(table, "DNS");
+        s->dhcp4_search_domains = state_table_get_strv(table, "DOMAINS");
+        s->dhcp4_ntp = state_table_get_strv(table, "NTP");
+}
+
+const char *link_state_snapshot_setup_state(const LinkStateSnapshot *s) {
+        return s ? s->setup_state : NULL;
+}
+
+const char *link_state_snapshot_operational_state(const LinkStateSnapshot *s) {
+        return s ? s->operational_state : NULL;
+}
+
+const char *link_state_snapshot_address_state(const LinkStateSnapshot *s) {
+        return s ? s->address_state : NULL;
+}
+
+const char *link_state_snapshot_ipv4_state(const LinkStateSnapshot *s) {
+        return s ? s->ipv4_state : NULL;
+}
+
+const char *link_state_snapshot_ipv6_state(const LinkStateSnapshot *s) {
+        return s ? s->ipv6_state : NULL;
+}
+
+const char *link_state_snapshot_online_state(const LinkStateSnapshot *s) {
+        return s ? s->online_state : NULL;
+}
+
+const char *link_state_snapshot_required_for_online(const LinkStateSnapshot *s) {
+        return s ? s->required_for_online : NULL;
+}
+
+const char *link_state_snapshot_activation_policy(const LinkStateSnapshot *s) {
+        return s ? s->activation_policy : NULL;
+}
+
+const char *link_state_snapshot_network_file(const LinkStateSnapshot *s) {
+        return s ? s->network_file : NULL;
+}
+
+const char *link_state_snapshot_timezone(const LinkStateSnapshot *s) {
+        return s ? s->timezone : NULL;
+}
+
+const char *link_state_snapshot_dhcp6_client_iaid(const LinkStateSnapshot *s) {
+        return s ? s->dhcp6_client_iaid : NULL;
+}
+
+const char *link_state_snapshot_dhcp6_client_duid(const LinkStateSnapshot *s) {
+        return s ? s->dhcp6_client_duid : NULL;
+}
+
+char **link_state_snapshot_dns(const LinkStateSnapshot *s) {
+        return s ? s->dns : NULL;
+}
+
+char **link_state_snapshot_ntp(const LinkStateSnapshot *s) {
+        return s ? s->ntp : NULL;
+}
+
+char **link_state_snapshot_search_domains(const LinkStateSnapshot *s) {
+        return s ? s->search_domains : NULL;
+}
+
+char **link_state_snapshot_route_domains(const LinkStateSnapshot *s) {
+        return s ? s->route_domains : NULL;
+}
+
+const char *link_state_snapshot_dhcp4_server_address(LinkStateSnapshot *s) {
+        if (!s)
+                return NULL;
+
+        link_state_snapshot_load_lease(s);
+        return s->dhcp4_server_address;
+}
+
+const char *link_state_snapshot_dhcp4_router(LinkStateSnapshot *s) {
+        if (!s)
+                return NULL;
+
+        link_state_snapshot_load_lease(s);
+        return s->dhcp4_router;
+}
+
+const char *link_state_snapshot_dhcp4_client_id(LinkStateSnapshot *s) {
+        if (!s)
+                return NULL;
+
+        link_state_snapshot_load_lease(s);
+        return s->dhcp4_client_id;
+}
+
+const char *link_state_snapshot_dhcp4_lifetime(LinkStateSnapshot *s) {
+        if (!s)
+                return NULL;
+
+        link_state_snapshot_load_lease(s);
+        return s->dhcp4_lifetime;
+}
+
+const char *link_state_snapshot_dhcp4_t1(LinkStateSnapshot *s) {
+        if (!s)
+                return NULL;
+
+        link_state_snapshot_load_lease(s);
+        return s->dhcp4_t1;
+}
+
+const char *link_state_snapshot_dhcp4_t2(LinkStateSnapshot *s) {
+        if (!s)
+                return NULL;
+
+        link_state_snapshot_load_lease(s);
+        return s->dhcp4_t2;
+}
+
+char **link_state_snapshot_dhcp4_dns(LinkStateSnapshot *s) {
+        if (!s)
+                return NULL;
+
+        link_state_snapshot_load_lease(s);
+        return s->dhcp4_dns;
+}
+
+char **link_state_snapshot_dhcp4_ntp(LinkStateSnapshot *s) {
+        if (!s)
+                return NULL;
+
+        link_state_snapshot_load_lease(s);
+        return s->dhcp4_ntp;
+}
@@ -3,6 +3,83 @@
  */
 #pragma once
 
+#include <stdbool.h>
+
+#include "alloc-util.h"
+
+/* Contents of /run/systemd/netif/links/<ifindex> (and lazily the DHCPv4 lease file), read once */
+typedef struct LinkStateSnapshot {
+        int ifindex;
+
+        char *setup_state;
+        char *operational_state;
+        char *address_state;
+        char *ipv4_state;
+        char *ipv6_state;
+        char *online_state;
+        char *required_for_online;
+        char *activation_policy;
+        char *network_file;
+        char *llmnr;
+        char *mdns;
+        char *dnssec;
+        char *dnssec_nta;
+        char *timezone;
+        char *dhcp6_client_iaid;
+        char *dhcp6_client_duid;
+
+        char **dns;
+        char **ntp;
+        char **search_domains;
+        char **route_domains;
+        char **addresses;
+
+        char *dhcp4_address;
+        char *dhcp4_server_address;
+        char *dhcp4_router;
+        char *dhcp4_client_id;
+        char *dhcp4_lifetime;
+        char *dhcp4_t1;
+        char *dhcp4_t2;
+
+        char **dhcp4_dns;
+        char **dhcp4_search_domains;
+        char **dhcp4_ntp;
+
+        bool lease_loaded;
+} LinkStateSnapshot;
+
+int link_state_snapshot_new(int ifindex, LinkStateSnapshot **ret);
+void link_state_snapshot_free(LinkStateSnapshot *s);
+DEFINE_CLEANUP(LinkStateSnapshot*, link_state_snapshot_free);
+
+const char *link_state_snapshot_setup_state(const LinkStateSnapshot *s);
+const char *link_state_snapshot_operational_state(const LinkStateSnapshot *s);
+const char *link_state_snapshot_address_state(const LinkStateSnapshot *s);
+const char *link_state_snapshot_ipv4_state(const LinkStateSnapshot *s);
+const char *link_state_snapshot_ipv6_state(const LinkStateSnapshot *s);
+const char *link_state_snapshot_online_state(const LinkStateSnapshot *s);
+const char *link_state_snapshot_required_for_online(const LinkStateSnapshot *s);
+const char *link_state_snapshot_activation_policy(const LinkStateSnapshot *s);
+const char *link_state_snapshot_network_file(const LinkStateSnapshot *s);
+const char *link_state_snapshot_timezone(const LinkStateSnapshot *s);
+const char *link_state_snapshot_dhcp6_client_iaid(const LinkStateSnapshot *s);
+const char *link_state_snapshot_dhcp6_client_duid(const LinkStateSnapshot *s);
+
+char **link_state_snapshot_dns(const LinkStateSnapshot *s);
+char **link_state_snapshot_ntp(const LinkStateSnapshot *s);
+char **link_state_snapshot_search_domains(const LinkStateSnapshot *s);
+char **link_state_snapshot_route_domains(const LinkStateSnapshot *s);
+
+const char *link_state_snapshot_dhcp4_server_address(LinkStateSnapshot *s);
+const char *link_state_snapshot_dhcp4_router(LinkStateSnapshot *s);
+const char *link_state_snapshot_dhcp4_client_id(LinkStateSnapshot *s);
+const char *link_state_snapshot_dhcp4_lifetime(LinkStateSnapshot *s);
+const char *link_state_snapshot_dhcp4_t1(LinkStateSnapshot *s);
+const char *link_state_snapshot_dhcp4_t2(LinkStateSnapshot *s);
+char **link_state_snapshot_dhcp4_dns(LinkStateSnapshot *s);
+char **link_state_snapshot_dhcp4_ntp(LinkStateSnapshot *s);
+
 
 int network_parse_string(const char *key, char **state);
 int network_parse_operational_state(char **state);
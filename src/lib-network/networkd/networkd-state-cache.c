@@ -0,0 +1,381 @@
+/* Copyright 2024 VMware, Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <network-config-manager.h>
+
+#include <fcntl.h>
+#include <sys/inotify.h>
+
+#include "alloc-util.h"
+#include "config-parser.h"
+#include "log.h"
+#include "macros.h"
+#include "networkd-state-cache.h"
+#include "parse-util.h"
+#include "string-util.h"
+
+#define NETIF_STATE_DIR        "/run/systemd/netif"
+#define NETIF_LINKS_STATE_DIR  "/run/systemd/netif/links"
+#define NETIF_LEASES_STATE_DIR "/run/systemd/netif/leases"
+
+#define NETIF_STATE_WATCH_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_CREATE)
+
+static const char *const netif_state_dirs[] = {
+        NETIF_STATE_DIR,
+        NETIF_LINKS_STATE_DIR,
+        NETIF_LEASES_STATE_DIR,
+};
+
+typedef struct NetifStateHandler {
+        NetifStateChangedHandler handler;
+        void *userdata;
+} NetifStateHandler;
+
+/* Keeps parsed networkd state files in memory. A path maps either to its parsed key/value table or to NULL
+ * when the file does not exist, so that links without a lease do not hit the file system again either.
+ * Entries are dropped as soon as inotify reports the file as written, renamed or removed.
+ *
+ * The cache is process wide and shared by nmctl, NcmContext, watch and embedders. Every successful
+ * netif_state_cache_enable() takes a reference and installs its handler next to the others, the matching
+ * netif_state_cache_disable() removes that handler again. The cache goes away with the last reference. */
+typedef struct NetifStateCache {
+        GMutex lock;
+        unsigned n_ref;
+
+        int fd;
+        int wd[ELEMENTSOF(netif_state_dirs)];
+
+        GHashTable *files;
+        GArray *changed;
+        GArray *handlers;
+} NetifStateCache;
+
+static NetifStateCache cache = {
+        .fd = -1,
+};
+
+static void state_table_unref(gpointer p) {
+        if (p)
+                g_hash_table_unref(p);
+}
+
+static void netif_state_cache_changed(int ifindex) {
+        if (cache.handlers->len > 0)
+                g_array_append_val(cache.changed, ifindex);
+}
+
+static void netif_state_cache_add_handler(NetifStateChangedHandler handler, void *userdata) {
+        NetifStateHandler h = {
+                .handler = handler,
+                .userdata = userdata,
+        };
+
+        if (handler)
+                g_array_append_val(cache.handlers, h);
+}
+
+static void netif_state_cache_remove_handler(NetifStateChangedHandler handler, void *userdata) {
+        if (!handler)
+                return;
+
+        for (guint i = 0; i < cache.handlers->len; i++) {
+                NetifStateHandler *h = &g_array_index(cache.handlers, NetifStateHandler, i);
+
+                if (h->handler == handler && h->userdata == userdata) {
+                        g_array_remove_index(cache.handlers, i);
+                        return;
+                }
+        }
+}
+
+static void netif_state_cache_invalidate(const char *dir, const char *name) {
+        _auto_cleanup_ char *path = NULL;
+        int ifindex = 0;
+
+        if (streq(dir, NETIF_STATE_DIR)) {
+                if (!streq(name, "state"))
+                        return;
+        } else if (parse_int(name, &ifindex) < 0)
+                return;
+
+        path = g_build_filename(dir, name, NULL);
+        if (!path)
+                return;
+
+        g_hash_table_remove(cache.files, path);
+        netif_state_cache_changed(ifindex);
+}
+
+/* Called with the lock held. networkd creates the leases directory only once the first lease is saved, so it is
+ * picked up from the parent directory when it shows up. Whatever was cached as missing below it is dropped then. */
+static void netif_state_cache_watch_leases(void) {
+        size_t i = ELEMENTSOF(netif_state_dirs) - 1;
+
+        if (cache.wd[i] >= 0)
+                return;
+
+        cache.wd[i] = inotify_add_watch(cache.fd, netif_state_dirs[i], NETIF_STATE_WATCH_MASK);
+        if (cache.wd[i] < 0)
+                return;
+
+        g_hash_table_remove_all(cache.files);
+        netif_state_cache_changed(0);
+}
+
+/* Called with the lock held. Reads whatever inotify has queued without blocking. */
+static int netif_state_cache_drain(void) {
+        char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+        for (;;) {
+                ssize_t n;
+
+                n = read(cache.fd, buf, sizeof(buf));
+                if (n < 0) {
+                        if (errno == EAGAIN || errno == EINTR)
+                                return 0;
+
+                        return -errno;
+                }
+                if (n == 0)
+                        return 0;
+
+                for (char *p = buf; p < buf + n; ) {
+                        struct inotify_event *e = (struct inotify_event *) p;
+
+                        p += sizeof(struct inotify_event) + e->len;
+
+                        if (e->mask & IN_Q_OVERFLOW) {
+                                g_hash_table_remove_all(cache.files);
+                                netif_state_cache_changed(0);
+                                continue;
+                        }
+
+                        /* The leases directory went away, watch it again once it is recreated */
+                        if (e->mask & IN_IGNORED) {
+                                if (e->wd == cache.wd[ELEMENTSOF(netif_state_dirs) - 1])
+                                        cache.wd[ELEMENTSOF(netif_state_dirs) - 1] = -1;
+                                continue;
+                        }
+
+                        if (e->len == 0)
+                                continue;
+
+                        if (e->wd == cache.wd[0] && streq(e->name, "leases") && (e->mask & (IN_CREATE | IN_MOVED_TO))) {
+                                netif_state_cache_watch_leases();
+                                continue;
+                        }
+
+                        for (size_t i = 0; i < ELEMENTSOF(netif_state_dirs); i++)
+                                if (cache.wd[i] == e->wd) {
+                                        netif_state_cache_invalidate(netif_state_dirs[i], e->name);
+                                        break;
+                                }
+                }
+        }
+}
+
+int netif_state_cache_enable(NetifStateChangedHandler handler, void *userdata) {
+        _auto_cleanup_close_ int fd = -1;
+        int wd[ELEMENTSOF(netif_state_dirs)];
+
+        g_mutex_lock(&cache.lock);
+
+        if (cache.n_ref > 0) {
+                cache.n_ref++;
+                netif_state_cache_add_handler(handler, userdata);
+                g_mutex_unlock(&cache.lock);
+                return 0;
+        }
+
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0) {
+                g_mutex_unlock(&cache.lock);
+                return -errno;
+        }
+
+        /* Watches must be in place before anything is cached, otherwise an update racing with the first read is lost */
+        for (size_t i = 0; i < ELEMENTSOF(netif_state_dirs); i++) {
+                wd[i] = inotify_add_watch(fd, netif_state_dirs[i], NETIF_STATE_WATCH_MASK);
+                if (wd[i] < 0) {
+                        int r = -errno;
+
+                        /* No lease has been saved yet, the directory is watched once it is created */
+                        if (r == -ENOENT && streq(netif_state_dirs[i], NETIF_LEASES_STATE_DIR))
+                                continue;
+
+                        g_mutex_unlock(&cache.lock);
+                        log_debug("Failed to watch %s: %s", netif_state_dirs[i], strerror(-r));
+                        return r;
+                }
+        }
+
+        cache.files = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, state_table_unref);
+        cache.changed = g_array_new(false, false, sizeof(int));
+        cache.handlers = g_array_new(false, false, sizeof(NetifStateHandler));
+        memcpy(cache.wd, wd, sizeof(wd));
+        cache.fd = steal_fd(fd);
+        cache.n_ref = 1;
+
+        netif_state_cache_add_handler(handler, userdata);
+
+        g_mutex_unlock(&cache.lock);
+        return 0;
+}
+
+/* Drops the reference taken by netif_state_cache_enable() with the same handler and userdata */
+void netif_state_cache_disable(NetifStateChangedHandler handler, void *userdata) {
+        g_mutex_lock(&cache.lock);
+
+        if (cache.n_ref == 0) {
+                g_mutex_unlock(&cache.lock);
+                return;
+        }
+
+        netif_state_cache_remove_handler(handler, userdata);
+
+        if (--cache.n_ref > 0) {
+                g_mutex_unlock(&cache.lock);
+                return;
+        }
+
+        if (cache.fd >= 0) {
+                close(cache.fd);
+                cache.fd = -1;
+        }
+
+        if (cache.files) {
+                g_hash_table_unref(cache.files);
+                cache.files = NULL;
+        }
+
+        if (cache.changed) {
+                g_array_unref(cache.changed);
+                cache.changed = NULL;
+        }
+
+        if (cache.handlers) {
+                g_array_unref(cache.handlers);
+                cache.handlers = NULL;
+        }
+
+        g_mutex_unlock(&cache.lock);
+}
+
+bool netif_state_cache_enabled(void) {
+        bool enabled;
+
+        g_mutex_lock(&cache.lock);
+        enabled = cache.fd >= 0;
+        g_mutex_unlock(&cache.lock);
+
+        return enabled;
+}
+
+/* For callers that run their own event loop: poll this for POLLIN and then call netif_state_cache_process() */
+int netif_state_cache_get_fd(void) {
+        int fd;
+
+        g_mutex_lock(&cache.lock);
+        fd = cache.fd >= 0 ? cache.fd : -EBADF;
+        g_mutex_unlock(&cache.lock);
+
+        return fd;
+}
+
+/* Applies all pending invalidations and delivers the "link state changed" notifications. Returns the number of
+ * notifications delivered. */
+int netif_state_cache_process(void) {
+        _cleanup_(g_array_unrefp) GArray *changed = NULL, *handlers = NULL;
+        int r;
+
+        g_mutex_lock(&cache.lock);
+
+        if (cache.fd < 0) {
+                g_mutex_unlock(&cache.lock);
+                return -EBADF;
+        }
+
+        r = netif_state_cache_drain();
+        if (r < 0) {
+                g_mutex_unlock(&cache.lock);
+                return r;
+        }
+
+        changed = steal_ptr(cache.changed);
+        cache.changed = g_array_new(false, false, sizeof(int));
+        handlers = g_array_sized_new(false, false, sizeof(NetifStateHandler), cache.handlers->len);
+        g_array_append_vals(handlers, cache.handlers->data, cache.handlers->len);
+
+        g_mutex_unlock(&cache.lock);
+
+        /* Handlers run unlocked so that they can query the cache again */
+        for (guint i = 0; i < changed->len; i++)
+                for (guint j = 0; j < handlers->len; j++) {
+                        NetifStateHandler *h = &g_array_index(handlers, NetifStateHandler, j);
+
+                        h->handler(g_array_index(changed, int, i), h->userdata);
+                }
+
+        return changed->len;
+}
+
+/* Returns a reference to the parsed key/value table of a networkd state file. The table must not be modified. */
+int netif_state_cache_acquire(const char *path, GHashTable **ret) {
+        _auto_cleanup_hash_ GHashTable *table = NULL;
+        gpointer v = NULL;
+        int r;
+
+        assert(path);
+        assert(ret);
+
+        g_mutex_lock(&cache.lock);
+
+        if (cache.fd < 0) {
+                g_mutex_unlock(&cache.lock);
+                return parse_state_file(path, NULL, NULL, ret);
+        }
+
+        (void) netif_state_cache_drain();
+
+        if (g_hash_table_lookup_extended(cache.files, path, NULL, &v)) {
+                g_mutex_unlock(&cache.lock);
+
+                if (!v)
+                        return -ENOENT;
+
+                *ret = g_hash_table_ref(v);
+                return 0;
+        }
+
+        r = parse_state_file(path, NULL, NULL, &table);
+        if (r < 0 && r != -ENOENT) {
+                g_mutex_unlock(&cache.lock);
+                return r;
+        }
+
+        g_hash_table_insert(cache.files, g_strdup(path), table ? g_hash_table_ref(table) : NULL);
+        g_mutex_unlock(&cache.lock);
+
+        if (!table)
+                return -ENOENT;
+
+        *ret = steal_ptr(table);
+        return 0;
+}
+
+_public_ int ncm_state_cache_enable(NetifStateChangedHandler handler, void *userdata) {
+        return netif_state_cache_enable(handler, userdata);
+}
+
+_public_ void ncm_state_cache_disable(NetifStateChangedHandler handler, void *userdata) {
+        netif_state_cache_disable(handler, userdata);
+}
+
+_public_ int ncm_state_cache_get_fd(void) {
+        return netif_state_cache_get_fd();
+}
+
+_public_ int ncm_state_cache_process(void) {
+        return netif_state_cache_process();
+}
@@ -0,0 +1,19 @@
+/* Copyright 2024 VMware, Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <glib.h>
+#include <stdbool.h>
+
+/* ifindex is 0 when the system wide state file changed or the whole cache had to be dropped */
+typedef void (*NetifStateChangedHandler)(int ifindex, void *userdata);
+
+int netif_state_cache_enable(NetifStateChangedHandler handler, void *userdata);
+void netif_state_cache_disable(NetifStateChangedHandler handler, void *userdata);
+bool netif_state_cache_enabled(void);
+
+int netif_state_cache_get_fd(void);
+int netif_state_cache_process(void);
+
+int netif_state_cache_acquire(const char *path, GHashTable **ret);
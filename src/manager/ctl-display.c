@@ -13,6 +13,7 @@
 #include "arphrd-to-name.h"
 #include "config-parser.h"
 #include "ctl-display.h"
+#include "ctl-watch.h"
 #include "ctl.h"
 #include "dbus.h"
 #include "device.h"
@@ -33,12 +34,50 @@
 #include "udev-hwdb.h"
 
 static bool arg_json = false;
+static JsonWriterFormat arg_output = JSON_WRITER_FORMAT_JSON;
 static bool arg_network_json = false;
 static bool arg_log = false;
 static bool arg_beautify = true;
+static bool arg_watch = false;
 
 static int arg_log_line;
 
+/* nmctl logs: realtime bounds in µs and where to resume, 0 and NULL when unset */
+static uint64_t arg_log_since = 0;
+static uint64_t arg_log_until = 0;
+static const char *arg_log_cursor = NULL;
+static bool arg_log_follow = false;
+
+/* --fields=, the link properties to show in their JSON names. Empty shows all. */
+static char **arg_fields = NULL;
+
+/* Link properties that are only known after asking networkd to describe the link */
+static const char *const link_network_data_fields[] = {
+        "Addresses",
+        "IPv6LinkLocalAddress",
+        "Routes",
+        "DNS",
+        "SearchDomains",
+        "DNSSettings",
+        "DHCPv4Client",
+        "DHCPv6Client",
+        "NTP",
+        NULL,
+};
+
+/* Link properties read from the udev database and the .link file */
+static const char *const link_device_fields[] = {
+        "Kind",
+        "Type",
+        "Path",
+        "Driver",
+        "Vendor",
+        "Model",
+        "HardwareDescription",
+        "LinkFile",
+        NULL,
+};
+
 void set_json(bool k) {
         arg_json = k;
 }
@@ -51,6 +90,16 @@ bool json_enabled(void) {
         return arg_json;
 }
 
+/* --output=cbor implies --json, every machine readable output goes through JsonWriter */
+void set_output_format(JsonWriterFormat format) {
+        arg_output = format;
+        arg_json = true;
+}
+
+JsonWriterFormat output_format(void) {
+        return arg_output;
+}
+
 void set_beautify(bool k) {
         arg_beautify = k;
 }
@@ -59,6 +108,14 @@ bool beautify_enabled(void) {
         return arg_beautify;
 }
 
+void set_watch(bool k) {
+        arg_watch = k;
+}
+
+bool watch_enabled(void) {
+        return arg_watch;
+}
+
 void set_log(bool k, int size) {
         arg_log = k;
         arg_log_line = size;
@@ -68,6 +125,73 @@ bool log_enabled(void) {
         return arg_log;
 }
 
+void set_log_since(uint64_t usec) {
+        arg_log_since = usec;
+}
+
+void set_log_until(uint64_t usec) {
+        arg_log_until = usec;
+}
+
+void set_log_cursor(const char *cursor) {
+        arg_log_cursor = cursor;
+}
+
+void set_log_follow(bool k) {
+        arg_log_follow = k;
+}
+
+int set_fields(const char *fields) {
+        _auto_cleanup_strv_ char **s = NULL;
+
+        assert(fields);
+
+        s = strsplit(fields, ",", -1);
+        if (!s)
+                return -ENOMEM;
+
+        for (char **f = s; *f; f++)
+                if (isempty(g_strstrip(*f)))
+                        return -EINVAL;
+
+        g_strfreev(arg_fields);
+        arg_fields = steal_ptr(s);
+        return 0;
+}
+
+bool field_enabled(const char *field) {
+        char **f;
+
+        assert(field);
+
+        if (strv_empty((const char **) arg_fields))
+                return true;
+
+        strv_foreach(f, arg_fields)
+                if (streq_fold(*f, field))
+                        return true;
+
+        return false;
+}
+
+bool fields_enabled(const char *const *fields) {
+        assert(fields);
+
+        for (const char *const *f = fields; *f; f++)
+                if (field_enabled(*f))
+                        return true;
+
+        return false;
+}
+
+bool link_fields_need_network_data(void) {
+        return fields_enabled(link_network_data_fields);
+}
+
+bool link_fields_need_device(void) {
+        return fields_enabled(link_device_fields);
+}
+
 int get_log_line(void) {
         return arg_log_line;
 }
@@ -83,7 +207,7 @@ static void system_online_state_to_color(const char *state, const char **on) {
                 *on = ansi_color_reset();
 }
 
-static void link_state_to_color(const char *state, const char **on) {
+void link_state_to_color(const char *state, const char **on) {
         if (streq(state, "routable") || streq(state, "configured") || streq(state,"up"))
                 *on = ansi_color_green();
         else if (streq(state, "failed") || streq(state,"down") || streq(state,"no-carrier") ||
@@ -100,14 +224,20 @@ static void link_state_to_color(const char *state, const char **on) {
 }
 
 static int list_links(int argc, char *argv[]) {
-        _cleanup_(sd_device_unrefp) sd_device *sd_device = NULL;
         _cleanup_(links_freep) Links *h = NULL;
+        _auto_cleanup_hash_ GHashTable *devices = NULL;
         int r;
 
+        if (arg_watch)
+                return watch_links(0);
+
         r = netlink_acquire_all_links(&h);
         if (r < 0)
                 return r;
 
+        /* One walk over the net subsystem instead of a udev lookup per link */
+        (void) net_devices_enumerate(&devices);
+
 
         if (arg_beautify)
                 printf("%s %10s      %8s %13s %15s %10s\n",
@@ -119,15 +249,16 @@ static int list_links(int argc, char *argv[]) {
                        "SETUP");
 
         for (GList *i = h->links; i; i = g_list_next (i)) {
-                const char *setup_color, *operational_color, *operstates, *operstates_color;
-                _auto_cleanup_ char *setup = NULL, *operational = NULL;
+                const char *setup_color, *operational_color, *operstates, *operstates_color, *setup, *operational;
+                _cleanup_(link_state_snapshot_freep) LinkStateSnapshot *state = NULL;
                 Link *link = (Link *) i->data;
-                const char *t = NULL;
+                const NetDevice *dev;
 
                 setup_color = operational_color = operstates = operstates_color = ansi_color_reset();
 
-                (void) network_parse_link_setup_state(link->ifindex, &setup);
-                (void) network_parse_link_operational_state(link->ifindex, &operational);
+                (void) link_state_snapshot_new(link->ifindex, &state);
+                setup = link_state_snapshot_setup_state(state);
+                operational = link_state_snapshot_operational_state(state);
                 operstates = link_operstates_to_name(link->operstate);
 
                 if (setup)
@@ -140,9 +271,9 @@ static int list_links(int argc, char *argv[]) {
                 display(arg_beautify, ansi_color_bold(), "%-8d", link->ifindex);
                 display(arg_beautify, ansi_color_bold_cyan(), "  %-15s ", link->name);
 
-                (void) device_new_from_ifname(&sd_device, link->name);
-                if (sd_device && sd_device_get_devtype(sd_device, &t) >= 0 &&  !isempty(t))
-                        display(arg_beautify, ansi_color_blue_magenta(), "%-12s ", t);
+                dev = net_devices_get(devices, link->ifindex);
+                if (dev && dev->devtype)
+                        display(arg_beautify, ansi_color_blue_magenta(), "%-12s ", dev->devtype);
                 else
                         display(arg_beautify, ansi_color_blue_magenta(), "%-12s ", arphrd_to_name(link->iftype));
 
@@ -154,18 +285,22 @@ static int list_links(int argc, char *argv[]) {
         return 0;
 }
 
+typedef struct LinkAddressDisplay {
+        json_object *jn;
+        LinkStateSnapshot *state;
+} LinkAddressDisplay;
+
 static void list_one_link_addresses(gpointer key, gpointer value, gpointer userdata) {
         _auto_cleanup_ char *c = NULL, *config_source = NULL, *config_provider = NULL, *config_state = NULL;
-        _auto_cleanup_ IfNameIndex *p = NULL;
+        LinkAddressDisplay *d = userdata;
         char buf[IF_NAMESIZE + 1] = {};
-        json_object *jobj = userdata;
         static bool first = true;
         unsigned long size;
         Address *a = NULL;
         int r;
 
         assert(key);
-        assert(jobj);
+        assert(d);
 
         a = (Address *) g_bytes_get_data(key, &size);
         (void) ip_to_str_prefix(a->family, &a->address, &c);
@@ -180,7 +315,7 @@ static void list_one_link_addresses(gpointer key, gpointer value, gpointer userd
                 return;
         }
 
-        r = json_parse_address_config_source(jobj, buf, c, &config_source, &config_provider, &config_state);
+        r = json_parse_address_config_source(d->jn, buf, c, &config_source, &config_provider, &config_state);
         if (r < 0) {
                 config_source = strdup("foreign");
                 if (!config_source)
@@ -188,15 +323,10 @@ static void list_one_link_addresses(gpointer key, gpointer value, gpointer userd
         }
 
         if (streq(config_source, "DHCPv4")) {
-                _auto_cleanup_ char *server = NULL, *life_time = NULL, *t1 = NULL, *t2 = NULL;
-
-                (void) network_parse_link_dhcp4_server_address(a->ifindex, &server);
-                (void) network_parse_link_dhcp4_address_lifetime(a->ifindex, &life_time);
-                (void) network_parse_link_dhcp4_address_lifetime_t1(a->ifindex, &t1);
-                (void) network_parse_link_dhcp4_address_lifetime_t2(a->ifindex, &t2);
-
-                printf("(DHCPv4 via %s) lease time: %s seconds T1: %s seconds T2: %s seconds", str_na(config_provider), str_na(life_time),
-                       str_na(t1), str_na(t2));
+                printf("(DHCPv4 via %s) lease time: %s seconds T1: %s seconds T2: %s seconds", str_na(config_provider),
+                       str_na(link_state_snapshot_dhcp4_lifetime(d->state)),
+                       str_na(link_state_snapshot_dhcp4_t1(d->state)),
+                       str_na(link_state_snapshot_dhcp4_t2(d->state)));
         } else {
                 if (a->family == AF_INET6 && IN6_IS_ADDR_LINKLOCAL(&a->address.in6))
                         printf("(IPv6 Link Local) ");
@@ -305,7 +435,7 @@ _public_ int ncm_display_one_link_addresses(int argc, char *argv[]) {
         if (!set_size(addr->addresses))
                 return -ENODATA;
 
-        r = json_acquire_and_parse_network_data(&jobj);
+        r = json_acquire_and_parse_link_data(p->ifindex, &jobj);
         if (r < 0) {
                 log_warning("Failed acquire network data: %s", strerror(-r));
                 return r;
@@ -351,24 +481,17 @@ _public_ int ncm_display_one_link_addresses(int argc, char *argv[]) {
         return 0;
 }
 
-static int display_one_link_device(Link *l, bool show, char **link_file) {
+static int display_one_link_device(Link *l, const NetDevice *dev, char **link_file) {
         const char *link = NULL, *driver = NULL, *path = NULL, *vendor = NULL, *model = NULL;
-        _cleanup_(sd_device_unrefp) sd_device *sd_device = NULL;
-        const char *t = NULL;
 
         assert(l);
 
-        (void) device_new_from_ifname(&sd_device, l->name);
-        if (sd_device) {
-                (void) sd_device_get_property_value(sd_device, "ID_NET_LINK_FILE", &link);
-                (void) sd_device_get_property_value(sd_device, "ID_NET_DRIVER", &driver);
-                (void) sd_device_get_property_value(sd_device, "ID_PATH", &path);
-
-                if (sd_device_get_property_value(sd_device, "ID_VENDOR_FROM_DATABASE", &vendor) < 0)
-                        (void) sd_device_get_property_value(sd_device, "ID_VENDOR", &vendor);
-
-                if (sd_device_get_property_value(sd_device, "ID_MODEL_FROM_DATABASE", &model) < 0)
-                        (void) sd_device_get_property_value(sd_device, "ID_MODEL", &model);
+        if (dev) {
+                link = dev->link_file;
+                driver = dev->driver;
+                path = dev->path;
+                vendor = dev->vendor;
+                model = dev->model;
         }
         if (l->kind) {
                 display(arg_beautify, ansi_color_bold_cyan(), "                        Kind: ");
@@ -376,8 +499,8 @@ static int display_one_link_device(Link *l, bool show, char **link_file) {
         }
 
         display(arg_beautify, ansi_color_bold_cyan(), "                        Type: ");
-        if (sd_device_get_devtype(sd_device, &t) >= 0 &&  !isempty(t))
-                printf("%s\n", t);
+        if (dev && dev->devtype)
+                printf("%s\n", dev->devtype);
         else
                 printf("%s\n", str_na(arphrd_to_name(l->iftype)));
 
@@ -422,29 +545,33 @@ static void list_link_attributes(Link *l) {
         (void) link_read_sysfs_attribute(l->name, "duplex", &duplex);
         (void) link_read_sysfs_attribute(l->name, "address", &ether);
 
-        if (!isempty(ether)) {
+        if (!isempty(ether) && field_enabled("HardwareAddress")) {
                 _auto_cleanup_ char *desc = NULL;
                 hwdb_get_description((uint8_t *) &l->mac_address.ether_addr_octet, &desc);
 
                 display(arg_beautify, ansi_color_bold_cyan(), "                  HW Address: ");
                 printf("%s (%s)\n", ether, desc);
         }
-        if (l->contains_mtu) {
+        if (l->contains_mtu && field_enabled("MTU")) {
                 display(arg_beautify, ansi_color_bold_cyan(), "                         MTU: ");
                 printf("%d (min: %d max: %d) \n", l->mtu, l->min_mtu, l->max_mtu);
         }
-        if (!isempty(duplex)) {
+        if (!isempty(duplex) && field_enabled("Duplex")) {
                 display(arg_beautify, ansi_color_bold_cyan(), "                      Duplex: ");
                 printf("%s\n", duplex);
         }
-        if (!isempty(speed)) {
+        if (!isempty(speed) && field_enabled("Speed")) {
                 display(arg_beautify, ansi_color_bold_cyan(), "                       Speed: ");
                 printf("%s\n", speed);
         }
-        if (!isempty(l->qdisc)) {
+        if (!isempty(l->qdisc) && field_enabled("QDisc")) {
                 display(arg_beautify, ansi_color_bold_cyan(), "                       QDISC: ");
                 printf("%s \n", l->qdisc);
         }
+        if (!fields_enabled((const char *const[]) { "NTXQueues", "NRXQueues", "IPv6AddressGenerationMode", "GSOMaxSize",
+                                                    "GSOMaxSegments", "TSOMaxSize", "TSOMaxSegments", NULL }))
+                return;
+
         display(arg_beautify, ansi_color_bold_cyan(), "              Queues (Tx/Rx): ");
         printf("%d/%d \n", l->n_tx_queues, l->n_rx_queues);
 
@@ -470,13 +597,12 @@ static void display_alterative_names(gpointer data, gpointer user_data) {
 }
 
 static int list_one_link(int argc, char *argv[]) {
-        _auto_cleanup_ char *setup_state = NULL, *operational_state = NULL, *address_state = NULL, *ipv4_state = NULL,
-                *ipv6_state = NULL, *required_for_online = NULL, *device_activation_policy = NULL, *tz = NULL, *network = NULL,
-                *online_state = NULL, *link = NULL, *dhcp4_identifier = NULL, *dhcp6_duid = NULL, *dhcp6_iaid = NULL, *iaid = NULL,
-                *dhcp4_duid_type = NULL, *dhcp6_duid_type = NULL, *dhcp4_duid_data = NULL, *dhcp6_duid_data = NULL;
-        _auto_cleanup_strv_ char **dns = NULL, **ntp = NULL, **search_domains = NULL, **route_domains = NULL;
-        const char *operational_state_color, *setup_set_color;
+        _auto_cleanup_ char *link = NULL, *iaid = NULL, *dhcp4_duid_type = NULL, *dhcp6_duid_type = NULL,
+                *dhcp4_duid_data = NULL, *dhcp6_duid_data = NULL;
+        const char *operational_state_color, *setup_set_color, *operational_state, *setup_state, *network, *s;
+        _cleanup_(link_state_snapshot_freep) LinkStateSnapshot *state = NULL;
         _cleanup_(json_object_putp) json_object *jn = NULL;
+        char **dns, **ntp, **search_domains, **route_domains;
         _cleanup_(addresses_freep) Addresses *addr = NULL;
         _cleanup_(routes_freep) Routes *route = NULL;
         _cleanup_(link_freep) Link *l = NULL;
@@ -504,41 +630,51 @@ static int list_one_link(int argc, char *argv[]) {
                 return -EINVAL;
         }
 
-        r = json_acquire_and_parse_network_data(&jn);
-        if (r < 0) {
-                log_warning("Failed acquire network data: %s", strerror(-r));
-                return r;
+        if (arg_watch)
+                return watch_links(p->ifindex);
+
+        if (link_fields_need_network_data()) {
+                r = json_acquire_and_parse_link_data(p->ifindex, &jn);
+                if (r < 0) {
+                        log_warning("Failed acquire network data: %s", strerror(-r));
+                        return r;
+                }
         }
 
         if (arg_json)
-                return json_fill_one_link(p, false, jn, NULL);
+                return json_show_one_link(p, false, jn, NULL);
 
         r = netlink_acqure_one_link(p->ifname, &l);
         if (r < 0)
                 return r;
 
-        display(arg_beautify, ansi_color_bold_cyan(), "                        Name: ");
-        printf("%s\n", p->ifname);
-        display(arg_beautify, ansi_color_bold_cyan(), "                       Index: ");
-        printf("%d\n", p->ifindex);
-        if (l->alt_names) {
+        if (field_enabled("Name")) {
+                display(arg_beautify, ansi_color_bold_cyan(), "                        Name: ");
+                printf("%s\n", p->ifname);
+        }
+        if (field_enabled("Index")) {
+                display(arg_beautify, ansi_color_bold_cyan(), "                       Index: ");
+                printf("%d\n", p->ifindex);
+        }
+        if (l->alt_names && field_enabled("AlternativeNames")) {
                 display(arg_beautify, ansi_color_bold_cyan(), "           Alternative names: ");
                 g_ptr_array_foreach(l->alt_names, display_alterative_names, NULL);
                 printf("\n");
         }
 
-        display(arg_beautify, ansi_color_bold_cyan(), "                       Group: ");
-        printf("%d\n", l->group);
-        (void) network_parse_link_operational_state(l->ifindex, &operational_state);
-
-        r = network_parse_link_setup_state(l->ifindex, &setup_state);
-        if (r == -ENODATA) {
-                setup_state = g_strdup("unmanaged");
-                if (!setup_state)
-                        return log_oom();
+        if (field_enabled("Group")) {
+                display(arg_beautify, ansi_color_bold_cyan(), "                       Group: ");
+                printf("%d\n", l->group);
         }
 
-        if (l->flags > 0) {
+        /* Every networkd state below is served from a single read of the link's state file */
+        r = link_state_snapshot_new(l->ifindex, &state);
+        operational_state = link_state_snapshot_operational_state(state);
+        setup_state = link_state_snapshot_setup_state(state);
+        if (r >= 0 && !setup_state)
+                setup_state = "unmanaged";
+
+        if (l->flags > 0 && field_enabled("Flags")) {
                 display(arg_beautify, ansi_color_bold_cyan(), "                       Flags: ");
                 if (l->flags & IFF_UP)
                         printf("up ");
@@ -573,73 +709,87 @@ static int list_one_link(int argc, char *argv[]) {
                 printf("\n");
         }
 
-        link_state_to_color(operational_state, &operational_state_color);
-        link_state_to_color(setup_state, &setup_set_color);
+        link_state_to_color(str_na(operational_state), &operational_state_color);
+        link_state_to_color(str_na(setup_state), &setup_set_color);
 
-        (void) network_parse_link_network_file(l->ifindex, &network);
+        network = link_state_snapshot_network_file(state);
 
-        (void)  display_one_link_device(l, true, &link);
-        display(arg_beautify, ansi_color_bold_cyan(), "                   Link File: ");
-        printf("%s\n", str_na(link));
+        if (link_fields_need_device()) {
+                _cleanup_(net_device_freep) NetDevice *dev = NULL;
 
-        display(arg_beautify, ansi_color_bold_cyan(), "                Network File: ");
-        printf("%s\n", str_na(network));
+                (void) net_device_new_from_ifname(l->name, &dev);
+                (void) display_one_link_device(l, dev, &link);
+                if (field_enabled("LinkFile")) {
+                        display(arg_beautify, ansi_color_bold_cyan(), "                   Link File: ");
+                        printf("%s\n", str_na(link));
+                }
+        }
 
-        display(arg_beautify, ansi_color_bold_cyan(), "                       State: ");
-        display(arg_beautify, operational_state_color, "%s", str_na(operational_state));
-        printf(" (");
-        display(arg_beautify, setup_set_color, "%s", str_na(setup_state));
-        printf(") \n");
+        if (field_enabled("NetworkFile")) {
+                display(arg_beautify, ansi_color_bold_cyan(), "                Network File: ");
+                printf("%s\n", str_na(network));
+        }
 
-        r = network_parse_link_address_state(l->ifindex, &address_state);
-        if (r >= 0) {
+        if (fields_enabled((const char *const[]) { "OperationalState", "SetupState", NULL })) {
+                display(arg_beautify, ansi_color_bold_cyan(), "                       State: ");
+                display(arg_beautify, operational_state_color, "%s", str_na(operational_state));
+                printf(" (");
+                display(arg_beautify, setup_set_color, "%s", str_na(setup_state));
+                printf(") \n");
+        }
+
+        s = link_state_snapshot_address_state(state);
+        if (s && field_enabled("AddressState")) {
                 display(arg_beautify, ansi_color_bold_cyan(), "               Address State: ");
-                printf("%s\n", address_state);
+                printf("%s\n", s);
         }
-        r = network_parse_link_ipv4_state(l->ifindex, &ipv4_state);
-        if (r >= 0) {
+        s = link_state_snapshot_ipv4_state(state);
+        if (s && field_enabled("IPv4AddressState")) {
                 display(arg_beautify, ansi_color_bold_cyan(), "          IPv4 Address State: ");
-                printf("%s\n", ipv4_state);
+                printf("%s\n", s);
         }
-        r = network_parse_link_ipv6_state(l->ifindex, &ipv6_state);
-        if (r >= 0) {
+        s = link_state_snapshot_ipv6_state(state);
+        if (s && field_enabled("IPv6AddressState")) {
                 display(arg_beautify, ansi_color_bold_cyan(), "          IPv6 Address State: ");
-                printf("%s\n", ipv6_state);
+                printf("%s\n", s);
         }
-        r = network_parse_link_online_state(l->ifindex, &online_state);
-        if (r >= 0) {
+        s = link_state_snapshot_online_state(state);
+        if (s && field_enabled("OnlineState")) {
                 display(arg_beautify, ansi_color_bold_cyan(), "                Online State: ");
-                printf("%s\n", online_state);
+                printf("%s\n", s);
         }
-        r = network_parse_link_required_for_online(l->ifindex, &required_for_online);
-        if (r >= 0) {
+        s = link_state_snapshot_required_for_online(state);
+        if (s && field_enabled("RequiredforOnline")) {
                 display(arg_beautify, ansi_color_bold_cyan(), "         Required for Online: ");
-                printf("%s\n", required_for_online);
+                printf("%s\n", s);
         }
-        r = network_parse_link_device_activation_policy(l->ifindex, &device_activation_policy);
-        if (r >= 0) {
+        s = link_state_snapshot_activation_policy(state);
+        if (s && field_enabled("ActivationPolicy")) {
                 display(arg_beautify, ansi_color_bold_cyan(), "           Activation Policy: ");
-                printf("%s\n", device_activation_policy);
+                printf("%s\n", s);
         }
 
         list_link_attributes(l);
 
-        r = netlink_get_one_link_address(l->ifindex, &addr);
+        r = field_enabled("Addresses") ? netlink_get_one_link_address(l->ifindex, &addr) : -ENODATA;
         if (r >= 0 && addr && set_size(addr->addresses) > 0) {
+                LinkAddressDisplay d = {
+                        .jn = jn,
+                        .state = state,
+                };
+
                 display(arg_beautify, ansi_color_bold_cyan(), "                     Address: ");
-                set_foreach(addr->addresses, list_one_link_addresses, jn);
+                set_foreach(addr->addresses, list_one_link_addresses, &d);
         }
 
-        r = netlink_get_one_link_route(l->ifindex, &route);
+        r = field_enabled("Routes") ? netlink_get_one_link_route(l->ifindex, &route) : -ENODATA;
         if (r >= 0 && route && set_size(route->routes) > 0) {
                 _auto_cleanup_ char *config_source = NULL, *config_provider = NULL, *config_state = NULL;
                 _auto_cleanup_strv_ char **gws = NULL;
-                _auto_cleanup_ char *router = NULL;
                 gpointer key, value;
                 GHashTableIter iter;
                 bool first = true;
 
-                r = network_parse_link_dhcp4_router(p->ifindex, &router);
                 display(arg_beautify, ansi_color_bold_cyan(), "                     Gateway: ");
 
                 g_hash_table_iter_init(&iter, route->routes->hash);
@@ -690,74 +840,74 @@ static int list_one_link(int argc, char *argv[]) {
                 printf("\n");
         }
 
-        r = network_parse_link_dns(l->ifindex, &dns);
-        if (r >= 0 && dns) {
-                _auto_cleanup_ char *s = NULL;
+        dns = link_state_snapshot_dns(state);
+        if (dns && field_enabled("DNS")) {
+                _auto_cleanup_ char *j = NULL;
 
-                s = strv_join(" ", dns);
-                if (!s)
+                j = strv_join(" ", dns);
+                if (!j)
                         return log_oom();
 
                 display(arg_beautify, ansi_color_bold_cyan(), "                         DNS: ");
-                printf("%s\n", s);
+                printf("%s\n", j);
         }
 
-        r = network_parse_link_search_domains(l->ifindex, &search_domains);
-        if (r >= 0 && search_domains) {
-                _auto_cleanup_ char *s = NULL;
+        search_domains = link_state_snapshot_search_domains(state);
+        if (search_domains && field_enabled("SearchDomains")) {
+                _auto_cleanup_ char *j = NULL;
 
-                s = strv_join(" ", search_domains);
-                if (!s)
+                j = strv_join(" ", search_domains);
+                if (!j)
                         return log_oom();
 
                 display(arg_beautify, ansi_color_bold_cyan(), "              Search Domains: ");
-                printf("%s\n", s);
+                printf("%s\n", j);
         }
 
-        r = network_parse_link_route_domains(l->ifindex, &route_domains);
-        if (r >= 0 && route_domains) {
-                _auto_cleanup_ char *s = NULL;
+        route_domains = link_state_snapshot_route_domains(state);
+        if (route_domains && field_enabled("RouteDomains")) {
+                _auto_cleanup_ char *j = NULL;
 
-                s = strv_join(" ", route_domains);
-                if (!s)
+                j = strv_join(" ", route_domains);
+                if (!j)
                         return log_oom();
 
                 display(arg_beautify, ansi_color_bold_cyan(), "               Route Domains: ");
-                printf("%s\n", s);
+                printf("%s\n", j);
         }
 
 
-        r = network_parse_link_ntp(l->ifindex, &ntp);
-        if (r >= 0 && ntp) {
-                _auto_cleanup_ char *s = NULL;
+        ntp = link_state_snapshot_ntp(state);
+        if (ntp && field_enabled("NTP")) {
+                _auto_cleanup_ char *j = NULL;
 
-                s = strv_join(" ", ntp);
-                if (!s)
+                j = strv_join(" ", ntp);
+                if (!j)
                         return log_oom();
 
                 display(arg_beautify, ansi_color_bold_cyan(), "                         NTP: ");
-                printf("%s\n", s);
+                printf("%s\n", j);
         }
 
-        r = network_parse_link_timezone(l->ifindex, &tz);
-        if (r >= 0 && tz) {
+        s = link_state_snapshot_timezone(state);
+        if (s && field_enabled("TimeZone")) {
                 display(arg_beautify, ansi_color_bold_cyan(), "                   Time Zone: ");
-                printf("%s\n", tz);
+                printf("%s\n", s);
         }
 
-        r = manager_acquire_link_dhcp_client_iaid(p, DHCP_CLIENT_IPV4, &iaid);
+        r = field_enabled("DHCPv4IAID") ? manager_acquire_link_dhcp_client_iaid(p, DHCP_CLIENT_IPV4, &iaid) : -ENODATA;
         if (r >= 0) {
                 display(arg_beautify, ansi_color_bold_cyan(), "                 DHCPv4 IAID: ");
                 printf("%s\n", iaid);
         }
 
-        r = manager_acquire_link_dhcp_client_iaid(p, DHCP_CLIENT_IPV6, &iaid);
+        r = field_enabled("DHCPv6IAID") ? manager_acquire_link_dhcp_client_iaid(p, DHCP_CLIENT_IPV6, &iaid) : -ENODATA;
         if (r >= 0) {
                 display(arg_beautify, ansi_color_bold_cyan(), "                 DHCPv6 IAID: ");
                 printf("%s\n", iaid);
         }
 
-        r = manager_acquire_link_dhcp_client_duid(p, DHCP_CLIENT_IPV4, &dhcp4_duid_type, &dhcp4_duid_data);
+        r = field_enabled("DHCPv4DUID") ? manager_acquire_link_dhcp_client_duid(p, DHCP_CLIENT_IPV4, &dhcp4_duid_type, &dhcp4_duid_data) : -ENODATA;
         if (r >= 0) {
                 display(arg_beautify, ansi_color_bold_cyan(), "             DHCPv4 DUIDType: ");
                 printf("%s ", dhcp4_duid_type);
@@ -765,7 +915,7 @@ static int list_one_link(int argc, char *argv[]) {
                 printf("%s\n", dhcp4_duid_data);
         }
 
-        r = manager_acquire_link_dhcp_client_duid(p, DHCP_CLIENT_IPV6, &dhcp6_duid_type, &dhcp6_duid_data);
+        r = field_enabled("DHCPv6DUID") ? manager_acquire_link_dhcp_client_duid(p, DHCP_CLIENT_IPV6, &dhcp6_duid_type, &dhcp6_duid_data) : -ENODATA;
         if (r >= 0) {
                 display(arg_beautify, ansi_color_bold_cyan(), "             DHCPv6 DUIDType: ");
                 printf("%s ", dhcp6_duid_type);
@@ -773,10 +923,9 @@ static int list_one_link(int argc, char *argv[]) {
                 printf("%s\n", dhcp6_duid_data);
         }
 
-        r = network_parse_link_dhcp4_client_id(p->ifindex, &dhcp4_identifier);
-        if (r >= 0) {
+        if (link_state_snapshot_dhcp4_client_id(state) && field_enabled("DHCPv4ClientIdentifier")) {
+                _auto_cleanup_ char *c = NULL, *network_path = NULL;
                 _auto_cleanup_ IfNameIndex *ifn = NULL;
-                _auto_cleanup_ char *c = NULL;
 
                 r = parse_ifname_or_index(l->name, &ifn);
                 if (r < 0) {
@@ -784,9 +933,9 @@ static int list_one_link(int argc, char *argv[]) {
                         return r;
                 }
 
-                r = parse_network_file(ifn->ifindex, ifn->ifname, &network);
+                r = parse_network_file(ifn->ifindex, ifn->ifname, &network_path);
                 if (r >= 0) {
-                        r = parse_config_file(network, "DHCPv4", "ClientIdentifier", &c);
+                        r = parse_config_file(network_path, "DHCPv4", "ClientIdentifier", &c);
                         if (r >= 0) {
                                 if (streq(c, "mac")) {
                                         _auto_cleanup_ char *e = NULL;
@@ -799,18 +948,18 @@ static int list_one_link(int argc, char *argv[]) {
                 }
         }
 
-        if (!iaid) {
-                r = network_parse_link_dhcp6_client_iaid(p->ifindex, &dhcp6_iaid);
-                if (r >= 0) {
+        if (!iaid && field_enabled("DHCPv6IAID")) {
+                s = link_state_snapshot_dhcp6_client_iaid(state);
+                if (s) {
                         display(arg_beautify, ansi_color_bold_cyan(), "           DHCP6 Client IAID: ");
-                        printf("%s\n", dhcp6_iaid);
+                        printf("%s\n", s);
                 }
         }
 
-        r = network_parse_link_dhcp6_client_duid(p->ifindex, &dhcp6_duid);
-        if (r >= 0) {
+        s = link_state_snapshot_dhcp6_client_duid(state);
+        if (s && field_enabled("DHCPv6DUID")) {
                 display(arg_beautify, ansi_color_bold_cyan(), "           DHCP6 Client DUID: ");
-                printf("%s\n", dhcp6_duid);
+                printf("%s\n", s);
         }
 
 
@@ -842,92 +991,140 @@ static void list_link_addresses(gpointer key, gpointer value, gpointer userdata)
         }
 }
 
+_public_ int ncm_show_network_logs(int argc, char *argv[]) {
+        _auto_cleanup_ IfNameIndex *p = NULL;
+        unsigned lines = 0;
+        int r;
+
+        if (argc > 1) {
+                int i = 1;
+
+                if (streq_fold(argv[i], "dev"))
+                        parse_next_arg(argv, argc, i);
+
+                r = parse_ifname_or_index(argv[i], &p);
+                if (r < 0) {
+                        log_warning("Failed to find device: %s", argv[i]);
+                        return r;
+                }
+        }
+
+        if (arg_json && arg_output != JSON_WRITER_FORMAT_JSON) {
+                log_warning("Logs can only be shown as text or JSON");
+                return -EOPNOTSUPP;
+        }
+
+        /* -l limits the backlog; when following start from the last few entries like journalctl -f */
+        if (arg_log_line > 0)
+                lines = arg_log_line;
+        else if (arg_log_follow)
+                lines = 10;
+
+        return journal_show_network_logs(&(JournalQuery) {
+                        .ifindex = p ? p->ifindex : 0,
+                        .ifname = p ? p->ifname : NULL,
+                        .since = arg_log_since,
+                        .until = arg_log_until,
+                        .cursor = arg_log_cursor,
+                        .lines = lines,
+                        .follow = arg_log_follow,
+                        .json = arg_json,
+                        .show_cursor = true,
+                });
+}
+
 _public_ int ncm_system_status(int argc, char *argv[]) {
-        _auto_cleanup_ char *state = NULL, *hostname = NULL, *kernel = NULL,
-                *kernel_release = NULL, *arch = NULL, *virt = NULL, *os = NULL,
-                *systemd = NULL, *hwvendor = NULL, *hwmodel = NULL, *firmware = NULL,
-                *firmware_vendor = NULL;
+        const char *state, *hostname, *kernel, *kernel_release, *arch, *virt, *os, *systemd, *hwvendor, *hwmodel,
+                *firmware, *firmware_vendor;
+        _cleanup_(dbus_system_status_freep) DBusSystemStatus *status = NULL;
         _auto_cleanup_strv_ char **dns = NULL, **search_domains = NULL, **ntp = NULL;
         _cleanup_(routes_freep) Routes *routes = NULL;
         _cleanup_(addresses_freep) Addresses *h = NULL;
         sd_id128_t machine_id = {};
         sd_id128_t boot_id = {};
-        uint64_t firmware_date;
         int r;
 
         if (argc > 1)
                 return list_one_link(argc, argv);
 
+        if (arg_watch)
+                return watch_links(0);
+
         if (arg_network_json && arg_json)
                 return json_acquire_network_status();
 
         if (arg_json)
                 return json_fill_system_status(NULL);
 
-        r =  dbus_get_property_from_hostnamed("StaticHostname", &hostname);
-        if (r >=0 && hostname) {
+        r = dbus_acquire_system_status(&status);
+        if (r < 0) {
+                log_warning("Failed to acquire system status: %s", strerror(-r));
+                return r;
+        }
+
+        hostname = g_hash_table_lookup(status->hostnamed, "StaticHostname");
+        if (hostname) {
                 display(arg_beautify, ansi_color_bold_cyan(), "         System Name: ");
                 printf("%s\n",hostname);
         }
 
-        (void) dbus_get_property_from_hostnamed("KernelRelease", &kernel_release);
-        (void) dbus_get_property_from_hostnamed("KernelName", &kernel);
+        kernel_release = g_hash_table_lookup(status->hostnamed, "KernelRelease");
+        kernel = g_hash_table_lookup(status->hostnamed, "KernelName");
         if (kernel) {
                 display(arg_beautify, ansi_color_bold_cyan(), "              Kernel: ");
                 printf("%s (%s)\n", kernel, str_na(kernel_release));
         }
 
-        r = dbus_get_string_systemd_manager("Version", &systemd);
-        if (r >= 0 && systemd) {
+        systemd = g_hash_table_lookup(status->manager, "Version");
+        if (systemd) {
                 display(arg_beautify, ansi_color_bold_cyan(), "     Systemd Version: ");
                 printf("%s\n", systemd);
         }
 
-        r = dbus_get_string_systemd_manager("Architecture", &arch);
-        if (r >= 0 && arch) {
+        arch = g_hash_table_lookup(status->manager, "Architecture");
+        if (arch) {
                 display(arg_beautify, ansi_color_bold_cyan(), "        Architecture: ");
                 printf("%s\n", arch);
         }
 
-        r = dbus_get_string_systemd_manager("Virtualization", &virt);
-        if (r >= 0 && virt) {
+        virt = g_hash_table_lookup(status->manager, "Virtualization");
+        if (virt) {
                 display(arg_beautify, ansi_color_bold_cyan(), "      Virtualization: ");
                 printf("%s\n", virt);
         }
 
-        r = dbus_get_property_from_hostnamed("OperatingSystemPrettyName", &os);
-        if (r >= 0 && os) {
+        os = g_hash_table_lookup(status->hostnamed, "OperatingSystemPrettyName");
+        if (os) {
                 display(arg_beautify, ansi_color_bold_cyan(), "    Operating System: ");
                 printf("%s\n", os);
         }
 
-        r = dbus_get_property_from_hostnamed("HardwareVendor", &hwvendor);
-        if (r >= 0 && hwvendor) {
+        hwvendor = g_hash_table_lookup(status->hostnamed, "HardwareVendor");
+        if (hwvendor) {
                 display(arg_beautify, ansi_color_bold_cyan(), "     Hardware Vendor: ");
                 printf("%s\n", hwvendor);
         }
 
-        r = dbus_get_property_from_hostnamed("HardwareModel", &hwmodel);
-        if (r >= 0 && hwmodel) {
+        hwmodel = g_hash_table_lookup(status->hostnamed, "HardwareModel");
+        if (hwmodel) {
                 display(arg_beautify, ansi_color_bold_cyan(), "      Hardware Model: ");
                 printf("%s\n", hwmodel);
         }
 
-        r = dbus_get_property_from_hostnamed("FirmwareVersion", &firmware);
-        if (r >= 0 && firmware) {
+        firmware = g_hash_table_lookup(status->hostnamed, "FirmwareVersion");
+        if (firmware) {
                 display(arg_beautify, ansi_color_bold_cyan(), "    Firmware Version: ");
                 printf("%s\n", firmware);
         }
 
-        r = dbus_get_property_from_hostnamed("FirmwareVendor", &firmware_vendor);
-        if (r >= 0 && firmware_vendor) {
+        firmware_vendor = g_hash_table_lookup(status->hostnamed, "FirmwareVendor");
+        if (firmware_vendor) {
                 display(arg_beautify, ansi_color_bold_cyan(), "     Firmware Vendor: ");
                 printf("%s\n", firmware_vendor);
         }
 
-        r = dbus_get_property_from_hostnamed_time("FirmwareDate", &firmware_date);
-        if (r >= 0) {
-                time_t now = firmware_date / USEC_PER_SEC;
+        if (status->firmware_date) {
+                time_t now = status->firmware_date / USEC_PER_SEC;
 
                 display(arg_beautify, ansi_color_bold_cyan(), "       Firmware Date: ");
                 printf("%s", ctime(&now));
@@ -952,8 +1149,8 @@ _public_ int ncm_system_status(int argc, char *argv[]) {
                 printf("\n");
         }
 
-        r = dbus_get_system_property_from_networkd("OperationalState", &state);
-        if (r >= 0) {
+        state = g_hash_table_lookup(status->networkd, "OperationalState");
+        if (state) {
                 const char *state_color;
 
                 link_state_to_color(state, &state_color);
@@ -962,8 +1159,8 @@ _public_ int ncm_system_status(int argc, char *argv[]) {
                 display(arg_beautify, state_color, "%s\n", state);
         }
 
-        r = dbus_get_system_property_from_networkd("OnlineState", &state);
-        if (r >= 0) {
+        state = g_hash_table_lookup(status->networkd, "OnlineState");
+        if (state) {
                 const char *state_color;
 
                 system_online_state_to_color(state, &state_color);
@@ -972,8 +1169,8 @@ _public_ int ncm_system_status(int argc, char *argv[]) {
                 display(arg_beautify, state_color, "%s\n", state);
         }
 
-        r = dbus_get_system_property_from_networkd("AddressState", &state);
-        if (r >= 0) {
+        state = g_hash_table_lookup(status->networkd, "AddressState");
+        if (state) {
                 const char *state_color;
 
                 system_online_state_to_color(state, &state_color);
@@ -982,8 +1179,8 @@ _public_ int ncm_system_status(int argc, char *argv[]) {
                 display(arg_beautify, state_color, "%s\n", state);
         }
 
-        r = dbus_get_system_property_from_networkd("IPv4AddressState", &state);
-        if (r >= 0) {
+        state = g_hash_table_lookup(status->networkd, "IPv4AddressState");
+        if (state) {
                 const char *state_color;
 
                 system_online_state_to_color(state, &state_color);
@@ -992,8 +1189,8 @@ _public_ int ncm_system_status(int argc, char *argv[]) {
                 display(arg_beautify, state_color, "%s\n", state);
         }
 
-        r = dbus_get_system_property_from_networkd("IPv6AddressState", &state);
-        if (r >= 0) {
+        state = g_hash_table_lookup(status->networkd, "IPv6AddressState");
+        if (state) {
                 const char *state_color;
 
                 system_online_state_to_color(state, &state_color);
@@ -1052,8 +1249,9 @@ _public_ int ncm_system_status(int argc, char *argv[]) {
 
         r = network_parse_dns(&dns);
         if (r >= 0 && dns) {
-                _auto_cleanup_ char *s = NULL, *mdns = NULL, *llmnr = NULL, *dns_over_tls = NULL, *conf_mode = NULL, *dns_sec = NULL;
-                _auto_cleanup_ DNSServer *c = NULL;
+                const char *mdns, *llmnr, *dns_over_tls, *conf_mode, *dns_sec;
+                DNSServer *c = status->current_dns_server;
+                _auto_cleanup_ char *s = NULL;
 
                 s = strv_join(" ", dns);
                 if (!s)
@@ -1062,8 +1260,7 @@ _public_ int ncm_system_status(int argc, char *argv[]) {
                 display(arg_beautify, ansi_color_bold_cyan(), "                 DNS: ");
                 printf("%s \n", s);
 
-                r = dbus_get_current_dns_server_from_resolved(&c);
-                if (r >= 0 && c) {
+                if (c) {
                         _auto_cleanup_ char *pretty = NULL;
 
                         r = ip_to_str(c->address.family, &c->address, &pretty);
@@ -1073,11 +1270,11 @@ _public_ int ncm_system_status(int argc, char *argv[]) {
                         }
                 }
 
-                (void) dbus_acqure_dns_setting_from_resolved("MulticastDNS", &mdns);
-                (void) dbus_acqure_dns_setting_from_resolved("LLMNR", &llmnr);
-                (void) dbus_acqure_dns_setting_from_resolved("DNSOverTLS", &dns_over_tls);
-                (void) dbus_acqure_dns_setting_from_resolved("ResolvConfMode", &conf_mode);
-                (void) dbus_acqure_dns_setting_from_resolved("DNSSEC", &dns_sec);
+                mdns = g_hash_table_lookup(status->resolved, "MulticastDNS");
+                llmnr = g_hash_table_lookup(status->resolved, "LLMNR");
+                dns_over_tls = g_hash_table_lookup(status->resolved, "DNSOverTLS");
+                conf_mode = g_hash_table_lookup(status->resolved, "ResolvConfMode");
+                dns_sec = g_hash_table_lookup(status->resolved, "DNSSEC");
 
                 display(arg_beautify, ansi_color_bold_cyan(), "        DNS Settings: ");
                 printf("MulticastDNS (%s) LLMNR (%s) DNSOverTLS (%s) ResolvConfMode (%s) DNSSEC (%s)\n",
@@ -1147,7 +1344,7 @@ _public_ int ncm_system_ipv4_status(int argc, char *argv[]) {
         }
 
         if (arg_json)
-                return json_fill_one_link(p, true, jobj, NULL);
+                return json_show_one_link(p, true, jobj, NULL);
 
         r = netlink_get_one_link_address(p->ifindex, &addr);
         if (r >= 0 && addr && set_size(addr->addresses) > 0)
@@ -1155,11 +1352,15 @@ _public_ int ncm_system_ipv4_status(int argc, char *argv[]) {
 
         r = netlink_acquire_all_link_routes(&routes);
         if (r >= 0 && set_size(routes->routes) > 0) {
+                _cleanup_(link_state_snapshot_freep) LinkStateSnapshot *state = NULL;
                 _cleanup_(set_freep) Set *devs = NULL;
                 _auto_cleanup_ char *network = NULL;
+                const char *dhcp4_router;
                 bool first = true;
 
                 (void) parse_network_file(p->ifindex, p->ifname, &network);
+                (void) link_state_snapshot_new(p->ifindex, &state);
+                dhcp4_router = link_state_snapshot_dhcp4_router(state);
 
                 r = set_new(&devs, g_int64_hash, g_int64_equal);
                 if (r < 0)
@@ -1167,15 +1368,13 @@ _public_ int ncm_system_ipv4_status(int argc, char *argv[]) {
 
                 g_hash_table_iter_init(&iter, routes->routes->hash);
                 while (g_hash_table_iter_next (&iter, &key, &value)) {
-                        _auto_cleanup_ char *c = NULL, *provider = NULL, *dhcp4_router = NULL;
+                        _auto_cleanup_ char *c = NULL, *provider = NULL;
                         Route *rt;
 
                         rt = (Route *) g_bytes_get_data(key, &size);
                         if (ip_is_null(&rt->gw) || rt->family != AF_INET)
                                 continue;
 
-                        (void) network_parse_link_dhcp4_router(p->ifindex, &dhcp4_router);
-
                         if (!set_contains(devs, &rt->ifindex))
                                 set_add(devs, &rt->ifindex);
                         else
@@ -1226,7 +1425,7 @@ _public_ int ncm_get_system_status(char **ret) {
 }
 
 _public_ int ncm_get_link_status(const char *ifname, char **ret) {
-        _cleanup_(json_object_putp) json_object *j = NULL, *jobj = NULL;
+        _cleanup_(json_object_putp) json_object *jobj = NULL;
         _auto_cleanup_ IfNameIndex *p = NULL;
         _auto_cleanup_ char *s = NULL;
         int r;
@@ -1238,22 +1437,16 @@ _public_ int ncm_get_link_status(const char *ifname, char **ret) {
         if (r < 0)
                 return r;
 
-        r = json_acquire_and_parse_network_data(&jobj);
+        r = json_acquire_and_parse_link_data(p->ifindex, &jobj);
         if (r < 0) {
                 log_warning("Failed acquire network data: %s", strerror(-r));
                 return r;
         }
 
-        r = json_fill_one_link(p, false, jobj, &j);
+        r = json_show_one_link(p, false, jobj, &s);
         if (r < 0)
                 return r;
 
-        s = strdup(json_object_to_json_string_ext(j, JSON_C_TO_STRING_NOSLASHESCAPE | JSON_C_TO_STRING_SPACED | JSON_C_TO_STRING_PRETTY));
-        if (!s)
-                return log_oom();
-
-        if (ret && *ret)
-                *ret = steal_ptr(s);
-
+        *ret = steal_ptr(s);
         return 0;
 }
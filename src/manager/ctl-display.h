@@ -4,13 +4,33 @@
 
 #pragma once
 
+#include <stdint.h>
+
+#include "json-writer.h"
+
 void set_json(bool k);
 void set_network_json(bool k);
+void set_output_format(JsonWriterFormat format);
 void set_beautify(bool k);
+void set_watch(bool k);
 void set_log(bool k, int size);
+void set_log_since(uint64_t usec);
+void set_log_until(uint64_t usec);
+void set_log_cursor(const char *cursor);
+void set_log_follow(bool k);
+int set_fields(const char *fields);
 
 bool json_enabled(void);
+JsonWriterFormat output_format(void);
 bool beautify_enabled(void);
+bool watch_enabled(void);
 bool log_enabled(void);
 
+bool field_enabled(const char *field);
+bool fields_enabled(const char *const *fields);
+bool link_fields_need_network_data(void);
+bool link_fields_need_device(void);
+
 int get_log_line(void);
+
+void link_state_to_color(const char *state, const char **on);
@@ -0,0 +1,585 @@
+/* Copyright 2024 VMware, Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <network-config-manager.h>
+
+#include <libmnl/libmnl.h>
+#include <net/if.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <systemd/sd-event.h>
+#include <unistd.h>
+
+#include "alloc-util.h"
+#include "ansi-color.h"
+#include "ctl-display.h"
+#include "ctl-watch.h"
+#include "log.h"
+#include "macros.h"
+#include "network-address.h"
+#include "network-link.h"
+#include "network-util.h"
+#include "networkd-api.h"
+#include "networkd-state-cache.h"
+#include "string-util.h"
+
+#define WATCH_INTERVAL_USEC   USEC_PER_SEC
+#define WATCH_RTNL_GROUPS     (RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR)
+#define WATCH_BUFFER_SIZE     (64 * 1024)
+
+/* Width of the columns in front of the addresses, see watch_compose() */
+#define WATCH_ADDRESS_COLUMN  91
+
+/* A row of the view. Everything but the traffic counters is kept up to date from rtnetlink notifications and
+ * networkd state file changes, the counters are polled once per interval. */
+typedef struct WatchLink {
+        int ifindex;
+        char name[IFNAMSIZ+1];
+        uint8_t operstate;
+        uint32_t flags;
+
+        char *setup_state;
+        char *operational_state;
+        GPtrArray *addresses;
+
+        uint64_t rx_bytes;
+        uint64_t tx_bytes;
+        uint64_t rx_rate;
+        uint64_t tx_rate;
+        bool has_stats:1;
+        bool has_rate:1;
+} WatchLink;
+
+typedef struct Watch {
+        sd_event *event;
+        sd_event_source *rtnl_event;
+        sd_event_source *state_event;
+        sd_event_source *timer_event;
+
+        int rtnl_fd;
+        int ifindex;
+
+        GHashTable *links;
+        GPtrArray *frame;
+        uint64_t stats_usec;
+
+        /* Whether this watch holds a reference on the networkd state cache */
+        bool state_cache;
+
+        char buf[WATCH_BUFFER_SIZE] __attribute__((aligned(__alignof__(struct nlmsghdr))));
+} Watch;
+
+static void watch_link_free(WatchLink *wl) {
+        if (!wl)
+                return;
+
+        free(wl->setup_state);
+        free(wl->operational_state);
+        g_ptr_array_unref(wl->addresses);
+        free(wl);
+}
+
+static void watch_link_load_state(WatchLink *wl) {
+        _cleanup_(link_state_snapshot_freep) LinkStateSnapshot *state = NULL;
+
+        free(wl->setup_state);
+        free(wl->operational_state);
+        wl->setup_state = wl->operational_state = NULL;
+
+        if (link_state_snapshot_new(wl->ifindex, &state) < 0)
+                return;
+
+        wl->setup_state = g_strdup(link_state_snapshot_setup_state(state) ?: "unmanaged");
+        wl->operational_state = g_strdup(link_state_snapshot_operational_state(state));
+}
+
+static gint compare_strings(gconstpointer a, gconstpointer b) {
+        return strcmp(*(const char **) a, *(const char **) b);
+}
+
+static gint compare_links(gconstpointer a, gconstpointer b) {
+        const WatchLink *x = *(const WatchLink **) a, *y = *(const WatchLink **) b;
+
+        return x->ifindex - y->ifindex;
+}
+
+static int watch_link_update_address(WatchLink *wl, const Address *a, bool remove) {
+        _auto_cleanup_ char *s = NULL;
+        guint i;
+        int r;
+
+        r = ip_to_str_prefix(a->family, &a->address, &s);
+        if (r < 0)
+                return r;
+
+        if (g_ptr_array_find_with_equal_func(wl->addresses, s, g_str_equal, &i)) {
+                if (remove)
+                        g_ptr_array_remove_index(wl->addresses, i);
+                return 0;
+        }
+
+        if (remove)
+                return 0;
+
+        g_ptr_array_add(wl->addresses, steal_ptr(s));
+        g_ptr_array_sort(wl->addresses, compare_strings);
+        return 0;
+}
+
+static int watch_update_link(Watch *w, const Link *l) {
+        WatchLink *wl;
+
+        if (w->ifindex > 0 && l->ifindex != w->ifindex)
+                return 0;
+
+        wl = g_hash_table_lookup(w->links, GINT_TO_POINTER(l->ifindex));
+        if (!wl) {
+                wl = new0(WatchLink, 1);
+                if (!wl)
+                        return log_oom();
+
+                wl->ifindex = l->ifindex;
+                wl->addresses = g_ptr_array_new_with_free_func(g_free);
+                watch_link_load_state(wl);
+
+                g_hash_table_insert(w->links, GINT_TO_POINTER(wl->ifindex), wl);
+        }
+
+        memcpy(wl->name, l->name, sizeof(wl->name));
+        wl->operstate = l->operstate;
+        wl->flags = l->flags;
+
+        return 0;
+}
+
+static int watch_update_address(Watch *w, const struct nlmsghdr *nlh) {
+        _cleanup_(address_freep) Address *a = NULL;
+        WatchLink *wl;
+        int r;
+
+        r = netlink_parse_address_message(nlh, &a);
+        if (r < 0)
+                return r;
+
+        wl = g_hash_table_lookup(w->links, GINT_TO_POINTER(a->ifindex));
+        if (!wl)
+                return 0;
+
+        return watch_link_update_address(wl, a, nlh->nlmsg_type == RTM_DELADDR);
+}
+
+/* Reads everything from scratch. Done once at the start and again whenever the kernel dropped notifications. */
+static int watch_load(Watch *w) {
+        _cleanup_(addresses_freep) Addresses *addresses = NULL;
+        _cleanup_(links_freep) Links *links = NULL;
+        GHashTableIter iter;
+        gpointer key;
+        int r;
+
+        g_hash_table_remove_all(w->links);
+
+        r = netlink_acquire_all_links(&links);
+        if (r < 0)
+                return r;
+
+        for (GList *i = links->links; i; i = g_list_next(i)) {
+                r = watch_update_link(w, i->data);
+                if (r < 0)
+                        return r;
+        }
+
+        if (w->ifindex > 0 && !g_hash_table_contains(w->links, GINT_TO_POINTER(w->ifindex)))
+                return -ENODEV;
+
+        r = netlink_acquire_all_link_addresses(&addresses);
+        if (r < 0)
+                return r;
+
+        g_hash_table_iter_init(&iter, addresses->addresses->hash);
+        while (g_hash_table_iter_next(&iter, &key, NULL)) {
+                Address *a = (Address *) g_bytes_get_data(key, NULL);
+                WatchLink *wl;
+
+                wl = g_hash_table_lookup(w->links, GINT_TO_POINTER(a->ifindex));
+                if (wl)
+                        (void) watch_link_update_address(wl, a, false);
+        }
+
+        return 0;
+}
+
+static int watch_update_stats(Watch *w) {
+        _auto_cleanup_hash_ GHashTable *stats = NULL;
+        uint64_t now = 0, interval;
+        GHashTableIter iter;
+        gpointer value;
+        int r;
+
+        r = netlink_acquire_all_link_stats(&stats);
+        if (r < 0)
+                return r;
+
+        (void) sd_event_now(w->event, CLOCK_MONOTONIC, &now);
+        interval = now - w->stats_usec;
+
+        g_hash_table_iter_init(&iter, w->links);
+        while (g_hash_table_iter_next(&iter, NULL, &value)) {
+                const struct rtnl_link_stats64 *s;
+                WatchLink *wl = value;
+
+                s = g_hash_table_lookup(stats, GINT_TO_POINTER(wl->ifindex));
+                if (!s) {
+                        wl->has_stats = wl->has_rate = false;
+                        continue;
+                }
+
+                if (wl->has_stats && interval > 0) {
+                        wl->rx_rate = s->rx_bytes >= wl->rx_bytes ? (s->rx_bytes - wl->rx_bytes) * USEC_PER_SEC / interval : 0;
+                        wl->tx_rate = s->tx_bytes >= wl->tx_bytes ? (s->tx_bytes - wl->tx_bytes) * USEC_PER_SEC / interval : 0;
+                        wl->has_rate = true;
+                }
+
+                wl->rx_bytes = s->rx_bytes;
+                wl->tx_bytes = s->tx_bytes;
+                wl->has_stats = true;
+        }
+
+        w->stats_usec = now;
+        return 0;
+}
+
+static void watch_append_state(GString *s, const char *state, int width) {
+        const char *color;
+
+        link_state_to_color(str_na(state), &color);
+        g_string_append_printf(s, "%s%-*s%s ", color, width, str_na(state), ansi_color_reset());
+}
+
+static void watch_append_rate(GString *s, const WatchLink *wl, uint64_t rate) {
+        _auto_cleanup_ char *size = NULL;
+
+        if (!wl->has_rate) {
+                g_string_append_printf(s, "%10s ", "-");
+                return;
+        }
+
+        size = g_format_size(rate);
+        g_string_append_printf(s, "%10s ", size);
+}
+
+/* One line per link, a single link shows all of its addresses below its row */
+static void watch_compose(Watch *w, GPtrArray *frame) {
+        _cleanup_(g_ptr_array_unrefp) GPtrArray *links = NULL;
+        GHashTableIter iter;
+        gpointer value;
+
+        g_ptr_array_add(frame, g_strdup_printf("%s%-7s %-15s %-9s %-8s %-12s %-11s %10s %10s  %s%s",
+                                               ansi_color_bold(), "INDEX", "DEVICE", "STATE", "CARRIER",
+                                               "OPERATIONAL", "SETUP", "RX/s", "TX/s", "ADDRESS",
+                                               ansi_color_reset()));
+
+        links = g_ptr_array_new();
+        g_hash_table_iter_init(&iter, w->links);
+        while (g_hash_table_iter_next(&iter, NULL, &value))
+                g_ptr_array_add(links, value);
+
+        g_ptr_array_sort(links, compare_links);
+
+        for (guint i = 0; i < links->len; i++) {
+                WatchLink *wl = g_ptr_array_index(links, i);
+                GString *s;
+
+                s = g_string_new(NULL);
+                g_string_append_printf(s, "%s%-7d%s ", ansi_color_bold(), wl->ifindex, ansi_color_reset());
+                g_string_append_printf(s, "%s%-15s%s ", ansi_color_bold_cyan(), wl->name, ansi_color_reset());
+                watch_append_state(s, link_operstates_to_name(wl->operstate), 9);
+                g_string_append_printf(s, "%-8s ", wl->flags & IFF_LOWER_UP ? "yes" : "no");
+                watch_append_state(s, wl->operational_state, 12);
+                watch_append_state(s, wl->setup_state, 11);
+                watch_append_rate(s, wl, wl->rx_rate);
+                watch_append_rate(s, wl, wl->tx_rate);
+
+                if (wl->addresses->len > 0) {
+                        g_string_append_printf(s, " %s", (char *) g_ptr_array_index(wl->addresses, 0));
+                        if (w->ifindex == 0 && wl->addresses->len > 1)
+                                g_string_append_printf(s, " (+%u)", wl->addresses->len - 1);
+                }
+
+                g_ptr_array_add(frame, g_string_free(s, false));
+
+                if (w->ifindex == 0)
+                        continue;
+
+                for (guint j = 1; j < wl->addresses->len; j++)
+                        g_ptr_array_add(frame, g_strdup_printf("%*s%s", WATCH_ADDRESS_COLUMN, "",
+                                                               (char *) g_ptr_array_index(wl->addresses, j)));
+        }
+}
+
+/* Lines that are on screen already are left alone, so a single link changing rewrites a single row */
+static void watch_draw(Watch *w) {
+        _cleanup_(g_ptr_array_unrefp) GPtrArray *frame = NULL;
+        struct winsize ws = {};
+
+        frame = g_ptr_array_new_with_free_func(g_free);
+        watch_compose(w, frame);
+
+        if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) >= 0 && ws.ws_row > 0 && frame->len > ws.ws_row)
+                g_ptr_array_set_size(frame, ws.ws_row);
+
+        for (guint i = 0; i < frame->len; i++) {
+                const char *line = g_ptr_array_index(frame, i);
+
+                if (w->frame && i < w->frame->len && streq(line, g_ptr_array_index(w->frame, i)))
+                        continue;
+
+                printf(ANSI_CURSOR_LINE_FORMAT "%s" ANSI_ERASE_TO_END_OF_LINE, i + 1, line);
+        }
+
+        for (guint i = frame->len; w->frame && i < w->frame->len; i++)
+                printf(ANSI_CURSOR_LINE_FORMAT ANSI_ERASE_TO_END_OF_LINE, i + 1);
+
+        fflush(stdout);
+
+        if (w->frame)
+                g_ptr_array_unref(w->frame);
+        w->frame = steal_ptr(frame);
+}
+
+static void watch_redraw(Watch *w) {
+        printf(ANSI_CLEAR_SCREEN);
+
+        if (w->frame) {
+                g_ptr_array_unref(w->frame);
+                w->frame = NULL;
+        }
+
+        watch_draw(w);
+}
+
+static int on_rtnl_message(const struct nlmsghdr *nlh, void *data) {
+        Watch *w = data;
+
+        switch (nlh->nlmsg_type) {
+        case RTM_NEWLINK: {
+                _cleanup_(link_freep) Link *l = NULL;
+
+                if (netlink_parse_link_message(nlh, &l) >= 0)
+                        (void) watch_update_link(w, l);
+                break;
+        }
+        case RTM_DELLINK: {
+                struct ifinfomsg *ifi = mnl_nlmsg_get_payload(nlh);
+
+                g_hash_table_remove(w->links, GINT_TO_POINTER(ifi->ifi_index));
+                break;
+        }
+        case RTM_NEWADDR:
+        case RTM_DELADDR:
+                (void) watch_update_address(w, nlh);
+                break;
+        default:
+                break;
+        }
+
+        return MNL_CB_OK;
+}
+
+static int on_rtnl(sd_event_source *s, int fd, uint32_t revents, void *userdata) {
+        Watch *w = userdata;
+
+        for (;;) {
+                ssize_t n;
+
+                n = recv(w->rtnl_fd, w->buf, sizeof(w->buf), MSG_DONTWAIT);
+                if (n < 0) {
+                        if (errno == EINTR)
+                                continue;
+                        if (errno == EAGAIN)
+                                break;
+
+                        /* The socket overran and notifications are lost, start over */
+                        if (errno == ENOBUFS) {
+                                (void) watch_load(w);
+                                continue;
+                        }
+
+                        return sd_event_exit(w->event, -errno);
+                }
+
+                (void) mnl_cb_run(w->buf, n, 0, 0, on_rtnl_message, w);
+        }
+
+        watch_draw(w);
+        return 0;
+}
+
+static void on_link_state_changed(int ifindex, void *userdata) {
+        Watch *w = userdata;
+        GHashTableIter iter;
+        gpointer value;
+
+        if (ifindex > 0) {
+                WatchLink *wl = g_hash_table_lookup(w->links, GINT_TO_POINTER(ifindex));
+
+                if (wl)
+                        watch_link_load_state(wl);
+                return;
+        }
+
+        g_hash_table_iter_init(&iter, w->links);
+        while (g_hash_table_iter_next(&iter, NULL, &value))
+                watch_link_load_state(value);
+}
+
+static int on_state(sd_event_source *s, int fd, uint32_t revents, void *userdata) {
+        if (netif_state_cache_process() > 0)
+                watch_draw(userdata);
+
+        return 0;
+}
+
+static int on_tick(sd_event_source *s, uint64_t usec, void *userdata) {
+        Watch *w = userdata;
+
+        (void) watch_update_stats(w);
+        watch_draw(w);
+
+        (void) sd_event_source_set_time_relative(s, WATCH_INTERVAL_USEC);
+        return sd_event_source_set_enabled(s, SD_EVENT_ONESHOT);
+}
+
+static int on_signal(sd_event_source *s, const struct signalfd_siginfo *si, void *userdata) {
+        Watch *w = userdata;
+
+        if (si->ssi_signo == SIGWINCH) {
+                watch_redraw(w);
+                return 0;
+        }
+
+        return sd_event_exit(w->event, 0);
+}
+
+static void watch_free(Watch *w) {
+        if (!w)
+                return;
+
+        sd_event_source_unref(w->rtnl_event);
+        sd_event_source_unref(w->state_event);
+        sd_event_source_unref(w->timer_event);
+        sd_event_unref(w->event);
+
+        if (w->rtnl_fd >= 0)
+                close(w->rtnl_fd);
+
+        if (w->links)
+                g_hash_table_unref(w->links);
+        if (w->frame)
+                g_ptr_array_unref(w->frame);
+
+        if (w->state_cache)
+                netif_state_cache_disable(on_link_state_changed, w);
+        free(w);
+}
+DEFINE_CLEANUP(Watch *, watch_free);
+
+static int watch_new(int ifindex, Watch **ret) {
+        _cleanup_(watch_freep) Watch *w = NULL;
+        sigset_t mask;
+        int r;
+
+        w = new0(Watch, 1);
+        if (!w)
+                return log_oom();
+
+        w->rtnl_fd = -1;
+        w->ifindex = ifindex;
+        w->links = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) watch_link_free);
+
+        r = sd_event_new(&w->event);
+        if (r < 0)
+                return r;
+
+        sigemptyset(&mask);
+        sigaddset(&mask, SIGTERM);
+        sigaddset(&mask, SIGINT);
+        sigaddset(&mask, SIGWINCH);
+        sigprocmask(SIG_BLOCK, &mask, NULL);
+
+        r = sd_event_add_signal(w->event, NULL, SIGTERM, on_signal, w);
+        if (r < 0)
+                return r;
+
+        r = sd_event_add_signal(w->event, NULL, SIGINT, on_signal, w);
+        if (r < 0)
+                return r;
+
+        r = sd_event_add_signal(w->event, NULL, SIGWINCH, on_signal, w);
+        if (r < 0)
+                return r;
+
+        /* Subscribed before anything is read, so that no change slips in between */
+        r = rtnl_socket_open(WATCH_RTNL_GROUPS, &w->rtnl_fd);
+        if (r < 0)
+                return r;
+
+        r = sd_event_add_io(w->event, &w->rtnl_event, w->rtnl_fd, EPOLLIN, on_rtnl, w);
+        if (r < 0)
+                return r;
+
+        /* Without networkd there are no state files to follow, the kernel's view is shown all the same */
+        r = netif_state_cache_enable(on_link_state_changed, w);
+        if (r >= 0) {
+                w->state_cache = true;
+
+                r = sd_event_add_io(w->event, &w->state_event, netif_state_cache_get_fd(), EPOLLIN, on_state, w);
+                if (r < 0)
+                        return r;
+        } else
+                log_debug("Failed to follow networkd state files: %s", strerror(-r));
+
+        r = sd_event_add_time_relative(w->event, &w->timer_event, CLOCK_MONOTONIC, WATCH_INTERVAL_USEC, 0, on_tick, w);
+        if (r < 0)
+                return r;
+
+        *ret = steal_ptr(w);
+        return 0;
+}
+
+/* A refreshing view of link state, addresses and traffic rates until interrupted. 'ifindex' is 0 for all links. */
+int watch_links(int ifindex) {
+        _cleanup_(watch_freep) Watch *w = NULL;
+        int r;
+
+        if (!isatty(STDOUT_FILENO)) {
+                log_warning("--watch needs a terminal");
+                return -ENOTTY;
+        }
+
+        r = watch_new(ifindex, &w);
+        if (r < 0) {
+                log_warning("Failed to watch links: %s", strerror(-r));
+                return r;
+        }
+
+        r = watch_load(w);
+        if (r < 0) {
+                log_warning("Failed to acquire links: %s", strerror(-r));
+                return r;
+        }
+
+        (void) watch_update_stats(w);
+
+        printf(ANSI_CURSOR_HIDE ANSI_AUTOWRAP_OFF);
+        watch_redraw(w);
+
+        r = sd_event_loop(w->event);
+
+        printf(ANSI_CURSOR_LINE_FORMAT ANSI_AUTOWRAP_ON ANSI_CURSOR_SHOW, w->frame ? w->frame->len + 1 : 1);
+        fflush(stdout);
+
+        return r;
+}
@@ -0,0 +1,7 @@
+/* Copyright 2024 VMware, Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+int watch_links(int ifindex);
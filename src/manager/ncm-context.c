@@ -0,0 +1,361 @@
+/* Copyright 2024 VMware, Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <network-config-manager.h>
+
+#include "alloc-util.h"
+#include "dbus.h"
+#include "log.h"
+#include "macros.h"
+#include "network-address.h"
+#include "network-link.h"
+#include "network-manager.h"
+#include "network-util.h"
+#include "networkd-state-cache.h"
+#include "string-util.h"
+
+/* Calls on a context are serialised by 'lock'. It is recursive so that a thread holding a batch open through
+ * ncm_context_begin() can keep calling in. Every call runs inside a networkd reload scope. The reload state is
+ * per thread, which is why a batch keeps the lock until ncm_context_commit(). */
+struct NcmContext {
+        GRecMutex lock;
+        unsigned batch;
+
+        /* Every context holds a reference on the process wide networkd state file cache, it installs no
+         * handler and so leaves those of embedders alone */
+        bool state_cache;
+};
+
+static void context_lock(NcmContext *ctx) {
+        g_rec_mutex_lock(&ctx->lock);
+        dbus_network_reload_defer();
+}
+
+static int context_unlock(NcmContext *ctx, int r) {
+        int k;
+
+        k = dbus_network_reload_flush();
+        g_rec_mutex_unlock(&ctx->lock);
+
+        return r < 0 ? r : k;
+}
+
+static int context_link(int ifindex, IfNameIndex **ret) {
+        _auto_cleanup_ IfNameIndex *p = NULL;
+
+        if (ifindex <= 0)
+                return -EINVAL;
+
+        p = new0(IfNameIndex, 1);
+        if (!p)
+                return -ENOMEM;
+
+        if (!if_indextoname(ifindex, p->ifname))
+                return -ENXIO;
+
+        p->ifindex = ifindex;
+        *ret = steal_ptr(p);
+        return 0;
+}
+
+_public_ int ncm_context_new(NcmContext **ret) {
+        NcmContext *ctx;
+
+        assert(ret);
+
+        ctx = new0(NcmContext, 1);
+        if (!ctx)
+                return -ENOMEM;
+
+        g_rec_mutex_init(&ctx->lock);
+        ctx->state_cache = netif_state_cache_enable(NULL, NULL) >= 0;
+
+        *ret = ctx;
+        return 0;
+}
+
+_public_ void ncm_context_free(NcmContext *ctx) {
+        if (!ctx)
+                return;
+
+        assert(ctx->batch == 0);
+
+        if (ctx->state_cache)
+                netif_state_cache_disable(NULL, NULL);
+
+        g_rec_mutex_clear(&ctx->lock);
+        free(ctx);
+}
+
+_public_ int ncm_context_begin(NcmContext *ctx) {
+        assert(ctx);
+
+        context_lock(ctx);
+        ctx->batch++;
+
+        return 0;
+}
+
+_public_ int ncm_context_commit(NcmContext *ctx) {
+        assert(ctx);
+        assert(ctx->batch > 0);
+
+        ctx->batch--;
+        return context_unlock(ctx, 0);
+}
+
+_public_ void ncm_link_free(NcmLink *l) {
+        if (!l)
+                return;
+
+        free(l->name);
+        free(l->kind);
+        free(l->mac);
+        free(l->operstate);
+        free(l);
+}
+
+static int ncm_link_new(const Link *l, NcmLink **ret) {
+        _cleanup_(ncm_link_freep) NcmLink *n = NULL;
+        const char *operstate;
+
+        n = new(NcmLink, 1);
+        if (!n)
+                return -ENOMEM;
+
+        *n = (NcmLink) {
+                .ifindex = l->ifindex,
+                .mtu = l->mtu,
+                .flags = l->flags,
+                .name = strdup(l->name),
+        };
+        if (!n->name)
+                return -ENOMEM;
+
+        if (l->kind) {
+                n->kind = strdup(l->kind);
+                if (!n->kind)
+                        return -ENOMEM;
+        }
+
+        if (l->contains_mac_address && ether_addr_is_not_null(&l->mac_address)) {
+                n->mac = new0(char, ETHER_ADDR_TO_STRING_MAX);
+                if (!n->mac)
+                        return -ENOMEM;
+
+                ether_addr_to_string(&l->mac_address, n->mac);
+        }
+
+        operstate = link_operstates_to_name(l->operstate);
+        if (operstate) {
+                n->operstate = strdup(operstate);
+                if (!n->operstate)
+                        return -ENOMEM;
+        }
+
+        *ret = steal_ptr(n);
+        return 0;
+}
+
+_public_ int ncm_context_get_links(NcmContext *ctx, GPtrArray **ret) {
+        _cleanup_(g_ptr_array_unrefp) GPtrArray *a = NULL;
+        _cleanup_(links_freep) Links *links = NULL;
+        int r;
+
+        assert(ctx);
+        assert(ret);
+
+        r = netlink_acquire_all_links(&links);
+        if (r < 0)
+                return r;
+
+        a = g_ptr_array_new_with_free_func((GDestroyNotify) ncm_link_free);
+
+        for (GList *i = links->links; i; i = g_list_next(i)) {
+                NcmLink *n;
+
+                r = ncm_link_new(i->data, &n);
+                if (r < 0)
+                        return r;
+
+                g_ptr_array_add(a, n);
+        }
+
+        *ret = steal_ptr(a);
+        return 0;
+}
+
+_public_ int ncm_context_get_link(NcmContext *ctx, int ifindex, NcmLink **ret) {
+        _auto_cleanup_ IfNameIndex *p = NULL;
+        _cleanup_(link_freep) Link *l = NULL;
+        int r;
+
+        assert(ctx);
+        assert(ret);
+
+        r = context_link(ifindex, &p);
+        if (r < 0)
+                return r;
+
+        r = netlink_acqure_one_link(p->ifname, &l);
+        if (r < 0)
+                return r;
+
+        return ncm_link_new(l, ret);
+}
+
+_public_ int ncm_context_link_get_addresses(NcmContext *ctx, int ifindex, char ***ret) {
+        _cleanup_(addresses_freep) Addresses *addr = NULL;
+        _auto_cleanup_strv_ char **s = NULL;
+        GHashTableIter iter;
+        gpointer key;
+        int r;
+
+        assert(ctx);
+        assert(ret);
+
+        if (ifindex <= 0)
+                return -EINVAL;
+
+        r = netlink_get_one_link_address(ifindex, &addr);
+        if (r < 0)
+                return r;
+
+        g_hash_table_iter_init(&iter, addr->addresses->hash);
+        while (g_hash_table_iter_next(&iter, &key, NULL)) {
+                Address *a = (Address *) g_bytes_get_data(key, NULL);
+                _auto_cleanup_ char *c = NULL;
+
+                r = ip_to_str_prefix(a->family, &a->address, &c);
+                if (r < 0)
+                        return r;
+
+                r = strv_extend(&s, c);
+                if (r < 0)
+                        return -ENOMEM;
+
+                steal_ptr(c);
+        }
+
+        *ret = steal_ptr(s);
+        return 0;
+}
+
+_public_ int ncm_context_link_set_mtu(NcmContext *ctx, int ifindex, uint32_t mtu) {
+        _auto_cleanup_ IfNameIndex *p = NULL;
+        int r;
+
+        assert(ctx);
+
+        if (mtu == 0)
+                return -EINVAL;
+
+        r = context_link(ifindex, &p);
+        if (r < 0)
+                return r;
+
+        context_lock(ctx);
+        r = manager_set_link_mtu(p, mtu);
+        return context_unlock(ctx, r);
+}
+
+_public_ int ncm_context_link_set_mac(NcmContext *ctx, int ifindex, const char *mac) {
+        _auto_cleanup_ IfNameIndex *p = NULL;
+        int r;
+
+        assert(ctx);
+        assert(mac);
+
+        if (!parse_ether_address(mac))
+                return -EINVAL;
+
+        r = context_link(ifindex, &p);
+        if (r < 0)
+                return r;
+
+        context_lock(ctx);
+        r = manager_set_link_mac_addr(p, mac);
+        return context_unlock(ctx, r);
+}
+
+_public_ int ncm_context_link_set_static(NcmContext *ctx, int ifindex, char **addresses, char **gateways, char **dns, bool keep) {
+        _auto_cleanup_ IfNameIndex *p = NULL;
+        int r;
+
+        assert(ctx);
+
+        if (ip_addresses_find_invalid(addresses, true) ||
+            ip_addresses_find_invalid(gateways, true) ||
+            ip_addresses_find_invalid(dns, false))
+                return -EINVAL;
+
+        r = context_link(ifindex, &p);
+        if (r < 0)
+                return r;
+
+        context_lock(ctx);
+        r = manager_set_link_static_conf(p, addresses, gateways, dns, -1, keep);
+        return context_unlock(ctx, r);
+}
+
+_public_ int ncm_context_link_set_dns(NcmContext *ctx, int ifindex, char **dns, bool keep) {
+        _auto_cleanup_ IfNameIndex *p = NULL;
+        int r;
+
+        assert(ctx);
+
+        if (ip_addresses_find_invalid(dns, false))
+                return -EINVAL;
+
+        r = context_link(ifindex, &p);
+        if (r < 0)
+                return r;
+
+        context_lock(ctx);
+        r = manager_set_dns_server(p, dns, -1, -1, keep);
+        return context_unlock(ctx, r);
+}
+
+_public_ int ncm_context_link_set_domains(NcmContext *ctx, int ifindex, char **domains, bool keep) {
+        _auto_cleanup_ IfNameIndex *p = NULL;
+        int r;
+
+        assert(ctx);
+
+        r = context_link(ifindex, &p);
+        if (r < 0)
+                return r;
+
+        context_lock(ctx);
+        r = manager_set_dns_server_domain(p, domains, keep);
+        return context_unlock(ctx, r);
+}
+
+_public_ int ncm_context_link_set_ntp(NcmContext *ctx, int ifindex, char **ntp, bool keep) {
+        _auto_cleanup_ IfNameIndex *p = NULL;
+        int r;
+
+        assert(ctx);
+
+        if (strv_empty((const char **) ntp))
+                return -EINVAL;
+
+        r = context_link(ifindex, &p);
+        if (r < 0)
+                return r;
+
+        context_lock(ctx);
+        r = manager_set_ntp_servers(p, ntp, keep);
+        return context_unlock(ctx, r);
+}
+
+_public_ int ncm_context_reload(NcmContext *ctx) {
+        int r;
+
+        assert(ctx);
+
+        context_lock(ctx);
+        r = manager_reload_network();
+        return context_unlock(ctx, r);
+}
@@ -3,6 +3,7 @@
  */
 
 #include "alloc-util.h"
+#include "config-stage.h"
 #include "file-util.h"
 #include "log.h"
 #include "macros.h"
@@ -199,7 +200,7 @@ int create_or_parse_netdev_link_conf_file(const char *ifname, char **ret) {
         if (!path)
                 return log_oom();
 
-        if (g_file_test(path, G_FILE_TEST_EXISTS)) {
+        if (config_file_exists(path)) {
                 *ret = steal_ptr(path);
                 return 0;
         }
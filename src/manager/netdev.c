@@ -49,11 +49,7 @@ const char *netdev_kind_to_name(NetDevKind id) {
 int netdev_name_to_kind(const char *name) {
         assert(name);
 
-        for (size_t i = NETDEV_KIND_VLAN; i < (int) ELEMENTSOF(netdev_kind_table); i++)
-                if (netdev_kind_table[i] && streq_fold(name, netdev_kind_table[i]))
-                        return i;
-
-        return _NETDEV_KIND_INVALID;
+        return string_table_lookup(netdev_kind_table, ELEMENTSOF(netdev_kind_table), name);
 }
 
 static const char *const bond_mode_table[_BOND_MODE_MAX] = {
@@ -79,11 +75,7 @@ const char *bond_mode_to_name(BondMode id) {
 int bond_name_to_mode(const char *name) {
         assert(name);
 
-        for (size_t i = BOND_MODE_ROUNDROBIN; i < (size_t) ELEMENTSOF(bond_mode_table); i++)
-                if (bond_mode_table[i] && streq_fold(name, bond_mode_table[i]))
-                        return i;
-
-        return _BOND_MODE_INVALID;
+        return string_table_lookup(bond_mode_table, ELEMENTSOF(bond_mode_table), name);
 }
 
 static const char* const bond_xmit_hash_policy_table[_BOND_XMIT_HASH_POLICY_MAX] = {
@@ -108,11 +100,7 @@ const char *bond_xmit_hash_policy_to_name(BondXmitHashPolicy id) {
 int bond_xmit_hash_policy_name_to_mode(const char *name) {
         assert(name);
 
-        for (size_t i = BOND_XMIT_POLICY_LAYER2; i < (size_t) ELEMENTSOF(bond_xmit_hash_policy_table); i++)
-                if (bond_xmit_hash_policy_table[i] && streq_fold(name, bond_xmit_hash_policy_table[i]))
-                        return i;
-
-        return _BOND_XMIT_HASH_POLICY_INVALID;
+        return string_table_lookup(bond_xmit_hash_policy_table, ELEMENTSOF(bond_xmit_hash_policy_table), name);
 }
 
 static const char* const bond_lacp_rate_table[_BOND_LACP_RATE_MAX] = {
@@ -133,11 +121,7 @@ const char *bond_lacp_rate_to_name(BondLacpRate id) {
 int bond_lacp_rate_to_mode(const char *name) {
         assert(name);
 
-        for (size_t i = BOND_LACP_RATE_SLOW; i < (size_t) ELEMENTSOF(bond_lacp_rate_table); i++)
-                if (bond_lacp_rate_table[i] && streq_fold(name, bond_lacp_rate_table[i]))
-                        return i;
-
-        return _BOND_LACP_RATE_INVALID;
+        return string_table_lookup(bond_lacp_rate_table, ELEMENTSOF(bond_lacp_rate_table), name);
 }
 
 static const char *const macvlan_mode_table[_MAC_VLAN_MODE_MAX] = {
@@ -161,11 +145,7 @@ const char *macvlan_mode_to_name(MACVLanMode id) {
 int macvlan_name_to_mode(const char *name) {
         assert(name);
 
-        for (size_t i= MAC_VLAN_MODE_PRIVATE; i < (size_t) ELEMENTSOF(macvlan_mode_table); i++)
-                if (macvlan_mode_table[i] && streq_fold(name, macvlan_mode_table[i]))
-                        return i;
-
-        return _MAC_VLAN_MODE_INVALID;
+        return string_table_lookup(macvlan_mode_table, ELEMENTSOF(macvlan_mode_table), name);
 }
 
 static const char *const bond_arp_validate_table[_BOND_ARP_VALIDATE_MAX] = {
@@ -188,11 +168,7 @@ const char *bond_arp_validate_mode_to_name(BondArpValidate id) {
 int bond_arp_validate_table_name_to_mode(const char *name) {
         assert(name);
 
-        for (size_t i= BOND_ARP_VALIDATE_NONE; i < (size_t) ELEMENTSOF(bond_arp_validate_table); i++)
-                if (bond_arp_validate_table[i] && streq_fold(name, bond_arp_validate_table[i]))
-                        return i;
-
-        return _BOND_ARP_VALIDATE_INVALID;
+        return string_table_lookup(bond_arp_validate_table, ELEMENTSOF(bond_arp_validate_table), name);
 }
 
 static const char* const bond_fail_over_mac_table[_BOND_FAIL_OVER_MAC_MAX] = {
@@ -214,11 +190,7 @@ const char *bond_fail_over_mac_mode_to_name(BondFailOverMac id) {
 int bond_fail_over_mac_name_to_mode(const char *name) {
         assert(name);
 
-        for (size_t i= BOND_ARP_VALIDATE_NONE; i < (size_t) ELEMENTSOF(bond_fail_over_mac_table); i++)
-                if (bond_fail_over_mac_table[i] && streq_fold(name, bond_fail_over_mac_table[i]))
-                        return i;
-
-        return _BOND_ARP_VALIDATE_INVALID;
+        return string_table_lookup(bond_fail_over_mac_table, ELEMENTSOF(bond_fail_over_mac_table), name);
 }
 
 static const char* const bond_ad_select_table[_BOND_AD_SELECT_MAX] = {
@@ -240,11 +212,7 @@ const char *bond_ad_select_mode_to_name(BondAdSelect id) {
 int bond_ad_select_name_to_mode(const char *name) {
         assert(name);
 
-        for (size_t i= BOND_ARP_VALIDATE_NONE; i < (size_t) ELEMENTSOF(bond_ad_select_table); i++)
-                if (bond_ad_select_table[i] && streq_fold(name, bond_ad_select_table[i]))
-                        return i;
-
-        return _BOND_AD_SELECT_INVALID;
+        return string_table_lookup(bond_ad_select_table, ELEMENTSOF(bond_ad_select_table), name);
 }
 
 static const char *const bond_primary_reselect_table[_BOND_PRIMARY_RESELECT_MAX] = {
@@ -266,11 +234,7 @@ const char *bond_primary_reselect_mode_to_name(BondPrimaryReselect id) {
 int bond_primary_reselect_name_to_mode(const char *name) {
         assert(name);
 
-        for (size_t i= BOND_ARP_VALIDATE_NONE; i < (size_t) ELEMENTSOF(bond_primary_reselect_table); i++)
-                if (bond_primary_reselect_table[i] && streq_fold(name, bond_primary_reselect_table[i]))
-                        return i;
-
-        return _BOND_AD_SELECT_INVALID;
+        return string_table_lookup(bond_primary_reselect_table, ELEMENTSOF(bond_primary_reselect_table), name);
 }
 
 static const char *const ipvlan_mode_table[_IP_VLAN_MODE_MAX] = {
@@ -292,11 +256,7 @@ const char *ipvlan_mode_to_name(IPVLanMode id) {
 int ipvlan_name_to_mode(const char *name) {
         assert(name);
 
-        for (size_t i = IP_VLAN_MODE_L2; i < (int) ELEMENTSOF(ipvlan_mode_table); i++)
-                if (ipvlan_mode_table[i] && streq_fold(name, ipvlan_mode_table[i]))
-                        return i;
-
-        return _IP_VLAN_MODE_INVALID;
+        return string_table_lookup(ipvlan_mode_table, ELEMENTSOF(ipvlan_mode_table), name);
 }
 
 static const Config netdev_ctl_name_to_config_table[] = {
@@ -0,0 +1,67 @@
+/* Copyright 2024 VMware, Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include "alloc-util.h"
+#include "dracut-parser.h"
+#include "file-util.h"
+#include "log.h"
+#include "network.h"
+#include "string-util.h"
+
+/* A systemd generator turning the ip=, rd.route= and nameserver= options of the kernel command line into .network
+ * files in /run/systemd/network before networkd starts. It is built from the dracut parser and what writes the
+ * files only, and unlike nmctl apply-cmdline it never talks to the bus: networkd is not running yet and reads the
+ * files when it starts.
+ *
+ * Like the generators of systemd it reads the command line from $SYSTEMD_PROC_CMDLINE when set. */
+int main(int argc, char *argv[]) {
+        _auto_cleanup_hash_ GHashTable *networks = NULL;
+        _auto_cleanup_ char *line = NULL;
+        const char *cmdline;
+        int r;
+
+        /* The normal, early and late unit directories, no units are generated */
+        if (argc > 1 && argc != 4) {
+                log_warning("This program takes three or no arguments.");
+                return EXIT_FAILURE;
+        }
+
+        cmdline = getenv("SYSTEMD_PROC_CMDLINE");
+        if (!cmdline) {
+                r = read_one_line("/proc/cmdline", &line);
+                if (r < 0) {
+                        log_warning("Failed to read '/proc/cmdline': %s", strerror(-r));
+                        return EXIT_FAILURE;
+                }
+
+                (void) truncate_newline(line);
+                cmdline = line;
+        }
+
+        r = parse_proc_command_line(cmdline, &networks);
+        if (r < 0) {
+                log_warning("Failed to parse kernel command line: %s", strerror(-r));
+                return EXIT_FAILURE;
+        }
+
+        /* Most boots configure no interface on the command line */
+        if (g_hash_table_size(networks) == 0)
+                return EXIT_SUCCESS;
+
+        if (g_mkdir_with_parents(NETWORKD_RUNTIME_CONFIG_DIR, 0755) < 0) {
+                log_warning("Failed to create '%s': %s", NETWORKD_RUNTIME_CONFIG_DIR, strerror(errno));
+                return EXIT_FAILURE;
+        }
+
+        network_config_dir_set(NETWORKD_RUNTIME_CONFIG_DIR);
+
+        r = dracut_generate_network_config(networks);
+        if (r < 0)
+                return EXIT_FAILURE;
+
+        return EXIT_SUCCESS;
+}
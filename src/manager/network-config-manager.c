@@ -3765,7 +3765,7 @@ _public_ int ncm_show_dns_server(int argc, char *argv[]) {
         else
                 (void) manager_acquire_all_link_dns(&dns_config);
 
-        r = json_acquire_and_parse_network_data(&jobj);
+        r = p ? json_acquire_and_parse_link_data(p->ifindex, &jobj) : json_acquire_and_parse_network_data(&jobj);
         if ((r < 0 || (r >= 0 && json_parse_dns_servers(jobj, p ? p->ifname : NULL, NULL) < 0)) && json_enabled()) {
                 r = json_build_dns_server(p, dns_config);
                 if (r < 0) {
@@ -4091,7 +4091,7 @@ _public_ int ncm_show_dns_server_domains(int argc, char *argv[]) {
                 return -EINVAL;
         }
 
-        (void) json_acquire_and_parse_network_data(&jobj);
+        (void) (p ? json_acquire_and_parse_link_data(p->ifindex, &jobj) : json_acquire_and_parse_network_data(&jobj));
         if (json_enabled())
                 return json_fill_dns_server_domains(p, jobj);
 
@@ -4285,7 +4285,7 @@ _public_ int ncm_show_ntp_servers(int argc, char *argv[]) {
                 return -EINVAL;
         }
 
-        r = json_acquire_and_parse_network_data(&jobj);
+        r = p ? json_acquire_and_parse_link_data(p->ifindex, &jobj) : json_acquire_and_parse_network_data(&jobj);
         if ((r < 0 || (r >= 0 && json_fill_ntp_servers(jobj, p ? p->ifname : NULL, NULL) < 0)) && json_enabled())
                 r = json_build_ntp_server(p, &jntp);
         else
@@ -4303,10 +4303,8 @@ _public_ int ncm_show_ntp_servers(int argc, char *argv[]) {
                 json_object_object_add(j, "NTP", jntp);
                 steal_ptr(jntp);
 
-                if (json_enabled()) {
-                        printf("%s\n", json_object_to_json_string_ext(j, JSON_C_TO_STRING_NOSLASHESCAPE | JSON_C_TO_STRING_SPACED | JSON_C_TO_STRING_PRETTY));
-                        return 0;
-                }
+                if (json_enabled())
+                        return json_print_object(j);
         }
 
         if (!json_object_object_get_ex(j, "NTP", &ja))
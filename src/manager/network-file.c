@@ -0,0 +1,257 @@
+/* Copyright 2024 VMware, Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "alloc-util.h"
+#include "config-file.h"
+#include "config-parser.h"
+#include "config-stage.h"
+#include "dbus.h"
+#include "file-util.h"
+#include "log.h"
+#include "macros.h"
+#include "network.h"
+#include "networkd-api.h"
+#include "network-util.h"
+#include "string-util.h"
+
+/* The .network files of running links: finding the one networkd loaded, and writing them with a reload of
+ * networkd afterwards. What only writes files lives in network.c, which the early boot generator is built from. */
+
+int create_network_conf_file(const char *ifname, char **ret) {
+        int r;
+
+        assert(ifname);
+
+        r = write_network_conf_file(ifname, ret);
+        if (r < 0)
+                return r;
+
+        return dbus_network_reload();
+}
+
+int create_or_parse_network_file(const IfNameIndex *p, char **ret) {
+        _auto_cleanup_ char *setup = NULL, *network = NULL;
+        int r;
+
+        assert(p);
+
+        r = network_parse_link_setup_state(p->ifindex, &setup);
+        if (r < 0) {
+                r = create_network_conf_file(p->ifname, &network);
+                if (r < 0)
+                        return r;
+        } else {
+                r = network_parse_link_network_file(p->ifindex, &network);
+                if (r < 0) {
+                        r = create_network_conf_file(p->ifname, &network);
+                        if (r < 0)
+                                return r;
+                }
+        }
+
+        if (!config_file_exists(network)) {
+                r = create_network_conf_file(p->ifname, &network);
+                if (r < 0)
+                        return r;
+        }
+
+        *ret = steal_ptr(network);
+        return 0;
+}
+
+int parse_network_file(const int ifindex, const char *ifname, char **ret) {
+        _auto_cleanup_ char *network = NULL;
+        int r;
+
+        if (ifindex > 0) {
+                r = network_parse_link_network_file(ifindex, &network);
+                if (r >= 0 && !config_file_exists(network)) {
+                        /* What networkd loaded is about to be replaced by a YAML apply */
+                        network = mfree(network);
+                        r = -ENOENT;
+                }
+                if (r < 0) {
+                        r = determine_network_conf_file(ifname, &network);
+                        if (r < 0)
+                                return r;
+
+                        if (!config_file_exists(network)) {
+                                r = create_network_conf_file(ifname, &network);
+                                if (r < 0)
+                                        return r;
+                        }
+                }
+        } else {
+                r = determine_network_conf_file(ifname, &network);
+                if (r < 0)
+                        return r;
+
+                if (!network || !config_file_exists(network)) {
+                        r = create_network_conf_file(ifname, &network);
+                        if (r < 0)
+                                return r;
+                }
+        }
+
+        *ret = steal_ptr(network);
+        return 0;
+}
+
+int generate_network_config(Network *n) {
+        int r;
+
+        assert(n);
+
+        r = write_network_config(n);
+        if (r <= 0)
+                return r;
+
+        (void) dbus_network_reload();
+        return 0;
+}
+
+int generate_master_device_network(Network *n) {
+        _cleanup_(config_manager_freep) ConfigManager *m = NULL;
+        _auto_cleanup_ IfNameIndex *p = NULL;
+        _auto_cleanup_ char *network = NULL;
+        int r;
+
+        if (!n->netdev)
+                return 0;
+
+        r = netdev_ctl_name_to_configs_new(&m);
+        if (r < 0)
+                return r;
+
+        /* MACVLAN */
+        switch (n->netdev->kind) {
+                case NETDEV_KIND_MACVLAN: {
+                        MACVLan *macvlan = n->netdev->macvlan;
+
+                        r = parse_ifname_or_index(macvlan->master, &p);
+                        if (r < 0)
+                                log_debug("Failed to find device: %s", macvlan->master);
+
+                        r = parse_network_file(p ? p->ifindex : -1, macvlan->master, &network);
+                        if (r < 0)
+                                return r;
+
+                        if (config_exists(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname))
+                                break;
+
+                        r = add_key_to_section_str(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname);
+                        if (r < 0)
+                                return r;
+                }
+                        break;
+                case NETDEV_KIND_VLAN: {
+                        VLan *vlan = n->netdev->vlan;
+
+                        r = parse_ifname_or_index(vlan->master, &p);
+                        if (r < 0)
+                                log_debug("Failed to find device: %s", vlan->master);
+
+                        r = parse_network_file(p ? p->ifindex : -1, vlan->master, &network);
+                        if (r < 0)
+                                return r;
+
+                        if (config_exists(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname))
+                                break;
+
+                        r = add_key_to_section_str(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname);
+                        if (r < 0)
+                                return r;
+                }
+                        break;
+                case NETDEV_KIND_BOND: {
+                        Bond *b = n->netdev->bond;
+                        char **d;
+
+                        strv_foreach(d, b->interfaces) {
+                                r = parse_ifname_or_index(*d, &p);
+                                if (r < 0)
+                                        log_debug("Failed to find device: %s", *d);
+
+                                r = parse_network_file(p ? p->ifindex : -1, *d, &network);
+                                if (r < 0)
+                                        return r;
+
+                                if (config_exists(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname))
+                                        break;
+
+                                r = add_key_to_section_str(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname);
+                                if (r < 0)
+                                        return r;
+                        }
+                }
+                        break;
+                case NETDEV_KIND_BRIDGE: {
+                        Bridge *b = n->netdev->bridge;
+                        char **d;
+
+                        strv_foreach(d, b->interfaces) {
+                                r = parse_ifname_or_index(*d, &p);
+                                if (r < 0)
+                                        log_debug("Failed to find device: %s", *d);
+
+                                r = parse_network_file(p ? p->ifindex : -1, *d, &network);
+                                if (r < 0)
+                                        return r;
+
+                                if (config_exists(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname))
+                                        break;
+
+                                r = add_key_to_section_str(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname);
+                                if (r < 0)
+                                        return r;
+                        }
+                }
+                        break;
+                case NETDEV_KIND_VRF: {
+                        VRF *vrf = n->netdev->vrf;
+                        char **d;
+
+                        strv_foreach(d, vrf->interfaces) {
+                                r = parse_ifname_or_index(*d, &p);
+                                if (r < 0)
+                                        log_debug("Failed to find device: %s", *d);
+
+                                r = parse_network_file(p ? p->ifindex : -1, *d, &network);
+                                if (r < 0)
+                                        return r;
+
+                                if (config_exists(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname))
+                                        break;
+
+                                r = add_key_to_section_str(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname);
+                                if (r < 0)
+                                        return r;
+                        }
+                }
+                        break;
+                case NETDEV_KIND_VXLAN: {
+                        VxLan *vx = n->netdev->vxlan;
+
+                        r = parse_ifname_or_index(vx->master, &p);
+                        if (r < 0)
+                                log_debug("Failed to find device: %s", vx->master);
+
+                        r = parse_network_file(p ? p->ifindex : -1, vx->master, &network);
+                        if (r < 0)
+                                return r;
+
+                        if (config_exists(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname))
+                                break;
+
+                        r = add_key_to_section_str(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname);
+                        if (r < 0)
+                                return r;
+                }
+
+                default:
+                        break;
+        }
+
+        return 0;
+}
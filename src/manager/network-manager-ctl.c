@@ -6,22 +6,46 @@
 #include <network-config-manager.h>
 
 #include "alloc-util.h"
+#include "config-file.h"
+#include "config-stage.h"
 #include "ctl-display.h"
+#include "dbus.h"
 #include "file-util.h"
 #include "ctl.h"
 #include "log.h"
 #include "macros.h"
+#include "network-json.h"
 #include "network-manager.h"
+#include "networkd-state-cache.h"
 #include "parse-util.h"
 
 #define DEFAULT_LOG_LINE_SIZE 64
 
 static bool alias = false;
+static char *batch = NULL;
+static bool keep_going = false;
+static bool dry_run = false;
+
+static void display_config_changes(GPtrArray *changes) {
+        if (!changes || changes->len == 0) {
+                printf("No changes\n");
+                return;
+        }
+
+        for (guint i = 0; i < changes->len; i++) {
+                ConfigChange *c = g_ptr_array_index(changes, i);
+
+                printf("%-6s %s\n", config_change_type_to_name(c->type), c->path);
+        }
+}
 
 static int load_yaml_files(void) {
+        _cleanup_(g_ptr_array_unrefp) GPtrArray *changes = NULL;
+        _auto_cleanup_strv_ char **files = NULL;
         g_autoptr(GHashTable) configs = NULL;
         g_autoptr(GList) config_keys = NULL;
         _cleanup_(globfree) glob_t g = {};
+        size_t n = 0;
         int r;
 
         r = glob_files("/etc/network-config-manager/yaml/*.y*ml", 0, &g);
@@ -37,11 +61,20 @@ static int load_yaml_files(void) {
 
         config_keys = g_list_sort(g_hash_table_get_keys(configs), (GCompareFunc) strcmp);
 
-        for (GList *i = config_keys; i ; i = i->next) {
-                r = manager_generate_network_config_from_yaml(g_hash_table_lookup(configs, i->data));
-                if (r < 0)
-                        return r;
-        }
+        files = new0(char *, g_hash_table_size(configs) + 1);
+        if (!files)
+                return log_oom();
+
+        for (GList *i = config_keys; i ; i = i->next)
+                files[n++] = g_strdup(g_hash_table_lookup(configs, i->data));
+
+        /* The directory is the whole desired state, files of YAML files that are gone are removed too */
+        r = manager_generate_network_config_from_yaml_files(files, true, dry_run, &changes);
+        if (r < 0)
+                return r;
+
+        if (dry_run)
+                display_config_changes(changes);
 
         return 0;
 }
@@ -56,11 +89,14 @@ static int generate_networkd_config_from_yaml(int argc, char *argv[]) {
                         return r;
                 }
         } else {
-                for (int i = 1; i < argc; i++) {
-                        r = manager_generate_network_config_from_yaml(argv[i]);
-                        if (r < 0)
-                                return r;
-                }
+                _cleanup_(g_ptr_array_unrefp) GPtrArray *changes = NULL;
+
+                r = manager_generate_network_config_from_yaml_files(argv + 1, false, dry_run, &changes);
+                if (r < 0)
+                        return r;
+
+                if (dry_run)
+                        display_config_changes(changes);
         }
 
         return 0;
@@ -123,11 +159,31 @@ static int help(void) {
                "  -h --help                    Show this help message and exit\n"
                "  -v --version                 Show package version\n"
                "  -j --json                    Show in JSON format\n"
+               "     --output=json|cbor        Show in JSON or in CBOR (RFC 8949) format. CBOR leaves out the string\n"
+               "                               spelling of members also present as integers, e.g. ScopeString\n"
                "  -b --no-beautify             Show without colors and headers\n"
+               "     --fields=FIELD,...        Show only these properties of a device, named as in the JSON output,\n"
+               "                               e.g. Name,KernelOperStateString,Addresses,MTU. Data needed only for\n"
+               "                               other properties is not gathered\n"
+               "     --watch                   With status and status-devs, keep showing device state, addresses and\n"
+               "                               traffic rates, updated as they change, until interrupted\n"
+               "     --since=TIME              With logs, show entries not older than TIME, e.g. \"2024-05-01 10:00\",\n"
+               "                               yesterday, -1h or @SECONDS\n"
+               "     --until=TIME              With logs, show entries not newer than TIME\n"
+               "     --cursor=CURSOR           With logs, show entries after the cursor printed by an earlier run\n"
+               "     --follow                  With logs, keep showing new entries as they are written\n"
                "  -a --alias                   Show command alias\n"
+               "  -d --drop-in                 Write single setting changes as drop-ins in <file>.d/ instead of\n"
+               "                               rewriting the .network/.link file\n"
+               "     --batch=FILE|-            Run one command per line of FILE or stdin in a single process and\n"
+               "                               reload systemd-networkd once at the end\n"
+               "     --keep-going              In batch mode, continue with the next line when a command fails\n"
+               "     --dry-run                 With apply and apply-file, show which files would be created, updated\n"
+               "                               or removed without changing anything\n"
                "\nCommands:\n"
                "  status                       [DEVICE] Show system or device status\n"
                "  status-devs                  List all devices.\n"
+               "  logs                         [DEVICE] Show systemd-networkd logs, or those of a device\n"
                "  show-ipv4-status             dev [DEVICE] Show device ipv4 address, address mode and gateway\n"
                "  set-mtu                      dev [DEVICE] mtu [MTU NUMBER] Configures device MTU.\n"
                "  set-mac                      dev [DEVICE] mac [MAC] Configures device MAC address.\n"
@@ -323,6 +379,16 @@ static int parse_argv(int argc, char *argv[]) {
 
         enum {
                 ARG_VERSION = 0x604,
+                ARG_BATCH,
+                ARG_KEEP_GOING,
+                ARG_FIELDS,
+                ARG_OUTPUT,
+                ARG_WATCH,
+                ARG_SINCE,
+                ARG_UNTIL,
+                ARG_CURSOR,
+                ARG_FOLLOW,
+                ARG_DRY_RUN,
         };
 
         static const struct option options[] = {
@@ -332,7 +398,18 @@ static int parse_argv(int argc, char *argv[]) {
                 { "network",     no_argument,       NULL, 'n'   },
                 { "no-beautify", no_argument,       NULL, 'b'   },
                 { "alias",       no_argument,       NULL, 'a'   },
+                { "drop-in",     no_argument,       NULL, 'd'   },
                 { "log",         optional_argument, NULL, 'l'   },
+                { "batch",       required_argument, NULL, ARG_BATCH      },
+                { "keep-going",  no_argument,       NULL, ARG_KEEP_GOING },
+                { "fields",      required_argument, NULL, ARG_FIELDS     },
+                { "output",      required_argument, NULL, ARG_OUTPUT     },
+                { "watch",       no_argument,       NULL, ARG_WATCH      },
+                { "since",       required_argument, NULL, ARG_SINCE      },
+                { "until",       required_argument, NULL, ARG_UNTIL      },
+                { "cursor",      required_argument, NULL, ARG_CURSOR     },
+                { "follow",      no_argument,       NULL, ARG_FOLLOW     },
+                { "dry-run",     no_argument,       NULL, ARG_DRY_RUN    },
                 {}
         };
         int r, c, l = 0;
@@ -340,7 +417,7 @@ static int parse_argv(int argc, char *argv[]) {
         assert(argc >= 0);
         assert(argv);
 
-        while ((c = getopt_long(argc, argv, "ahvjnbl", options, 0)) >= 0) {
+        while ((c = getopt_long(argc, argv, "ahvjnbdl", options, 0)) >= 0) {
                 switch (c) {
                 case 'h':
                         return help();
@@ -358,6 +435,59 @@ static int parse_argv(int argc, char *argv[]) {
                 case 'a':
                         alias = true;
                         break;
+                case 'd':
+                        config_file_set_drop_in(true);
+                        break;
+                case ARG_BATCH:
+                        batch = optarg;
+                        break;
+                case ARG_KEEP_GOING:
+                        keep_going = true;
+                        break;
+                case ARG_OUTPUT:
+                        r = json_writer_name_to_format(optarg);
+                        if (r < 0) {
+                                log_warning("Unknown output format '%s'", optarg);
+                                return r;
+                        }
+
+                        set_output_format(r);
+                        break;
+                case ARG_WATCH:
+                        set_watch(true);
+                        break;
+                case ARG_SINCE:
+                case ARG_UNTIL: {
+                        uint64_t t;
+
+                        r = parse_timestamp(optarg, &t);
+                        if (r < 0) {
+                                log_warning("Failed to parse timestamp '%s': %s", optarg, strerror(-r));
+                                return r;
+                        }
+
+                        if (c == ARG_SINCE)
+                                set_log_since(t);
+                        else
+                                set_log_until(t);
+                        break;
+                }
+                case ARG_CURSOR:
+                        set_log_cursor(optarg);
+                        break;
+                case ARG_FOLLOW:
+                        set_log_follow(true);
+                        break;
+                case ARG_DRY_RUN:
+                        dry_run = true;
+                        break;
+                case ARG_FIELDS:
+                        r = set_fields(optarg);
+                        if (r < 0) {
+                                log_warning("Failed to parse fields '%s': %s", optarg, strerror(-r));
+                                return r;
+                        }
+                        break;
                 case 'l':
                         for (int i = optind; i < argc; ++i) {
                                 r = parse_int(argv[i], &l);
@@ -381,13 +511,87 @@ static int parse_argv(int argc, char *argv[]) {
         return 1;
 }
 
+/* Runs the commands of 'path' ("-" for stdin), one per line, with the same words as on the command line. Global
+ * options such as --json apply to every line. Empty lines and lines starting with '#' are skipped. */
+static int run_batch(const CtlManager *m, const char *path) {
+        _auto_cleanup_fclose_ FILE *f = NULL;
+        _auto_cleanup_ char *line = NULL;
+        bool networkd_checked = false, state_cache;
+        size_t size = 0;
+        FILE *in;
+        int r = 0;
+
+        assert(m);
+        assert(path);
+
+        if (streq(path, "-"))
+                in = stdin;
+        else {
+                f = fopen(path, "re");
+                if (!f) {
+                        log_warning("Failed to open '%s': %s", path, strerror(errno));
+                        return -errno;
+                }
+                in = f;
+        }
+
+        /* State files are read again and again across the commands, keep them parsed until networkd rewrites them */
+        state_cache = netif_state_cache_enable(NULL, NULL) >= 0;
+
+        for (unsigned n = 1; getline(&line, &size, in) >= 0; n++) {
+                _cleanup_(g_error_freep) GError *e = NULL;
+                _auto_cleanup_strv_ char **args = NULL;
+                char *c;
+                int argc, k;
+
+                c = g_strstrip(line);
+                if (isempty(c) || c[0] == '#')
+                        continue;
+
+                if (!g_shell_parse_argv(c, &argc, &args, &e)) {
+                        log_warning("%s:%u: Failed to parse '%s': %s", path, n, c, e->message);
+                        k = -EINVAL;
+                } else {
+                        if (!networkd_checked && !runs_without_networkd(args[0])) {
+                                if (!ncm_is_netword_running()) {
+                                        r = -ENETDOWN;
+                                        break;
+                                }
+
+                                networkd_checked = true;
+                        }
+
+                        /* The previous command may have changed what networkd describes */
+                        json_network_data_cache_clear();
+
+                        optind = 0;
+                        k = ctl_run_command(m, argc, args);
+                        if (k < 0)
+                                log_warning("%s:%u: '%s' failed: %s", path, n, c, strerror(-k));
+                }
+
+                if (k < 0) {
+                        if (r >= 0)
+                                r = k;
+
+                        if (!keep_going)
+                                break;
+                }
+        }
+
+        if (state_cache)
+                netif_state_cache_disable(NULL, NULL);
+        return r;
+}
+
 static int cli_run(int argc, char *argv[]) {
         _cleanup_(ctl_freep) CtlManager *m = NULL;
-        int r;
+        int r, k;
 
         static const Ctl commands[] = {
                 { "status",                        "s",                WORD_ANY, WORD_ANY, true,  ncm_system_status },
                 { "status-devs",                   "sd",               WORD_ANY, WORD_ANY, false, ncm_link_status },
+                { "logs",                          "lg",               WORD_ANY, WORD_ANY, false, ncm_show_network_logs },
                 { "show-ipv4-status",              "s4s",              1,        WORD_ANY, false, ncm_system_ipv4_status },
                 { "set-mtu",                       "mtu",              3,        WORD_ANY, false, ncm_link_set_mtu },
                 { "set-mac",                       "mac",              3,        WORD_ANY, false, ncm_link_set_mac },
@@ -536,7 +740,7 @@ static int cli_run(int argc, char *argv[]) {
                 return 0;
         }
 
-        if (!isempty(argv[1]) && !runs_without_networkd(argv[1]))
+        if (!batch && !isempty(argv[1]) && !runs_without_networkd(argv[1]))
                 if (!ncm_is_netword_running())
                         exit(-1);
 
@@ -544,11 +748,27 @@ static int cli_run(int argc, char *argv[]) {
         if (r < 0)
                 return r;
 
-        return ctl_run_command(m, argc, argv);
+        /* Whatever the command (or the whole batch) changes, networkd is reloaded once when it is done */
+        dbus_network_reload_defer();
+        if (batch)
+                r = run_batch(m, batch);
+        else
+                r = ctl_run_command(m, argc, argv);
+        k = dbus_network_reload_flush();
+        if (k < 0 && r >= 0)
+                r = k;
+
+        return r;
 }
 
 int main(int argc, char *argv[]) {
+        int r;
+
         g_log_set_default_handler (g_log_default_handler, NULL);
 
-        return cli_run(argc, argv);
+        r = cli_run(argc, argv);
+
+        json_network_data_cache_clear();
+        dbus_release_system_bus();
+        return r;
 }
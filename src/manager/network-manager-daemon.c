@@ -0,0 +1,611 @@
+/* Copyright 2024 VMware, Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <network-config-manager.h>
+
+#include <signal.h>
+#include <sys/epoll.h>
+#include <systemd/sd-bus.h>
+#include <systemd/sd-event.h>
+
+#include "alloc-util.h"
+#include "dbus.h"
+#include "log.h"
+#include "macros.h"
+#include "network-json.h"
+#include "network-manager.h"
+#include "network-util.h"
+#include "networkd-state-cache.h"
+#include "parse-util.h"
+#include "string-util.h"
+
+#define NMCTL_BUS_NAME    "org.freedesktop.nmctl1"
+#define NMCTL_OBJECT_PATH "/org/freedesktop/nmctl1"
+#define NMCTL_INTERFACE   "org.freedesktop.nmctl1.Manager"
+
+/* The service is bus activated, so it goes away once the management agent has been quiet for a while */
+#define DAEMON_IDLE_TIMEOUT_USEC (5 * 60 * 1000000ULL)
+
+typedef struct Daemon {
+        sd_event *event;
+        sd_bus *bus;
+
+        sd_event_source *flush_event;
+        sd_event_source *idle_event;
+        sd_event_source *state_event;
+
+        bool batch;
+        bool state_cache;
+} Daemon;
+
+static void on_link_state_changed(int ifindex, void *userdata) {
+        /* networkd rewrote a state file, so its Describe output moved on as well */
+        json_network_data_cache_clear();
+}
+
+static void daemon_free(Daemon *d) {
+        if (!d)
+                return;
+
+        sd_event_source_unref(d->flush_event);
+        sd_event_source_unref(d->idle_event);
+        sd_event_source_unref(d->state_event);
+
+        if (d->bus)
+                sd_bus_detach_event(d->bus);
+
+        sd_bus_flush_close_unref(d->bus);
+        sd_event_unref(d->event);
+
+        if (d->state_cache)
+                netif_state_cache_disable(on_link_state_changed, d);
+        free(d);
+}
+DEFINE_CLEANUP(Daemon *, daemon_free);
+
+static void daemon_touch(Daemon *d) {
+        (void) sd_event_source_set_time_relative(d->idle_event, DAEMON_IDLE_TIMEOUT_USEC);
+        (void) sd_event_source_set_enabled(d->idle_event, SD_EVENT_ONESHOT);
+}
+
+/* Writes are not followed by a networkd Reload right away. The first write opens a reload scope, which is closed
+ * from an idle priority event source, i.e. once every call already queued on the bus was dispatched. A burst of
+ * calls from the agent thus costs one Reload. */
+static void daemon_batch_begin(Daemon *d) {
+        daemon_touch(d);
+
+        if (d->batch)
+                return;
+
+        dbus_network_reload_defer();
+        d->batch = true;
+        (void) sd_event_source_set_enabled(d->flush_event, SD_EVENT_ONESHOT);
+}
+
+static int daemon_batch_flush(Daemon *d) {
+        int r;
+
+        if (!d->batch)
+                return 0;
+
+        d->batch = false;
+        (void) sd_event_source_set_enabled(d->flush_event, SD_EVENT_OFF);
+
+        r = dbus_network_reload_flush();
+        if (r < 0)
+                log_warning("Failed to reload systemd-networkd: %s", strerror(-r));
+
+        return r;
+}
+
+static int on_flush(sd_event_source *s, void *userdata) {
+        (void) daemon_batch_flush(userdata);
+        return 0;
+}
+
+static int on_idle(sd_event_source *s, uint64_t usec, void *userdata) {
+        Daemon *d = userdata;
+
+        log_debug("No requests for a while, exiting");
+        return sd_event_exit(d->event, 0);
+}
+
+static int on_signal(sd_event_source *s, const struct signalfd_siginfo *si, void *userdata) {
+        Daemon *d = userdata;
+
+        return sd_event_exit(d->event, 0);
+}
+
+static int on_state_cache(sd_event_source *s, int fd, uint32_t revents, void *userdata) {
+        (void) netif_state_cache_process();
+        return 0;
+}
+
+static int bus_parse_link(const char *s, IfNameIndex **ret, sd_bus_error *error) {
+        int r;
+
+        r = parse_ifname_or_index(s, ret);
+        if (r < 0)
+                return sd_bus_error_setf(error, SD_BUS_ERROR_INVALID_ARGS, "Failed to find device '%s'", s);
+
+        return 0;
+}
+
+static int bus_verify_addresses(char **addresses, bool prefix, sd_bus_error *error) {
+        const char *a;
+
+        a = ip_addresses_find_invalid(addresses, prefix);
+        if (a)
+                return sd_bus_error_setf(error, SD_BUS_ERROR_INVALID_ARGS, "Invalid address '%s'", a);
+
+        return 0;
+}
+
+static int method_set_link_mtu(sd_bus_message *m, void *userdata, sd_bus_error *error) {
+        _auto_cleanup_ IfNameIndex *p = NULL;
+        const char *link;
+        uint32_t mtu;
+        int r;
+
+        r = sd_bus_message_read(m, "su", &link, &mtu);
+        if (r < 0)
+                return r;
+
+        r = bus_parse_link(link, &p, error);
+        if (r < 0)
+                return r;
+
+        if (mtu == 0)
+                return sd_bus_error_setf(error, SD_BUS_ERROR_INVALID_ARGS, "Invalid MTU %u", mtu);
+
+        daemon_batch_begin(userdata);
+
+        r = manager_set_link_mtu(p, mtu);
+        if (r < 0)
+                return sd_bus_error_set_errnof(error, r, "Failed to set MTU of device '%s': %s", p->ifname, strerror(-r));
+
+        return sd_bus_reply_method_return(m, NULL);
+}
+
+static int method_set_link_mac_address(sd_bus_message *m, void *userdata, sd_bus_error *error) {
+        _auto_cleanup_ IfNameIndex *p = NULL;
+        const char *link, *mac;
+        int r;
+
+        r = sd_bus_message_read(m, "ss", &link, &mac);
+        if (r < 0)
+                return r;
+
+        r = bus_parse_link(link, &p, error);
+        if (r < 0)
+                return r;
+
+        if (!parse_ether_address(mac))
+                return sd_bus_error_setf(error, SD_BUS_ERROR_INVALID_ARGS, "Invalid MAC address '%s'", mac);
+
+        daemon_batch_begin(userdata);
+
+        r = manager_set_link_mac_addr(p, mac);
+        if (r < 0)
+                return sd_bus_error_set_errnof(error, r, "Failed to set MAC address of device '%s': %s", p->ifname, strerror(-r));
+
+        return sd_bus_reply_method_return(m, NULL);
+}
+
+static int method_set_link_group(sd_bus_message *m, void *userdata, sd_bus_error *error) {
+        _auto_cleanup_ IfNameIndex *p = NULL;
+        const char *link;
+        uint32_t group;
+        int r;
+
+        r = sd_bus_message_read(m, "su", &link, &group);
+        if (r < 0)
+                return r;
+
+        r = bus_parse_link(link, &p, error);
+        if (r < 0)
+                return r;
+
+        if (group == 0)
+                return sd_bus_error_setf(error, SD_BUS_ERROR_INVALID_ARGS, "Invalid group %u", group);
+
+        daemon_batch_begin(userdata);
+
+        r = manager_set_link_group(p, group);
+        if (r < 0)
+                return sd_bus_error_set_errnof(error, r, "Failed to set group of device '%s': %s", p->ifname, strerror(-r));
+
+        return sd_bus_reply_method_return(m, NULL);
+}
+
+static int method_set_link_static(sd_bus_message *m, void *userdata, sd_bus_error *error) {
+        _auto_cleanup_strv_ char **addrs = NULL, **gws = NULL, **dns = NULL;
+        _auto_cleanup_ IfNameIndex *p = NULL;
+        const char *link;
+        int keep, r;
+
+        r = sd_bus_message_read(m, "s", &link);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_read_strv(m, &addrs);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_read_strv(m, &gws);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_read_strv(m, &dns);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_read(m, "b", &keep);
+        if (r < 0)
+                return r;
+
+        r = bus_parse_link(link, &p, error);
+        if (r < 0)
+                return r;
+
+        r = bus_verify_addresses(addrs, true, error);
+        if (r < 0)
+                return r;
+
+        r = bus_verify_addresses(gws, true, error);
+        if (r < 0)
+                return r;
+
+        r = bus_verify_addresses(dns, false, error);
+        if (r < 0)
+                return r;
+
+        daemon_batch_begin(userdata);
+
+        r = manager_set_link_static_conf(p, addrs, gws, dns, -1, keep);
+        if (r < 0)
+                return sd_bus_error_set_errnof(error, r, "Failed to set static configuration of device '%s': %s", p->ifname, strerror(-r));
+
+        return sd_bus_reply_method_return(m, NULL);
+}
+
+static int method_set_link_dns(sd_bus_message *m, void *userdata, sd_bus_error *error) {
+        _auto_cleanup_ IfNameIndex *p = NULL;
+        _auto_cleanup_strv_ char **dns = NULL;
+        const char *link;
+        int keep, r;
+
+        r = sd_bus_message_read(m, "s", &link);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_read_strv(m, &dns);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_read(m, "b", &keep);
+        if (r < 0)
+                return r;
+
+        r = bus_parse_link(link, &p, error);
+        if (r < 0)
+                return r;
+
+        r = bus_verify_addresses(dns, false, error);
+        if (r < 0)
+                return r;
+
+        daemon_batch_begin(userdata);
+
+        r = manager_set_dns_server(p, dns, -1, -1, keep);
+        if (r < 0)
+                return sd_bus_error_set_errnof(error, r, "Failed to set DNS servers of device '%s': %s", p->ifname, strerror(-r));
+
+        return sd_bus_reply_method_return(m, NULL);
+}
+
+static int method_set_link_domains(sd_bus_message *m, void *userdata, sd_bus_error *error) {
+        _auto_cleanup_strv_ char **domains = NULL;
+        _auto_cleanup_ IfNameIndex *p = NULL;
+        const char *link;
+        int keep, r;
+
+        r = sd_bus_message_read(m, "s", &link);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_read_strv(m, &domains);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_read(m, "b", &keep);
+        if (r < 0)
+                return r;
+
+        r = bus_parse_link(link, &p, error);
+        if (r < 0)
+                return r;
+
+        daemon_batch_begin(userdata);
+
+        r = manager_set_dns_server_domain(p, domains, keep);
+        if (r < 0)
+                return sd_bus_error_set_errnof(error, r, "Failed to set DNS domains of device '%s': %s", p->ifname, strerror(-r));
+
+        return sd_bus_reply_method_return(m, NULL);
+}
+
+static int method_set_link_ntp(sd_bus_message *m, void *userdata, sd_bus_error *error) {
+        _auto_cleanup_ IfNameIndex *p = NULL;
+        _auto_cleanup_strv_ char **ntp = NULL;
+        const char *link;
+        int keep, r;
+
+        r = sd_bus_message_read(m, "s", &link);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_read_strv(m, &ntp);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_message_read(m, "b", &keep);
+        if (r < 0)
+                return r;
+
+        r = bus_parse_link(link, &p, error);
+        if (r < 0)
+                return r;
+
+        if (strv_empty((const char **) ntp))
+                return sd_bus_error_setf(error, SD_BUS_ERROR_INVALID_ARGS, "No NTP servers given");
+
+        daemon_batch_begin(userdata);
+
+        r = manager_set_ntp_servers(p, ntp, keep);
+        if (r < 0)
+                return sd_bus_error_set_errnof(error, r, "Failed to set NTP servers of device '%s': %s", p->ifname, strerror(-r));
+
+        return sd_bus_reply_method_return(m, NULL);
+}
+
+static int method_remove_link_ntp(sd_bus_message *m, void *userdata, sd_bus_error *error) {
+        _auto_cleanup_ IfNameIndex *p = NULL;
+        const char *link;
+        int r;
+
+        r = sd_bus_message_read(m, "s", &link);
+        if (r < 0)
+                return r;
+
+        r = bus_parse_link(link, &p, error);
+        if (r < 0)
+                return r;
+
+        daemon_batch_begin(userdata);
+
+        r = manager_remove_ntp_addresses(p);
+        if (r < 0)
+                return sd_bus_error_set_errnof(error, r, "Failed to remove NTP servers of device '%s': %s", p->ifname, strerror(-r));
+
+        return sd_bus_reply_method_return(m, NULL);
+}
+
+static int method_apply_yaml(sd_bus_message *m, void *userdata, sd_bus_error *error) {
+        const char *file;
+        int r;
+
+        r = sd_bus_message_read(m, "s", &file);
+        if (r < 0)
+                return r;
+
+        if (!g_path_is_absolute(file))
+                return sd_bus_error_setf(error, SD_BUS_ERROR_INVALID_ARGS, "Path '%s' is not absolute", file);
+
+        daemon_batch_begin(userdata);
+
+        r = manager_generate_network_config_from_yaml(file);
+        if (r < 0)
+                return sd_bus_error_set_errnof(error, r, "Failed to apply '%s': %s", file, strerror(-r));
+
+        return sd_bus_reply_method_return(m, NULL);
+}
+
+static int method_reconfigure_link(sd_bus_message *m, void *userdata, sd_bus_error *error) {
+        _auto_cleanup_ IfNameIndex *p = NULL;
+        const char *link;
+        int r;
+
+        r = sd_bus_message_read(m, "s", &link);
+        if (r < 0)
+                return r;
+
+        r = bus_parse_link(link, &p, error);
+        if (r < 0)
+                return r;
+
+        daemon_batch_begin(userdata);
+
+        r = manager_reconfigure_link(p);
+        if (r < 0)
+                return sd_bus_error_set_errnof(error, r, "Failed to reconfigure device '%s': %s", p->ifname, strerror(-r));
+
+        return sd_bus_reply_method_return(m, NULL);
+}
+
+/* Unlike the batched writes, an explicit Reload() is carried out before the reply, and so are pending writes */
+static int method_reload(sd_bus_message *m, void *userdata, sd_bus_error *error) {
+        int r;
+
+        daemon_batch_begin(userdata);
+
+        r = manager_reload_network();
+        if (r >= 0)
+                r = daemon_batch_flush(userdata);
+        else
+                (void) daemon_batch_flush(userdata);
+        if (r < 0)
+                return sd_bus_error_set_errnof(error, r, "Failed to reload systemd-networkd: %s", strerror(-r));
+
+        return sd_bus_reply_method_return(m, NULL);
+}
+
+static int method_get_link_status(sd_bus_message *m, void *userdata, sd_bus_error *error) {
+        _auto_cleanup_ char *s = NULL;
+        const char *link;
+        int r;
+
+        r = sd_bus_message_read(m, "s", &link);
+        if (r < 0)
+                return r;
+
+        /* Readers see the effect of everything written before them */
+        daemon_touch(userdata);
+        (void) daemon_batch_flush(userdata);
+
+        r = ncm_get_link_status(link, &s);
+        if (r < 0)
+                return sd_bus_error_set_errnof(error, r, "Failed to acquire status of device '%s': %s", link, strerror(-r));
+
+        return sd_bus_reply_method_return(m, "s", s);
+}
+
+static int method_get_system_status(sd_bus_message *m, void *userdata, sd_bus_error *error) {
+        _auto_cleanup_ char *s = NULL;
+        int r;
+
+        daemon_touch(userdata);
+        (void) daemon_batch_flush(userdata);
+
+        r = ncm_get_system_status(&s);
+        if (r < 0)
+                return sd_bus_error_set_errnof(error, r, "Failed to acquire system status: %s", strerror(-r));
+
+        return sd_bus_reply_method_return(m, "s", s);
+}
+
+static const sd_bus_vtable manager_vtable[] = {
+        SD_BUS_VTABLE_START(0),
+        SD_BUS_METHOD_WITH_NAMES("SetLinkMTU", "su", SD_BUS_PARAM(link) SD_BUS_PARAM(mtu),
+                                 "", SD_BUS_NO_RESULT, method_set_link_mtu, 0),
+        SD_BUS_METHOD_WITH_NAMES("SetLinkMACAddress", "ss", SD_BUS_PARAM(link) SD_BUS_PARAM(mac),
+                                 "", SD_BUS_NO_RESULT, method_set_link_mac_address, 0),
+        SD_BUS_METHOD_WITH_NAMES("SetLinkGroup", "su", SD_BUS_PARAM(link) SD_BUS_PARAM(group),
+                                 "", SD_BUS_NO_RESULT, method_set_link_group, 0),
+        SD_BUS_METHOD_WITH_NAMES("SetLinkStatic", "sasasasb",
+                                 SD_BUS_PARAM(link) SD_BUS_PARAM(addresses) SD_BUS_PARAM(gateways) SD_BUS_PARAM(dns) SD_BUS_PARAM(keep),
+                                 "", SD_BUS_NO_RESULT, method_set_link_static, 0),
+        SD_BUS_METHOD_WITH_NAMES("SetLinkDNS", "sasb", SD_BUS_PARAM(link) SD_BUS_PARAM(servers) SD_BUS_PARAM(keep),
+                                 "", SD_BUS_NO_RESULT, method_set_link_dns, 0),
+        SD_BUS_METHOD_WITH_NAMES("SetLinkDomains", "sasb", SD_BUS_PARAM(link) SD_BUS_PARAM(domains) SD_BUS_PARAM(keep),
+                                 "", SD_BUS_NO_RESULT, method_set_link_domains, 0),
+        SD_BUS_METHOD_WITH_NAMES("SetLinkNTP", "sasb", SD_BUS_PARAM(link) SD_BUS_PARAM(servers) SD_BUS_PARAM(keep),
+                                 "", SD_BUS_NO_RESULT, method_set_link_ntp, 0),
+        SD_BUS_METHOD_WITH_NAMES("RemoveLinkNTP", "s", SD_BUS_PARAM(link),
+                                 "", SD_BUS_NO_RESULT, method_remove_link_ntp, 0),
+        SD_BUS_METHOD_WITH_NAMES("ApplyYAML", "s", SD_BUS_PARAM(file),
+                                 "", SD_BUS_NO_RESULT, method_apply_yaml, 0),
+        SD_BUS_METHOD_WITH_NAMES("ReconfigureLink", "s", SD_BUS_PARAM(link),
+                                 "", SD_BUS_NO_RESULT, method_reconfigure_link, 0),
+        SD_BUS_METHOD("Reload", "", "", method_reload, 0),
+        SD_BUS_METHOD_WITH_NAMES("GetLinkStatus", "s", SD_BUS_PARAM(link),
+                                 "s", SD_BUS_PARAM(json), method_get_link_status, 0),
+        SD_BUS_METHOD_WITH_NAMES("GetSystemStatus", "", SD_BUS_NO_ARGS,
+                                 "s", SD_BUS_PARAM(json), method_get_system_status, 0),
+        SD_BUS_VTABLE_END
+};
+
+static int daemon_new(Daemon **ret) {
+        _cleanup_(daemon_freep) Daemon *d = NULL;
+        sigset_t mask;
+        int r;
+
+        d = new0(Daemon, 1);
+        if (!d)
+                return log_oom();
+
+        r = sd_event_default(&d->event);
+        if (r < 0)
+                return r;
+
+        sigemptyset(&mask);
+        sigaddset(&mask, SIGTERM);
+        sigaddset(&mask, SIGINT);
+        sigprocmask(SIG_BLOCK, &mask, NULL);
+
+        r = sd_event_add_signal(d->event, NULL, SIGTERM, on_signal, d);
+        if (r < 0)
+                return r;
+
+        r = sd_event_add_signal(d->event, NULL, SIGINT, on_signal, d);
+        if (r < 0)
+                return r;
+
+        r = sd_event_add_defer(d->event, &d->flush_event, on_flush, d);
+        if (r < 0)
+                return r;
+
+        (void) sd_event_source_set_priority(d->flush_event, SD_EVENT_PRIORITY_IDLE);
+        (void) sd_event_source_set_enabled(d->flush_event, SD_EVENT_OFF);
+
+        r = sd_event_add_time_relative(d->event, &d->idle_event, CLOCK_MONOTONIC, DAEMON_IDLE_TIMEOUT_USEC, 0, on_idle, d);
+        if (r < 0)
+                return r;
+
+        /* A connection of its own: the D-Bus helpers pump the shared one while collecting replies, which sd-bus
+         * refuses to do from inside a method call dispatched on that same connection */
+        r = sd_bus_open_system(&d->bus);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_add_object_vtable(d->bus, NULL, NMCTL_OBJECT_PATH, NMCTL_INTERFACE, manager_vtable, d);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_attach_event(d->bus, d->event, 0);
+        if (r < 0)
+                return r;
+
+        r = sd_bus_request_name(d->bus, NMCTL_BUS_NAME, 0);
+        if (r < 0)
+                return r;
+
+        /* Keeps parsed networkd state files around between calls. Not fatal, everything works uncached as well. */
+        r = netif_state_cache_enable(on_link_state_changed, d);
+        if (r >= 0) {
+                d->state_cache = true;
+
+                r = sd_event_add_io(d->event, &d->state_event, netif_state_cache_get_fd(), EPOLLIN, on_state_cache, d);
+                if (r < 0)
+                        return r;
+        } else
+                log_debug("Failed to enable networkd state cache: %s", strerror(-r));
+
+        *ret = steal_ptr(d);
+        return 0;
+}
+
+int main(int argc, char *argv[]) {
+        _cleanup_(daemon_freep) Daemon *d = NULL;
+        int r;
+
+        g_log_set_default_handler (g_log_default_handler, NULL);
+
+        r = daemon_new(&d);
+        if (r < 0) {
+                log_warning("Failed to start %s: %s", NMCTL_BUS_NAME, strerror(-r));
+                return EXIT_FAILURE;
+        }
+
+        r = sd_event_loop(d->event);
+
+        /* Writes that have not been followed by a reload yet */
+        (void) daemon_batch_flush(d);
+
+        daemon_free(steal_ptr(d));
+        json_network_data_cache_clear();
+        dbus_release_system_bus();
+
+        return r < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -10,6 +10,7 @@
 #include "alloc-util.h"
 #include "config-file.h"
 #include "config-parser.h"
+#include "config-stage.h"
 #include "dbus.h"
 #include "device.h"
 #include "dracut-parser.h"
@@ -1174,8 +1175,8 @@ int manager_configure_link_address(const IfNameIndex *p,
                                    const char *label,
                                    char **many) {
 
+        _cleanup_(key_file_freep) KeyFile *key_file = NULL, *merged = NULL;
         _auto_cleanup_ char *network = NULL, *a = NULL, *b = NULL;
-        _cleanup_(key_file_freep) KeyFile *key_file = NULL;
         _cleanup_(section_freep) Section *section = NULL;
         char **t;
         int r;
@@ -1186,7 +1187,12 @@ int manager_configure_link_address(const IfNameIndex *p,
         if (r < 0)
                 return r;
 
-        r = parse_key_file(network, &key_file);
+        r = parse_key_file_for_section(network, "Address", &key_file);
+        if (r < 0)
+                return r;
+
+        /* The address may already be configured by the base file or any drop-in */
+        r = parse_key_file_merged(network, &merged);
         if (r < 0)
                 return r;
 
@@ -1212,7 +1218,7 @@ int manager_configure_link_address(const IfNameIndex *p,
                         return r;
         }
 
-        if (a && !key_file_config_exists(key_file, "Address", "Address", a)) {
+        if (a && !key_file_config_exists(merged, "Address", "Address", a)) {
                 add_key_to_section(section, "Address", a);
 
                 if (b)
@@ -1241,7 +1247,8 @@ int manager_configure_link_address(const IfNameIndex *p,
         }
 
         strv_foreach(t, many) {
-                if (key_file_config_exists(key_file, "Address", "Address", *t))
+                if (key_file_config_exists(key_file, "Address", "Address", *t) ||
+                    key_file_config_exists(merged, "Address", "Address", *t))
                         continue;
 
                 r = section_new("Address", &section);
@@ -1310,7 +1317,7 @@ int manager_replace_link_address_internal(KeyFile *key_file, char **many, Addres
 }
 
 int manager_replace_link_address(const IfNameIndex *p, char **many, AddressFamily family) {
-        _cleanup_(key_file_freep) KeyFile *key_file = NULL;
+        _cleanup_(key_file_freep) KeyFile *key_file = NULL, *drop_in = NULL;
         _auto_cleanup_ char *setup = NULL, *network = NULL;
         int r;
 
@@ -1332,42 +1339,44 @@ int manager_replace_link_address(const IfNameIndex *p, char **many, AddressFamil
         if (r < 0)
                 return r;
 
+        /* A drop-in can not take back the addresses of the base file, so the new ones live there and those
+         * added in drop-in mode are removed */
+        r = config_drop_in_open(network, "Address", NULL, &drop_in);
+        if (r < 0 && r != -ENOENT)
+                return r;
+
         r = manager_replace_link_address_internal(key_file, many, family);
         if (r < 0)
                 return r;
 
+        if (drop_in) {
+                r = manager_replace_link_address_internal(drop_in, NULL, family);
+                if (r < 0)
+                        return r;
+        }
+
         r = key_file_save (key_file);
         if (r < 0) {
                 log_warning("Failed to write to '%s': %s", key_file->name, strerror(-r));
                 return r;
         }
 
+        if (drop_in) {
+                r = config_drop_in_save(drop_in);
+                if (r < 0) {
+                        log_warning("Failed to write to '%s': %s", drop_in->name, strerror(-r));
+                        return r;
+                }
+        }
+
         return dbus_network_reload();
 }
 
-int manager_remove_link_address(const IfNameIndex *p, char **addresses, AddressFamily family) {
-        _cleanup_(key_file_freep) KeyFile *key_file = NULL;
-        _auto_cleanup_ char *setup = NULL, *network = NULL;
+static void manager_remove_link_address_internal(KeyFile *key_file, char **addresses, AddressFamily family) {
         char **a;
         int r;
 
-        assert(p);
-
-        r = network_parse_link_setup_state(p->ifindex, &setup);
-        if (r < 0) {
-                log_warning("Failed to find device setup '%s': %s", p->ifname, strerror(-r));
-                return r;
-        }
-
-        r = network_parse_link_network_file(p->ifindex, &network);
-        if (r < 0) {
-                log_warning("Failed to find .network file for '%s': %s", p->ifname, strerror(-r));
-                return r;
-        }
-
-        r = parse_key_file(network, &key_file);
-        if (r < 0)
-                return r;
+        assert(key_file);
 
         strv_foreach(a, addresses)
                 key_file_remove_section_key_value(key_file, "Address", "Address", *a);
@@ -1394,6 +1403,39 @@ int manager_remove_link_address(const IfNameIndex *p, char **addresses, AddressF
                         }
                 }
         }
+}
+
+int manager_remove_link_address(const IfNameIndex *p, char **addresses, AddressFamily family) {
+        _cleanup_(key_file_freep) KeyFile *key_file = NULL, *drop_in = NULL;
+        _auto_cleanup_ char *setup = NULL, *network = NULL;
+        int r;
+
+        assert(p);
+
+        r = network_parse_link_setup_state(p->ifindex, &setup);
+        if (r < 0) {
+                log_warning("Failed to find device setup '%s': %s", p->ifname, strerror(-r));
+                return r;
+        }
+
+        r = network_parse_link_network_file(p->ifindex, &network);
+        if (r < 0) {
+                log_warning("Failed to find .network file for '%s': %s", p->ifname, strerror(-r));
+                return r;
+        }
+
+        r = parse_key_file(network, &key_file);
+        if (r < 0)
+                return r;
+
+        /* Addresses added in drop-in mode are removed from the drop-in too */
+        r = config_drop_in_open(network, "Address", NULL, &drop_in);
+        if (r < 0 && r != -ENOENT)
+                return r;
+
+        manager_remove_link_address_internal(key_file, addresses, family);
+        if (drop_in)
+                manager_remove_link_address_internal(drop_in, addresses, family);
 
         r = key_file_save (key_file);
         if (r < 0) {
@@ -1401,6 +1443,14 @@ int manager_remove_link_address(const IfNameIndex *p, char **addresses, AddressF
                 return r;
         }
 
+        if (drop_in) {
+                r = config_drop_in_save(drop_in);
+                if (r < 0) {
+                        log_warning("Failed to write to '%s': %s", drop_in->name, strerror(-r));
+                        return r;
+                }
+        }
+
         return dbus_network_reload();
 }
 
@@ -1513,7 +1563,10 @@ int manager_configure_default_gateway(const IfNameIndex *p, Route *rt, bool keep
         if (r < 0)
                 return r;
 
-        r = parse_key_file(network, &key_file);
+        if (keep)
+                r = parse_key_file_for_section(network, "Route", &key_file);
+        else
+                r = parse_key_file(network, &key_file);
         if (r < 0)
                 return r;
 
@@ -1552,6 +1605,10 @@ int manager_configure_default_gateway(const IfNameIndex *p, Route *rt, bool keep
                 return r;
         }
 
+        /* A gateway added in drop-in mode would be configured next to the one just set */
+        if (!keep)
+                (void) remove_config_drop_ins(network, "Route", "Gateway");
+
         return dbus_network_reload();
 }
 
@@ -1581,7 +1638,7 @@ int manager_configure_route(const IfNameIndex *p,
         if (r < 0)
                 return r;
 
-        r = parse_key_file(network, &key_file);
+        r = parse_key_file_for_section(network, "Route", &key_file);
         if (r < 0)
                 return r;
 
@@ -1721,7 +1778,7 @@ int manager_remove_gateway_or_route_full_internal(KeyFile *key_file, bool gatewa
 }
 
 int manager_remove_gateway_or_route_full(const char *network, bool gateway, AddressFamily family) {
-        _cleanup_(key_file_freep) KeyFile *key_file = NULL;
+        _cleanup_(key_file_freep) KeyFile *key_file = NULL, *drop_in = NULL;
         int r;
 
         assert(network);
@@ -1730,14 +1787,31 @@ int manager_remove_gateway_or_route_full(const char *network, bool gateway, Addr
         if (r < 0)
                 return r;
 
+        /* Routes added in drop-in mode are removed from the drop-in too */
+        r = config_drop_in_open(network, "Route", NULL, &drop_in);
+        if (r < 0 && r != -ENOENT)
+                return r;
+
         r = manager_remove_gateway_or_route_full_internal(key_file, gateway, family);
         if (r < 0)
                 return r;
 
+        if (drop_in) {
+                r = manager_remove_gateway_or_route_full_internal(drop_in, gateway, family);
+                if (r < 0)
+                        return r;
+        }
+
         r = key_file_save (key_file);
         if (r < 0)
                 return r;
 
+        if (drop_in) {
+                r = config_drop_in_save(drop_in);
+                if (r < 0)
+                        return r;
+        }
+
         return dbus_network_reload();
 }
 
@@ -1793,7 +1867,7 @@ int manager_configure_routing_policy_rules(const IfNameIndex *p, RoutingPolicyRu
                 return r;
         }
 
-        r = parse_key_file(network, &key_file);
+        r = parse_key_file_for_section(network, "RoutingPolicyRule", &key_file);
         if (r < 0)
                 return r;
 
@@ -3052,7 +3126,7 @@ int manager_set_ipv4(const IfNameIndex *p,
 }
 
 int manager_reload_network(void) {
-        return dbus_network_reload();
+        return dbus_network_force_reload();
 }
 
 int manager_reconfigure_link(const IfNameIndex *i) {
@@ -3096,7 +3170,7 @@ int manager_remove_networkd_debug_config(void) {
         _auto_cleanup_close_ int fd = -1;
         int r;
 
-        r = remove("/etc/systemd/system/systemd-networkd.service.d/10-debug.conf");
+        r = remove_conf_file("/etc/systemd/system/systemd-networkd.service.d/10-debug.conf");
         if (r < 0)
                 return r;
 
@@ -3363,19 +3437,17 @@ int manager_parse_proxy_config(GHashTable **c) {
         return 0;
 }
 
-int manager_generate_network_config_from_yaml(const char *file) {
-        _cleanup_(networks_freep) Networks *n = NULL;
+/* Files are recorded as generated from the YAML file that describes the interface */
+static void networks_set_stage_source(const Networks *n, const Network *net) {
+        config_stage_set_source(g_hash_table_lookup(n->sources, net->ifname));
+}
+
+static int generate_network_config_from_networks(const Networks *n) {
         GHashTableIter iter;
         gpointer k, v;
         int r;
 
-        assert(file);
-
-        r = yaml_parse_file(file, &n);
-        if (r < 0) {
-                log_warning("Failed to parse configuration file '%s': %s", file, strerror(-r));
-                return r;
-        }
+        assert(n);
 
         /* generate netdev */
         g_hash_table_iter_init (&iter, n->networks);
@@ -3383,9 +3455,11 @@ int manager_generate_network_config_from_yaml(const char *file) {
                 Network *net = (Network *) v;
 
                 if (net->netdev) {
+                        networks_set_stage_source(n, net);
+
                         r = generate_netdev_config(net->netdev);
                         if (r < 0) {
-                                log_warning("Failed to generate network configuration for file '%s': %s", file, strerror(-r));
+                                log_warning("Failed to generate network configuration for '%s': %s", net->ifname, strerror(-r));
                                 return r;
                         }
                 }
@@ -3396,9 +3470,11 @@ int manager_generate_network_config_from_yaml(const char *file) {
         for (;g_hash_table_iter_next (&iter, (gpointer *) &k, (gpointer *) &v);) {
                 Network *net = (Network *) v;
 
+                networks_set_stage_source(n, net);
+
                 r = generate_network_config(net);
                 if (r < 0) {
-                        log_warning("Failed to generate network configuration for file '%s': %s", file, strerror(-r));
+                        log_warning("Failed to generate network configuration for '%s': %s", net->ifname, strerror(-r));
                         return r;
                 }
 
@@ -3424,6 +3500,8 @@ int manager_generate_network_config_from_yaml(const char *file) {
                 if (!net->netdev)
                         continue;
 
+                networks_set_stage_source(n, net);
+
                 r = generate_master_device_network(net);
                 if (r < 0) {
 
@@ -3434,46 +3512,244 @@ int manager_generate_network_config_from_yaml(const char *file) {
         return dbus_network_reload();
 }
 
-static void manager_command_line_config_generator(void *key, void *value, void *user_data) {
-        Network *n;
+/* Records the interfaces each YAML file describes, files describing the same one are generated together */
+static int networks_stage_interfaces(const Networks *n) {
+        GHashTableIter iter;
+        gpointer k, v;
         int r;
 
-        assert(key);
-        assert(value);
+        assert(n);
 
-        n = (Network *) value;
-        r = generate_network_config(n);
+        g_hash_table_iter_init(&iter, n->sources);
+        while (g_hash_table_iter_next(&iter, &k, &v)) {
+                r = config_stage_add_interface(v, k);
+                if (r < 0)
+                        return r;
+        }
+
+        g_hash_table_iter_init(&iter, n->overridden);
+        while (g_hash_table_iter_next(&iter, &k, &v)) {
+                GPtrArray *files = v;
+
+                for (guint i = 0; i < files->len; i++) {
+                        r = config_stage_add_interface(g_ptr_array_index(files, i), k);
+                        if (r < 0)
+                                return r;
+                }
+        }
+
+        return 0;
+}
+
+static int generate_network_config_from_networks_staged(const Networks *n, char **sources, char **hashes, GHashTable *dirty, char ***ret_foreign) {
+        int r;
+
+        assert(n);
+        assert(ret_foreign);
+
+        for (size_t i = 0; sources[i]; i++) {
+                if (!g_hash_table_contains(dirty, sources[i]))
+                        continue;
+
+                r = config_stage_set_source_hash(sources[i], hashes[i]);
+                if (r < 0)
+                        return r;
+        }
+
+        r = networks_stage_interfaces(n);
+        if (r < 0)
+                return r;
+
+        r = generate_network_config_from_networks(n);
+        if (r < 0)
+                return r;
+
+        return config_stage_get_foreign_sources(ret_foreign);
+}
+
+/* Generates the files of the YAML files in 'dirty' alone: those of them in 'sources' are parsed, the files an
+ * earlier apply generated from any of them are replaced. When files of other YAML files in 'sources' would be
+ * touched, those are added to 'dirty' and -EAGAIN is returned without writing anything. */
+static int generate_network_config_from_yaml_files_staged(char **sources, char **hashes, GHashTable *dirty, bool dry_run, GPtrArray **ret_changes) {
+        _auto_cleanup_strv_ char **parse = NULL, **replace = NULL, **foreign = NULL;
+        _cleanup_(networks_freep) Networks *n = NULL;
+        bool added = false;
+        GHashTableIter iter;
+        size_t k = 0;
+        gpointer s;
+        int r;
+
+        parse = new0(char *, g_strv_length(sources) + 1);
+        replace = new0(char *, g_hash_table_size(dirty) + 1);
+        if (!parse || !replace)
+                return log_oom();
+
+        /* In the order given, later files override earlier ones */
+        for (size_t i = 0; sources[i]; i++) {
+                if (!g_hash_table_contains(dirty, sources[i]))
+                        continue;
+
+                parse[k] = g_strdup(sources[i]);
+                if (!parse[k++])
+                        return log_oom();
+        }
+
+        k = 0;
+        g_hash_table_iter_init(&iter, dirty);
+        while (g_hash_table_iter_next(&iter, &s, NULL)) {
+                replace[k] = g_strdup(s);
+                if (!replace[k++])
+                        return log_oom();
+        }
+
+        /* All files are read before anything is generated, in parallel */
+        r = yaml_parse_files(parse, &n);
+        if (r < 0)
+                return r;
+
+        r = config_stage_begin(replace, false);
+        if (r < 0)
+                return r;
+
+        r = generate_network_config_from_networks_staged(n, sources, hashes, dirty, &foreign);
         if (r < 0) {
-                log_warning("Failed to generate network configuration: %s", strerror(-r));
-                return;
+                /* Nothing is written when any of the interfaces fails */
+                config_stage_abort();
+                return r;
         }
+
+        for (char **f = foreign; f && *f; f++)
+                if (g_strv_contains((const char *const *) sources, *f)) {
+                        g_hash_table_add(dirty, g_strdup(*f));
+                        added = true;
+                }
+
+        if (added) {
+                log_debug("Configuration of unchanged YAML files is touched, generating it again too");
+                config_stage_abort();
+                return -EAGAIN;
+        }
+
+        return config_stage_commit(dry_run, ret_changes);
 }
 
-static Network *manager_no_interface_name(GHashTable *networks) {
-        Network *n;
-        GList *l;
+/* The YAML files whose contents or generated files changed since they were applied, with 'all' also the ones
+ * applied before that are gone */
+static int yaml_files_changed(char **sources, char **hashes, bool all, GHashTable **ret) {
+        _cleanup_(config_manifest_freep) ConfigManifest *m = NULL;
+        _auto_cleanup_strv_ char **applied = NULL;
+        _auto_cleanup_hash_ GHashTable *dirty = NULL;
+        int r;
+
+        assert(ret);
+
+        dirty = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+        if (!dirty)
+                return log_oom();
+
+        r = config_manifest_load(&m);
+        if (r < 0) {
+                log_warning("Failed to read '%s', generating all files again: %s", CONFIG_MANIFEST_PATH, strerror(-r));
+
+                for (size_t i = 0; sources[i]; i++)
+                        g_hash_table_add(dirty, g_strdup(sources[i]));
+
+                *ret = steal_ptr(dirty);
+                return 0;
+        }
 
-        assert(networks);
+        for (size_t i = 0; sources[i]; i++)
+                if (!config_manifest_up_to_date(m, sources[i], hashes[i]))
+                        g_hash_table_add(dirty, g_strdup(sources[i]));
 
-        if (g_hash_table_size(networks) > 1)
-                return NULL;
+        if (all) {
+                r = config_manifest_get_sources(m, &applied);
+                if (r < 0)
+                        return r;
 
-        l = g_hash_table_get_values(networks);
-        if (!l)
-                return NULL;
+                for (char **a = applied; *a; a++)
+                        if (!g_strv_contains((const char *const *) sources, *a))
+                                g_hash_table_add(dirty, g_strdup(*a));
+        }
 
-        n = l->data;
-        if (!n || !n->ifname)
-                return NULL;
+        /* Files generated or edited by more than one YAML file have to be generated from all of them */
+        if (g_hash_table_size(dirty) > 0)
+                config_manifest_add_coupled(m, dirty);
 
-        return n;
+        *ret = steal_ptr(dirty);
+        return 0;
+}
+
+/* Generates the configuration of the YAML files in memory as one desired state, later files overriding earlier
+ * ones, and writes only the files whose contents differ from the disk. Files an earlier apply generated from
+ * these YAML files, or from any with 'all', that are not generated any more are removed. networkd is reloaded
+ * once, and only when a file changed. With 'dry_run' the changes are returned but not made.
+ *
+ * The manifest records the hash of each YAML file and of the files generated from it. YAML files that did not
+ * change, and whose files are still as written, are not parsed at all unless they share files or interfaces
+ * with one that did. */
+int manager_generate_network_config_from_yaml_files(char **files, bool all, bool dry_run, GPtrArray **ret_changes) {
+        _auto_cleanup_strv_ char **sources = NULL, **hashes = NULL;
+        _auto_cleanup_hash_ GHashTable *dirty = NULL;
+        size_t n;
+        int r, k;
+
+        n = files ? g_strv_length(files) : 0;
+
+        sources = new0(char *, n + 1);
+        hashes = new0(char *, n + 1);
+        if (!sources || !hashes)
+                return log_oom();
+
+        /* The manifest records where files came from by absolute path */
+        for (size_t i = 0; i < n; i++) {
+                sources[i] = g_canonicalize_filename(files[i], NULL);
+                if (!sources[i])
+                        return log_oom();
+
+                /* Taken before parsing, a file changed meanwhile is applied again next time */
+                r = config_source_hash(sources[i], &hashes[i]);
+                if (r < 0) {
+                        log_warning("Failed to read configuration file '%s': %s", sources[i], strerror(-r));
+                        return r;
+                }
+        }
+
+        r = yaml_files_changed(sources, hashes, all, &dirty);
+        if (r < 0)
+                return r;
+
+        if (g_hash_table_size(dirty) == 0) {
+                log_debug("YAML files did not change since the last apply, nothing to do");
+
+                if (ret_changes)
+                        *ret_changes = NULL;
+                return 0;
+        }
+
+        dbus_network_reload_defer();
+        do
+                r = generate_network_config_from_yaml_files_staged(sources, hashes, dirty, dry_run, ret_changes);
+        while (r == -EAGAIN);
+        k = dbus_network_reload_flush();
+
+        return r < 0 ? r : k;
+}
+
+int manager_generate_network_config_from_yaml(const char *file) {
+        char *files[] = { (char *) file, NULL };
+
+        assert(file);
+
+        return manager_generate_network_config_from_yaml_files(files, false, false, NULL);
 }
 
 int manager_generate_networkd_config_from_command_line(const char *file, const char *command_line) {
         _auto_cleanup_hash_ GHashTable *networks = NULL;
         _auto_cleanup_ char *line = NULL;
-        Network *n;
-        int r = 0;
+        int r;
+
+        assert(file || command_line);
 
         if (file) {
                 r = read_one_line(file, &line);
@@ -3481,22 +3757,16 @@ int manager_generate_networkd_config_from_command_line(const char *file, const c
                         return r;
 
                 (void) truncate_newline(line);
+                command_line = line;
+        }
 
-                r = parse_proc_command_line(line, &networks);
-        } else if (command_line)
-                r = parse_proc_command_line(command_line, &networks);
+        r = parse_proc_command_line(command_line, &networks);
         if (r < 0)
                 return r;
 
-        n = manager_no_interface_name(networks);
-        if (n) {
-                r = generate_network_config(n);
-                if (r < 0) {
-                        log_warning("Failed to generate network configuration: %s", strerror(-r));
-                        return r;
-                }
-        } else
-                g_hash_table_foreach(networks, manager_command_line_config_generator, NULL);
+        r = dracut_generate_network_config(networks);
+        if (r < 0)
+                return r;
 
         return dbus_network_reload();
 }
@@ -157,6 +157,7 @@ int manager_set_dhcp_section(DHCPClient kind, const IfNameIndex *p, const char *
 int manager_create_vlan(const IfNameIndex *p, const char *ifname, VLan *v);
 
 int manager_generate_network_config_from_yaml(const char *file);
+int manager_generate_network_config_from_yaml_files(char **files, bool all, bool dry_run, GPtrArray **ret_changes);
 
 int manager_generate_networkd_config_from_command_line(const char *file, const char *command_line);
 
@@ -5,14 +5,11 @@
 #include "alloc-util.h"
 #include "config-file.h"
 #include "config-parser.h"
-#include "dbus.h"
 #include "dracut-parser.h"
 #include "file-util.h"
 #include "log.h"
 #include "macros.h"
-#include "network-manager.h"
 #include "network.h"
-#include "networkd-api.h"
 #include "parse-util.h"
 #include "network-sriov.h"
 #include "string-util.h"
@@ -39,11 +36,7 @@ const char *use_domains_modes_to_name(int id) {
 int use_domains_name_to_mode(char *name) {
         assert(name);
 
-        for (size_t i = USE_DOMAINS_NO; i < (size_t) ELEMENTSOF(use_domains_mode_table); i++)
-                if (streq_fold(name, use_domains_mode_table[i]))
-                        return i;
-
-        return _USE_DOMAINS_INVALID;
+        return string_table_lookup(use_domains_mode_table, ELEMENTSOF(use_domains_mode_table), name);
 }
 
 static const char *const dhcp_client_mode_table[_DHCP_CLIENT_MAX] = {
@@ -66,11 +59,7 @@ const char *dhcp_client_modes_to_name(int id) {
 int dhcp_client_name_to_mode(char *name) {
         assert(name);
 
-        for (size_t i = DHCP_CLIENT_NO; i < (size_t) ELEMENTSOF(dhcp_client_mode_table); i++)
-                if (streq_fold(name, dhcp_client_mode_table[i]))
-                        return i;
-
-        return _DHCP_CLIENT_INVALID;
+        return string_table_lookup(dhcp_client_mode_table, ELEMENTSOF(dhcp_client_mode_table), name);
 }
 
 static const char *const dhcp_client_kind_table[_DHCP_CLIENT_MAX] = {
@@ -89,11 +78,13 @@ const char *dhcp_client_to_name(int id) {
 }
 
 int dhcp_name_to_client(char *name) {
+        int r;
+
         assert(name);
 
-        for (size_t i = DHCP_CLIENT_IPV4; i < (size_t) ELEMENTSOF(dhcp_client_kind_table); i++)
-                if (streq_fold(name, dhcp_client_kind_table[i]))
-                        return i;
+        r = string_table_lookup(dhcp_client_kind_table, ELEMENTSOF(dhcp_client_kind_table), name);
+        if (r >= 0)
+                return r;
 
         if (streq(name, "4"))
                 return DHCP_CLIENT_IPV4;
@@ -122,11 +113,7 @@ const char *dhcp_client_identifier_to_name(int id) {
 int dhcp_client_identifier_to_kind(char *name) {
         assert(name);
 
-        for (size_t i = DHCP_CLIENT_IDENTIFIER_MAC; i < (size_t) ELEMENTSOF(dhcp_client_identifier); i++)
-                if (streq_fold(name, dhcp_client_identifier[i]))
-                        return i;
-
-        return _DHCP_CLIENT_IDENTIFIER_INVALID;
+        return string_table_lookup(dhcp_client_identifier, ELEMENTSOF(dhcp_client_identifier), name);
 }
 
 static const char *const dhcp_client_duid_type [_DHCP_CLIENT_DUID_TYPE_MAX] =  {
@@ -149,11 +136,7 @@ const char *dhcp_client_duid_type_to_name(int id) {
 int dhcp_client_duid_name_to_type(char *name) {
         assert(name);
 
-        for (size_t i = DHCP_CLIENT_DUID_TYPE_LINK_LAYER_TIME; i < (size_t) ELEMENTSOF(dhcp_client_duid_type); i++)
-                if (streq_fold(name, dhcp_client_duid_type[i]))
-                        return i;
-
-        return _DHCP_CLIENT_DUID_TYPE_INVALID;
+        return string_table_lookup(dhcp_client_duid_type, ELEMENTSOF(dhcp_client_duid_type), name);
 }
 
 static const char *const link_local_address_type[_LINK_LOCAL_ADDRESS_MAX] =  {
@@ -176,11 +159,7 @@ const char *link_local_address_type_to_name(int id) {
 int link_local_address_type_to_kind(const char *name) {
         assert(name);
 
-        for (size_t i = LINK_LOCAL_ADDRESS_NO; i < (size_t) ELEMENTSOF(link_local_address_type); i++)
-                if (streq_fold(name, link_local_address_type[i]))
-                        return i;
-
-        return _LINK_LOCAL_ADDRESS_INVALID;
+        return string_table_lookup(link_local_address_type, ELEMENTSOF(link_local_address_type), name);
 }
 
 static const char* const ipv6_link_local_address_gen_type[_IPV6_LINK_LOCAL_ADDRESS_GEN_MODE_MAX] = {
@@ -203,11 +182,7 @@ const char *ipv6_link_local_address_gen_type_to_name(int id) {
 int ipv6_link_local_address_gen_type_to_mode(const char *name) {
         assert(name);
 
-        for (size_t i = IPV6_LINK_LOCAL_ADDRESSS_GEN_MODE_EUI64; i < (size_t) ELEMENTSOF(ipv6_link_local_address_gen_type); i++)
-                if (streq_fold(name, ipv6_link_local_address_gen_type[i]))
-                        return i;
-
-        return _IPV6_LINK_LOCAL_ADDRESS_GEN_MODE_INVALID;
+        return string_table_lookup(ipv6_link_local_address_gen_type, ELEMENTSOF(ipv6_link_local_address_gen_type), name);
 }
 
 static const char* const address_protocol_table[_ADDRESS_PROTOCOL_MAX] = {
@@ -230,11 +205,7 @@ const char *address_protocol_type_to_name(int id) {
 int address_protocol_type_to_mode(const char *name) {
         assert(name);
 
-        for (size_t i = ADDRESS_PROTOCOL_UNSPEC; i < (size_t) ELEMENTSOF(address_protocol_table); i++)
-                if (streq_fold(name, address_protocol_table[i]))
-                        return i;
-
-        return _ADDRESS_PROTOCOL_INVALID;
+        return string_table_lookup(address_protocol_table, ELEMENTSOF(address_protocol_table), name);
 }
 
 static const char* const link_event_table[_LINK_EVENT_MAX] = {
@@ -260,11 +231,7 @@ const char *link_event_type_to_name(int id) {
 int link_event_type_to_mode(const char *name) {
         assert(name);
 
-        for (size_t i = LINK_EVENT_NONE; i < (size_t) ELEMENTSOF(link_event_table); i++)
-                if (streq_fold(name, link_event_table[i]))
-                        return i;
-
-        return _LINK_EVENT_INVALID;
+        return string_table_lookup(link_event_table, ELEMENTSOF(link_event_table), name);
 }
 
 static const char* const ipv6_privacy_extensions_type[_IPV6_PRIVACY_EXTENSIONS_MAX] = {
@@ -286,11 +253,7 @@ const char *ipv6_privacy_extensions_type_to_name(int id) {
 int ipv6_privacy_extensions_to_type(const char *name) {
         assert(name);
 
-        for (size_t i = IPV6_PRIVACY_EXTENSIONS_NO; i < (size_t) ELEMENTSOF(ipv6_link_local_address_gen_type); i++)
-                if (streq_fold(name, ipv6_privacy_extensions_type[i]))
-                        return i;
-
-        return _IPV6_PRIVACY_EXTENSIONS_INVALID;
+        return string_table_lookup(ipv6_privacy_extensions_type, ELEMENTSOF(ipv6_privacy_extensions_type), name);
 }
 
 static const char *const ipv6_ra_preference_type[_IPV6_RA_PREFERENCE_MAX] =  {
@@ -312,11 +275,7 @@ const char *ipv6_ra_preference_type_to_name(int id) {
 int ipv6_ra_preference_type_to_mode(const char *name) {
         assert(name);
 
-        for (size_t i = IPV6_RA_PREFERENCE_LOW; i < (size_t) ELEMENTSOF(ipv6_ra_preference_type); i++)
-                if (streq_fold(name, ipv6_ra_preference_type[i]))
-                        return i;
-
-        return _IPV6_RA_PREFERENCE_INVALID;
+        return string_table_lookup(ipv6_ra_preference_type, ELEMENTSOF(ipv6_ra_preference_type), name);
 }
 
 static const char *const ip_duplicate_address_detection_type[_IP_DUPLICATE_ADDRESS_DETECTION_MAX] =  {
@@ -339,11 +298,7 @@ const char *ip_duplicate_address_detection_type_to_name(int id) {
 int ip_duplicate_address_detection_type_to_mode(const char *name) {
         assert(name);
 
-        for (size_t i = IP_DUPLICATE_ADDRESS_DETECTION_NONE; i < (size_t) ELEMENTSOF(ip_duplicate_address_detection_type); i++)
-                if (streq_fold(name, ip_duplicate_address_detection_type[i]))
-                        return i;
-
-        return _IP_DUPLICATE_ADDRESS_DETECTION_INVALID;
+        return string_table_lookup(ip_duplicate_address_detection_type, ELEMENTSOF(ip_duplicate_address_detection_type), name);
 }
 
 static const char* const keep_configuration_table[_KEEP_CONFIGURATION_MAX] = {
@@ -367,11 +322,7 @@ const char *keep_configuration_type_to_name(int id) {
 int keep_configuration_type_to_mode(const char *name) {
         assert(name);
 
-        for (size_t i = KEEP_CONFIGURATION_NO; i < (size_t) ELEMENTSOF(keep_configuration_table); i++)
-                if (streq_fold(name, keep_configuration_table[i]))
-                        return i;
-
-        return _KEEP_CONFIGURATION_INVALID;
+        return string_table_lookup(keep_configuration_table, ELEMENTSOF(keep_configuration_table), name);
 }
 
 static const char* const dhcp6_client_start_mode_table[_DHCP6_CLIENT_START_MODE_MAX] = {
@@ -393,11 +344,7 @@ const char *dhcp6_client_start_mode_to_name(int id) {
 int dhcp6_client_start_name_to_mode(const char *name) {
         assert(name);
 
-        for (size_t i = DHCP6_CLIENT_START_MODE_NO; i < (size_t) ELEMENTSOF(dhcp6_client_start_mode_table); i++)
-                if (streq_fold(name, dhcp6_client_start_mode_table[i]))
-                        return i;
-
-        return _DHCP6_CLIENT_START_MODE_INVALID;
+        return string_table_lookup(dhcp6_client_start_mode_table, ELEMENTSOF(dhcp6_client_start_mode_table), name);
 }
 
 static const char *const auth_key_management_type[_AUTH_KEY_MANAGEMENT_MAX] =  {
@@ -420,11 +367,7 @@ const char *auth_key_management_type_to_name(int id) {
 int auth_key_management_type_to_mode(const char *name) {
         assert(name);
 
-        for (size_t i = AUTH_KEY_MANAGEMENT_NONE; i < (size_t) ELEMENTSOF(auth_key_management_type); i++)
-                if (streq_fold(name, auth_key_management_type[i]))
-                        return i;
-
-        return _AUTH_KEY_MANAGEMENT_INVALID;
+        return string_table_lookup(auth_key_management_type, ELEMENTSOF(auth_key_management_type), name);
 }
 
 static const char* const auth_eap_method_type[_AUTH_EAP_METHOD_MAX] =  {
@@ -447,14 +390,24 @@ const char *auth_eap_method_to_name(int id) {
 int auth_eap_method_to_mode(const char *name) {
         assert(name);
 
-        for (size_t i = AUTH_EAP_METHOD_NONE; i < (size_t) ELEMENTSOF(auth_eap_method_type); i++)
-                if (streq_fold(name, auth_eap_method_type[i]))
-                        return i;
+        return string_table_lookup(auth_eap_method_type, ELEMENTSOF(auth_eap_method_type), name);
+}
+
+static const char *network_dir = NETWORKD_CONFIG_DIR;
 
-        return _AUTH_EAP_METHOD_INVALID;
+const char *network_config_dir(void) {
+        return network_dir;
 }
 
-int create_network_conf_file(const char *ifname, char **ret) {
+void network_config_dir_set(const char *dir) {
+        assert(dir);
+
+        network_dir = dir;
+}
+
+/* Writes the .network file matching the link by name, without asking networkd to reload it. See
+ * create_network_conf_file() for the variant that does. */
+int write_network_conf_file(const char *ifname, char **ret) {
         _auto_cleanup_ char *file = NULL, *network = NULL;
         int r;
 
@@ -464,7 +417,7 @@ int create_network_conf_file(const char *ifname, char **ret) {
         if (r < 0)
                 return r;
 
-        r = create_conf_file("/etc/systemd/network", file, "network", &network);
+        r = create_conf_file(network_dir, file, "network", &network);
         if (r < 0)
                 return r;
 
@@ -479,8 +432,7 @@ int create_network_conf_file(const char *ifname, char **ret) {
         if (ret)
                 *ret = steal_ptr(network);
 
-
-        return dbus_network_reload();
+        return 0;
 }
 
 int determine_network_conf_file(const char *ifname, char **ret) {
@@ -491,7 +443,7 @@ int determine_network_conf_file(const char *ifname, char **ret) {
         if (r < 0)
                 return r;
 
-        r = determine_conf_file("/etc/systemd/network", file, "network", &network);
+        r = determine_conf_file(network_dir, file, "network", &network);
         if (r < 0)
                 return r;
 
@@ -499,69 +451,6 @@ int determine_network_conf_file(const char *ifname, char **ret) {
         return 0;
 }
 
-int create_or_parse_network_file(const IfNameIndex *p, char **ret) {
-        _auto_cleanup_ char *setup = NULL, *network = NULL;
-        int r;
-
-        assert(p);
-
-        r = network_parse_link_setup_state(p->ifindex, &setup);
-        if (r < 0) {
-                r = create_network_conf_file(p->ifname, &network);
-                if (r < 0)
-                        return r;
-        } else {
-                r = network_parse_link_network_file(p->ifindex, &network);
-                if (r < 0) {
-                        r = create_network_conf_file(p->ifname, &network);
-                        if (r < 0)
-                                return r;
-                }
-        }
-
-        if (!g_file_test(network, G_FILE_TEST_EXISTS)) {
-                r = create_network_conf_file(p->ifname, &network);
-                if (r < 0)
-                        return r;
-        }
-
-        *ret = steal_ptr(network);
-        return 0;
-}
-
-int parse_network_file(const int ifindex, const char *ifname, char **ret) {
-        _auto_cleanup_ char *network = NULL;
-        int r;
-
-        if (ifindex > 0) {
-                r = network_parse_link_network_file(ifindex, &network);
-                if (r < 0) {
-                        r = determine_network_conf_file(ifname, &network);
-                        if (r < 0)
-                                return r;
-
-                        if (!g_file_test(network, G_FILE_TEST_EXISTS)) {
-                                r = create_network_conf_file(ifname, &network);
-                                if (r < 0)
-                                        return r;
-                        }
-                }
-        } else {
-                r = determine_network_conf_file(ifname, &network);
-                if (r < 0)
-                        return r;
-
-                if (!network || !g_file_test(network, G_FILE_TEST_EXISTS)) {
-                        r = create_network_conf_file(ifname, &network);
-                        if (r < 0)
-                                return r;
-                }
-        }
-
-        *ret = steal_ptr(network);
-        return 0;
-}
-
 int dhcp4_server_new(DHCP4Server **ret) {
         _cleanup_(dhcp4_server_freep) DHCP4Server *s = NULL;
 
@@ -590,73 +479,6 @@ void dhcp4_server_free(DHCP4Server *s) {
         free(s);
 }
 
-static gboolean routing_policy_rule_equal(gconstpointer v1, gconstpointer v2) {
-        RoutingPolicyRule *a = (RoutingPolicyRule *) v1;
-        RoutingPolicyRule *b = (RoutingPolicyRule *) v2;
-
-        if (!memcmp(&a->to, &b->to, sizeof(a->to)) &&
-            !memcmp(&a->from, &b->from, sizeof(a->from)) &&
-            !memcmp(&a->iif, &b->iif, sizeof(a->iif)) &&
-            !memcmp(&a->oif, &b->oif, sizeof(a->oif)) &&
-            a->table == b->table &&
-            a->priority == b->priority &&
-            a->table == b->table &&
-            a->fwmark == b->fwmark &&
-            a->type == b->type &&
-            a->tos == b->tos &&
-            a->invert_rule == b->invert_rule )
-                return true;
-
-        return false;
-}
-
-
-static gboolean route_equal(gconstpointer v1, gconstpointer v2) {
-        Route *a = (Route *) v1;
-        Route *b = (Route *) v2;
-
-        if (!memcmp(&a->gw, &b->gw, sizeof(a->gw)) &&
-            !memcmp(&a->dst, &b->dst, sizeof(a->dst)) &&
-            !memcmp(&a->src, &b->src, sizeof(a->src)) &&
-            !memcmp(&a->prefsrc, &b->prefsrc, sizeof(a->prefsrc)) &&
-            a->family == b->family &&
-            a->priority == b->priority &&
-            a->table == b->table &&
-            a->mtu == b->mtu &&
-            a->metric == b->metric &&
-            a->flags == b->flags)
-                return true;
-
-        return false;
-}
-
-static gboolean address_equal(gconstpointer v1, gconstpointer v2) {
-        IPAddress *a = (IPAddress *) v1;
-        IPAddress *b = (IPAddress *) v2;
-        int r;
-
-        switch (a->family) {
-                case AF_INET:
-                        r = memcmp(&a->in, &b->in, sizeof(a->in));
-                        if (!r)
-                                true;
-                        break;
-                case AF_INET6:
-                        r = memcmp(&a->in6, &b->in6, sizeof(a->in6));
-                        if (!r)
-                                true;
-                        break;
-                default:
-                        break;
-        }
-
-        if (a->family == b->family)
-                return true;
-
-        return false;
-}
-
-
 static int wifi_access_point_free (void *key, void *value, void *user_data) {
         WiFiAccessPoint *ap = value;
 
@@ -738,15 +560,15 @@ int network_new(Network **ret) {
                 .ipoib_mode = _IP_OIB_MODE_MODE_INVALID,
         };
 
-        r = set_new(&n->addresses, g_str_hash, address_equal);
+        r = set_new(&n->addresses, ip_address_hash, ip_address_equal);
         if (r < 0)
                 return r;
 
-        n->routes = g_hash_table_new_full(g_str_hash, route_equal, NULL, g_free);
+        n->routes = g_hash_table_new_full(route_hash, route_equal, NULL, g_free);
         if (!n->routes)
                 return log_oom();
 
-        n->routing_policy_rules = g_hash_table_new_full(g_str_hash, routing_policy_rule_equal, NULL, g_free);
+        n->routing_policy_rules = g_hash_table_new_full(routing_policy_rule_hash, routing_policy_rule_equal, NULL, g_free);
         if (!n->routing_policy_rules)
                 return log_oom();
 
@@ -754,7 +576,7 @@ int network_new(Network **ret) {
         if (!n->sriovs)
                 return log_oom();
 
-        r = set_new(&n->nameservers, g_str_hash, g_str_equal);
+        r = set_new(&n->nameservers, ip_address_hash, ip_address_equal);
         if (r < 0)
                 return r;
 
@@ -823,6 +645,8 @@ int parse_address_from_str_and_add(const char *s, Set *a) {
         if (r < 0)
                 return r;
 
+        if (set_contains(a, address))
+                return -EEXIST;
 
         set_add(a, address);
         steal_ptr(address);
@@ -1126,7 +950,8 @@ static void append_addresses(gpointer key, gpointer value, gpointer userdata) {
         steal_ptr(section);
 }
 
-int generate_network_config(Network *n) {
+/* Returns 1 when the .network file was written, 0 when a YAML network was left unchanged */
+int write_network_config(Network *n) {
         _cleanup_(key_file_freep) KeyFile *key_file = NULL;
         _auto_cleanup_ char *network = NULL;
         int r;
@@ -1136,7 +961,7 @@ int generate_network_config(Network *n) {
         if (n->parser_type == PARSER_TYPE_YAML && !n->modified)
                 return 0;
 
-        r = create_network_conf_file(n->ifname, &network);
+        r = write_network_conf_file(n->ifname, &network);
         if (r < 0)
                 return r;
 
@@ -1645,151 +1470,5 @@ int generate_network_config(Network *n) {
                 return r;
         }
 
-        (void) dbus_network_reload();
-        return 0;
-}
-
-int generate_master_device_network(Network *n) {
-        _cleanup_(config_manager_freep) ConfigManager *m = NULL;
-        _auto_cleanup_ IfNameIndex *p = NULL;
-        _auto_cleanup_ char *network = NULL;
-        int r;
-
-        if (!n->netdev)
-                return 0;
-
-        r = netdev_ctl_name_to_configs_new(&m);
-        if (r < 0)
-                return r;
-
-        /* MACVLAN */
-        switch (n->netdev->kind) {
-                case NETDEV_KIND_MACVLAN: {
-                        MACVLan *macvlan = n->netdev->macvlan;
-
-                        r = parse_ifname_or_index(macvlan->master, &p);
-                        if (r < 0)
-                                log_debug("Failed to find device: %s", macvlan->master);
-
-                        r = parse_network_file(p ? p->ifindex : -1, macvlan->master, &network);
-                        if (r < 0)
-                                return r;
-
-                        if (config_exists(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname))
-                                break;
-
-                        r = add_key_to_section_str(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname);
-                        if (r < 0)
-                                return r;
-                }
-                        break;
-                case NETDEV_KIND_VLAN: {
-                        VLan *vlan = n->netdev->vlan;
-
-                        r = parse_ifname_or_index(vlan->master, &p);
-                        if (r < 0)
-                                log_debug("Failed to find device: %s", vlan->master);
-
-                        r = parse_network_file(p ? p->ifindex : -1, vlan->master, &network);
-                        if (r < 0)
-                                return r;
-
-                        if (config_exists(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname))
-                                break;
-
-                        r = add_key_to_section_str(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname);
-                        if (r < 0)
-                                return r;
-                }
-                        break;
-                case NETDEV_KIND_BOND: {
-                        Bond *b = n->netdev->bond;
-                        char **d;
-
-                        strv_foreach(d, b->interfaces) {
-                                r = parse_ifname_or_index(*d, &p);
-                                if (r < 0)
-                                        log_debug("Failed to find device: %s", *d);
-
-                                r = parse_network_file(p ? p->ifindex : -1, *d, &network);
-                                if (r < 0)
-                                        return r;
-
-                                if (config_exists(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname))
-                                        break;
-
-                                r = add_key_to_section_str(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname);
-                                if (r < 0)
-                                        return r;
-                        }
-                }
-                        break;
-                case NETDEV_KIND_BRIDGE: {
-                        Bridge *b = n->netdev->bridge;
-                        char **d;
-
-                        strv_foreach(d, b->interfaces) {
-                                r = parse_ifname_or_index(*d, &p);
-                                if (r < 0)
-                                        log_debug("Failed to find device: %s", *d);
-
-                                r = parse_network_file(p ? p->ifindex : -1, *d, &network);
-                                if (r < 0)
-                                        return r;
-
-                                if (config_exists(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname))
-                                        break;
-
-                                r = add_key_to_section_str(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname);
-                                if (r < 0)
-                                        return r;
-                        }
-                }
-                        break;
-                case NETDEV_KIND_VRF: {
-                        VRF *vrf = n->netdev->vrf;
-                        char **d;
-
-                        strv_foreach(d, vrf->interfaces) {
-                                r = parse_ifname_or_index(*d, &p);
-                                if (r < 0)
-                                        log_debug("Failed to find device: %s", *d);
-
-                                r = parse_network_file(p ? p->ifindex : -1, *d, &network);
-                                if (r < 0)
-                                        return r;
-
-                                if (config_exists(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname))
-                                        break;
-
-                                r = add_key_to_section_str(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname);
-                                if (r < 0)
-                                        return r;
-                        }
-                }
-                        break;
-                case NETDEV_KIND_VXLAN: {
-                        VxLan *vx = n->netdev->vxlan;
-
-                        r = parse_ifname_or_index(vx->master, &p);
-                        if (r < 0)
-                                log_debug("Failed to find device: %s", vx->master);
-
-                        r = parse_network_file(p ? p->ifindex : -1, vx->master, &network);
-                        if (r < 0)
-                                return r;
-
-                        if (config_exists(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname))
-                                break;
-
-                        r = add_key_to_section_str(network, "Network", ctl_to_config(m, netdev_kind_to_name(n->netdev->kind)), n->netdev->ifname);
-                        if (r < 0)
-                                return r;
-                }
-
-                default:
-                        break;
-        }
-
-        return 0;
+        return 1;
 }
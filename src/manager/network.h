@@ -301,6 +301,7 @@ DEFINE_CLEANUP(DHCP4Server*, dhcp4_server_free);
 
 int parse_address_from_str_and_add(const char *s, Set *a);
 
+int write_network_conf_file(const char *ifname, char **ret);
 int create_network_conf_file(const char *ifname, char **ret);
 int create_or_parse_network_file(const IfNameIndex *p, char **ret);
 int determine_network_conf_file(const char *ifname, char **ret);
@@ -351,6 +352,14 @@ int address_protocol_type_to_mode(const char *name);
 const char *link_event_type_to_name(int id);
 int link_event_type_to_mode(const char *name);
 
+/* .network files are written to the first, the early boot generator writes to the second */
+#define NETWORKD_CONFIG_DIR         "/etc/systemd/network"
+#define NETWORKD_RUNTIME_CONFIG_DIR "/run/systemd/network"
+
+const char *network_config_dir(void);
+void network_config_dir_set(const char *dir);
+
+int write_network_config(Network *n);
 int generate_network_config(Network *n);
 int generate_master_device_network(Network *n);
 int generate_wifi_config(Network *n, GString **ret);
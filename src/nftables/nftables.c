@@ -61,11 +61,7 @@ const char *nft_family_to_name(int id) {
 int nft_family_name_to_type(const char *name) {
         assert(name);
 
-        for (size_t i = NF_PROTO_FAMILY_INET; i < (size_t) ELEMENTSOF(nft_family_table); i++)
-                if (nft_family_table[i] && streq_fold(name, nft_family_table[i]))
-                        return i;
-
-        return _NF_PROTO_FAMILY_INVALID;
+        return string_table_lookup(nft_family_table, ELEMENTSOF(nft_family_table), name);
 }
 
 static const char* const nft_packet_action_table[] = {
@@ -90,11 +86,7 @@ const char *nft_packet_action_to_name(int id) {
 int nft_packet_action_name_to_type(char *name) {
         assert(name);
 
-        for (size_t i = NF_PACKET_ACTION_DROP; i < (size_t) ELEMENTSOF(nft_packet_action_table); i++)
-                if (nft_packet_action_table[i] && streq_fold(name, nft_packet_action_table[i]))
-                        return i;
-
-        return _NF_PACKET_ACTION_INVALID;
+        return string_table_lookup(nft_packet_action_table, ELEMENTSOF(nft_packet_action_table), name);
 }
 
 static const char* const ip_packet_port_table[] = {
@@ -113,15 +105,9 @@ const char *ip_packet_port_type_to_name(int id) {
 }
 
 int ip_packet_port_name_to_type(char *name) {
-        int i;
-
         assert(name);
 
-        for (i = IP_PACKET_PORT_SPORT; i < (int) ELEMENTSOF(ip_packet_port_table); i++)
-                if (ip_packet_port_table[i] && streq_fold(name, ip_packet_port_table[i]))
-                        return i;
-
-        return _IP_PACKET_PORT_INVALID;
+        return string_table_lookup(ip_packet_port_table, ELEMENTSOF(ip_packet_port_table), name);
 }
 
 static const char* const ip_packet_protocol_table[] = {
@@ -150,11 +136,7 @@ void nft_ctx_unbuffer_output_unref(nft_ctx *t) {
 int ip_packet_protcol_name_to_type(char *name) {
         assert(name);
 
-        for (size_t i = IP_PACKET_PROTOCOL_TCP; i < (size_t) ELEMENTSOF(ip_packet_protocol_table); i++)
-                if (ip_packet_protocol_table[i] && streq_fold(name, ip_packet_protocol_table[i]))
-                        return i;
-
-        return _IP_PACKET_PROTOCOL_INVALID;
+        return string_table_lookup(ip_packet_protocol_table, ELEMENTSOF(ip_packet_protocol_table), name);
 }
 
 void nft_table_free(NFTNLTable *t) {
@@ -52,6 +52,7 @@ DEFINE_CLEANUP(FILE *, pclose);
 DEFINE_CLEANUP(int *, close_fdp);
 DEFINE_CLEANUP(GString*, g_string_unref);
 DEFINE_CLEANUP(GPtrArray*, g_ptr_array_unref);
+DEFINE_CLEANUP(GArray*, g_array_unref);
 DEFINE_CLEANUP(char **, strv_free);
 DEFINE_CLEANUP(GHashTable*, g_hash_table_unref);
 DEFINE_CLEANUP(GDir*, g_dir_close);
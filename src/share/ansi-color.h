@@ -30,6 +30,14 @@
 #define ANSI_COLOR_UNDERLINE      "\x1B[0;4m"
 #define ANSI_COLOR_UNDERLINE_BOLD "\x1B[0;1;4m"
 
+#define ANSI_CLEAR_SCREEN         "\x1b[H\x1b[2J"
+#define ANSI_ERASE_TO_END_OF_LINE "\x1b[K"
+#define ANSI_CURSOR_HIDE          "\x1b[?25l"
+#define ANSI_CURSOR_SHOW          "\x1b[?25h"
+#define ANSI_CURSOR_LINE_FORMAT   "\x1b[%u;1H"
+#define ANSI_AUTOWRAP_OFF         "\x1b[?7l"
+#define ANSI_AUTOWRAP_ON          "\x1b[?7h"
+
 bool colors_supported(void);
 
 #define DEFINE_ANSI_COLOR_INLINE_FUNCTION(name, NAME)                 \
@@ -7,6 +7,7 @@
 #include "alloc-util.h"
 #include "config-file.h"
 #include "config-parser.h"
+#include "config-stage.h"
 #include "file-util.h"
 #include "log.h"
 #include "string-util.h"
@@ -284,47 +285,382 @@ int set_config_uint(KeyFile *key_file, const char *section, const char *k, uint
         return 0;
 }
 
-int set_config_file_str(const char *path, const char *section, const char *k, const char *v) {
-        _cleanup_(key_file_freep) KeyFile *key_file = NULL;
+/* When enabled, single key edits of .network and .link files and added [Address], [Route] and
+ * [RoutingPolicyRule] sections are written to small drop-ins below "<file>.d/", one per concern, instead of
+ * rewriting the whole file. See set_config_file_str() and parse_key_file_for_section(). */
+static bool config_drop_in = false;
+
+void config_file_set_drop_in(bool b) {
+        config_drop_in = b;
+}
+
+bool config_file_drop_in_enabled(void) {
+        return config_drop_in;
+}
+
+/* Sections networkd allows to appear more than once. Every occurrence configures a separate object. */
+static const char *const repeated_sections[] = {
+        "Address",
+        "Route",
+        "RoutingPolicyRule",
+        "NextHop",
+        "Neighbor",
+        "BridgeFDB",
+        "BridgeMDB",
+        "BridgeVLAN",
+        "DHCPServerStaticLease",
+        "IPv6Prefix",
+        "IPv6RoutePrefix",
+        "SR-IOV",
+        NULL
+};
+
+/* Keys which accumulate across assignments (and so across drop-ins) until an empty assignment resets them */
+static const struct {
+        const char *section;
+        const char *key;
+} list_keys[] = {
+        { "Match",   "Name"                 },
+        { "Network", "DNS"                  },
+        { "Network", "Domains"              },
+        { "Network", "NTP"                  },
+        { "Network", "Address"              },
+        { "Network", "Gateway"              },
+        { "Link",    "NamePolicy"           },
+        { "Link",    "AlternativeNamesPolicy" },
+        { "Link",    "AlternativeName"      },
+        { "Link",    "Advertise"            },
+};
+
+bool config_section_is_repeated(const char *section) {
+        assert(section);
+
+        return g_strv_contains(repeated_sections, section);
+}
+
+bool config_key_is_list(const char *section, const char *k) {
+        assert(section);
+        assert(k);
+
+        for (size_t i = 0; i < ELEMENTSOF(list_keys); i++)
+                if (streq(list_keys[i].section, section) && streq(list_keys[i].key, k))
+                        return true;
+
+        return false;
+}
+
+static bool config_file_use_drop_in(const char *path, const char *section) {
+        /* A YAML apply describes whole files */
+        if (!config_drop_in || config_stage_active())
+                return false;
+
+        /* The base file keeps matching the link, drop-ins only carry settings */
+        if (streq(section, "Match"))
+                return false;
+
+        return g_str_has_suffix(path, ".network") || g_str_has_suffix(path, ".link");
+}
+
+/* Settings which are changed together share a drop-in, so that e.g. set-dns and add-domain edit the same file.
+ * Keys not listed here go to the drop-in named after their section. */
+static const struct {
+        const char *section;
+        const char *key;        /* NULL for all keys of the section */
+        const char *concern;
+} drop_in_concerns[] = {
+        { "Link",              "MTUBytes",   "mtu"                  },
+        { "Link",              "MACAddress", "mac"                  },
+        { "Network",           "DNS",        "dns"                  },
+        { "Network",           "Domains",    "dns"                  },
+        { "Network",           "NTP",        "ntp"                  },
+        { "Network",           "DHCP",       "dhcp"                 },
+        { "Network",           "Address",    "addresses"            },
+        { "Network",           "Gateway",    "routes"               },
+        { "DHCPv4",            NULL,         "dhcp"                 },
+        { "DHCPv6",            NULL,         "dhcp"                 },
+        { "Address",           NULL,         "addresses"            },
+        { "Route",             NULL,         "routes"               },
+        { "RoutingPolicyRule", NULL,         "routing-policy-rules" },
+};
+
+static int config_drop_in_name(const char *section, const char *k, char **ret) {
+        _auto_cleanup_ char *concern = NULL;
+
+        assert(section);
+        assert(ret);
+
+        for (size_t i = 0; i < ELEMENTSOF(drop_in_concerns); i++) {
+                if (!streq(drop_in_concerns[i].section, section))
+                        continue;
+
+                if (drop_in_concerns[i].key && (!k || !streq(drop_in_concerns[i].key, k)))
+                        continue;
+
+                concern = strdup(drop_in_concerns[i].concern);
+                break;
+        }
+
+        if (!concern)
+                concern = g_ascii_strdown(section, -1);
+        if (!concern)
+                return -ENOMEM;
+
+        *ret = strjoin("", "50-nmctl-", concern, ".conf", NULL);
+        if (!*ret)
+                return -ENOMEM;
+
+        return 0;
+}
+
+/* "/etc/systemd/network/10-eth0.network" + [Link] MTUBytes= -> ".../10-eth0.network.d/50-nmctl-mtu.conf" */
+int config_file_drop_in_path(const char *path, const char *section, const char *k, char **ret) {
+        _auto_cleanup_ char *d = NULL, *f = NULL, *p = NULL;
         int r;
 
         assert(path);
         assert(section);
-        assert(k);
+        assert(ret);
 
-        r = parse_key_file(path, &key_file);
+        r = config_drop_in_name(section, k, &f);
         if (r < 0)
                 return r;
 
-        r = set_config(key_file, section, k, v);
+        d = strjoin("", path, ".d", NULL);
+        if (!d)
+                return -ENOMEM;
+
+        p = g_build_filename(d, f, NULL);
+        if (!p)
+                return -ENOMEM;
+
+        *ret = steal_ptr(p);
+        return 0;
+}
+
+static bool section_has_key(const Section *s, const char *k) {
+        for (GList *i = s->keys; i; i = g_list_next (i))
+                if (streq(((Key *) i->data)->name, k))
+                        return true;
+
+        return false;
+}
+
+/* Drops k from the section. Sections networkd repeats describe one object each and are dropped as a whole when
+ * they carry k. Without k all sections of that name go. */
+static void key_file_drop_key(KeyFile *key_file, const char *section, const char *k) {
+        GList *i = key_file->sections;
+
+        while (i) {
+                Section *s = (Section *) i->data;
+                GList *next = g_list_next (i);
+
+                if (streq(s->name, section)) {
+                        if (!k || (config_section_is_repeated(section) && section_has_key(s, k))) {
+                                key_file->sections = g_list_delete_link(key_file->sections, i);
+                                key_file->nsections--;
+                                section_free(s);
+                        } else {
+                                GList *j = s->keys;
+
+                                while (j) {
+                                        GList *n = g_list_next (j);
+
+                                        if (streq(((Key *) j->data)->name, k)) {
+                                                key_free(j->data);
+                                                s->keys = g_list_delete_link(s->keys, j);
+                                        }
+                                        j = n;
+                                }
+                        }
+                }
+
+                i = next;
+        }
+}
+
+/* Returns the drop-in nmctl keeps for the section (and key), -ENOENT when there is none. Unlike
+ * config_drop_in_parse() it never creates anything, which is what paths only taking settings away want. */
+int config_drop_in_open(const char *path, const char *section, const char *k, KeyFile **ret) {
+        _auto_cleanup_ char *drop_in = NULL;
+        int r;
+
+        assert(path);
+        assert(section);
+        assert(ret);
+
+        r = config_file_drop_in_path(path, section, k, &drop_in);
         if (r < 0)
                 return r;
 
-        r = key_file_save (key_file);
+        return parse_key_file(drop_in, ret);
+}
+
+/* Returns the drop-in nmctl keeps for the section (and key), empty when it does not exist yet */
+int config_drop_in_parse(const char *path, const char *section, const char *k, KeyFile **ret) {
+        _auto_cleanup_ char *drop_in = NULL, *d = NULL;
+        int r;
+
+        assert(path);
+        assert(section);
+        assert(ret);
+
+        r = config_drop_in_open(path, section, k, ret);
+        if (r != -ENOENT)
+                return r;
+
+        r = config_file_drop_in_path(path, section, k, &drop_in);
         if (r < 0)
                 return r;
 
-        return set_file_permisssion(path, "systemd-network");
+        d = g_path_get_dirname(drop_in);
+        if (g_mkdir_with_parents(d, 0755) < 0)
+                return -errno;
+
+        (void) set_file_permisssion(d, "systemd-network");
+        return key_file_new(drop_in, ret);
 }
 
-int set_config_file_int(const char *path, const char *section, const char *k, int v) {
+/* Like key_file_save(), but a drop-in left without keys is removed rather than written empty */
+int config_drop_in_save(KeyFile *key_file) {
+        _auto_cleanup_ char *d = NULL;
+        int r;
+
+        assert(key_file);
+
+        for (GList *i = key_file->sections; i; i = g_list_next (i))
+                if (((Section *) i->data)->keys)
+                        return key_file_save(key_file);
+
+        if (config_stage_active())
+                return config_stage_remove(key_file->name);
+
+        r = remove_conf_file(key_file->name);
+        if (r == -ENOENT)
+                return 0;
+        if (r < 0)
+                return r;
+
+        /* Fails when other drop-ins are left, which is fine */
+        d = g_path_get_dirname(key_file->name);
+        (void) rmdir(d);
+        return 0;
+}
+
+/* The file objects such as [Address] or [Route] sections are added to. In drop-in mode that is the drop-in of
+ * their concern, note that a drop-in can only add them: replacing or removing one still edits the base file. */
+int parse_key_file_for_section(const char *path, const char *section, KeyFile **ret) {
+        assert(path);
+        assert(section);
+        assert(ret);
+
+        if (config_file_use_drop_in(path, section))
+                return config_drop_in_parse(path, section, NULL, ret);
+
+        return parse_key_file(path, ret);
+}
+
+static int set_config_drop_in_str(const char *path, const char *section, const char *k, const char *v) {
+        _cleanup_(key_file_freep) KeyFile *key_file = NULL;
+        int r;
+
+        r = config_drop_in_parse(path, section, k, &key_file);
+        if (r < 0)
+                return r;
+
+        key_file_drop_key(key_file, section, k);
+
+        /* Without the reset networkd would append our value to whatever the base file already lists */
+        if (config_key_is_list(section, k) && !isempty(v)) {
+                r = set_config(key_file, section, k, "");
+                if (r < 0)
+                        return r;
+        }
+
+        r = key_file_add_str(key_file, section, k, v);
+        if (r < 0)
+                return r;
+
+        /* g_file_set_contents() replaces the file by rename(), readers never see a partial drop-in */
+        return key_file_save(key_file);
+}
+
+static int remove_config_drop_in(const char *path, const char *section, const char *k) {
+        _cleanup_(key_file_freep) KeyFile *key_file = NULL;
+        int r;
+
+        r = config_drop_in_open(path, section, k, &key_file);
+        if (r == -ENOENT)
+                return 0;
+        if (r < 0)
+                return r;
+
+        key_file_drop_key(key_file, section, k);
+        return config_drop_in_save(key_file);
+}
+
+/* Removes what nmctl wrote for the key to its drop-ins, see key_file_drop_key(). Without k the section is
+ * removed from all nmctl drop-ins, as its keys may be spread over several concerns. */
+int remove_config_drop_ins(const char *path, const char *section, const char *k) {
+        _cleanup_(g_dir_closep) GDir *dir = NULL;
+        _auto_cleanup_ char *d = NULL;
+        const char *name;
+        int r;
+
+        assert(path);
+        assert(section);
+
+        if (k)
+                return remove_config_drop_in(path, section, k);
+
+        d = strjoin("", path, ".d", NULL);
+        if (!d)
+                return -ENOMEM;
+
+        dir = g_dir_open(d, 0, NULL);
+        if (!dir)
+                return 0;
+
+        while ((name = g_dir_read_name(dir))) {
+                _cleanup_(key_file_freep) KeyFile *key_file = NULL;
+                _auto_cleanup_ char *p = NULL;
+
+                if (!g_str_has_prefix(name, "50-nmctl-") || !g_str_has_suffix(name, ".conf"))
+                        continue;
+
+                p = g_build_filename(d, name, NULL);
+                if (!p)
+                        return -ENOMEM;
+
+                r = parse_key_file(p, &key_file);
+                if (r < 0)
+                        continue;
+
+                key_file_drop_key(key_file, section, NULL);
+
+                r = config_drop_in_save(key_file);
+                if (r < 0)
+                        return r;
+        }
+
+        return 0;
+}
+
+int set_config_file_str(const char *path, const char *section, const char *k, const char *v) {
         _cleanup_(key_file_freep) KeyFile *key_file = NULL;
-        _auto_cleanup_ gchar *s = NULL;
         int r;
 
         assert(path);
         assert(section);
         assert(k);
 
+        if (config_file_use_drop_in(path, section))
+                return set_config_drop_in_str(path, section, k, v);
+
         r = parse_key_file(path, &key_file);
         if (r < 0)
                 return r;
 
-        s = g_strdup_printf("%i", v);
-        if (!s)
-                return -ENOMEM;
-
-        r = key_file_set_str(key_file, section, k, s);
+        r = set_config(key_file, section, k, v);
         if (r < 0)
                 return r;
 
@@ -332,9 +668,26 @@ int set_config_file_int(const char *path, const char *section, const char *k, in
         if (r < 0)
                 return r;
 
+        /* A drop-in from an earlier edit would still override the value just written */
+        (void) remove_config_drop_ins(path, section, k);
+
         return set_file_permisssion(path, "systemd-network");
 }
 
+int set_config_file_int(const char *path, const char *section, const char *k, int v) {
+        _auto_cleanup_ gchar *s = NULL;
+
+        assert(path);
+        assert(section);
+        assert(k);
+
+        s = g_strdup_printf("%i", v);
+        if (!s)
+                return -ENOMEM;
+
+        return set_config_file_str(path, section, k, s);
+}
+
 int set_config_file_bool(const char *path, const char *section, const char *k, bool b) {
         assert(path);
         assert(section);
@@ -578,6 +931,8 @@ int remove_key_from_config_file(const char *path, const char *section, const cha
         if (r < 0)
                 return r;
 
+        (void) remove_config_drop_ins(path, section, k);
+
         return set_file_permisssion(path, "systemd-network");
 }
 
@@ -639,6 +994,8 @@ int remove_section_from_config_file(const char *path, const char *section) {
         if (r < 0)
                 return r;
 
+        (void) remove_config_drop_ins(path, section, NULL);
+
         return set_file_permisssion(path, "systemd-network");
 }
 
@@ -713,18 +1070,31 @@ int remove_section_from_config_file_key(const char *path, const char *section, c
         if (r < 0)
                 return r;
 
+        (void) remove_config_drop_ins(path, section, k);
+
         return set_file_permisssion(path, "systemd-network");
 }
 
 int write_to_conf_file(const char *path, const GString *s) {
         _cleanup_(g_error_freep) GError *e = NULL;
+        _auto_cleanup_ char *old = NULL;
+        size_t n;
 
         assert(path);
         assert(s);
 
+        if (config_stage_active())
+                return config_stage_write(path, s->str, s->len);
+
+        /* Rewriting identical contents is not a change networkd needs to hear about */
+        if (g_file_get_contents(path, &old, &n, NULL) && n == s->len && memcmp(old, s->str, n) == 0)
+                return set_file_permisssion(path, "systemd-network");
+
         if (!g_file_set_contents(path, s->str, s->len, &e))
                 return -e->code;
 
+        conf_file_changed();
+
         steal_ptr(e);
         return set_file_permisssion(path, "systemd-network");
 }
@@ -753,6 +1123,7 @@ int append_to_conf_file(const char *path, const GString *s) {
         if (r < 0)
                 return -e->code;
 
+        conf_file_changed();
         return 0;
 }
 
@@ -792,7 +1163,7 @@ int remove_config_files_glob(const char *path, const char *section, const char *
                         return r;
 
                 if (streq(s, v))
-                        unlink(g.gl_pathv[i]);
+                        (void) remove_conf_file(g.gl_pathv[i]);
         }
 
         return 0;
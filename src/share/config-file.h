@@ -63,6 +63,19 @@ int add_section_to_key_file(KeyFile *k, Section *s);
 
 const char *ctl_to_config(const ConfigManager *m, const char *name);
 
+void config_file_set_drop_in(bool b);
+bool config_file_drop_in_enabled(void);
+
+bool config_section_is_repeated(const char *section);
+bool config_key_is_list(const char *section, const char *k);
+
+int config_file_drop_in_path(const char *path, const char *section, const char *k, char **ret);
+int remove_config_drop_ins(const char *path, const char *section, const char *k);
+int config_drop_in_open(const char *path, const char *section, const char *k, KeyFile **ret);
+int config_drop_in_parse(const char *path, const char *section, const char *k, KeyFile **ret);
+int config_drop_in_save(KeyFile *key_file);
+int parse_key_file_for_section(const char *path, const char *section, KeyFile **ret);
+
 int set_config_file_str(const char *path, const char *section, const char *k, const char *v);
 int set_config_file_bool(const char *path, const char *section, const char *k, bool b);
 int set_config_file_int(const char *path, const char *section, const char *k, int v);
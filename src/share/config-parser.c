@@ -10,13 +10,12 @@
 
 #include "alloc-util.h"
 #include "config-parser.h"
-#include "config-parser.h"
+#include "config-stage.h"
 #include "string-util.h"
 #include "log.h"
 
 int parse_key_file(const char *path, KeyFile **ret) {
         _cleanup_(section_freep) Section *section = NULL;
-        _cleanup_(g_error_freep) GError *error = NULL;
         _auto_cleanup_ KeyFile *key_file = NULL;
         _auto_cleanup_strv_ char **lines = NULL;
         _auto_cleanup_ char *contents = NULL;
@@ -28,11 +27,9 @@ int parse_key_file(const char *path, KeyFile **ret) {
 
         assert(path);
 
-        if (!g_file_test(path, G_FILE_TEST_EXISTS))
-                return -ENOENT;
-
-        if (!g_file_get_contents(path, &contents, &n , &error))
-                return -error->code;
+        r = config_file_read(path, &contents, &n);
+        if (r < 0)
+                return r;
 
         r = key_file_new(path, &key_file);
         if (r < 0)
@@ -105,6 +102,180 @@ int parse_key_file(const char *path, KeyFile **ret) {
         return 0;
 }
 
+/* Drop-in directories networkd consults, lowest priority first */
+static const char *const network_dirs[] = {
+        "/usr/lib/systemd/network",
+        "/usr/local/lib/systemd/network",
+        "/run/systemd/network",
+        "/etc/systemd/network",
+        NULL
+};
+
+/* Lists "<file>.d/*.conf" the way networkd does: a drop-in in a higher priority directory masks one with the
+ * same name elsewhere and the result is ordered by file name, not by directory. */
+int config_file_drop_ins(const char *path, char ***ret) {
+        _auto_cleanup_hash_ GHashTable *drop_ins = NULL;
+        _auto_cleanup_ char *base = NULL, *parent = NULL;
+        g_autoptr(GList) names = NULL;
+        _auto_cleanup_strv_ char **l = NULL;
+        size_t n = 0;
+
+        assert(path);
+        assert(ret);
+
+        base = g_path_get_basename(path);
+        parent = g_path_get_dirname(path);
+        if (!base || !parent)
+                return log_oom();
+
+        drop_ins = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+        if (!drop_ins)
+                return log_oom();
+
+        for (size_t i = 0; network_dirs[i]; i++) {
+                _cleanup_(g_dir_closep) GDir *dir = NULL;
+                _auto_cleanup_ char *d = NULL;
+                const char *name;
+
+                /* Files outside of the search path only get the drop-ins next to them */
+                if (g_strv_contains(network_dirs, parent))
+                        d = g_strconcat(network_dirs[i], "/", base, ".d", NULL);
+                else if (!network_dirs[i + 1])
+                        d = g_strconcat(path, ".d", NULL);
+                else
+                        continue;
+                if (!d)
+                        return log_oom();
+
+                dir = g_dir_open(d, 0, NULL);
+                if (!dir)
+                        continue;
+
+                while ((name = g_dir_read_name(dir))) {
+                        _auto_cleanup_ char *p = NULL;
+
+                        if (!g_str_has_suffix(name, ".conf"))
+                                continue;
+
+                        /* Skips drop-ins an open stage is about to remove */
+                        p = g_build_filename(d, name, NULL);
+                        if (!config_file_exists(p))
+                                continue;
+
+                        g_hash_table_replace(drop_ins, g_strdup(name), steal_ptr(p));
+                }
+        }
+
+        names = g_list_sort(g_hash_table_get_keys(drop_ins), (GCompareFunc) strcmp);
+
+        l = new0(char *, g_hash_table_size(drop_ins) + 1);
+        if (!l)
+                return log_oom();
+
+        for (GList *i = names; i; i = g_list_next (i)) {
+                l[n] = g_strdup(g_hash_table_lookup(drop_ins, i->data));
+                if (!l[n])
+                        return log_oom();
+                n++;
+        }
+
+        *ret = steal_ptr(l);
+        return 0;
+}
+
+static int key_file_merge_key(KeyFile *key_file, const char *section, const Key *key) {
+        _auto_cleanup_ char *old = NULL, *v = NULL;
+
+        if (!config_key_is_list(section, key->name) || isempty(key->v))
+                return set_config(key_file, section, key->name, key->v);
+
+        old = key_file_config_get(key_file, section, key->name);
+        if (isempty(old))
+                return set_config(key_file, section, key->name, key->v);
+
+        v = strjoin(" ", old, key->v, NULL);
+        if (!v)
+                return log_oom();
+
+        return set_config(key_file, section, key->name, v);
+}
+
+static int key_file_merge_drop_in(KeyFile *key_file, const KeyFile *drop_in) {
+        int r;
+
+        for (GList *i = drop_in->sections; i; i = g_list_next (i)) {
+                Section *s = (Section *) i->data;
+
+                if (config_section_is_repeated(s->name)) {
+                        _cleanup_(section_freep) Section *copy = NULL;
+
+                        r = section_new(s->name, &copy);
+                        if (r < 0)
+                                return r;
+
+                        for (GList *j = s->keys; j; j = g_list_next (j)) {
+                                Key *key = (Key *) j->data;
+
+                                r = add_key_to_section(copy, key->name, key->v);
+                                if (r < 0)
+                                        return r;
+                        }
+
+                        r = add_section_to_key_file(key_file, copy);
+                        if (r < 0)
+                                return r;
+
+                        steal_ptr(copy);
+                        continue;
+                }
+
+                for (GList *j = s->keys; j; j = g_list_next (j)) {
+                        r = key_file_merge_key(key_file, s->name, (Key *) j->data);
+                        if (r < 0)
+                                return r;
+                }
+        }
+
+        return 0;
+}
+
+/* Parses the file and applies its drop-ins on top, so that the result is what networkd sees. Not to be saved
+ * back, the returned KeyFile mixes contents of several files. */
+int parse_key_file_merged(const char *path, KeyFile **ret) {
+        _cleanup_(key_file_freep) KeyFile *key_file = NULL;
+        _auto_cleanup_strv_ char **drop_ins = NULL;
+        char **l;
+        int r;
+
+        assert(path);
+        assert(ret);
+
+        r = parse_key_file(path, &key_file);
+        if (r < 0)
+                return r;
+
+        r = config_file_drop_ins(path, &drop_ins);
+        if (r < 0)
+                return r;
+
+        strv_foreach(l, drop_ins) {
+                _cleanup_(key_file_freep) KeyFile *drop_in = NULL;
+
+                r = parse_key_file(*l, &drop_in);
+                if (r < 0) {
+                        log_debug("Failed to parse drop-in '%s', ignoring: %s", *l, strerror(-r));
+                        continue;
+                }
+
+                r = key_file_merge_drop_in(key_file, drop_in);
+                if (r < 0)
+                        return r;
+        }
+
+        *ret = steal_ptr(key_file);
+        return 0;
+}
+
 static void display_keys(gpointer data_ptr, gpointer ignored) {
         Key *k = data_ptr;
 
@@ -136,7 +307,7 @@ bool config_exists(const char *path, const char *section, const char *k, const c
         assert(section);
         assert(k);
 
-        r = parse_key_file(path, &key_file);
+        r = parse_key_file_merged(path, &key_file);
         if (r < 0)
                 return r;
 
@@ -152,7 +323,7 @@ bool config_contains(const char *path, const char *section, const char *k, const
         assert(section);
         assert(k);
 
-        r = parse_key_file(path, &key_file);
+        r = parse_key_file_merged(path, &key_file);
         if (r < 0)
                 return r;
 
@@ -238,7 +409,7 @@ int parse_config_file(const char *path, const char *section, const char *k, char
         assert(section);
         assert(k);
 
-        r = parse_key_file(path, &key_file);
+        r = parse_key_file_merged(path, &key_file);
         if (r < 0)
                 return r;
 
@@ -280,7 +451,7 @@ int parse_config_file_integer(const char *path, const char *section, const char
         assert(section);
         assert(k);
 
-        r = parse_key_file(path, &key_file);
+        r = parse_key_file_merged(path, &key_file);
         if (r < 0)
                 return r;
 
@@ -418,7 +589,7 @@ int key_file_parse_strv(const char *path, const char *section, const char *key,
         assert(section);
         assert(key);
 
-        r = parse_key_file(path, &key_file);
+        r = parse_key_file_merged(path, &key_file);
         if (r < 0)
                 return r;
 
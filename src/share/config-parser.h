@@ -18,6 +18,8 @@ int parse_line(const char *line, char **key, char **value);
 int parse_state_file(const char *path, const char *key, char **v, GHashTable **table);
 
 int parse_key_file(const char *path, KeyFile **ret);
+int parse_key_file_merged(const char *path, KeyFile **ret);
+int config_file_drop_ins(const char *path, char ***ret);
 int display_key_file(const KeyFile *k);
 
 bool config_exists(const char *path, const char *section, const char *k, const char *v);
@@ -0,0 +1,996 @@
+/* Copyright 2024 VMware, Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <glib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "alloc-util.h"
+#include "config-parser.h"
+#include "config-stage.h"
+#include "file-util.h"
+#include "log.h"
+#include "macros.h"
+#include "string-util.h"
+
+/* While a stage is open configuration files are written to memory only. Reads see the staged contents, so that
+ * the generators can keep parsing and editing files as they do on disk. Committing the stage compares the
+ * result with what is on disk and touches only the files that differ.
+ *
+ * Files an earlier apply generated from the sources being applied again are invisible while the stage is
+ * open: the desired state is built from the YAML alone, and what is not generated again is removed. */
+typedef struct StagedFile {
+        GString *contents;      /* NULL when the file is to be removed */
+        char *source;           /* The YAML file the file was created for, NULL when only edited */
+} StagedFile;
+
+/* What the last apply of a YAML file left behind */
+typedef struct ManifestSource {
+        char *hash;             /* Of the YAML file as applied, NULL when not known */
+        GHashTable *files;      /* path -> hash of the contents generated, NULL when not known */
+        GHashTable *edits;      /* Files it edited without creating them */
+        GHashTable *interfaces; /* The interfaces it describes, also those a later file overrides */
+} ManifestSource;
+
+struct ConfigManifest {
+        GHashTable *sources;    /* source -> ManifestSource */
+        GHashTable *owners;     /* path -> source */
+};
+
+typedef struct ConfigStage {
+        GHashTable *files;      /* path -> StagedFile */
+        ConfigManifest *manifest;
+
+        GHashTable *hashes;     /* source -> hash of the YAML file applied */
+        GHashTable *edits;      /* source -> files it edited without creating them */
+        GHashTable *interfaces; /* source -> interfaces it describes */
+
+        char **sources;
+        bool all;
+        char *source;
+} ConfigStage;
+
+static __thread ConfigStage *stage = NULL;
+
+static const char *const config_change_type_table[_CONFIG_CHANGE_MAX] = {
+        [CONFIG_CHANGE_CREATE] = "create",
+        [CONFIG_CHANGE_UPDATE] = "update",
+        [CONFIG_CHANGE_REMOVE] = "remove",
+};
+
+const char *config_change_type_to_name(ConfigChangeType id) {
+        if (id < 0)
+                return NULL;
+
+        if ((size_t) id >= ELEMENTSOF(config_change_type_table))
+                return NULL;
+
+        return config_change_type_table[id];
+}
+
+void config_change_free(ConfigChange *c) {
+        if (!c)
+                return;
+
+        free(c->path);
+        free(c);
+}
+
+static int config_change_add(GPtrArray *changes, ConfigChangeType type, const char *path) {
+        _cleanup_(config_change_freep) ConfigChange *c = NULL;
+
+        assert(changes);
+        assert(path);
+
+        c = new0(ConfigChange, 1);
+        if (!c)
+                return log_oom();
+
+        *c = (ConfigChange) {
+                .type = type,
+                .path = g_strdup(path),
+        };
+        if (!c->path)
+                return log_oom();
+
+        g_ptr_array_add(changes, steal_ptr(c));
+        return 0;
+}
+
+static void staged_file_free(StagedFile *f) {
+        if (!f)
+                return;
+
+        if (f->contents)
+                g_string_free(f->contents, true);
+
+        free(f->source);
+        free(f);
+}
+
+static GHashTable *string_set_new(void) {
+        return g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+}
+
+/* Adds 'value' to the set 'key' maps to in 't' */
+static int string_set_table_add(GHashTable *t, const char *key, const char *value) {
+        GHashTable *set;
+
+        assert(t);
+        assert(key);
+        assert(value);
+
+        set = g_hash_table_lookup(t, key);
+        if (!set) {
+                set = string_set_new();
+                if (!set)
+                        return log_oom();
+
+                g_hash_table_insert(t, g_strdup(key), set);
+        }
+
+        if (!g_hash_table_contains(set, value))
+                g_hash_table_add(set, g_strdup(value));
+
+        return 0;
+}
+
+static bool string_sets_intersect(GHashTable *a, GHashTable *b) {
+        GHashTableIter iter;
+        gpointer k;
+
+        g_hash_table_iter_init(&iter, a);
+        while (g_hash_table_iter_next(&iter, &k, NULL))
+                if (g_hash_table_contains(b, k))
+                        return true;
+
+        return false;
+}
+
+static char *config_contents_hash(const char *contents, size_t size) {
+        return g_compute_checksum_for_data(G_CHECKSUM_SHA256, (const guchar *) contents, size);
+}
+
+/* The hash covers the version too, files are generated again after an upgrade */
+int config_source_hash(const char *path, char **ret) {
+        _cleanup_(g_error_freep) GError *e = NULL;
+        g_autoptr(GChecksum) c = NULL;
+        _auto_cleanup_ char *s = NULL;
+        size_t n;
+
+        assert(path);
+        assert(ret);
+
+        if (!g_file_get_contents(path, &s, &n, &e))
+                return -e->code;
+
+        c = g_checksum_new(G_CHECKSUM_SHA256);
+        if (!c)
+                return log_oom();
+
+        g_checksum_update(c, (const guchar *) PACKAGE_VERSION "\n", -1);
+        g_checksum_update(c, (const guchar *) s, n);
+
+        *ret = g_strdup(g_checksum_get_string(c));
+        if (!*ret)
+                return log_oom();
+
+        return 0;
+}
+
+static void manifest_source_free(ManifestSource *ms) {
+        if (!ms)
+                return;
+
+        if (ms->files)
+                g_hash_table_unref(ms->files);
+        if (ms->edits)
+                g_hash_table_unref(ms->edits);
+        if (ms->interfaces)
+                g_hash_table_unref(ms->interfaces);
+
+        free(ms->hash);
+        free(ms);
+}
+DEFINE_CLEANUP(ManifestSource*, manifest_source_free);
+
+static int manifest_source_new(const char *hash, ManifestSource **ret) {
+        _cleanup_(manifest_source_freep) ManifestSource *ms = NULL;
+
+        assert(ret);
+
+        ms = new(ManifestSource, 1);
+        if (!ms)
+                return log_oom();
+
+        *ms = (ManifestSource) {
+                .hash = g_strdup(hash),
+                .files = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free),
+                .edits = string_set_new(),
+                .interfaces = string_set_new(),
+        };
+        if ((hash && !ms->hash) || !ms->files || !ms->edits || !ms->interfaces)
+                return log_oom();
+
+        *ret = steal_ptr(ms);
+        return 0;
+}
+
+/* Whether the two sources generated, edited or describe the same thing */
+static bool manifest_source_shares(const ManifestSource *a, const ManifestSource *b) {
+        assert(a);
+        assert(b);
+
+        return string_sets_intersect(a->files, b->files) ||
+                string_sets_intersect(a->files, b->edits) ||
+                string_sets_intersect(a->edits, b->files) ||
+                string_sets_intersect(a->edits, b->edits) ||
+                string_sets_intersect(a->interfaces, b->interfaces);
+}
+
+void config_manifest_free(ConfigManifest *m) {
+        if (!m)
+                return;
+
+        if (m->sources)
+                g_hash_table_unref(m->sources);
+        if (m->owners)
+                g_hash_table_unref(m->owners);
+
+        free(m);
+}
+
+static int config_manifest_new(ConfigManifest **ret) {
+        _cleanup_(config_manifest_freep) ConfigManifest *m = NULL;
+
+        assert(ret);
+
+        m = new(ConfigManifest, 1);
+        if (!m)
+                return log_oom();
+
+        *m = (ConfigManifest) {
+                .sources = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify) manifest_source_free),
+                .owners = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free),
+        };
+        if (!m->sources || !m->owners)
+                return log_oom();
+
+        *ret = steal_ptr(m);
+        return 0;
+}
+
+/* "File=<path> <hash>", manifests written before hashes were recorded list the path alone */
+static int manifest_parse_file(const char *v, char **ret_path, char **ret_hash) {
+        _auto_cleanup_ char *path = NULL, *hash = NULL;
+        const char *p;
+
+        assert(v);
+        assert(ret_path);
+        assert(ret_hash);
+
+        p = strrchr(v, ' ');
+        if (p && strlen(p + 1) == 64 && strspn(p + 1, "0123456789abcdef") == 64) {
+                path = g_strndup(v, p - v);
+                hash = g_strdup(p + 1);
+                if (!path || !hash)
+                        return log_oom();
+        } else {
+                path = g_strdup(v);
+                if (!path)
+                        return log_oom();
+        }
+
+        *ret_path = steal_ptr(path);
+        *ret_hash = steal_ptr(hash);
+        return 0;
+}
+
+int config_manifest_load(ConfigManifest **ret) {
+        _cleanup_(config_manifest_freep) ConfigManifest *m = NULL;
+        _cleanup_(key_file_freep) KeyFile *key_file = NULL;
+        int r;
+
+        assert(ret);
+
+        r = config_manifest_new(&m);
+        if (r < 0)
+                return r;
+
+        r = parse_key_file(CONFIG_MANIFEST_PATH, &key_file);
+        if (r < 0 && r != -ENOENT)
+                return r;
+
+        /* One section per YAML file listing what was generated from it */
+        for (GList *i = key_file ? key_file->sections : NULL; i; i = g_list_next (i)) {
+                _cleanup_(manifest_source_freep) ManifestSource *ms = NULL;
+                Section *s = (Section *) i->data;
+
+                r = manifest_source_new(NULL, &ms);
+                if (r < 0)
+                        return r;
+
+                for (GList *j = s->keys; j; j = g_list_next (j)) {
+                        Key *key = (Key *) j->data;
+
+                        if (isempty(key->v))
+                                continue;
+
+                        if (streq(key->name, "Hash")) {
+                                free(ms->hash);
+                                ms->hash = g_strdup(key->v);
+                        } else if (streq(key->name, "File")) {
+                                char *path, *hash;
+
+                                r = manifest_parse_file(key->v, &path, &hash);
+                                if (r < 0)
+                                        return r;
+
+                                g_hash_table_replace(ms->files, path, hash);
+                                g_hash_table_replace(m->owners, g_strdup(path), g_strdup(s->name));
+                        } else if (streq(key->name, "Edit"))
+                                g_hash_table_add(ms->edits, g_strdup(key->v));
+                        else if (streq(key->name, "Interface"))
+                                g_hash_table_add(ms->interfaces, g_strdup(key->v));
+                }
+
+                g_hash_table_replace(m->sources, g_strdup(s->name), steal_ptr(ms));
+        }
+
+        *ret = steal_ptr(m);
+        return 0;
+}
+
+static void manifest_append_keys(GString *c, const char *key, GHashTable *t) {
+        g_autoptr(GList) keys = NULL;
+
+        keys = g_list_sort(g_hash_table_get_keys(t), (GCompareFunc) strcmp);
+        for (GList *i = keys; i; i = g_list_next (i))
+                g_string_append_printf(c, "%s=%s\n", key, (const char *) i->data);
+}
+
+static int config_manifest_save(const ConfigManifest *m) {
+        _cleanup_(g_string_unrefp) GString *c = NULL;
+        _cleanup_(g_error_freep) GError *e = NULL;
+        g_autoptr(GList) sources = NULL;
+        _auto_cleanup_ char *old = NULL;
+        size_t n;
+        int r;
+
+        assert(m);
+
+        c = g_string_new("# Generated by nmctl apply, do not edit\n");
+        if (!c)
+                return log_oom();
+
+        sources = g_list_sort(g_hash_table_get_keys(m->sources), (GCompareFunc) strcmp);
+        for (GList *i = sources; i; i = g_list_next (i)) {
+                ManifestSource *ms = g_hash_table_lookup(m->sources, i->data);
+                g_autoptr(GList) paths = NULL;
+
+                g_string_append_printf(c, "\n[%s]\n", (const char *) i->data);
+                if (ms->hash)
+                        g_string_append_printf(c, "Hash=%s\n", ms->hash);
+
+                paths = g_list_sort(g_hash_table_get_keys(ms->files), (GCompareFunc) strcmp);
+                for (GList *j = paths; j; j = g_list_next (j)) {
+                        const char *hash = g_hash_table_lookup(ms->files, j->data);
+
+                        if (hash)
+                                g_string_append_printf(c, "File=%s %s\n", (const char *) j->data, hash);
+                        else
+                                g_string_append_printf(c, "File=%s\n", (const char *) j->data);
+                }
+
+                manifest_append_keys(c, "Edit", ms->edits);
+                manifest_append_keys(c, "Interface", ms->interfaces);
+        }
+
+        if (g_file_get_contents(CONFIG_MANIFEST_PATH, &old, &n, NULL) && n == c->len && memcmp(old, c->str, n) == 0)
+                return 0;
+
+        r = safe_mkdir_p_dir(CONFIG_MANIFEST_PATH);
+        if (r < 0)
+                return r;
+
+        if (!g_file_set_contents(CONFIG_MANIFEST_PATH, c->str, c->len, &e))
+                return -e->code;
+
+        return 0;
+}
+
+/* Whether 'source' was applied with the contents 'hash' and the files generated from it are still as written */
+bool config_manifest_up_to_date(const ConfigManifest *m, const char *source, const char *hash) {
+        ManifestSource *ms;
+        GHashTableIter iter;
+        gpointer k, v;
+
+        assert(m);
+        assert(source);
+        assert(hash);
+
+        ms = g_hash_table_lookup(m->sources, source);
+        if (!ms || g_strcmp0(ms->hash, hash) != 0)
+                return false;
+
+        g_hash_table_iter_init(&iter, ms->files);
+        while (g_hash_table_iter_next(&iter, &k, &v)) {
+                _auto_cleanup_ char *c = NULL, *h = NULL;
+                size_t n;
+
+                if (!v || !g_file_get_contents(k, &c, &n, NULL))
+                        return false;
+
+                h = config_contents_hash(c, n);
+                if (g_strcmp0(h, v) != 0)
+                        return false;
+        }
+
+        return true;
+}
+
+bool config_manifest_has_source(const ConfigManifest *m, const char *source) {
+        assert(m);
+        assert(source);
+
+        return g_hash_table_contains(m->sources, source);
+}
+
+int config_manifest_get_sources(const ConfigManifest *m, char ***ret) {
+        _auto_cleanup_strv_ char **s = NULL;
+        GHashTableIter iter;
+        size_t n = 0;
+        gpointer k;
+
+        assert(m);
+        assert(ret);
+
+        s = new0(char *, g_hash_table_size(m->sources) + 1);
+        if (!s)
+                return log_oom();
+
+        g_hash_table_iter_init(&iter, m->sources);
+        while (g_hash_table_iter_next(&iter, &k, NULL)) {
+                s[n] = g_strdup(k);
+                if (!s[n++])
+                        return log_oom();
+        }
+
+        *ret = steal_ptr(s);
+        return 0;
+}
+
+/* Adds to the set 'sources' the ones that generated, edited or describe the same thing as any in it, until no
+ * more are found. Those have to be generated again together. */
+void config_manifest_add_coupled(const ConfigManifest *m, GHashTable *sources) {
+        bool added;
+
+        assert(m);
+        assert(sources);
+
+        do {
+                GHashTableIter iter;
+                gpointer k, v;
+
+                added = false;
+
+                g_hash_table_iter_init(&iter, m->sources);
+                while (g_hash_table_iter_next(&iter, &k, &v)) {
+                        GHashTableIter j;
+                        gpointer s;
+
+                        if (g_hash_table_contains(sources, k))
+                                continue;
+
+                        g_hash_table_iter_init(&j, sources);
+                        while (g_hash_table_iter_next(&j, &s, NULL)) {
+                                ManifestSource *other = g_hash_table_lookup(m->sources, s);
+
+                                if (other && manifest_source_shares(v, other)) {
+                                        added = true;
+                                        break;
+                                }
+                        }
+
+                        /* Only after the iteration over 'sources' is done */
+                        if (added) {
+                                g_hash_table_add(sources, g_strdup(k));
+                                break;
+                        }
+                }
+        } while (added);
+}
+
+static void config_stage_free(ConfigStage *s) {
+        if (!s)
+                return;
+
+        if (s->files)
+                g_hash_table_unref(s->files);
+        if (s->hashes)
+                g_hash_table_unref(s->hashes);
+        if (s->edits)
+                g_hash_table_unref(s->edits);
+        if (s->interfaces)
+                g_hash_table_unref(s->interfaces);
+
+        config_manifest_free(s->manifest);
+        g_strfreev(s->sources);
+        free(s->source);
+        free(s);
+}
+DEFINE_CLEANUP(ConfigStage*, config_stage_free);
+
+/* Whether the files an earlier apply generated from 'source' are generated anew */
+static bool config_stage_replaces_source(const ConfigStage *s, const char *source) {
+        assert(s);
+        assert(source);
+
+        return s->all || (s->sources && g_strv_contains((const char *const *) s->sources, source));
+}
+
+/* Whether 'path' was generated by an earlier apply of one of the sources being applied now */
+static bool config_stage_replaces(const ConfigStage *s, const char *path) {
+        const char *source;
+
+        assert(s);
+        assert(path);
+
+        source = g_hash_table_lookup(s->manifest->owners, path);
+        if (!source)
+                return false;
+
+        return config_stage_replaces_source(s, source);
+}
+
+/* A new entry has no contents, i.e. stands for removing the file */
+static StagedFile *config_stage_get(ConfigStage *s, const char *path) {
+        StagedFile *f;
+
+        assert(s);
+        assert(path);
+
+        f = g_hash_table_lookup(s->files, path);
+        if (f)
+                return f;
+
+        f = new0(StagedFile, 1);
+        if (!f)
+                return NULL;
+
+        g_hash_table_insert(s->files, g_strdup(path), f);
+        return f;
+}
+
+int config_stage_begin(char **sources, bool all) {
+        _cleanup_(config_stage_freep) ConfigStage *s = NULL;
+        int r;
+
+        assert(!stage);
+
+        s = new0(ConfigStage, 1);
+        if (!s)
+                return log_oom();
+
+        *s = (ConfigStage) {
+                .files = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify) staged_file_free),
+                .hashes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free),
+                .edits = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref),
+                .interfaces = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref),
+                .sources = g_strdupv(sources),
+                .all = all,
+        };
+        if (!s->files || !s->hashes || !s->edits || !s->interfaces)
+                return log_oom();
+
+        r = config_manifest_load(&s->manifest);
+        if (r < 0) {
+                log_warning("Failed to read '%s', keeping files of earlier applies: %s", CONFIG_MANIFEST_PATH, strerror(-r));
+
+                r = config_manifest_new(&s->manifest);
+                if (r < 0)
+                        return r;
+        }
+
+        stage = steal_ptr(s);
+        return 0;
+}
+
+/* Files created from now on are recorded as generated from 'source' */
+void config_stage_set_source(const char *source) {
+        assert(stage);
+
+        free(stage->source);
+        stage->source = g_strdup(source);
+}
+
+/* Records that 'source' was applied with the contents 'hash' */
+int config_stage_set_source_hash(const char *source, const char *hash) {
+        assert(stage);
+        assert(source);
+        assert(hash);
+
+        g_hash_table_replace(stage->hashes, g_strdup(source), g_strdup(hash));
+        return 0;
+}
+
+/* Records that 'source' describes 'ifname', files of another source may be generated from it later */
+int config_stage_add_interface(const char *source, const char *ifname) {
+        assert(stage);
+
+        return string_set_table_add(stage->interfaces, source, ifname);
+}
+
+/* Returns the sources not applied now whose files were created, edited or removed in the stage */
+int config_stage_get_foreign_sources(char ***ret) {
+        _auto_cleanup_hash_ GHashTable *foreign = NULL;
+        _auto_cleanup_strv_ char **s = NULL;
+        g_autoptr(GList) sources = NULL;
+        GHashTableIter iter;
+        size_t n = 0;
+        gpointer k;
+
+        assert(stage);
+        assert(ret);
+
+        foreign = g_hash_table_new(g_str_hash, g_str_equal);
+        if (!foreign)
+                return log_oom();
+
+        g_hash_table_iter_init(&iter, stage->files);
+        while (g_hash_table_iter_next(&iter, &k, NULL)) {
+                const char *owner = g_hash_table_lookup(stage->manifest->owners, k);
+
+                if (owner && !config_stage_replaces_source(stage, owner))
+                        g_hash_table_add(foreign, (gpointer) owner);
+        }
+
+        s = new0(char *, g_hash_table_size(foreign) + 1);
+        if (!s)
+                return log_oom();
+
+        sources = g_list_sort(g_hash_table_get_keys(foreign), (GCompareFunc) strcmp);
+        for (GList *i = sources; i; i = g_list_next (i)) {
+                s[n] = g_strdup(i->data);
+                if (!s[n++])
+                        return log_oom();
+        }
+
+        *ret = steal_ptr(s);
+        return 0;
+}
+
+bool config_stage_active(void) {
+        return !!stage;
+}
+
+void config_stage_abort(void) {
+        config_stage_free(steal_ptr(stage));
+}
+
+int config_stage_create(const char *path) {
+        StagedFile *f;
+
+        assert(stage);
+        assert(path);
+
+        f = config_stage_get(stage, path);
+        if (!f)
+                return log_oom();
+
+        if (f->contents)
+                g_string_truncate(f->contents, 0);
+        else
+                f->contents = g_string_new(NULL);
+
+        free(f->source);
+        f->source = g_strdup(stage->source);
+        return 0;
+}
+
+int config_stage_write(const char *path, const char *contents, size_t size) {
+        StagedFile *f;
+
+        assert(stage);
+        assert(path);
+        assert(contents || size == 0);
+
+        f = config_stage_get(stage, path);
+        if (!f)
+                return log_oom();
+
+        if (f->contents)
+                g_string_truncate(f->contents, 0);
+        else
+                f->contents = g_string_sized_new(size);
+
+        g_string_append_len(f->contents, contents, size);
+
+        if (stage->source && g_strcmp0(f->source, stage->source) != 0)
+                return string_set_table_add(stage->edits, stage->source, path);
+
+        return 0;
+}
+
+int config_stage_remove(const char *path) {
+        StagedFile *f;
+
+        assert(stage);
+        assert(path);
+
+        f = config_stage_get(stage, path);
+        if (!f)
+                return log_oom();
+
+        if (f->contents)
+                g_string_free(f->contents, true);
+
+        f->contents = NULL;
+        f->source = mfree(f->source);
+
+        if (stage->source)
+                return string_set_table_add(stage->edits, stage->source, path);
+
+        return 0;
+}
+
+bool config_file_exists(const char *path) {
+        assert(path);
+
+        if (stage) {
+                StagedFile *f;
+
+                f = g_hash_table_lookup(stage->files, path);
+                if (f)
+                        return !!f->contents;
+
+                if (config_stage_replaces(stage, path))
+                        return false;
+        }
+
+        return g_file_test(path, G_FILE_TEST_EXISTS);
+}
+
+int config_file_read(const char *path, char **ret, size_t *ret_size) {
+        _cleanup_(g_error_freep) GError *e = NULL;
+        _auto_cleanup_ char *c = NULL;
+        size_t n;
+
+        assert(path);
+        assert(ret);
+
+        if (stage) {
+                StagedFile *f;
+
+                f = g_hash_table_lookup(stage->files, path);
+                if (f) {
+                        if (!f->contents)
+                                return -ENOENT;
+
+                        c = g_strndup(f->contents->str, f->contents->len);
+                        if (!c)
+                                return log_oom();
+
+                        if (ret_size)
+                                *ret_size = f->contents->len;
+
+                        *ret = steal_ptr(c);
+                        return 0;
+                }
+
+                if (config_stage_replaces(stage, path))
+                        return -ENOENT;
+        }
+
+        if (!g_file_test(path, G_FILE_TEST_EXISTS))
+                return -ENOENT;
+
+        if (!g_file_get_contents(path, &c, &n, &e))
+                return -e->code;
+
+        if (ret_size)
+                *ret_size = n;
+
+        *ret = steal_ptr(c);
+        return 0;
+}
+
+static int config_stage_apply_one(const char *path, const StagedFile *f) {
+        _cleanup_(g_error_freep) GError *e = NULL;
+        int r;
+
+        assert(path);
+        assert(f);
+
+        if (!f->contents) {
+                _auto_cleanup_ char *d = NULL;
+
+                if (unlink(path) < 0 && errno != ENOENT)
+                        return -errno;
+
+                /* Fails when hand written drop-ins are left, which is fine */
+                d = g_path_get_dirname(path);
+                if (d && g_str_has_suffix(d, ".d"))
+                        (void) rmdir(d);
+
+                conf_file_changed();
+                return 0;
+        }
+
+        r = safe_mkdir_p_dir(path);
+        if (r < 0)
+                return r;
+
+        /* g_file_set_contents() replaces the file by rename(), networkd never reads a partial file */
+        if (!g_file_set_contents(path, f->contents->str, f->contents->len, &e))
+                return -e->code;
+
+        conf_file_changed();
+        return set_file_permisssion(path, "systemd-network");
+}
+
+/* Moves 'path' from the record of the source that generated it before to the one of 'source' */
+static int config_manifest_set_owner(ConfigManifest *m, const char *path, const char *old, const char *source, const GString *contents) {
+        ManifestSource *ms;
+        char *hash;
+
+        assert(m);
+        assert(path);
+
+        if (old && g_strcmp0(old, source) != 0) {
+                ms = g_hash_table_lookup(m->sources, old);
+                if (ms)
+                        g_hash_table_remove(ms->files, path);
+        }
+
+        if (!source || !contents)
+                return 0;
+
+        ms = g_hash_table_lookup(m->sources, source);
+        if (!ms)
+                return 0;
+
+        hash = config_contents_hash(contents->str, contents->len);
+        if (!hash)
+                return log_oom();
+
+        g_hash_table_replace(ms->files, g_strdup(path), hash);
+        return 0;
+}
+
+/* The sources not applied now keep their records, the applied ones start over with what the stage saw */
+static int config_stage_build_manifest(ConfigStage *s, ConfigManifest **ret) {
+        _cleanup_(config_manifest_freep) ConfigManifest *m = NULL;
+        GHashTableIter iter;
+        gpointer k, v;
+        int r;
+
+        assert(s);
+        assert(ret);
+
+        r = config_manifest_new(&m);
+        if (r < 0)
+                return r;
+
+        g_hash_table_iter_init(&iter, s->manifest->sources);
+        while (g_hash_table_iter_next(&iter, &k, &v)) {
+                if (config_stage_replaces_source(s, k))
+                        continue;
+
+                g_hash_table_iter_steal(&iter);
+                g_hash_table_insert(m->sources, k, v);
+        }
+
+        g_hash_table_iter_init(&iter, s->hashes);
+        while (g_hash_table_iter_next(&iter, &k, &v)) {
+                ManifestSource *ms;
+                GHashTable *t;
+
+                r = manifest_source_new(v, &ms);
+                if (r < 0)
+                        return r;
+
+                g_hash_table_replace(m->sources, g_strdup(k), ms);
+
+                t = g_hash_table_lookup(s->edits, k);
+                if (t) {
+                        g_hash_table_unref(ms->edits);
+                        ms->edits = g_hash_table_ref(t);
+                }
+
+                t = g_hash_table_lookup(s->interfaces, k);
+                if (t) {
+                        g_hash_table_unref(ms->interfaces);
+                        ms->interfaces = g_hash_table_ref(t);
+                }
+        }
+
+        *ret = steal_ptr(m);
+        return 0;
+}
+
+/* Writes the files whose staged contents differ from the disk, removes the ones staged for removal and the
+ * ones generated earlier from the applied sources that were not generated again. With 'dry_run' nothing is
+ * touched. Either way the changes are returned in the order of their paths. */
+int config_stage_commit(bool dry_run, GPtrArray **ret_changes) {
+        _cleanup_(config_stage_freep) ConfigStage *s = steal_ptr(stage);
+        _cleanup_(g_ptr_array_unrefp) GPtrArray *changes = NULL;
+        _cleanup_(config_manifest_freep) ConfigManifest *manifest = NULL;
+        g_autoptr(GList) paths = NULL;
+        GHashTableIter iter;
+        gpointer k;
+        int r;
+
+        assert(s);
+
+        changes = g_ptr_array_new_with_free_func((GDestroyNotify) config_change_free);
+        if (!changes)
+                return log_oom();
+
+        /* Orphans: generated from the applied sources before, not now */
+        g_hash_table_iter_init(&iter, s->manifest->owners);
+        while (g_hash_table_iter_next(&iter, &k, NULL)) {
+                if (!config_stage_replaces(s, k))
+                        continue;
+
+                if (!config_stage_get(s, k))
+                        return log_oom();
+        }
+
+        r = config_stage_build_manifest(s, &manifest);
+        if (r < 0)
+                return r;
+
+        paths = g_list_sort(g_hash_table_get_keys(s->files), (GCompareFunc) strcmp);
+        for (GList *i = paths; i; i = g_list_next (i)) {
+                StagedFile *f = g_hash_table_lookup(s->files, i->data);
+                const char *path = i->data, *owner;
+                _auto_cleanup_ char *old = NULL;
+                ConfigChangeType type;
+                size_t n;
+
+                /* Created files belong to their source, edited ones keep their owner if any */
+                owner = g_hash_table_lookup(s->manifest->owners, path);
+                r = config_manifest_set_owner(manifest, path, owner, f->source ?: owner, f->contents);
+                if (r < 0)
+                        return r;
+
+                if (!f->contents) {
+                        if (!g_file_test(path, G_FILE_TEST_EXISTS))
+                                continue;
+
+                        type = CONFIG_CHANGE_REMOVE;
+                } else {
+                        if (!g_file_get_contents(path, &old, &n, NULL))
+                                type = CONFIG_CHANGE_CREATE;
+                        else if (n != f->contents->len || memcmp(old, f->contents->str, n) != 0)
+                                type = CONFIG_CHANGE_UPDATE;
+                        else
+                                continue;
+                }
+
+                if (!dry_run) {
+                        r = config_stage_apply_one(path, f);
+                        if (r < 0) {
+                                log_warning("Failed to %s '%s': %s", config_change_type_to_name(type), path, strerror(-r));
+                                return r;
+                        }
+                }
+
+                r = config_change_add(changes, type, path);
+                if (r < 0)
+                        return r;
+        }
+
+        if (!dry_run) {
+                r = config_manifest_save(manifest);
+                if (r < 0)
+                        log_warning("Failed to write '%s': %s", CONFIG_MANIFEST_PATH, strerror(-r));
+        }
+
+        if (ret_changes)
+                *ret_changes = steal_ptr(changes);
+
+        return 0;
+}
@@ -0,0 +1,59 @@
+/* Copyright 2024 VMware, Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <glib.h>
+#include <stdbool.h>
+
+#include "alloc-util.h"
+
+/* Which configuration files each YAML source generated on the last apply, with the hashes of both */
+#define CONFIG_MANIFEST_PATH "/var/lib/network-config-manager/manifest"
+
+typedef enum ConfigChangeType {
+        CONFIG_CHANGE_CREATE,
+        CONFIG_CHANGE_UPDATE,
+        CONFIG_CHANGE_REMOVE,
+        _CONFIG_CHANGE_MAX,
+        _CONFIG_CHANGE_INVALID = -EINVAL
+} ConfigChangeType;
+
+typedef struct ConfigChange {
+        ConfigChangeType type;
+        char *path;
+} ConfigChange;
+
+void config_change_free(ConfigChange *c);
+DEFINE_CLEANUP(ConfigChange*, config_change_free);
+
+const char *config_change_type_to_name(ConfigChangeType id);
+
+typedef struct ConfigManifest ConfigManifest;
+
+int config_manifest_load(ConfigManifest **ret);
+void config_manifest_free(ConfigManifest *m);
+DEFINE_CLEANUP(ConfigManifest*, config_manifest_free);
+
+bool config_manifest_up_to_date(const ConfigManifest *m, const char *source, const char *hash);
+bool config_manifest_has_source(const ConfigManifest *m, const char *source);
+int config_manifest_get_sources(const ConfigManifest *m, char ***ret);
+void config_manifest_add_coupled(const ConfigManifest *m, GHashTable *sources);
+
+int config_source_hash(const char *path, char **ret);
+
+int config_stage_begin(char **sources, bool all);
+void config_stage_set_source(const char *source);
+int config_stage_set_source_hash(const char *source, const char *hash);
+int config_stage_add_interface(const char *source, const char *ifname);
+int config_stage_get_foreign_sources(char ***ret);
+int config_stage_commit(bool dry_run, GPtrArray **ret_changes);
+void config_stage_abort(void);
+bool config_stage_active(void);
+
+int config_stage_create(const char *path);
+int config_stage_write(const char *path, const char *contents, size_t size);
+int config_stage_remove(const char *path);
+
+bool config_file_exists(const char *path);
+int config_file_read(const char *path, char **ret, size_t *ret_size);
@@ -10,10 +10,23 @@
 #include <unistd.h>
 
 #include "alloc-util.h"
+#include "config-stage.h"
 #include "file-util.h"
 #include "macros.h"
 #include "string-util.h"
 
+/* Bumped whenever a configuration file is created, removed or its contents change. Lets callers tell whether
+ * an operation left anything for networkd to reload. Per thread, like the reload state it feeds. */
+static __thread unsigned conf_file_changes = 0;
+
+void conf_file_changed(void) {
+        conf_file_changes++;
+}
+
+unsigned conf_file_get_changes(void) {
+        return conf_file_changes;
+}
+
 int safe_mkdir_p_dir(const char* file_path) {
     _auto_cleanup_  char* dir = g_path_get_dirname(file_path);
 
@@ -30,6 +43,10 @@ int set_file_permisssion(const char *path, const char *user) {
         assert(path);
         assert(user);
 
+        /* Staged files get their owner when the stage is committed */
+        if (config_stage_active())
+                return 0;
+
         pw = getpwnam(user);
         if (!pw)
                 return -errno;
@@ -78,10 +95,21 @@ int create_conf_file(const char *path, const char *ifname, const char *extension
         if (!p)
                 return -ENOMEM;
 
+        if (config_stage_active()) {
+                r = config_stage_create(p);
+                if (r < 0)
+                        return r;
+
+                *ret = steal_ptr(p);
+                return 0;
+        }
+
         fd = creat(p, 0644 | S_ISUID | S_ISGID);
         if (fd < 0)
                return -errno;
 
+        conf_file_changed();
+
         r = set_file_permisssion(path, "systemd-network");
         if (r < 0)
                 return r;
@@ -90,6 +118,20 @@ int create_conf_file(const char *path, const char *ifname, const char *extension
         return 0;
 }
 
+/* Removes a configuration file and counts that as a change, so the reload following it is not skipped */
+int remove_conf_file(const char *path) {
+        assert(path);
+
+        if (config_stage_active())
+                return config_stage_remove(path);
+
+        if (unlink(path) < 0)
+                return -errno;
+
+        conf_file_changed();
+        return 0;
+}
+
 int read_one_line(const char *path, char **v) {
         _auto_cleanup_fclose_ FILE *fp = NULL;
         _auto_cleanup_ char *line = NULL;
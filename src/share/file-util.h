@@ -5,11 +5,15 @@
 
 #include <glob.h>
 
+void conf_file_changed(void);
+unsigned conf_file_get_changes(void);
+
 int safe_mkdir_p_dir(const char* file_path) ;
 
 int set_file_permisssion(const char *path, const char *user);
 int create_conf_file(const char *path, const char *ifname, const char *extension, char **ret);
 int write_to_conf_file(const char *path, const GString *s);
+int remove_conf_file(const char *path);
 int determine_conf_file(const char *path, const char *ifname, const char *extension, char **ret);
 
 int read_one_line(const char *path, char **v);
@@ -2,7 +2,10 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <inttypes.h>
+#include <json-c/json.h>
 #include <systemd/sd-journal.h>
+#include <time.h>
 
 #include "alloc-util.h"
 #include "ctl-display.h"
@@ -10,6 +13,10 @@
 #include "parse-util.h"
 #include "string-util.h"
 #include "journal.h"
+#include "network-json.h"
+
+#define JOURNAL_DATA_THRESHOLD      (4 * 1024)
+#define JOURNAL_JSON_DATA_THRESHOLD (64 * 1024)
 
 int add_matches_for_unit(sd_journal *j, const char *unit) {
         const char *match_systemd_unit, *match_coredump_unit, *match_unit, *match_object_systemd_unit;
@@ -56,31 +63,28 @@ int add_match_current_boot(sd_journal *j) {
         return sd_journal_add_conjunction(j);
 }
 
-int display_network_logs(int ifindex, char *ifname) {
-        sd_journal *j = NULL;
+static int journal_add_network_matches(sd_journal *j, const JournalQuery *q) {
         int r;
 
-        r = sd_journal_open(&j, SD_JOURNAL_LOCAL_ONLY);
-        if (r < 0) {
-                log_error("Failed to open journal: %s", strerror(-r));
-                return r;
+        /* A cursor or a start time may well reach back into earlier boots */
+        if (!q->cursor && q->since == 0) {
+                r = add_match_current_boot(j);
+                if (r < 0) {
+                        log_warning("Failed to add boot matches: %s", strerror(-r));
+                        return r;
+                }
         }
 
-        r = add_match_current_boot(j);
-        if (r < 0) {
-                log_warning("Failed to add boot matches: %s", strerror(-r));
-                return r;
-        }
-        if (ifindex > 0 && ifname) {
+        if (q->ifindex > 0 && q->ifname) {
                 _auto_cleanup_ char *device = NULL, *kernel_device = NULL;
                 char interface[256] = {};
 
-                device = strjoin("", "INTERFACE=", ifname, NULL);
+                device = strjoin("", "INTERFACE=", q->ifname, NULL);
                 if (!device)
                         return log_oom();
 
-                kernel_device = strjoin("", "DEVICE=", ifname, NULL);
-                sprintf(interface, "_KERNEL_DEVICE=n%i", ifindex);
+                kernel_device = strjoin("", "DEVICE=", q->ifname, NULL);
+                sprintf(interface, "_KERNEL_DEVICE=n%i", q->ifindex);
 
                 r = sd_journal_add_match(j, interface, 0);
                 r = sd_journal_add_disjunction(j);
@@ -92,87 +96,274 @@ int display_network_logs(int ifindex, char *ifname) {
                         return r;
                 }
 
-        } else {
-                r = add_matches_for_unit(j, "systemd-networkd.service");
-                if (r < 0) {
-                        log_warning("Failed to add unit matches: %s", strerror(-r));
-                        return r;
+                return 0;
+        }
+
+        r = add_matches_for_unit(j, "systemd-networkd.service");
+        if (r < 0) {
+                log_warning("Failed to add unit matches: %s", strerror(-r));
+                return r;
+        }
+
+        r = add_matches_for_unit(j, "systemd-networkd-wait-online.service");
+        if (r < 0) {
+                log_warning("Failed to add unit matches: %s", strerror(-r));
+                return r;
+        }
+
+        return 0;
+}
+
+static bool journal_field_value(const void *data, size_t size, const char *field, const char **ret, size_t *ret_size) {
+        size_t n = strlen(field);
+
+        if (size <= n || memcmp(data, field, n) != 0 || ((const char *) data)[n] != '=')
+                return false;
+
+        *ret = (const char *) data + n + 1;
+        *ret_size = size - n - 1;
+        return true;
+}
+
+/* The fields of the entry are walked once and printed straight from the journal's buffers */
+static int journal_print_entry(sd_journal *j) {
+        const char *message = "", *pid = "", *identifier = "", *hostname = "";
+        size_t message_size = 0, pid_size = 0, identifier_size = 0, hostname_size = 0, size;
+        const void *data;
+        char buf[64] = {};
+        struct tm tm;
+        uint64_t x;
+        time_t t;
+        int r;
+
+        r = sd_journal_get_realtime_usec(j, &x);
+        if (r < 0)
+                return r;
+
+        sd_journal_restart_data(j);
+        while ((r = sd_journal_enumerate_available_data(j, &data, &size)) > 0)
+                (void) (journal_field_value(data, size, "MESSAGE", &message, &message_size) ||
+                        journal_field_value(data, size, "_PID", &pid, &pid_size) ||
+                        journal_field_value(data, size, "SYSLOG_IDENTIFIER", &identifier, &identifier_size) ||
+                        journal_field_value(data, size, "_HOSTNAME", &hostname, &hostname_size));
+        if (r < 0)
+                return r;
+
+        t = x / USEC_PER_SEC;
+        strftime(buf, sizeof(buf), "%b %d %H:%M:%S", localtime_r(&t, &tm));
+
+        printf("%s %.*s %.*s", buf, (int) hostname_size, hostname, (int) identifier_size, identifier);
+        if (pid_size > 0)
+                printf("[%.*s]", (int) pid_size, pid);
+        printf(": %.*s\n", (int) message_size, message);
+
+        return 0;
+}
+
+/* One object per line with every field of the entry, in the layout of journalctl --output=json */
+static int journal_print_entry_json(sd_journal *j) {
+        _cleanup_(json_object_putp) json_object *jobj = NULL;
+        _auto_cleanup_ char *cursor = NULL;
+        char timestamp[32];
+        const void *data;
+        size_t size;
+        uint64_t x;
+        int r;
+
+        r = sd_journal_get_cursor(j, &cursor);
+        if (r < 0)
+                return r;
+
+        r = sd_journal_get_realtime_usec(j, &x);
+        if (r < 0)
+                return r;
+
+        jobj = json_object_new_object();
+        if (!jobj)
+                return log_oom();
+
+        snprintf(timestamp, sizeof(timestamp), "%" PRIu64, x);
+        json_object_object_add(jobj, "__CURSOR", json_object_new_string(cursor));
+        json_object_object_add(jobj, "__REALTIME_TIMESTAMP", json_object_new_string(timestamp));
+
+        sd_journal_restart_data(j);
+        while ((r = sd_journal_enumerate_available_data(j, &data, &size)) > 0) {
+                _auto_cleanup_ char *field = NULL;
+                json_object *js, *e;
+                const char *eq;
+
+                eq = memchr(data, '=', size);
+                if (!eq)
+                        continue;
+
+                field = strndup(data, eq - (const char *) data);
+                if (!field)
+                        return log_oom();
+
+                js = json_object_new_string_len(eq + 1, size - (eq - (const char *) data) - 1);
+                if (!js)
+                        return log_oom();
+
+                /* Fields present more than once become arrays */
+                if (!json_object_object_get_ex(jobj, field, &e)) {
+                        json_object_object_add(jobj, field, js);
+                        continue;
                 }
 
-                r = add_matches_for_unit(j, "systemd-networkd-wait-online.service");
-                if (r < 0) {
-                        log_warning("Failed to add unit matches: %s", strerror(-r));
-                        return r;
+                if (!json_object_is_type(e, json_type_array)) {
+                        json_object *ja;
+
+                        ja = json_object_new_array();
+                        if (!ja) {
+                                json_object_put(js);
+                                return log_oom();
+                        }
+
+                        json_object_array_add(ja, json_object_get(e));
+                        json_object_object_add(jobj, field, ja);
+                        e = ja;
                 }
+
+                json_object_array_add(e, js);
         }
+        if (r < 0)
+                return r;
+
+        printf("%s\n", json_object_to_json_string_ext(jobj, JSON_C_TO_STRING_PLAIN | JSON_C_TO_STRING_NOSLASHESCAPE));
+        return 0;
+}
+
+static int journal_seek(sd_journal *j, const JournalQuery *q, bool *ret_positioned) {
+        int r;
+
+        *ret_positioned = false;
 
-        r = sd_journal_seek_tail(j);
+        if (q->cursor) {
+                r = sd_journal_seek_cursor(j, q->cursor);
+                if (r < 0)
+                        return r;
+
+                /* The cursor names the last entry that was seen already, continue after it */
+                r = sd_journal_next(j);
+                if (r < 0)
+                        return r;
+
+                *ret_positioned = r > 0 && sd_journal_test_cursor(j, q->cursor) <= 0;
+                return 0;
+        }
+
+        if (q->since > 0)
+                return sd_journal_seek_realtime_usec(j, q->since);
+
+        if (q->lines > 0) {
+                r = sd_journal_seek_tail(j);
+                if (r < 0)
+                        return r;
+
+                r = sd_journal_previous_skip(j, q->lines);
+                if (r < 0)
+                        return r;
+
+                *ret_positioned = r > 0;
+                return 0;
+        }
+
+        return sd_journal_seek_head(j);
+}
+
+int journal_show_network_logs(const JournalQuery *q) {
+        _cleanup_(sd_journal_closep) sd_journal *j = NULL;
+        bool positioned, past_until = false;
+        unsigned n = 0;
+        int r;
+
+        assert(q);
+
+        r = sd_journal_open(&j, SD_JOURNAL_LOCAL_ONLY);
         if (r < 0) {
-                log_warning("Failed to iterate to next entry: %s", strerror(-r));
+                log_error("Failed to open journal: %s", strerror(-r));
                 return r;
         }
 
-        r = sd_journal_previous_skip(j, get_log_line());
+        /* Large fields such as core dumps are not decompressed in full only to be cut down on output */
+        r = sd_journal_set_data_threshold(j, q->json ? JOURNAL_JSON_DATA_THRESHOLD : JOURNAL_DATA_THRESHOLD);
+        if (r < 0)
+                return r;
+
+        r = journal_add_network_matches(j, q);
+        if (r < 0)
+                return r;
+
+        r = journal_seek(j, q, &positioned);
         if (r < 0) {
-                log_warning("Failed to skip previous: %s", strerror(-r));
+                log_warning("Failed to seek journal: %s", strerror(-r));
                 return r;
         }
 
-        printf("\n");
-        SD_JOURNAL_FOREACH (j)  {
-                _auto_cleanup_ char *p = NULL, *s = NULL, *a = NULL, *b = NULL, *c = NULL, *e = NULL, *f = NULL, *g = NULL;
-                size_t l, pid_len, syslog_indentifier_len, host_name_len;
-                const void *d, *pid, *syslog_indentifier, *host_name;
-                char buf[128] = {};
-                uint64_t x;
-                time_t t;
-
-                r = sd_journal_next(j);
-                if (r < 0) {
-                        log_warning("Failed to iterate to next entry: %s", strerror(-r));
-                        break;
-                }
-                if (r == 0) {
-                        r = sd_journal_wait(j, (uint64_t) -1);
+        for (;;) {
+                if (!positioned) {
+                        r = sd_journal_next(j);
                         if (r < 0) {
-                                log_warning("Failed to wait for changes: %s", strerror(-r));
-                                break;
+                                log_warning("Failed to iterate to next entry: %s", strerror(-r));
+                                return r;
+                        }
+                        if (r == 0) {
+                                if (!q->follow)
+                                        break;
+
+                                fflush(stdout);
+                                r = sd_journal_wait(j, UINT64_MAX);
+                                if (r < 0) {
+                                        log_warning("Failed to wait for changes: %s", strerror(-r));
+                                        return r;
+                                }
+                                continue;
                         }
-                        continue;
                 }
+                positioned = false;
 
-                r = sd_journal_get_realtime_usec(j, &x);
-                if (r < 0)
-                        continue;
+                if (q->until > 0) {
+                        uint64_t x;
 
-                t = x / 1000000;
-                strftime(buf, 16, "%b %d %H:%M:%S", localtime(&t));
+                        if (sd_journal_get_realtime_usec(j, &x) >= 0 && x > q->until) {
+                                past_until = true;
+                                break;
+                        }
+                }
 
-                r = sd_journal_get_data(j, "MESSAGE", &d, &l);
+                r = q->json ? journal_print_entry_json(j) : journal_print_entry(j);
+                if (r == -ENOMEM)
+                        return r;
                 if (r < 0) {
-                        log_warning("Failed to read message field: %s", strerror(-r));
+                        log_debug("Failed to read journal entry: %s", strerror(-r));
                         continue;
                 }
 
-                r = sd_journal_get_data(j, "_PID", (const void **) &pid, &pid_len);
-                if (r < 0)
-                        continue;
+                n++;
+        }
 
-                r = sd_journal_get_data(j, "SYSLOG_IDENTIFIER", (const void **) &syslog_indentifier, &syslog_indentifier_len);
-                if (r < 0)
-                        continue;
+        /* Where to pick up next time. JSON entries carry their own __CURSOR. */
+        if (q->show_cursor && !q->json) {
+                _auto_cleanup_ char *cursor = NULL;
 
-                r = sd_journal_get_data(j, "_HOSTNAME", (const void **) &host_name, &host_name_len);
-                if (r < 0)
-                        continue;
+                if (past_until)
+                        (void) sd_journal_previous(j);
 
-                split_pair((char *) d, "=", &p, &s);
-                split_pair((char *) pid, "=", &a, &b);
-                split_pair((char *) syslog_indentifier, "=", &c, &e);
-                split_pair((char *) host_name, "=", &f, &g);
-                printf("%s %s %s [%.*s] %.*s\n", buf, g, e, (int) (strlen(a) + 1), b, (int) l, s);
+                if (n > 0 && sd_journal_get_cursor(j, &cursor) >= 0)
+                        printf("-- cursor: %s\n", cursor);
+                else if (q->cursor)
+                        printf("-- cursor: %s\n", q->cursor);
         }
 
-        sd_journal_close(j);
         return 0;
 }
+
+int display_network_logs(int ifindex, char *ifname) {
+        printf("\n");
+
+        return journal_show_network_logs(&(JournalQuery) {
+                        .ifindex = ifindex,
+                        .ifname = ifname,
+                        .lines = get_log_line(),
+                });
+}
@@ -3,10 +3,29 @@
  */
 #pragma once
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <systemd/sd-journal.h>
 
+/* Which networkd log entries to show. Without 'cursor' and 'since' the last 'lines' entries of the current boot
+ * are shown, all of them when 'lines' is 0. */
+typedef struct JournalQuery {
+        int ifindex;
+        const char *ifname;
+
+        uint64_t since;
+        uint64_t until;
+        const char *cursor;
+        unsigned lines;
+
+        bool follow;
+        bool json;
+        bool show_cursor;
+} JournalQuery;
+
 int add_matches_for_unit(sd_journal *j, const char *unit);
 int add_match_boot_id(sd_journal *j, sd_id128_t id);
 int add_match_current_boot(sd_journal *j);
 
+int journal_show_network_logs(const JournalQuery *q);
 int display_network_logs(int ifindex, char *ifname);
@@ -39,11 +39,7 @@ const char *address_family_type_to_name(int id) {
 int address_family_name_to_type(const char *name) {
         assert(name);
 
-        for (size_t i = ADDRESS_FAMILY_NO; i < (size_t) ELEMENTSOF(address_family_table); i++)
-                if (streq_fold(name, address_family_table[i]))
-                        return i;
-
-        return _ADDRESS_FAMILY_INVALID;
+        return string_table_lookup(address_family_table, ELEMENTSOF(address_family_table), name);
 }
 
 static const char * const required_address_family_for_online_table[_REQUIRED_ADDRESS_FAMILY_FOR_ONLINE_MAX] = {
@@ -66,11 +62,7 @@ const char *required_address_family_for_online_type_to_name(int id) {
 int required_address_family_for_online_name_to_type(const char *name) {
         assert(name);
 
-        for (size_t i = REQUIRED_ADDRESS_FAMILY_FOR_ONLINE_IPV4; i < (size_t) ELEMENTSOF(required_address_family_for_online_table); i++)
-                if (streq_fold(name, required_address_family_for_online_table[i]))
-                        return i;
-
-        return _ADDRESS_FAMILY_INVALID;
+        return string_table_lookup(required_address_family_for_online_table, ELEMENTSOF(required_address_family_for_online_table), name);
 }
 
 static const char* const device_activation_policy_table[_DEVICE_ACTIVATION_POLICY_MAX] = {
@@ -95,11 +87,7 @@ const char *device_activation_policy_type_to_name(int id) {
 int device_activation_policy_name_to_type(const char *name) {
         assert(name);
 
-        for (size_t i = DEVICE_ACTIVATION_POLICY_UP; i < (size_t) ELEMENTSOF(device_activation_policy_table); i++)
-                if (streq_fold(name, device_activation_policy_table[i]))
-                        return i;
-
-        return _DEVICE_ACTIVATION_POLICY_INVALID;
+        return string_table_lookup(device_activation_policy_table, ELEMENTSOF(device_activation_policy_table), name);
 }
 
 bool ip4_addr_is_null(const IPAddress *a) {
@@ -120,6 +108,50 @@ int ip_is_null(const IPAddress *a) {
         return -EAFNOSUPPORT;
 }
 
+/* Hashes only the family, prefix length and the address bytes of that family */
+guint ip_address_hash(gconstpointer p) {
+        const IPAddress *a = p;
+        const uint8_t *b = NULL;
+        size_t l = 0;
+        guint h;
+
+        assert(a);
+
+        h = (guint) a->family * 31 + (guint) a->prefix_len;
+
+        if (a->family == AF_INET) {
+                b = (const uint8_t *) &a->in;
+                l = sizeof(a->in);
+        } else if (a->family == AF_INET6) {
+                b = (const uint8_t *) &a->in6;
+                l = sizeof(a->in6);
+        }
+
+        for (size_t i = 0; i < l; i++)
+                h = h * 31 + b[i];
+
+        return h;
+}
+
+gboolean ip_address_equal(gconstpointer v1, gconstpointer v2) {
+        const IPAddress *a = v1, *b = v2;
+
+        assert(a);
+        assert(b);
+
+        if (a->family != b->family || a->prefix_len != b->prefix_len)
+                return false;
+
+        switch (a->family) {
+        case AF_INET:
+                return a->in.s_addr == b->in.s_addr;
+        case AF_INET6:
+                return memcmp(&a->in6, &b->in6, sizeof(a->in6)) == 0;
+        default:
+                return true;
+        }
+}
+
 int ip_to_str(int family, const struct IPAddress *u, char **ret) {
         _auto_cleanup_ char *x = NULL;
         const char *p = NULL;
@@ -275,6 +307,22 @@ int ipv4_netmask_to_prefixlen(IPAddress *addr) {
         return 32U - __builtin_ctz(be32toh(addr->in.s_addr));
 }
 
+/* Returns the first entry of 'addresses' that is not an IP address (with prefix length if 'prefix'), or NULL */
+const char *ip_addresses_find_invalid(char **addresses, bool prefix) {
+        char **a;
+
+        strv_foreach(a, addresses) {
+                _auto_cleanup_ IPAddress *ip = NULL;
+                int r;
+
+                r = prefix ? parse_ip_from_str(*a, &ip) : parse_ip(*a, &ip);
+                if (r < 0)
+                        return *a;
+        }
+
+        return NULL;
+}
+
 int parse_ip_port(const char *s, IPAddress **ret, uint16_t *port) {
         _auto_cleanup_ char *c = NULL;
         char *p;
@@ -82,11 +82,15 @@ int parse_ip(const char *s, IPAddress **ret);
 int parse_ip_port(const char *s, IPAddress **ret, uint16_t *port);
 
 int parse_ip_from_str(const char *s, IPAddress **ret);
+const char *ip_addresses_find_invalid(char **addresses, bool prefix);
 int ipv4_netmask_to_prefixlen(IPAddress *addr);
 
 bool ip4_addr_is_null(const IPAddress *a);
 int ip_is_null(const IPAddress *a);
 
+guint ip_address_hash(gconstpointer p);
+gboolean ip_address_equal(gconstpointer a, gconstpointer b);
+
 int parse_ifname_or_index(const char *s, IfNameIndex **ret);
 char *ether_addr_to_string(const struct ether_addr *addr, char *s);
 bool ether_addr_is_not_null(const struct ether_addr *addr);
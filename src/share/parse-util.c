@@ -5,11 +5,13 @@
 #include <errno.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <time.h>
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <linux/if.h>
 
 #include "alloc-util.h"
+#include "defines.h"
 #include "macros.h"
 #include "parse-util.h"
 #include "string-util.h"
@@ -51,6 +53,118 @@ int parse_uint64(const char *c, uint64_t *val) {
         return 0;
 }
 
+/* Accepts "now", "today", "yesterday", "@SECONDS" since the epoch, "-N" or "+N" with a s, min, h or d suffix
+ * relative to now, and "YYYY-MM-DD[ HH:MM[:SS]]" in local time. Returns CLOCK_REALTIME microseconds. */
+int parse_timestamp(const char *c, uint64_t *ret) {
+        static const struct {
+                const char *suffix;
+                uint64_t usec;
+        } units[] = {
+                { "s",   USEC_PER_SEC         },
+                { "min", 60 * USEC_PER_SEC    },
+                { "h",   3600 * USEC_PER_SEC  },
+                { "d",   86400 * USEC_PER_SEC },
+        };
+        static const char *const formats[] = {
+                "%Y-%m-%d %H:%M:%S",
+                "%Y-%m-%d %H:%M",
+                "%Y-%m-%d",
+        };
+        struct timespec ts;
+        struct tm tm;
+        uint64_t now;
+        time_t t;
+
+        assert(c);
+        assert(ret);
+
+        if (clock_gettime(CLOCK_REALTIME, &ts) < 0)
+                return -errno;
+
+        now = (uint64_t) ts.tv_sec * USEC_PER_SEC + ts.tv_nsec / 1000;
+
+        if (streq(c, "now")) {
+                *ret = now;
+                return 0;
+        }
+
+        if (streq(c, "today") || streq(c, "yesterday")) {
+                t = ts.tv_sec;
+                if (!localtime_r(&t, &tm))
+                        return -EINVAL;
+
+                tm.tm_hour = tm.tm_min = tm.tm_sec = 0;
+                tm.tm_isdst = -1;
+                if (streq(c, "yesterday"))
+                        tm.tm_mday--;
+
+                t = mktime(&tm);
+                if (t == (time_t) -1)
+                        return -EINVAL;
+
+                *ret = (uint64_t) t * USEC_PER_SEC;
+                return 0;
+        }
+
+        if (c[0] == '@') {
+                uint64_t k;
+
+                if (parse_uint64(c + 1, &k) < 0)
+                        return -EINVAL;
+
+                *ret = k * USEC_PER_SEC;
+                return 0;
+        }
+
+        if (c[0] == '-' || c[0] == '+') {
+                unsigned long long n;
+                char *e;
+
+                errno = 0;
+                n = strtoull(c + 1, &e, 10);
+                if (errno != 0 || e == c + 1)
+                        return -EINVAL;
+
+                for (size_t i = 0; i < ELEMENTSOF(units); i++) {
+                        uint64_t d;
+
+                        if (!streq(e, units[i].suffix))
+                                continue;
+
+                        d = n * units[i].usec;
+                        if (c[0] == '+')
+                                *ret = now + d;
+                        else
+                                *ret = d > now ? 0 : now - d;
+
+                        return 0;
+                }
+
+                return -EINVAL;
+        }
+
+        for (size_t i = 0; i < ELEMENTSOF(formats); i++) {
+                const char *e;
+
+                tm = (struct tm) {
+                        .tm_isdst = -1,
+                };
+
+                e = strptime(c, formats[i], &tm);
+                if (!e || *e)
+                        continue;
+
+                t = mktime(&tm);
+                if (t == (time_t) -1)
+                        return -EINVAL;
+
+                *ret = (uint64_t) t * USEC_PER_SEC;
+                return 0;
+        }
+
+        return -EINVAL;
+}
+
 int parse_uint32(const char *c, unsigned *val) {
         char *p;
         long r;
@@ -8,6 +8,7 @@
 
 int parse_int(const char *c, int *val);
 int parse_uint64(const char *c, uint64_t *val);
+int parse_timestamp(const char *c, uint64_t *ret);
 int parse_uint32(const char *c, unsigned *val);
 int parse_uint16(const char *c, uint16_t *val);
 int parse_link_queue(const char *c, unsigned *ret);
@@ -319,3 +319,20 @@ int unhexchar(char c) {
 
         return -EINVAL;
 }
+
+/* Case-insensitive reverse lookup in a *_to_name() table, NULL slots are skipped */
+int string_table_lookup(const char *const *table, size_t n, const char *name) {
+        char c;
+
+        assert(table);
+
+        if (isempty(name))
+                return -EINVAL;
+
+        c = g_ascii_tolower(name[0]);
+        for (size_t i = 0; i < n; i++)
+                if (table[i] && g_ascii_tolower(table[i][0]) == c && streq_fold(name, table[i]))
+                        return i;
+
+        return -EINVAL;
+}
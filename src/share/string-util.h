@@ -72,3 +72,5 @@ int skip_first_word_and_split(char *line, const char *first_word, const char *se
 const char *bool_to_str(bool x);
 
 int unhexchar(char c);
+
+int string_table_lookup(const char *const *table, size_t n, const char *name);
@@ -1,6 +1,7 @@
 
 #include "alloc-util.h"
 #include "device.h"
+#include "string-util.h"
 
 int device_new_from_ifname(sd_device **ret, const char *ifname) {
         _cleanup_(sd_device_unrefp) sd_device *dev = NULL;
@@ -15,3 +16,136 @@ int device_new_from_ifname(sd_device **ret, const char *ifname) {
         *ret = steal_ptr(dev);
         return 0;
 }
+
+static int device_dup_property(sd_device *dev, const char *key, const char *fallback, char **ret) {
+        const char *v = NULL;
+
+        if (sd_device_get_property_value(dev, key, &v) < 0 && fallback)
+                (void) sd_device_get_property_value(dev, fallback, &v);
+
+        if (isempty(v))
+                return 0;
+
+        *ret = strdup(v);
+        if (!*ret)
+                return -ENOMEM;
+
+        return 0;
+}
+
+int net_device_new(sd_device *dev, NetDevice **ret) {
+        _cleanup_(net_device_freep) NetDevice *d = NULL;
+        const char *t = NULL;
+        int r;
+
+        assert(dev);
+        assert(ret);
+
+        d = new0(NetDevice, 1);
+        if (!d)
+                return -ENOMEM;
+
+        r = sd_device_get_ifindex(dev, &d->ifindex);
+        if (r < 0)
+                return r;
+
+        if (sd_device_get_devtype(dev, &t) >= 0 && !isempty(t)) {
+                d->devtype = strdup(t);
+                if (!d->devtype)
+                        return -ENOMEM;
+        }
+
+        r = device_dup_property(dev, "ID_NET_LINK_FILE", NULL, &d->link_file);
+        if (r < 0)
+                return r;
+
+        r = device_dup_property(dev, "ID_NET_DRIVER", NULL, &d->driver);
+        if (r < 0)
+                return r;
+
+        r = device_dup_property(dev, "ID_PATH", NULL, &d->path);
+        if (r < 0)
+                return r;
+
+        r = device_dup_property(dev, "ID_VENDOR_FROM_DATABASE", "ID_VENDOR", &d->vendor);
+        if (r < 0)
+                return r;
+
+        r = device_dup_property(dev, "ID_MODEL_FROM_DATABASE", "ID_MODEL", &d->model);
+        if (r < 0)
+                return r;
+
+        *ret = steal_ptr(d);
+        return 0;
+}
+
+int net_device_new_from_ifname(const char *ifname, NetDevice **ret) {
+        _cleanup_(sd_device_unrefp) sd_device *dev = NULL;
+        int r;
+
+        assert(ifname);
+        assert(ret);
+
+        r = device_new_from_ifname(&dev, ifname);
+        if (r < 0)
+                return r;
+
+        return net_device_new(dev, ret);
+}
+
+void net_device_free(NetDevice *d) {
+        if (!d)
+                return;
+
+        free(d->devtype);
+        free(d->link_file);
+        free(d->driver);
+        free(d->path);
+        free(d->vendor);
+        free(d->model);
+        free(d);
+}
+
+/* Reads every device of the "net" subsystem in one pass, for listings that look at all links. Returns a
+ * table of NetDevice keyed by ifindex. */
+int net_devices_enumerate(GHashTable **ret) {
+        _cleanup_(sd_device_enumerator_unrefp) sd_device_enumerator *e = NULL;
+        _auto_cleanup_hash_ GHashTable *devices = NULL;
+        int r;
+
+        assert(ret);
+
+        r = sd_device_enumerator_new(&e);
+        if (r < 0)
+                return r;
+
+        r = sd_device_enumerator_add_match_subsystem(e, "net", true);
+        if (r < 0)
+                return r;
+
+        devices = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) net_device_free);
+        if (!devices)
+                return -ENOMEM;
+
+        for (sd_device *dev = sd_device_enumerator_get_device_first(e); dev; dev = sd_device_enumerator_get_device_next(e)) {
+                NetDevice *d;
+
+                r = net_device_new(dev, &d);
+                if (r == -ENOMEM)
+                        return r;
+                if (r < 0)
+                        continue;
+
+                g_hash_table_replace(devices, GINT_TO_POINTER(d->ifindex), d);
+        }
+
+        *ret = steal_ptr(devices);
+        return 0;
+}
+
+const NetDevice *net_devices_get(GHashTable *devices, int ifindex) {
+        if (!devices)
+                return NULL;
+
+        return g_hash_table_lookup(devices, GINT_TO_POINTER(ifindex));
+}
@@ -4,6 +4,29 @@
 
 #pragma once
 
+#include <glib.h>
 #include <systemd/sd-device.h>
 
+#include "alloc-util.h"
+
+/* The udev properties of a network device that status output shows */
+typedef struct NetDevice {
+        int ifindex;
+
+        char *devtype;
+        char *link_file;
+        char *driver;
+        char *path;
+        char *vendor;
+        char *model;
+} NetDevice;
+
 int device_new_from_ifname(sd_device **ret, const char *ifname);
+
+int net_device_new(sd_device *dev, NetDevice **ret);
+int net_device_new_from_ifname(const char *ifname, NetDevice **ret);
+void net_device_free(NetDevice *d);
+DEFINE_CLEANUP(NetDevice*, net_device_free);
+
+int net_devices_enumerate(GHashTable **ret);
+const NetDevice *net_devices_get(GHashTable *devices, int ifindex);
@@ -6,10 +6,84 @@
 #include "yaml-network-parser.h"
 #include "yaml-netdev-parser.h"
 #include "yaml-link-parser.h"
+#include "yaml-template.h"
 #include "alloc-util.h"
 #include "string-util.h"
 #include "log.h"
 
+static int yaml_parse_section_entries(YAMLManager *m, const char *section, yaml_document_t *dp, yaml_node_t *node, Networks *networks) {
+        if (streq(section, "ethernets")) {
+                (void) parse_ethernet_config(m, dp, node, networks);
+                return 0;
+        }
+
+        return yaml_parse_netdev_config(m, yaml_netdev_name_to_kind(section), dp, node, networks);
+}
+
+/* Parses the entry 'node' is narrowed to once for each number of the range in its name */
+static int yaml_parse_section_template(YAMLManager *m, const char *section, yaml_document_t *dp, yaml_node_t *node, Networks *networks) {
+        _cleanup_(yaml_template_freep) YAMLTemplate *t = NULL;
+        yaml_node_pair_t *p = node->data.mapping.pairs.start;
+        unsigned first, last;
+        yaml_node_t *k;
+        int r;
+
+        k = yaml_document_get_node(dp, p->key);
+        r = k && k->type == YAML_SCALAR_NODE ? yaml_template_find_range(scalar(k), &first, &last) : 0;
+        if (r <= 0)
+                return r < 0 ? r : yaml_parse_section_entries(m, section, dp, node, networks);
+
+        r = yaml_template_new(dp, p, &t);
+        if (r < 0)
+                return r;
+
+        for (unsigned long n = first; n <= last; n++) {
+                r = yaml_template_apply(t, n);
+                if (r < 0)
+                        return r;
+
+                r = yaml_parse_section_entries(m, section, dp, node, networks);
+                if (r < 0)
+                        return r;
+        }
+
+        return 0;
+}
+
+/* Entries named like "vlan{100..3999}" are generated in place. Their scalars are pointed at the text for each
+ * number in turn and the entry is parsed again, so nothing is copied however large the range. */
+static int yaml_parse_section(YAMLManager *m, const char *section, yaml_document_t *dp, yaml_node_t *node, Networks *networks) {
+        yaml_node_pair_t *start, *top;
+        bool templates = false;
+        int r = 0;
+
+        if (node->type == YAML_MAPPING_NODE)
+                for (yaml_node_pair_t *p = node->data.mapping.pairs.start; p < node->data.mapping.pairs.top && !templates; p++) {
+                        yaml_node_t *k = yaml_document_get_node(dp, p->key);
+
+                        templates = k && k->type == YAML_SCALAR_NODE && strchr(scalar(k), '{');
+                }
+
+        if (!templates)
+                return yaml_parse_section_entries(m, section, dp, node, networks);
+
+        /* Hand the entries to the section parser one at a time */
+        start = node->data.mapping.pairs.start;
+        top = node->data.mapping.pairs.top;
+
+        for (yaml_node_pair_t *p = start; p < top && r >= 0; p++) {
+                node->data.mapping.pairs.start = p;
+                node->data.mapping.pairs.top = p + 1;
+
+                r = yaml_parse_section_template(m, section, dp, node, networks);
+        }
+
+        node->data.mapping.pairs.start = start;
+        node->data.mapping.pairs.top = top;
+
+        return r;
+}
+
 static int yaml_parse_node(YAMLManager *m, yaml_document_t *dp, yaml_node_t *node, Networks *networks) {
         int r;
 
@@ -34,16 +108,12 @@ static int yaml_parse_node(YAMLManager *m, yaml_document_t *dp, yaml_node_t *nod
                 for (yaml_node_pair_t *p = node->data.mapping.pairs.start; p < node->data.mapping.pairs.top; p++) {
                         yaml_node_t *n = yaml_document_get_node(dp, p->key);
 
-                        if (streq(scalar(n), "ethernets")) {
-                                n = yaml_document_get_node(dp, p->value);
-                                if (n)
-                                        (void) parse_ethernet_config(m, dp, n, networks);
-                        } else if (is_yaml_netdev_kind(scalar(n))) {
-                                YAMLNetDevKind kind = yaml_netdev_name_to_kind(scalar(n));
+                        if (streq(scalar(n), "ethernets") || is_yaml_netdev_kind(scalar(n))) {
+                                const char *section = scalar(n);
 
                                 n = yaml_document_get_node(dp, p->value);
                                 if (n) {
-                                        r = yaml_parse_netdev_config(m, kind, dp, n, networks);
+                                        r = yaml_parse_section(m, section, dp, n, networks);
                                         if (r < 0)
                                                 return r;
                                 }
@@ -63,18 +133,411 @@ static int yaml_parse_node(YAMLManager *m, yaml_document_t *dp, yaml_node_t *nod
 }
 
 static int yaml_parse_document(YAMLManager *m, yaml_document_t *dp, Networks *n) {
+        int r;
+
+        r = yaml_template_expand_ranges(dp);
+        if (r < 0)
+                return r;
+
         return yaml_parse_node(m, dp, yaml_document_get_root_node(dp), n);
 }
 
-int yaml_parse_file(const char *file, Networks **n) {
-        _cleanup_(yaml_manager_freep) YAMLManager *m = NULL;
-        _cleanup_(networks_freep) Networks *networks = NULL;
-        _auto_cleanup_fclose_ FILE *f = NULL;
+static int yaml_load_documents(YAMLManager *m, yaml_parser_t *parser, Networks *networks) {
         yaml_document_t document;
-        yaml_parser_t parser;
         bool done = false;
         int r = 0;
 
+        assert(m);
+        assert(parser);
+        assert(networks);
+
+        for (;!done;) {
+                if (!yaml_parser_load(parser, &document))
+                        return -EINVAL;
+
+                done = !yaml_document_get_root_node(&document);
+                if (!done)
+                        r = yaml_parse_document(m, &document, networks);
+
+                yaml_document_delete(&document);
+        }
+
+        return r;
+}
+
+static inline void yaml_event_deletep(yaml_event_t *e) {
+        yaml_event_delete(e);
+}
+
+static int yaml_stream_next(yaml_parser_t *parser, yaml_event_t *ret) {
+        if (!yaml_parser_parse(parser, ret)) {
+                log_warning("Failed to parse YAML at line %zu: %s", parser->problem_mark.line + 1, str_na(parser->problem));
+                return -EINVAL;
+        }
+
+        return 0;
+}
+
+/* Errors the stream can not go on after: the YAML itself is broken, memory ran out, or the file needs to be
+ * loaded as a whole. Anything else is dropped the way yaml_parse_node() drops it. */
+static bool yaml_stream_fatal(const yaml_parser_t *parser, int r) {
+        return parser->error != YAML_NO_ERROR || r == -ENOMEM || r == -EOPNOTSUPP;
+}
+
+/* Consumes the events up to the end of the mapping or sequence being read */
+static int yaml_stream_skip_rest(yaml_parser_t *parser) {
+        unsigned depth = 1;
+        int r;
+
+        assert(parser);
+
+        while (depth > 0) {
+                _cleanup_(yaml_event_deletep) yaml_event_t e = {};
+
+                r = yaml_stream_next(parser, &e);
+                if (r < 0)
+                        return r;
+
+                if (e.type == YAML_MAPPING_START_EVENT || e.type == YAML_SEQUENCE_START_EVENT)
+                        depth++;
+                else if (e.type == YAML_MAPPING_END_EVENT || e.type == YAML_SEQUENCE_END_EVENT)
+                        depth--;
+        }
+
+        return 0;
+}
+
+/* Consumes the rest of the node that started with 'first' */
+static int yaml_stream_skip(yaml_parser_t *parser, const yaml_event_t *first) {
+        assert(parser);
+        assert(first);
+
+        if (first->type != YAML_MAPPING_START_EVENT && first->type != YAML_SEQUENCE_START_EVENT)
+                return 0;
+
+        return yaml_stream_skip_rest(parser);
+}
+
+static int yaml_stream_anchor(GHashTable *anchors, const yaml_char_t *anchor, int id) {
+        if (anchor)
+                g_hash_table_replace(anchors, g_strdup((const char *) anchor), GINT_TO_POINTER(id));
+
+        return id;
+}
+
+/* Copies the node that started with 'first' into 'doc', returns its id */
+static int yaml_stream_add_node(yaml_parser_t *parser, const yaml_event_t *first, yaml_document_t *doc, GHashTable *anchors) {
+        int id, r;
+
+        assert(parser);
+        assert(first);
+        assert(doc);
+        assert(anchors);
+
+        switch (first->type) {
+        case YAML_SCALAR_EVENT:
+                id = yaml_document_add_scalar(doc, first->data.scalar.tag, first->data.scalar.value,
+                                              first->data.scalar.length, first->data.scalar.style);
+                if (id == 0)
+                        return log_oom();
+
+                return yaml_stream_anchor(anchors, first->data.scalar.anchor, id);
+
+        case YAML_ALIAS_EVENT:
+                id = GPOINTER_TO_INT(g_hash_table_lookup(anchors, first->data.alias.anchor));
+                if (id == 0)
+                        /* Defined outside of this interface's entry */
+                        return -EOPNOTSUPP;
+
+                return id;
+
+        case YAML_SEQUENCE_START_EVENT:
+                id = yaml_document_add_sequence(doc, first->data.sequence_start.tag, first->data.sequence_start.style);
+                if (id == 0)
+                        return log_oom();
+
+                (void) yaml_stream_anchor(anchors, first->data.sequence_start.anchor, id);
+
+                for (;;) {
+                        _cleanup_(yaml_event_deletep) yaml_event_t e = {};
+                        int item;
+
+                        r = yaml_stream_next(parser, &e);
+                        if (r < 0)
+                                return r;
+
+                        if (e.type == YAML_SEQUENCE_END_EVENT)
+                                return id;
+
+                        item = yaml_stream_add_node(parser, &e, doc, anchors);
+                        if (item < 0)
+                                return item;
+
+                        if (!yaml_document_append_sequence_item(doc, id, item))
+                                return log_oom();
+                }
+
+        case YAML_MAPPING_START_EVENT:
+                id = yaml_document_add_mapping(doc, first->data.mapping_start.tag, first->data.mapping_start.style);
+                if (id == 0)
+                        return log_oom();
+
+                (void) yaml_stream_anchor(anchors, first->data.mapping_start.anchor, id);
+
+                for (;;) {
+                        _cleanup_(yaml_event_deletep) yaml_event_t k = {}, v = {};
+                        int key, value;
+
+                        r = yaml_stream_next(parser, &k);
+                        if (r < 0)
+                                return r;
+
+                        if (k.type == YAML_MAPPING_END_EVENT)
+                                return id;
+
+                        key = yaml_stream_add_node(parser, &k, doc, anchors);
+                        if (key < 0)
+                                return key;
+
+                        r = yaml_stream_next(parser, &v);
+                        if (r < 0)
+                                return r;
+
+                        value = yaml_stream_add_node(parser, &v, doc, anchors);
+                        if (value < 0)
+                                return value;
+
+                        if (!yaml_document_append_mapping_pair(doc, id, key, value))
+                                return log_oom();
+                }
+
+        default:
+                return -EINVAL;
+        }
+}
+
+/* Parses one interface of an "ethernets:" or netdev section. The entry is copied into a document of its own,
+ * "<section>: { <name>: <entry> }", which the node based parsers fill the Network from and which is freed
+ * right after. So memory stays bounded by the largest interface, not by the size of the file. */
+static int yaml_stream_parse_entry(YAMLManager *m, yaml_parser_t *parser, const char *section,
+                                   const yaml_event_t *name, Networks *networks) {
+        _auto_cleanup_hash_ GHashTable *anchors = NULL;
+        _cleanup_(yaml_event_deletep) yaml_event_t v = {};
+        int root, sec, key, value, r;
+        yaml_document_t doc;
+
+        anchors = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+        if (!anchors)
+                return log_oom();
+
+        r = yaml_stream_next(parser, &v);
+        if (r < 0)
+                return r;
+
+        if (!yaml_document_initialize(&doc, NULL, NULL, NULL, 1, 1))
+                return log_oom();
+
+        root = yaml_document_add_mapping(&doc, NULL, YAML_ANY_MAPPING_STYLE);
+        sec = yaml_document_add_mapping(&doc, NULL, YAML_ANY_MAPPING_STYLE);
+        key = yaml_document_add_scalar(&doc, NULL, (yaml_char_t *) section, -1, YAML_ANY_SCALAR_STYLE);
+        if (root == 0 || sec == 0 || key == 0 || !yaml_document_append_mapping_pair(&doc, root, key, sec)) {
+                yaml_document_delete(&doc);
+                return log_oom();
+        }
+
+        key = yaml_stream_add_node(parser, name, &doc, anchors);
+        value = key < 0 ? key : yaml_stream_add_node(parser, &v, &doc, anchors);
+        if (value < 0) {
+                yaml_document_delete(&doc);
+                return value;
+        }
+
+        if (!yaml_document_append_mapping_pair(&doc, sec, key, value)) {
+                yaml_document_delete(&doc);
+                return log_oom();
+        }
+
+        r = yaml_parse_document(m, &doc, networks);
+        yaml_document_delete(&doc);
+        return r;
+}
+
+/* Like yaml_parse_section(), the interfaces following one that fails are not parsed. The error is returned
+ * once the whole section is consumed. */
+static int yaml_stream_parse_section(YAMLManager *m, yaml_parser_t *parser, const char *section,
+                                     const yaml_event_t *first, Networks *networks) {
+        int r, q;
+
+        /* The interfaces are in the anchored node */
+        if (first->type == YAML_ALIAS_EVENT)
+                return -EOPNOTSUPP;
+
+        if (first->type != YAML_MAPPING_START_EVENT)
+                return yaml_stream_skip(parser, first);
+
+        for (;;) {
+                _cleanup_(yaml_event_deletep) yaml_event_t k = {};
+
+                r = yaml_stream_next(parser, &k);
+                if (r < 0)
+                        return r;
+
+                if (k.type == YAML_MAPPING_END_EVENT)
+                        return 0;
+
+                r = yaml_stream_parse_entry(m, parser, section, &k, networks);
+                if (r < 0) {
+                        if (yaml_stream_fatal(parser, r))
+                                return r;
+
+                        q = yaml_stream_skip_rest(parser);
+                        return q < 0 ? q : r;
+                }
+        }
+}
+
+/* The streaming counterpart of yaml_parse_node(). Errors below the node are dropped, except for a failing
+ * section right in it, which ends the node. Either way the whole node is consumed unless the error is fatal. */
+static int yaml_stream_parse_node(YAMLManager *m, yaml_parser_t *parser, const yaml_event_t *first, Networks *networks) {
+        int r, q;
+
+        assert(m);
+        assert(parser);
+        assert(first);
+        assert(networks);
+
+        switch (first->type) {
+        case YAML_SEQUENCE_START_EVENT:
+                for (;;) {
+                        _cleanup_(yaml_event_deletep) yaml_event_t e = {};
+
+                        r = yaml_stream_next(parser, &e);
+                        if (r < 0)
+                                return r;
+
+                        if (e.type == YAML_SEQUENCE_END_EVENT)
+                                return 0;
+
+                        r = yaml_stream_parse_node(m, parser, &e, networks);
+                        if (r < 0 && yaml_stream_fatal(parser, r))
+                                return r;
+                }
+
+        case YAML_MAPPING_START_EVENT:
+                for (;;) {
+                        _cleanup_(yaml_event_deletep) yaml_event_t k = {}, v = {};
+                        const char *key;
+
+                        r = yaml_stream_next(parser, &k);
+                        if (r < 0)
+                                return r;
+
+                        if (k.type == YAML_MAPPING_END_EVENT)
+                                return 0;
+
+                        /* Complex keys are not ours */
+                        if (k.type != YAML_SCALAR_EVENT) {
+                                r = yaml_stream_skip(parser, &k);
+                                if (r < 0)
+                                        return r;
+                        }
+
+                        r = yaml_stream_next(parser, &v);
+                        if (r < 0)
+                                return r;
+
+                        key = k.type == YAML_SCALAR_EVENT ? (const char *) k.data.scalar.value : NULL;
+                        if (key && (streq(key, "ethernets") || is_yaml_netdev_kind(key))) {
+                                r = yaml_stream_parse_section(m, parser, key, &v, networks);
+                                if (r < 0) {
+                                        if (yaml_stream_fatal(parser, r))
+                                                return r;
+
+                                        q = yaml_stream_skip_rest(parser);
+                                        return q < 0 ? q : r;
+                                }
+                        } else {
+                                r = yaml_stream_parse_node(m, parser, &v, networks);
+                                if (r < 0 && yaml_stream_fatal(parser, r))
+                                        return r;
+                        }
+                }
+
+        case YAML_ALIAS_EVENT:
+                /* Sections may hide in the anchored node */
+                return -EOPNOTSUPP;
+
+        default:
+                return 0;
+        }
+}
+
+/* As in yaml_load_documents(), the result is that of the last document */
+static int yaml_stream_documents(YAMLManager *m, yaml_parser_t *parser, Networks *networks) {
+        int r, ret = 0;
+
+        assert(m);
+        assert(parser);
+        assert(networks);
+
+        for (;;) {
+                _cleanup_(yaml_event_deletep) yaml_event_t e = {};
+
+                r = yaml_stream_next(parser, &e);
+                if (r < 0)
+                        return r;
+
+                switch (e.type) {
+                case YAML_STREAM_END_EVENT:
+                        return ret;
+                case YAML_STREAM_START_EVENT:
+                case YAML_DOCUMENT_START_EVENT:
+                case YAML_DOCUMENT_END_EVENT:
+                        break;
+                default:
+                        r = yaml_stream_parse_node(m, parser, &e, networks);
+                        if (r < 0 && yaml_stream_fatal(parser, r))
+                                return r;
+
+                        ret = r;
+                }
+        }
+}
+
+static int yaml_parse_stream(YAMLManager *m, FILE *f, bool stream, Networks **ret) {
+        _cleanup_(networks_freep) Networks *networks = NULL;
+        yaml_parser_t parser;
+        int r;
+
+        assert(m);
+        assert(f);
+        assert(ret);
+
+        r = networks_new(&networks);
+        if (r < 0)
+                return r;
+
+        assert(yaml_parser_initialize(&parser));
+        yaml_parser_set_input_file(&parser, f);
+
+        if (stream)
+                r = yaml_stream_documents(m, &parser, networks);
+        else
+                r = yaml_load_documents(m, &parser, networks);
+
+        yaml_parser_delete(&parser);
+        if (r < 0)
+                return r;
+
+        *ret = steal_ptr(networks);
+        return 0;
+}
+
+int yaml_parse_file(const char *file, Networks **n) {
+        _cleanup_(yaml_manager_freep) YAMLManager *m = NULL;
+        _auto_cleanup_fclose_ FILE *f = NULL;
+        int r;
+
         assert(file);
         assert(n);
 
@@ -88,31 +551,122 @@ int yaml_parse_file(const char *file, Networks **n) {
                 return -errno;
         }
 
-        assert(yaml_parser_initialize(&parser));
-        yaml_parser_set_input_file(&parser, f);
+        /* Interfaces are filled while the file is read, without building the whole document first */
+        r = yaml_parse_stream(m, f, true, n);
+        if (r != -EOPNOTSUPP)
+                return r;
+
+        /* Aliases to anchors outside of an interface need the whole document */
+        log_debug("'%s' refers to anchors across interfaces, loading it as a whole", file);
+
+        rewind(f);
+        return yaml_parse_stream(m, f, false, n);
+}
+
+typedef struct YAMLParseJob {
+        const char *file;
+        Networks *networks;
+        int r;
+} YAMLParseJob;
+
+static void yaml_parse_job(gpointer data, gpointer userdata) {
+        YAMLParseJob *j = data;
+
+        j->r = yaml_parse_file(j->file, &j->networks);
+}
+
+/* Moves the networks of 'other' into 'n'. A network of the same name is replaced, the later file wins. */
+static void networks_merge(Networks *n, Networks *other, const char *file) {
+        GHashTableIter iter;
+        gpointer k, v;
+
+        assert(n);
+        assert(other);
+        assert(file);
+
+        g_hash_table_iter_init(&iter, other->networks);
+        while (g_hash_table_iter_next(&iter, &k, &v)) {
+                const char *old = g_hash_table_lookup(n->sources, k);
+                Network *replaced = g_hash_table_lookup(n->networks, k);
+
+                if (old && !streq(old, file)) {
+                        GPtrArray *files = g_hash_table_lookup(n->overridden, k);
+
+                        if (!files) {
+                                files = g_ptr_array_new_with_free_func(g_free);
+                                g_hash_table_insert(n->overridden, g_strdup(k), files);
+                        }
+
+                        g_ptr_array_add(files, g_strdup(old));
+                }
+
+                /* The table does not own its values, and the key is the name the replaced network holds */
+                g_hash_table_replace(n->networks, k, v);
+                network_free(replaced);
+
+                g_hash_table_replace(n->sources, g_strdup(k), g_strdup(file));
+        }
+
+        g_hash_table_steal_all(other->networks);
+}
+
+/* Parses the files on a thread pool, one file per job. The results are merged in the order of 'files', so the
+ * outcome does not depend on which parse finishes first. */
+int yaml_parse_files(char **files, Networks **ret) {
+        _cleanup_(networks_freep) Networks *networks = NULL;
+        _auto_cleanup_ YAMLParseJob *jobs = NULL;
+        GThreadPool *pool = NULL;
+        size_t n;
+        int r;
+
+        assert(ret);
 
         r = networks_new(&networks);
         if (r < 0)
                 return r;
 
-        for (;!done;) {
-                if (!yaml_parser_load(&parser, &document)) {
-                        r = -EINVAL;
-                        break;
+        n = files ? g_strv_length(files) : 0;
+        if (n == 0) {
+                *ret = steal_ptr(networks);
+                return 0;
+        }
+
+        jobs = new0(YAMLParseJob, n);
+        if (!jobs)
+                return log_oom();
+
+        for (size_t i = 0; i < n; i++)
+                jobs[i].file = files[i];
+
+        if (n > 1)
+                pool = g_thread_pool_new(yaml_parse_job, NULL, MIN(n, g_get_num_processors()), false, NULL);
+        if (pool) {
+                for (size_t i = 0; i < n; i++)
+                        g_thread_pool_push(pool, &jobs[i], NULL);
+
+                /* Waits for all jobs */
+                g_thread_pool_free(pool, false, true);
+        } else
+                for (size_t i = 0; i < n; i++)
+                        yaml_parse_job(&jobs[i], NULL);
+
+        r = 0;
+        for (size_t i = 0; i < n; i++) {
+                if (r >= 0 && jobs[i].r < 0) {
+                        log_warning("Failed to parse configuration file '%s': %s", jobs[i].file, strerror(-jobs[i].r));
+                        r = jobs[i].r;
                 }
 
-                done = !yaml_document_get_root_node(&document);
-                if (!done)
-                        r = yaml_parse_document(m, &document, networks);
+                if (r >= 0)
+                        networks_merge(networks, jobs[i].networks, jobs[i].file);
 
-                yaml_document_delete(&document);
+                networks_free(jobs[i].networks);
         }
+        if (r < 0)
+                return r;
 
-        yaml_parser_delete(&parser);
-        if (r >= 0)
-                *n = steal_ptr(networks);
-
-        return r;
+        *ret = steal_ptr(networks);
+        return 0;
 }
 
 void networks_free(Networks *n) {
@@ -120,6 +674,10 @@ void networks_free(Networks *n) {
                 return;
 
         g_hash_table_unref(n->networks);
+        if (n->sources)
+                g_hash_table_unref(n->sources);
+        if (n->overridden)
+                g_hash_table_unref(n->overridden);
         free(n);
 }
 
@@ -131,7 +689,9 @@ int networks_new(Networks **ret) {
                 return log_oom();
 
         n->networks = g_hash_table_new(g_str_hash, g_str_equal);
-        if (!n->networks)
+        n->sources = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+        n->overridden = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+        if (!n->networks || !n->sources || !n->overridden)
              return log_oom();
 
         *ret = steal_ptr(n);
@@ -9,6 +9,8 @@
 
 typedef struct Networks {
     GHashTable *networks;
+    GHashTable *sources;    /* ifname -> YAML file, filled by yaml_parse_files() */
+    GHashTable *overridden; /* ifname -> GPtrArray of the earlier YAML files a later one overrides */
 } Networks;
 
 int networks_new(Networks **ret);
@@ -51,3 +53,4 @@ static inline const char *scalar(const yaml_node_t *node) {
 }
 
 int yaml_parse_file(const char *yaml_file, Networks **n);
+int yaml_parse_files(char **files, Networks **ret);
@@ -44,11 +44,7 @@ const char *yaml_netdev_kind_to_name(YAMLNetDevKind id) {
 int yaml_netdev_name_to_kind(const char *name) {
         assert(name);
 
-        for (size_t i = YAML_NETDEV_KIND_VLAN; i < (int) ELEMENTSOF(yaml_netdev_kind_table); i++)
-                if (yaml_netdev_kind_table[i] && streq_fold(name, yaml_netdev_kind_table[i]))
-                        return i;
-
-        return _YAML_NETDEV_KIND_INVALID;
+        return string_table_lookup(yaml_netdev_kind_table, ELEMENTSOF(yaml_netdev_kind_table), name);
 }
 
 bool is_yaml_netdev_kind(const char *s) {
@@ -265,7 +265,7 @@ static int parse_route(GHashTable *config, yaml_document_t *dp, yaml_node_t *nod
         }
 
         if (rt) {
-                g_hash_table_insert(network->routes, rt, rt);
+                g_hash_table_replace(network->routes, rt, rt);
 
                 network->modified = true;
                 steal_ptr(rt);
@@ -336,14 +336,16 @@ static int parse_address(YAMLManager *m, yaml_document_t *dp, yaml_node_t *node,
                                 steal_ptr(*addr);
                         }
 
-                        set_add(network->addresses, address);
-                        steal_ptr(address);
+                        if (!set_contains(network->addresses, address)) {
+                                set_add(network->addresses, address);
+                                steal_ptr(address);
+                        }
 
                         network->modified = true;
 
                         if (v) {
                                 r = parse_address_from_str_and_add(scalar(v), network->addresses);
-                                if (r < 0)
+                                if (r < 0 && r != -EEXIST)
                                         log_debug("Failed to parse address='%s': %s", scalar(v), strerror(-r));
                         }
                 }
@@ -403,7 +405,7 @@ static int parse_routing_policy_rule(GHashTable *config, yaml_document_t *dp, ya
         }
 
         if (rule) {
-                g_hash_table_insert(network->routing_policy_rules, rule, rule);
+                g_hash_table_replace(network->routing_policy_rules, rule, rule);
 
                 network->modified = true;
                 steal_ptr(rule);
@@ -53,11 +53,7 @@ const char *conf_type_to_name(int id) {
 int conf_type_to_mode(const char *name) {
         assert(name);
 
-        for (size_t i = CONF_TYPE_MATCH; i < (size_t) ELEMENTSOF(conf_type_table); i++)
-                if (streq_fold(name, conf_type_table[i]))
-                        return i;
-
-        return _CONF_TYPE_INVALID;
+        return string_table_lookup(conf_type_table, ELEMENTSOF(conf_type_table), name);
 }
 
 int parse_yaml_bool(const char *key,
@@ -0,0 +1,420 @@
+/* Copyright 2024 VMware, Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <ctype.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc-util.h"
+#include "log.h"
+#include "string-util.h"
+#include "yaml-manager.h"
+#include "yaml-template.h"
+
+typedef struct YAMLTemplateScalar {
+        yaml_node_t *node;
+
+        /* What the document held, put back by yaml_template_free() */
+        yaml_char_t *value;
+        size_t length;
+
+        char *expanded;
+} YAMLTemplateScalar;
+
+/* Parses "{first..last}" at the start of 's', returns its length or 0 */
+static size_t yaml_template_range_at(const char *s, unsigned *ret_first, unsigned *ret_last) {
+        unsigned long first, last;
+        char *p;
+
+        if (s[0] != '{' || !isdigit((unsigned char) s[1]))
+                return 0;
+
+        first = strtoul(s + 1, &p, 10);
+        if (!string_has_prefix(p, "..") || !isdigit((unsigned char) p[2]))
+                return 0;
+
+        last = strtoul(p + 2, &p, 10);
+        if (*p != '}' || first > UINT_MAX || last > UINT_MAX)
+                return 0;
+
+        *ret_first = first;
+        *ret_last = last;
+        return p + 1 - s;
+}
+
+static int yaml_template_range(const char *s, size_t *ret_offset, size_t *ret_length, unsigned *ret_first, unsigned *ret_last) {
+        unsigned first, last;
+
+        for (const char *p = strchr(s, '{'); p; p = strchr(p + 1, '{')) {
+                size_t l;
+
+                l = yaml_template_range_at(p, &first, &last);
+                if (l == 0)
+                        continue;
+
+                if (first > last || last - first >= YAML_TEMPLATE_RANGE_MAX) {
+                        log_warning("Invalid range in '%s', expected {first..last} with at most %d numbers", s, YAML_TEMPLATE_RANGE_MAX);
+                        return -ERANGE;
+                }
+
+                *ret_offset = p - s;
+                *ret_length = l;
+                *ret_first = first;
+                *ret_last = last;
+                return 1;
+        }
+
+        return 0;
+}
+
+/* Returns 1 and the bounds if 's' holds "{first..last}", 0 if not */
+int yaml_template_find_range(const char *s, unsigned *ret_first, unsigned *ret_last) {
+        size_t offset, length;
+
+        assert(s);
+        assert(ret_first);
+        assert(ret_last);
+
+        return yaml_template_range(s, &offset, &length, ret_first, ret_last);
+}
+
+/* Evaluates the placeholder at the start of 's'. A range stands for n, "{n}" is n, and "{n/256}", "{n%256}",
+ * "{n+1}", "{n/256%256}" ... apply +, -, *, / and % from left to right. Returns its length or 0. */
+static int yaml_template_eval(const char *s, unsigned n, unsigned *ret, size_t *ret_length) {
+        unsigned first, last, v = n;
+        const char *p;
+        size_t l;
+
+        *ret_length = 0;
+
+        l = yaml_template_range_at(s, &first, &last);
+        if (l > 0) {
+                *ret = n;
+                *ret_length = l;
+                return 0;
+        }
+
+        if (s[0] != '{' || s[1] != 'n')
+                return 0;
+
+        for (p = s + 2; *p != '}'; ) {
+                unsigned long k;
+                char *end;
+
+                if (!*p || !strchr("+-*/%", *p) || !isdigit((unsigned char) p[1]))
+                        return 0;
+
+                errno = 0;
+                k = strtoul(p + 1, &end, 10);
+                if (errno == ERANGE || k > UINT_MAX) {
+                        log_warning("'%s' is out of range", s);
+                        return -ERANGE;
+                }
+
+                switch (*p) {
+                case '+':
+                        /* Would wrap around to a small number */
+                        if (k > UINT_MAX - v) {
+                                log_warning("'%s' is out of range for n=%u", s, n);
+                                return -ERANGE;
+                        }
+
+                        v += k;
+                        break;
+                case '-':
+                        /* Would wrap around to a huge number */
+                        if (k > v) {
+                                log_warning("'%s' is below zero for n=%u", s, n);
+                                return -ERANGE;
+                        }
+
+                        v -= k;
+                        break;
+                case '*':
+                        if (k > 0 && v > UINT_MAX / k) {
+                                log_warning("'%s' is out of range for n=%u", s, n);
+                                return -ERANGE;
+                        }
+
+                        v *= k;
+                        break;
+                case '/':
+                case '%':
+                        if (k == 0) {
+                                log_warning("Division by zero in '%s'", s);
+                                return -EINVAL;
+                        }
+
+                        v = *p == '/' ? v / k : v % k;
+                        break;
+                }
+
+                p = end;
+        }
+
+        *ret = v;
+        *ret_length = p + 1 - s;
+        return 0;
+}
+
+/* Replaces the placeholders in 's' with their value for n. Braces that are not placeholders are kept. */
+int yaml_template_expand(const char *s, unsigned n, char **ret) {
+        _cleanup_(g_string_unrefp) GString *e = NULL;
+        int r;
+
+        assert(s);
+        assert(ret);
+
+        e = g_string_new(NULL);
+        if (!e)
+                return log_oom();
+
+        for (const char *p = s; *p; ) {
+                unsigned v;
+                size_t l;
+
+                r = yaml_template_eval(p, n, &v, &l);
+                if (r < 0)
+                        return r;
+
+                if (l == 0) {
+                        g_string_append_c(e, *p++);
+                        continue;
+                }
+
+                g_string_append_printf(e, "%u", v);
+                p += l;
+        }
+
+        *ret = g_string_free(steal_ptr(e), false);
+        return 0;
+}
+
+static int yaml_template_expand_sequence(yaml_document_t *dp, int id) {
+        _cleanup_(g_array_unrefp) GArray *items = NULL;
+        yaml_node_item_t *p;
+        bool found = false;
+        yaml_node_t *node;
+        size_t n;
+        int r;
+
+        node = yaml_document_get_node(dp, id);
+        n = node->data.sequence.items.top - node->data.sequence.items.start;
+
+        for (size_t i = 0; i < n; i++) {
+                yaml_node_t *item = yaml_document_get_node(dp, node->data.sequence.items.start[i]);
+                unsigned first, last;
+
+                if (item && item->type == YAML_SCALAR_NODE && yaml_template_find_range(scalar(item), &first, &last) != 0) {
+                        found = true;
+                        break;
+                }
+        }
+
+        if (!found)
+                return 0;
+
+        items = g_array_new(false, false, sizeof(yaml_node_item_t));
+        if (!items)
+                return log_oom();
+
+        for (size_t i = 0; i < n; i++) {
+                size_t offset, length;
+                yaml_scalar_style_t style;
+                unsigned first, last;
+                yaml_node_item_t k;
+                yaml_node_t *item;
+                const char *s;
+
+                /* Adding nodes may move them, look the sequence up again */
+                node = yaml_document_get_node(dp, id);
+                k = node->data.sequence.items.start[i];
+
+                item = yaml_document_get_node(dp, k);
+                if (!item || item->type != YAML_SCALAR_NODE) {
+                        g_array_append_val(items, k);
+                        continue;
+                }
+
+                s = scalar(item);
+                style = item->data.scalar.style;
+
+                r = yaml_template_range(s, &offset, &length, &first, &last);
+                if (r < 0)
+                        return r;
+                if (r == 0) {
+                        g_array_append_val(items, k);
+                        continue;
+                }
+
+                for (unsigned long v = first; v <= last; v++) {
+                        _auto_cleanup_ char *e = NULL;
+
+                        e = g_strdup_printf("%.*s%lu%s", (int) offset, s, v, s + offset + length);
+                        if (!e)
+                                return log_oom();
+
+                        k = yaml_document_add_scalar(dp, NULL, (yaml_char_t *) e, -1, style);
+                        if (k == 0)
+                                return log_oom();
+
+                        g_array_append_val(items, k);
+                }
+        }
+
+        /* libyaml releases the item stack with free() */
+        p = malloc(items->len * sizeof(yaml_node_item_t));
+        if (!p)
+                return log_oom();
+
+        memcpy(p, items->data, items->len * sizeof(yaml_node_item_t));
+
+        node = yaml_document_get_node(dp, id);
+        free(node->data.sequence.items.start);
+        node->data.sequence.items.start = p;
+        node->data.sequence.items.top = node->data.sequence.items.end = p + items->len;
+
+        return 0;
+}
+
+/* Turns list items such as "10.0.0.{1..100}/24" into one item per number */
+int yaml_template_expand_ranges(yaml_document_t *dp) {
+        int r;
+
+        assert(dp);
+
+        for (int id = 1; ; id++) {
+                yaml_node_t *node = yaml_document_get_node(dp, id);
+
+                if (!node)
+                        return 0;
+
+                if (node->type != YAML_SEQUENCE_NODE || node->data.sequence.items.start == node->data.sequence.items.top)
+                        continue;
+
+                r = yaml_template_expand_sequence(dp, id);
+                if (r < 0)
+                        return r;
+        }
+}
+
+static int yaml_template_collect(yaml_document_t *dp, yaml_node_t *node, GHashTable *seen, GArray *scalars) {
+        int r;
+
+        if (!node || !g_hash_table_add(seen, node))
+                return 0;
+
+        switch (node->type) {
+        case YAML_SCALAR_NODE:
+                if (strchr(scalar(node), '{')) {
+                        YAMLTemplateScalar s = {
+                                .node = node,
+                                .value = node->data.scalar.value,
+                                .length = node->data.scalar.length,
+                        };
+
+                        g_array_append_val(scalars, s);
+                }
+                break;
+        case YAML_SEQUENCE_NODE:
+                for (yaml_node_item_t *i = node->data.sequence.items.start; i < node->data.sequence.items.top; i++) {
+                        r = yaml_template_collect(dp, yaml_document_get_node(dp, *i), seen, scalars);
+                        if (r < 0)
+                                return r;
+                }
+                break;
+        case YAML_MAPPING_NODE:
+                for (yaml_node_pair_t *p = node->data.mapping.pairs.start; p < node->data.mapping.pairs.top; p++) {
+                        r = yaml_template_collect(dp, yaml_document_get_node(dp, p->key), seen, scalars);
+                        if (r < 0)
+                                return r;
+
+                        r = yaml_template_collect(dp, yaml_document_get_node(dp, p->value), seen, scalars);
+                        if (r < 0)
+                                return r;
+                }
+                break;
+        default:
+                break;
+        }
+
+        return 0;
+}
+
+/* Remembers the scalars of an entry, its name included, that hold a placeholder */
+int yaml_template_new(yaml_document_t *dp, const yaml_node_pair_t *entry, YAMLTemplate **ret) {
+        _cleanup_(yaml_template_freep) YAMLTemplate *t = NULL;
+        _auto_cleanup_hash_ GHashTable *seen = NULL;
+        int r;
+
+        assert(dp);
+        assert(entry);
+        assert(ret);
+
+        seen = g_hash_table_new(g_direct_hash, g_direct_equal);
+        if (!seen)
+                return log_oom();
+
+        t = new(YAMLTemplate, 1);
+        if (!t)
+                return log_oom();
+
+        *t = (YAMLTemplate) {
+                .scalars = g_array_new(false, false, sizeof(YAMLTemplateScalar)),
+        };
+        if (!t->scalars)
+                return log_oom();
+
+        r = yaml_template_collect(dp, yaml_document_get_node(dp, entry->key), seen, t->scalars);
+        if (r < 0)
+                return r;
+
+        r = yaml_template_collect(dp, yaml_document_get_node(dp, entry->value), seen, t->scalars);
+        if (r < 0)
+                return r;
+
+        *ret = steal_ptr(t);
+        return 0;
+}
+
+/* Points the remembered scalars at their text for n */
+int yaml_template_apply(YAMLTemplate *t, unsigned n) {
+        int r;
+
+        assert(t);
+
+        for (guint i = 0; i < t->scalars->len; i++) {
+                YAMLTemplateScalar *s = &g_array_index(t->scalars, YAMLTemplateScalar, i);
+                char *e;
+
+                r = yaml_template_expand((const char *) s->value, n, &e);
+                if (r < 0)
+                        return r;
+
+                free(s->expanded);
+                s->expanded = e;
+                s->node->data.scalar.value = (yaml_char_t *) e;
+                s->node->data.scalar.length = strlen(e);
+        }
+
+        return 0;
+}
+
+void yaml_template_free(YAMLTemplate *t) {
+        if (!t)
+                return;
+
+        for (guint i = 0; t->scalars && i < t->scalars->len; i++) {
+                YAMLTemplateScalar *s = &g_array_index(t->scalars, YAMLTemplateScalar, i);
+
+                s->node->data.scalar.value = s->value;
+                s->node->data.scalar.length = s->length;
+                free(s->expanded);
+        }
+
+        if (t->scalars)
+                g_array_unref(t->scalars);
+        free(t);
+}
@@ -0,0 +1,27 @@
+/* Copyright 2024 VMware, Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <glib.h>
+#include <yaml.h>
+
+#include "alloc-util.h"
+
+/* Most interfaces or list items a single "{first..last}" may stand for */
+#define YAML_TEMPLATE_RANGE_MAX 65536
+
+typedef struct YAMLTemplate {
+        GArray *scalars;
+} YAMLTemplate;
+
+void yaml_template_free(YAMLTemplate *t);
+DEFINE_CLEANUP(YAMLTemplate *, yaml_template_free);
+
+int yaml_template_find_range(const char *s, unsigned *ret_first, unsigned *ret_last);
+int yaml_template_expand(const char *s, unsigned n, char **ret);
+
+int yaml_template_expand_ranges(yaml_document_t *dp);
+
+int yaml_template_new(yaml_document_t *dp, const yaml_node_pair_t *entry, YAMLTemplate **ret);
+int yaml_template_apply(YAMLTemplate *t, unsigned n);
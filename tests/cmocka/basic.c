@@ -13,6 +13,7 @@
 #include "file-util.h"
 #include "log.h"
 #include "macros.h"
+#include "ncm-context.h"
 #include "parse-util.h"
 #include "set-network.h"
 #include "shared.h"
@@ -2072,6 +2073,12 @@ int main(void) {
         cmocka_unit_test (test_none_ipv4_dhcp_ipv6_dhcp_dns),
         cmocka_unit_test (test_none_ipv4_auto_ipv6_dhcp_dns),
         cmocka_unit_test (test_none_ipv4_static_ipv6_static_dns),
+        /* library context API */
+        cmocka_unit_test (test_ncm_context_new_free),
+        cmocka_unit_test (test_ncm_context_batch),
+        cmocka_unit_test (test_ncm_context_get_link),
+        cmocka_unit_test (test_ncm_context_link_set_mtu),
+        cmocka_unit_test (test_ncm_context_state_cache_handler),
 };
 
         int count_fail_tests = cmocka_run_group_tests (tests, setup, teardown);
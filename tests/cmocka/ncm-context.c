@@ -0,0 +1,159 @@
+/* Copyright 2024 VMware, Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <network-config-manager.h>
+
+#include <net/if.h>
+
+#include "alloc-util.h"
+#include "config-parser.h"
+#include "file-util.h"
+#include "log.h"
+#include "macros.h"
+#include "ncm-context.h"
+#include "networkd-state-cache.h"
+#include "string-util.h"
+
+/* Not a link networkd knows, it ignores the state file */
+#define TEST_STATE_IFINDEX 999999
+#define TEST_STATE_FILE    "/run/systemd/netif/links/999999"
+
+static void on_state_changed(int ifindex, void *userdata) {
+        int *seen = userdata;
+
+        if (ifindex == TEST_STATE_IFINDEX)
+                (*seen)++;
+}
+
+/* Rewrites a state file and lets the cache deliver what inotify reported */
+static void state_file_touch(void) {
+        assert_true(g_file_set_contents(TEST_STATE_FILE, "ADMIN_STATE=unmanaged\n", -1, NULL));
+        assert_true(netif_state_cache_process() >= 0);
+
+        unlink(TEST_STATE_FILE);
+        assert_true(netif_state_cache_process() >= 0);
+}
+
+void test_ncm_context_new_free(void **state) {
+        NcmContext *a = NULL, *b = NULL;
+
+        assert_true(ncm_context_new(&a) >= 0);
+        assert_non_null(a);
+
+        assert_true(ncm_context_new(&b) >= 0);
+        assert_non_null(b);
+
+        if (!netif_state_cache_enabled()) {
+                ncm_context_free(b);
+                ncm_context_free(a);
+                skip();
+        }
+
+        /* The cache lives as long as any context does */
+        ncm_context_free(a);
+        assert_true(netif_state_cache_enabled());
+
+        ncm_context_free(b);
+        assert_false(netif_state_cache_enabled());
+
+        ncm_context_free(NULL);
+}
+
+void test_ncm_context_batch(void **state) {
+        NcmContext *ctx = NULL;
+
+        assert_true(ncm_context_new(&ctx) >= 0);
+
+        assert_true(ncm_context_begin(ctx) >= 0);
+        assert_true(ncm_context_begin(ctx) >= 0);
+        assert_true(ncm_context_commit(ctx) >= 0);
+        assert_true(ncm_context_commit(ctx) >= 0);
+
+        ncm_context_free(ctx);
+}
+
+void test_ncm_context_get_link(void **state) {
+        _cleanup_(ncm_link_freep) NcmLink *l = NULL;
+        _cleanup_(g_ptr_array_unrefp) GPtrArray *links = NULL;
+        NcmContext *ctx = NULL;
+        bool found = false;
+        int ifindex;
+
+        ifindex = if_nametoindex("test99");
+        assert_true(ifindex > 0);
+
+        assert_true(ncm_context_new(&ctx) >= 0);
+
+        assert_true(ncm_context_get_link(ctx, ifindex, &l) >= 0);
+        assert_int_equal(l->ifindex, ifindex);
+        assert_string_equal(l->name, "test99");
+
+        assert_true(ncm_context_get_links(ctx, &links) >= 0);
+        for (guint i = 0; i < links->len; i++) {
+                NcmLink *n = g_ptr_array_index(links, i);
+
+                if (n->ifindex == ifindex) {
+                        assert_string_equal(n->name, "test99");
+                        found = true;
+                }
+        }
+        assert_true(found);
+
+        assert_int_equal(ncm_context_get_link(ctx, 0, &l), -EINVAL);
+        assert_int_equal(ncm_context_get_link(ctx, TEST_STATE_IFINDEX, &l), -ENXIO);
+
+        ncm_context_free(ctx);
+}
+
+void test_ncm_context_link_set_mtu(void **state) {
+        _cleanup_(key_file_freep) KeyFile *key_file = NULL;
+        NcmContext *ctx = NULL;
+        int ifindex;
+
+        ifindex = if_nametoindex("test99");
+        assert_true(ifindex > 0);
+
+        assert_true(ncm_context_new(&ctx) >= 0);
+
+        assert_int_equal(ncm_context_link_set_mtu(ctx, ifindex, 0), -EINVAL);
+        assert_int_equal(ncm_context_link_set_mtu(ctx, TEST_STATE_IFINDEX, 1400), -ENXIO);
+
+        assert_true(ncm_context_link_set_mtu(ctx, ifindex, 1400) >= 0);
+
+        assert_true(parse_key_file("/etc/systemd/network/10-test99.network", &key_file) >= 0);
+        assert_true(key_file_config_exists(key_file, "Match", "Name", "test99"));
+        assert_true(key_file_config_exists(key_file, "Link", "MTUBytes", "1400"));
+
+        ncm_context_free(ctx);
+        unlink("/etc/systemd/network/10-test99.network");
+}
+
+/* A context neither replaces the handler an embedder installed nor tears the cache down under it */
+void test_ncm_context_state_cache_handler(void **state) {
+        NcmContext *ctx = NULL;
+        int seen = 0;
+
+        if (ncm_state_cache_enable(on_state_changed, &seen) < 0)
+                skip();
+
+        assert_true(ncm_context_new(&ctx) >= 0);
+
+        state_file_touch();
+        assert_true(seen > 0);
+
+        ncm_context_free(ctx);
+        assert_true(netif_state_cache_enabled());
+
+        seen = 0;
+        state_file_touch();
+        assert_true(seen > 0);
+
+        ncm_state_cache_disable(on_state_changed, &seen);
+        assert_false(netif_state_cache_enabled());
+}
@@ -0,0 +1,10 @@
+/* Copyright 2024 VMware, Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+void test_ncm_context_new_free(void **state);
+void test_ncm_context_batch(void **state);
+void test_ncm_context_get_link(void **state);
+void test_ncm_context_link_set_mtu(void **state);
+void test_ncm_context_state_cache_handler(void **state);
@@ -4,6 +4,9 @@
 
 import os
 import errno
+import pty
+import select
+import signal
 import sys
 import subprocess
 import json
@@ -61,7 +64,13 @@ units = ["10-test99.network",
          '10-wg99.netdev',
          '10-wg99.network',
          '10-eni99np1.network',
-         '10-test99.link']
+         '10-test99.link',
+         '10-vlan1000.netdev',
+         '10-vlan1000.network',
+         '10-vlan1001.netdev',
+         '10-vlan1001.network',
+         '10-vlan1002.netdev',
+         '10-vlan1002.network']
 
 def link_exist(link):
     return os.path.exists(os.path.join('/sys/class/net', link))
@@ -231,6 +240,13 @@ class TestNetworkConfigManagerYAML:
         "routing-policy-rule.yaml",
         "multiple-rt.yaml",
         "vlan.yaml",
+        "50-tenant-a.yaml",
+        "60-tenant-b.yaml",
+        "anchors.yaml",
+        "duplicate-addresses.yaml",
+        "vlan-range.yaml",
+        "bad-tunnel.yaml",
+        "section-alias.yaml",
     ]
 
     def copy_yaml_file_to_netmanager_yaml_path(self, config_file):
@@ -255,6 +271,80 @@ class TestNetworkConfigManagerYAML:
     def test_cmocka(self):
         subprocess.check_call("/usr/bin/nmctl-tests")
 
+    def test_multiple_files_later_file_wins(self):
+        self.copy_yaml_file_to_netmanager_yaml_path('50-tenant-a.yaml')
+        self.copy_yaml_file_to_netmanager_yaml_path('60-tenant-b.yaml')
+
+        subprocess.check_call("nmctl apply", shell = True)
+        assert(unit_exist('10-test99.network') == True)
+        assert(unit_exist('10-test98.network') == True)
+
+        parser = configparser.ConfigParser()
+        parser.read(os.path.join(networkd_unit_file_path, '10-test99.network'))
+        assert(parser.get('Link', 'MTUBytes') == '1500')
+
+        parser = configparser.ConfigParser()
+        parser.read(os.path.join(networkd_unit_file_path, '10-test98.network'))
+        assert(parser.get('Network', 'DHCP') == 'ipv4')
+
+    def test_anchor_shared_across_interfaces(self):
+        self.copy_yaml_file_to_netmanager_yaml_path('anchors.yaml')
+
+        subprocess.check_call("nmctl apply", shell = True)
+
+        for link in ['test99', 'test98']:
+            parser = configparser.ConfigParser()
+            parser.read(os.path.join(networkd_unit_file_path, '10-' + link + '.network'))
+            assert(parser.get('Link', 'MTUBytes') == '1400')
+
+    def test_anchored_section(self):
+        self.copy_yaml_file_to_netmanager_yaml_path('section-alias.yaml')
+
+        subprocess.check_call("nmctl apply", shell = True)
+
+        for link in ['test99', 'test98']:
+            parser = configparser.ConfigParser()
+            parser.read(os.path.join(networkd_unit_file_path, '10-' + link + '.network'))
+            assert(parser.get('Link', 'MTUBytes') == '1400')
+
+    def test_bad_netdev_does_not_fail_apply(self):
+        self.copy_yaml_file_to_netmanager_yaml_path('bad-tunnel.yaml')
+
+        # As when the file is loaded as a whole, an entry below network: that fails is dropped
+        subprocess.check_call("nmctl apply", shell = True)
+
+        parser = configparser.ConfigParser()
+        parser.read(os.path.join(networkd_unit_file_path, '10-test99.network'))
+        assert(parser.get('Link', 'MTUBytes') == '1400')
+
+        assert(unit_exist('10-tun99.netdev') == False)
+
+    def test_duplicate_addresses_collapse(self):
+        self.copy_yaml_file_to_netmanager_yaml_path('duplicate-addresses.yaml')
+
+        subprocess.check_call("nmctl apply", shell = True)
+
+        with open(os.path.join(networkd_unit_file_path, '10-test99.network')) as f:
+            addresses = sorted(l.split('=', 1)[1].strip() for l in f if l.startswith('Address='))
+
+        assert(addresses == ['10.0.0.1/16', '10.0.0.1/24', '10.0.0.2/24', '2001:db8::1/64'])
+
+    def test_vlan_range_template(self):
+        self.copy_yaml_file_to_netmanager_yaml_path('vlan-range.yaml')
+
+        subprocess.check_call("nmctl apply", shell = True)
+
+        for n in range(1000, 1003):
+            assert(unit_exist('10-vlan%d.netdev' % n) == True)
+
+            parser = configparser.ConfigParser()
+            parser.read(os.path.join(networkd_unit_file_path, '10-vlan%d.netdev' % n))
+            assert(parser.get('VLAN', 'Id') == str(n))
+
+            with open(os.path.join(networkd_unit_file_path, '10-vlan%d.network' % n)) as f:
+                addresses = sorted(l.split('=', 1)[1].strip() for l in f if l.startswith('Address='))
+            assert(addresses == ['10.%d.%d.1/24' % (n // 256, n % 256), '10.%d.%d.2/24' % (n // 256, n % 256)])
+
     def test_match_driver(self):
         self.copy_yaml_file_to_netmanager_yaml_path('match-driver.yaml')
 
@@ -571,6 +661,58 @@ class TestNetDevConfigManagerYAML:
 
         subprocess.call("nmctl remove-netdev br0 kind bridge", shell = True)
 
+    def test_netdev_apply_dry_run_and_removal(self):
+        self.copy_yaml_file_to_netmanager_yaml_path('bridge.yaml')
+
+        output = subprocess.check_output("nmctl apply --dry-run", text=True, shell = True)
+        assert('create ' + os.path.join(networkd_unit_file_path, '10-br0.netdev') in output)
+        assert(unit_exist('10-br0.netdev') == False)
+
+        subprocess.check_call("nmctl apply", shell = True)
+        assert(unit_exist('10-br0.netdev') == True)
+        mtime = os.path.getmtime(os.path.join(networkd_unit_file_path, '10-br0.netdev'))
+
+        output = subprocess.check_output("nmctl apply --dry-run", text=True, shell = True)
+        assert('No changes' in output)
+
+        subprocess.check_call("nmctl apply", shell = True)
+        assert(os.path.getmtime(os.path.join(networkd_unit_file_path, '10-br0.netdev')) == mtime)
+
+        self.remove_units_from_netmanager_yaml_path()
+
+        output = subprocess.check_output("nmctl apply --dry-run", text=True, shell = True)
+        assert('remove ' + os.path.join(networkd_unit_file_path, '10-br0.netdev') in output)
+        assert(unit_exist('10-br0.netdev') == True)
+
+        subprocess.check_call("nmctl apply", shell = True)
+        assert(unit_exist('10-br0.netdev') == False)
+        assert(unit_exist('10-br0.network') == False)
+
+    def test_netdev_apply_skips_unchanged_yaml(self):
+        self.copy_yaml_file_to_netmanager_yaml_path('bridge.yaml')
+
+        subprocess.check_call("nmctl apply", shell = True)
+        assert(unit_exist('10-br0.netdev') == True)
+
+        with open('/var/lib/network-config-manager/manifest') as f:
+            manifest = f.read()
+        assert('Hash=' in manifest)
+        assert('File=' + os.path.join(networkd_unit_file_path, '10-br0.netdev') + ' ' in manifest)
+
+        output = subprocess.check_output("nmctl apply --dry-run", text=True, shell = True)
+        assert('No changes' in output)
+
+        # The YAML file is unchanged, but a file generated from it is gone
+        os.remove(os.path.join(networkd_unit_file_path, '10-br0.netdev'))
+
+        output = subprocess.check_output("nmctl apply --dry-run", text=True, shell = True)
+        assert('create ' + os.path.join(networkd_unit_file_path, '10-br0.netdev') in output)
+
+        subprocess.check_call("nmctl apply", shell = True)
+        assert(unit_exist('10-br0.netdev') == True)
+
+        subprocess.call("nmctl remove-netdev br0 kind bridge", shell = True)
+
     def test_netdev_tunnel(self):
         self.copy_yaml_file_to_netmanager_yaml_path('tunnel.yaml')
 
@@ -798,6 +940,27 @@ class TestKernelCommandLine:
         assert(parser.get('Address', 'Address') == '192.168.1.34')
         assert(parser.get('Route', 'Gateway') == '192.168.1.1')
 
+    def test_network_kernel_command_line_generator(self):
+        ''' The systemd generator writes to /run/systemd/network '''
+
+        network = os.path.join('/run/systemd/network', '10-test99.network')
+        env = dict(os.environ, SYSTEMD_PROC_CMDLINE = 'ro  quiet ip=192.168.1.34::192.168.1.1:::test99:dhcp')
+
+        try:
+            subprocess.check_call(['/lib/systemd/system-generators/network-config-manager-generator'], env = env)
+            assert(os.path.exists(network) == True)
+            assert(unit_exist('10-test99.network') == False)
+
+            parser = configparser.ConfigParser()
+            parser.read(network)
+
+            assert(parser.get('Match', 'Name') == 'test99')
+            assert(parser.get('Network', 'DHCP') == 'ipv4')
+            assert(parser.get('Address', 'Address') == '192.168.1.34')
+        finally:
+            if os.path.exists(network):
+                os.remove(network)
+
 class TestCLINetwork:
     def setup_method(self):
         link_remove('test99')
@@ -820,9 +983,101 @@ class TestCLINetwork:
     def test_cli_link_status_json(self):
         subprocess.check_call("nmctl status -j", text=True, shell = True)
 
+    def test_cli_link_status_json_parse(self):
+        output = subprocess.check_output("nmctl status -j", text=True, shell = True)
+        json_object = json.loads(output)
+
+        links = [link["Name"] for link in json_object["Interfaces"]]
+        assert('test99' in links)
+
+        output = subprocess.check_output("nmctl status test99 -j", text=True, shell = True)
+        json_object = json.loads(output)
+        assert(json_object["Name"] == 'test99')
+
+        output = subprocess.check_output("nmctl show-addr dev test99 -j", text=True, shell = True)
+        json.loads(output)
+
+    def test_cli_link_status_json_fields(self):
+        output = subprocess.check_output("nmctl status test99 -j --fields=Name,MTU", text=True, shell = True)
+        json_object = json.loads(output)
+
+        assert(sorted(json_object.keys()) == ['MTU', 'Name'])
+        assert(json_object["Name"] == 'test99')
+
+        output = subprocess.check_output("nmctl status -j --fields=Name", text=True, shell = True)
+        json_object = json.loads(output)
+
+        assert(list(json_object.keys()) == ['Interfaces'])
+        assert({'Name': 'test99'} in json_object["Interfaces"])
+
+        output = subprocess.check_output("nmctl status test99 --fields=Name", text=True, shell = True)
+        assert('test99' in output)
+        assert('Network File' not in output)
+
+    def test_cli_link_status_cbor(self):
+        output = subprocess.check_output("nmctl status test99 --output=cbor --fields=Name", shell = True)
+
+        # self-describe tag, map of indefinite length, "Name": "test99", break
+        assert(output == bytes.fromhex('d9d9f7bf') + b'\x64Name' + b'\x66test99' + b'\xff')
+
+        r = subprocess.run("nmctl status test99 --output=xml", shell = True)
+        assert(r.returncode != 0)
+
+    def test_cli_link_status_watch_needs_terminal(self):
+        r = subprocess.run("nmctl status test99 --watch", stdout = subprocess.PIPE, shell = True, timeout = 10)
+        assert(r.returncode != 0)
+
+        r = subprocess.run("nmctl status-devs --watch", stdout = subprocess.PIPE, shell = True, timeout = 10)
+        assert(r.returncode != 0)
+
+    def test_cli_link_status_watch_shows_link_changes(self):
+        subprocess.check_call("ip link set dev test99 down", shell = True)
+
+        # --watch only draws on a terminal
+        master, slave = pty.openpty()
+        watch = subprocess.Popen(["nmctl", "status", "test99", "--watch"], stdin = slave, stdout = slave, stderr = slave)
+        os.close(slave)
+
+        def read_until(text, timeout = 10):
+            output = b''
+            deadline = time.time() + timeout
+            while text not in output and time.time() < deadline:
+                r, _, _ = select.select([master], [], [], 0.5)
+                if r:
+                    output += os.read(master, 4096)
+            return output
+
+        try:
+            assert(b'test99' in read_until(b'test99'))
+
+            subprocess.check_call("ip link set dev test99 up", shell = True)
+            subprocess.check_call("ip address add 192.168.77.1/24 dev test99", shell = True)
+
+            assert(b'192.168.77.1' in read_until(b'192.168.77.1'))
+        finally:
+            watch.send_signal(signal.SIGTERM)
+            assert(watch.wait(timeout = 10) == 0)
+            os.close(master)
+
     def test_cli_link_status_with_logs(self):
         subprocess.check_call("nmctl status 2 -l", text=True, shell = True)
 
+    def test_cli_logs_json(self):
+        output = subprocess.check_output("nmctl logs --json --since=-1d", text=True, shell = True)
+
+        cursor = None
+        for line in output.splitlines():
+            entry = json.loads(line)
+            assert('__CURSOR' in entry)
+            cursor = entry['__CURSOR']
+
+        if cursor is not None:
+            output = subprocess.check_output(f"nmctl logs --json --cursor='{cursor}'", text=True, shell = True)
+            assert(cursor not in output)
+
+        r = subprocess.run("nmctl logs --since=bogus", shell = True)
+        assert(r.returncode != 0)
+
     def test_cli_system_status(self):
         subprocess.check_call("nmctl", text=True, shell = True)
 
@@ -1169,6 +1424,103 @@ class TestCLINetwork:
         assert(parser.get('Match', 'Name') == 'test99')
         assert(parser.get('Link', 'MTUBytes') == '1400')
 
+    def test_cli_set_mtu_drop_in(self):
+        assert(link_exist('test99') == True)
+
+        subprocess.check_call("nmctl set-mtu dev test99 mtu 1400", shell = True)
+        subprocess.check_call("nmctl --drop-in set-mtu dev test99 mtu 1280", shell = True)
+
+        assert(unit_exist('10-test99.network') == True)
+        parser = configparser.ConfigParser()
+        parser.read(os.path.join(networkd_unit_file_path, '10-test99.network'))
+
+        assert(parser.get('Match', 'Name') == 'test99')
+        assert(parser.get('Link', 'MTUBytes') == '1400')
+
+        drop_in = os.path.join(networkd_unit_file_path, '10-test99.network.d')
+        parser = configparser.ConfigParser()
+        parser.read(os.path.join(drop_in, '50-nmctl-mtu.conf'))
+
+        assert(parser.get('Link', 'MTUBytes') == '1280')
+
+        subprocess.check_call("nmctl set-mtu dev test99 mtu 1500", shell = True)
+        assert(os.path.exists(os.path.join(drop_in, '50-nmctl-mtu.conf')) == False)
+
+        shutil.rmtree(drop_in, ignore_errors=True)
+
+    def test_cli_add_address_drop_in(self):
+        assert(link_exist('test99') == True)
+
+        subprocess.check_call("nmctl add-addr dev test99 a 192.168.1.45/24", shell = True)
+        subprocess.check_call("nmctl --drop-in add-addr dev test99 a 192.168.1.46/24", shell = True)
+        subprocess.check_call("nmctl --drop-in add-addr dev test99 a 192.168.1.45/24", shell = True)
+
+        assert(unit_exist('10-test99.network') == True)
+        parser = configparser.ConfigParser()
+        parser.read(os.path.join(networkd_unit_file_path, '10-test99.network'))
+
+        assert(parser.get('Address', 'Address') == '192.168.1.45/24')
+
+        # Addresses share one drop-in, the one the base file already has is not repeated
+        drop_in = os.path.join(networkd_unit_file_path, '10-test99.network.d')
+        parser = configparser.ConfigParser()
+        parser.read(os.path.join(drop_in, '50-nmctl-addresses.conf'))
+
+        assert(parser.get('Address', 'Address') == '192.168.1.46/24')
+
+        # A drop-in can not take back [Address] sections, removing edits both files
+        subprocess.check_call("nmctl remove-addr dev test99 a 192.168.1.45/24", shell = True)
+        subprocess.check_call("nmctl remove-addr dev test99 a 192.168.1.46/24", shell = True)
+        assert(os.path.exists(os.path.join(drop_in, '50-nmctl-addresses.conf')) == False)
+
+        parser = configparser.ConfigParser()
+        parser.read(os.path.join(networkd_unit_file_path, '10-test99.network'))
+        assert(parser.has_section('Address') == False)
+
+        shutil.rmtree(drop_in, ignore_errors=True)
+
+    def test_cli_remove_address_keeps_drop_in_directory(self):
+        assert(link_exist('test99') == True)
+
+        subprocess.check_call("nmctl add-addr dev test99 a 192.168.1.45/24", shell = True)
+
+        # Removing never creates a drop-in directory, nor deletes an empty one the user made
+        drop_in = os.path.join(networkd_unit_file_path, '10-test99.network.d')
+        subprocess.check_call("nmctl remove-addr dev test99 a 192.168.1.45/24", shell = True)
+        assert(os.path.exists(drop_in) == False)
+
+        subprocess.check_call("nmctl add-addr dev test99 a 192.168.1.45/24", shell = True)
+        os.mkdir(drop_in)
+        subprocess.check_call("nmctl remove-addr dev test99 a 192.168.1.45/24", shell = True)
+        assert(os.path.isdir(drop_in) == True)
+
+        shutil.rmtree(drop_in, ignore_errors=True)
+
+    def test_cli_batch(self):
+        assert(link_exist('test99') == True)
+
+        subprocess.run("nmctl --batch -", shell = True, check = True, text = True,
+                       input = "# provisioning\n"
+                               "set-mtu dev test99 mtu 1400\n"
+                               "\n"
+                               "set-link-group dev test99 group 2147483647\n")
+
+        assert(unit_exist('10-test99.network') == True)
+        parser = configparser.ConfigParser()
+        parser.read(os.path.join(networkd_unit_file_path, '10-test99.network'))
+
+        assert(parser.get('Match', 'Name') == 'test99')
+        assert(parser.get('Link', 'MTUBytes') == '1400')
+        assert(parser.get('Link', 'Group') == '2147483647')
+
+        r = subprocess.run("nmctl --batch -", shell = True, text = True,
+                           input = "set-mtu dev test99 mtu abc\nset-mtu dev test99 mtu 1500\n")
+        assert(r.returncode != 0)
+
+        parser = configparser.ConfigParser()
+        parser.read(os.path.join(networkd_unit_file_path, '10-test99.network'))
+        assert(parser.get('Link', 'MTUBytes') == '1400')
+
     def test_cli_set_ipv6_mtu(self):
         assert(link_exist('test99') == True)
 
@@ -1945,6 +2297,76 @@ class TestCLINetwork:
 
         assert(unit_exist('10-test99.network') == False)
 
+class TestDBusDaemon:
+    manager = "org.freedesktop.nmctl1 /org/freedesktop/nmctl1 org.freedesktop.nmctl1.Manager"
+
+    def setup_method(self):
+        link_remove('test99')
+        link_add_dummy('test99')
+        restart_networkd()
+        subprocess.check_call("systemctl start network-config-manager", shell = True)
+
+    def teardown_method(self):
+        subprocess.call("systemctl stop network-config-manager", shell = True)
+        remove_units_from_netword_unit_path()
+        link_remove('test99')
+
+    def busctl_call(self, method, *args, json_output = False):
+        command = "busctl --json=short call " if json_output else "busctl call "
+        return subprocess.run(command + self.manager + " " + method + " " + " ".join(args),
+                              stdout = subprocess.PIPE, stderr = subprocess.PIPE, text = True, shell = True)
+
+    def test_daemon_set_link_mtu(self):
+        assert(link_exist('test99') == True)
+
+        r = self.busctl_call("SetLinkMTU", "su", "test99", "1400")
+        assert(r.returncode == 0)
+
+        assert(unit_exist('10-test99.network') == True)
+        parser = configparser.ConfigParser()
+        parser.read(os.path.join(networkd_unit_file_path, '10-test99.network'))
+
+        assert(parser.get('Match', 'Name') == 'test99')
+        assert(parser.get('Link', 'MTUBytes') == '1400')
+
+    def test_daemon_get_link_status(self):
+        assert(link_exist('test99') == True)
+
+        r = self.busctl_call("GetLinkStatus", "s", "test99", json_output = True)
+        assert(r.returncode == 0)
+
+        reply = json.loads(r.stdout)
+        assert(reply['type'] == 's')
+
+        status = json.loads(reply['data'][0])
+        assert(status['Name'] == 'test99')
+
+    def test_daemon_get_system_status(self):
+        assert(link_exist('test99') == True)
+
+        r = self.busctl_call("GetSystemStatus", json_output = True)
+        assert(r.returncode == 0)
+
+        reply = json.loads(r.stdout)
+        assert(reply['type'] == 's')
+
+        status = json.loads(reply['data'][0])
+        links = [link["Name"] for link in status["Interfaces"]]
+        assert('test99' in links)
+
+    def test_daemon_set_link_mtu_failure(self):
+        assert(link_exist('test99') == True)
+
+        r = self.busctl_call("SetLinkMTU", "su", "test-nonexistent", "1400")
+        assert(r.returncode != 0)
+        assert("Failed to find device 'test-nonexistent'" in r.stderr)
+
+        r = self.busctl_call("SetLinkMTU", "su", "test99", "0")
+        assert(r.returncode != 0)
+        assert("Invalid MTU" in r.stderr)
+
+        assert(unit_exist('10-test99.network') == False)
+
 class TestCLIDHCPv4Server:
     def setup_method(self):
         link_remove('test99')